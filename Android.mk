@@ -46,9 +46,11 @@ LOCAL_SRC_FILES := \
     aidl.cpp \
     aidl_language.cpp \
     aidl_language_l.ll \
+    aidl_language_rd.cpp \
     aidl_language_y.yy \
     ast_cpp.cpp \
     ast_java.cpp \
+    bundle.cpp \
     code_writer.cpp \
     generate_cpp.cpp \
     generate_java.cpp \
@@ -57,10 +59,19 @@ LOCAL_SRC_FILES := \
     line_reader.cpp \
     io_delegate.cpp \
     options.cpp \
+    recording_io_delegate.cpp \
     type_cpp.cpp \
     type_java.cpp \
     type_namespace.cpp \
 
+# Windows builds lack std::thread, so they always do I/O on the main thread.
+LOCAL_SRC_FILES_darwin := async_io_delegate.cpp jobserver.cpp
+LOCAL_SRC_FILES_linux := async_io_delegate.cpp jobserver.cpp
+# Build with AIDL_USE_RECURSIVE_DESCENT_PARSER=true to parse with
+# aidl_language_rd.cpp instead of bison.
+ifeq ($(AIDL_USE_RECURSIVE_DESCENT_PARSER),true)
+LOCAL_CFLAGS += -DAIDL_USE_RECURSIVE_DESCENT_PARSER
+endif
 include $(BUILD_HOST_STATIC_LIBRARY)
 
 
@@ -95,18 +106,35 @@ LOCAL_CFLAGS := $(aidl_cflags) -g -DUNIT_TEST
 # Tragically, the code is riddled with unused parameters.
 LOCAL_CLANG_CFLAGS := -Wno-unused-parameter
 LOCAL_SRC_FILES := \
+    aidl_language_rd_unittest.cpp \
     aidl_unittest.cpp \
     ast_cpp_unittest.cpp \
+    async_io_delegate_unittest.cpp \
     ast_java_unittest.cpp \
     generate_cpp_unittest.cpp \
     io_delegate_unittest.cpp \
+    jobserver_unittest.cpp \
     options_unittest.cpp \
+    recording_io_delegate_unittest.cpp \
     tests/end_to_end_tests.cpp \
     tests/fake_io_delegate.cpp \
     tests/main.cpp \
+    tests/slow_io_delegate.cpp \
     tests/test_data_example_interface.cpp \
     tests/test_data_ping_responder.cpp \
     tests/test_util.cpp \
+    transport/call_watchdog.cpp \
+    transport/call_watchdog_unittest.cpp \
+    transport/socket_framing.cpp \
+    transport/socket_framing_unittest.cpp \
+    transport/state_mirror_region.cpp \
+    transport/state_mirror_region_unittest.cpp \
+    transport/trace_context.cpp \
+    transport/trace_context_unittest.cpp \
+    transport/transaction_metrics.cpp \
+    transport/transaction_metrics_unittest.cpp \
+    transport/worker_pool_autoscaler.cpp \
+    transport/worker_pool_autoscaler_unittest.cpp \
     type_cpp_unittest.cpp \
     type_java_unittest.cpp \
 
@@ -119,6 +147,68 @@ LOCAL_STATIC_LIBRARIES := \
 LOCAL_LDLIBS_linux := -lrt
 include $(BUILD_HOST_NATIVE_TEST)
 
+# Compiler benchmark against simulated slow storage
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_io_benchmark
+LOCAL_MODULE_HOST_OS := darwin linux
+
+LOCAL_CFLAGS := $(aidl_cflags)
+LOCAL_C_INCLUDES := external/gtest/include
+LOCAL_SRC_FILES := \
+    tests/aidl_io_benchmark.cpp \
+    tests/fake_io_delegate.cpp \
+    tests/slow_io_delegate.cpp \
+    tests/test_util.cpp \
+
+LOCAL_STATIC_LIBRARIES := libaidl-common $(aidl_static_libraries)
+include $(BUILD_HOST_EXECUTABLE)
+
+# Host build of libaidl-allocation-counter below, for the parser benchmark.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libaidl-allocation-counter-host
+LOCAL_MODULE_HOST_OS := linux
+LOCAL_CFLAGS := $(aidl_cflags)
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_STATIC_LIBRARIES := libgtest_host
+LOCAL_SRC_FILES := tests/allocation_counter.cpp
+include $(BUILD_HOST_STATIC_LIBRARY)
+
+# Parse throughput and allocations of the bison and recursive descent parsers
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_parse_benchmark
+LOCAL_MODULE_HOST_OS := linux
+
+LOCAL_CFLAGS := $(aidl_cflags)
+LOCAL_C_INCLUDES := external/gtest/include
+LOCAL_SRC_FILES := \
+    tests/aidl_parse_benchmark.cpp \
+    tests/fake_io_delegate.cpp \
+    tests/test_util.cpp \
+
+LOCAL_WHOLE_STATIC_LIBRARIES := libaidl-allocation-counter-host
+LOCAL_STATIC_LIBRARIES := \
+    libaidl-common \
+    $(aidl_static_libraries) \
+    libgtest_host \
+
+LOCAL_LDLIBS_linux := -ldl -lpthread
+include $(BUILD_HOST_EXECUTABLE)
+
+# Replays aidl invocations captured from a real build with AIDL_CAPTURE_DIR
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_replay_benchmark
+LOCAL_MODULE_HOST_OS := darwin linux
+
+LOCAL_CFLAGS := $(aidl_cflags)
+LOCAL_C_INCLUDES := external/gtest/include
+LOCAL_SRC_FILES := \
+    tests/aidl_replay_benchmark.cpp \
+    tests/fake_io_delegate.cpp \
+    tests/test_util.cpp \
+
+LOCAL_STATIC_LIBRARIES := libaidl-common $(aidl_static_libraries)
+include $(BUILD_HOST_EXECUTABLE)
+
 #
 # Everything below here is used for integration testing of generated AIDL code.
 #
@@ -140,9 +230,82 @@ LOCAL_AIDL_INCLUDES := \
 LOCAL_SRC_FILES := \
     tests/android/aidl/tests/ITestService.aidl \
     tests/android/aidl/tests/INamedCallback.aidl \
+    tests/android/aidl/tests/IDeltaBuffer.aidl \
     tests/simple_parcelable.cpp
 include $(BUILD_SHARED_LIBRARY)
 
+# Runtime for serving generated interfaces over AF_UNIX sockets.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libaidl-socket-transport
+LOCAL_CFLAGS := $(aidl_cflags)
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := \
+    transport/call_watchdog.cpp \
+    transport/socket_framing.cpp \
+    transport/socket_transport.cpp \
+    transport/state_mirror.cpp \
+    transport/state_mirror_region.cpp \
+    transport/trace_context.cpp \
+    transport/transaction_metrics.cpp \
+    transport/worker_pool_autoscaler.cpp
+include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_socket_benchmark
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_SHARED_LIBRARIES := \
+    libaidl-integration-test \
+    libaidl-socket-transport \
+    $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := \
+    tests/aidl_socket_benchmark.cpp \
+    tests/test_util.cpp
+include $(BUILD_EXECUTABLE)
+
+# A service generated with --server-metrics under bursts of load, served by a
+# SocketServer that a WorkerPoolAutoscaler resizes.
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_autoscale_benchmark
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_SHARED_LIBRARIES := \
+    libaidl-socket-transport \
+    $(aidl_integration_test_shared_libs)
+LOCAL_AIDL_FLAGS := --server-metrics
+LOCAL_SRC_FILES := \
+    tests/android/aidl/tests/ILoadBench.aidl \
+    tests/aidl_autoscale_benchmark.cpp \
+    tests/test_util.cpp
+include $(BUILD_EXECUTABLE)
+
+# A @mirrored method read from its state mirror, against the same call made
+# over the socket transport.
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_mirror_benchmark
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_SHARED_LIBRARIES := \
+    libaidl-integration-test \
+    libaidl-socket-transport \
+    $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := \
+    tests/android/aidl/tests/IMirrorBench.aidl \
+    tests/aidl_mirror_benchmark.cpp \
+    tests/test_util.cpp
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_delta_benchmark
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_SHARED_LIBRARIES := \
+    libaidl-integration-test \
+    $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := \
+    tests/aidl_delta_benchmark.cpp
+include $(BUILD_EXECUTABLE)
+
 include $(CLEAR_VARS)
 LOCAL_MODULE := aidl_test_service
 LOCAL_CFLAGS := $(aidl_integration_test_cflags)
@@ -169,6 +332,70 @@ LOCAL_SRC_FILES := \
     tests/aidl_test_client_service_exceptions.cpp
 include $(BUILD_EXECUTABLE)
 
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_socket_transport_unittests
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_SHARED_LIBRARIES := \
+    libaidl-socket-transport \
+    $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := transport/socket_transport_unittest.cpp
+include $(BUILD_NATIVE_TEST)
+
+# Replaces the allocator in test binaries to count allocations; link it
+# with LOCAL_WHOLE_STATIC_LIBRARIES so that the replacements are kept.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libaidl-allocation-counter
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_STATIC_LIBRARIES := libgtest
+LOCAL_SRC_FILES := tests/allocation_counter.cpp
+include $(BUILD_STATIC_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_test_allocations
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_WHOLE_STATIC_LIBRARIES := libaidl-allocation-counter
+LOCAL_SHARED_LIBRARIES := \
+    libaidl-integration-test \
+    libdl \
+    $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := tests/aidl_test_allocations.cpp
+include $(BUILD_NATIVE_TEST)
+
+# The same interfaces generated by aidl-cpp and declared with
+# IMPLEMENT_META_INTERFACE, as aidl-cpp used to, for the startup benchmark.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libaidl-startup-generated
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_SHARED_LIBRARIES := $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := \
+    tests/android/aidl/tests/INamedCallback.aidl \
+    tests/android/aidl/tests/IDeltaBuffer.aidl \
+    tests/android/aidl/tests/ILoadBench.aidl \
+    tests/android/aidl/tests/IPooledParcelBench.aidl
+include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := libaidl-startup-meta-interface
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_SHARED_LIBRARIES := $(aidl_integration_test_shared_libs)
+LOCAL_SRC_FILES := tests/aidl_startup_meta_interface.cpp
+include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_startup_benchmark
+LOCAL_CFLAGS := $(aidl_integration_test_cflags)
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_WHOLE_STATIC_LIBRARIES := libaidl-allocation-counter
+LOCAL_STATIC_LIBRARIES := libgtest
+LOCAL_SHARED_LIBRARIES := libdl
+LOCAL_REQUIRED_MODULES := \
+    libaidl-startup-generated \
+    libaidl-startup-meta-interface
+LOCAL_SRC_FILES := tests/aidl_startup_benchmark.cpp
+include $(BUILD_EXECUTABLE)
+
 include $(CLEAR_VARS)
 LOCAL_MODULE := aidl_test_sentinel_searcher
 LOCAL_SRC_FILES := tests/aidl_test_sentinel_searcher.cpp
@@ -180,6 +407,12 @@ include $(BUILD_EXECUTABLE)
 # compatibility introduces java dependencies.
 ifndef BRILLO
 
+# Base classes for Java code generated with --shared-runtime.
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl-java-runtime
+LOCAL_SRC_FILES := $(call all-java-files-under, runtime/java/src)
+include $(BUILD_STATIC_JAVA_LIBRARY)
+
 include $(CLEAR_VARS)
 LOCAL_PACKAGE_NAME := aidl_test_services
 # Turn off Java optimization tools to speed up our test iterations.
@@ -198,4 +431,43 @@ LOCAL_AIDL_INCLUDES := \
     frameworks/native/aidl/binder
 include $(BUILD_PACKAGE)
 
+# Proxies generated with --thread-local-parcels, for the benchmark below.
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl-thread-parcel-bench-stubs
+LOCAL_AIDL_FLAGS := --thread-local-parcels
+LOCAL_SRC_FILES := tests/android/aidl/tests/IThreadParcelBench.aidl
+include $(BUILD_STATIC_JAVA_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_parcel_benchmark
+LOCAL_STATIC_JAVA_LIBRARIES := aidl-thread-parcel-bench-stubs
+LOCAL_SRC_FILES := \
+    tests/android/aidl/tests/IPooledParcelBench.aidl \
+    tests/java_benchmark/src/android/aidl/tests/ParcelReuseBenchmark.java
+include $(BUILD_JAVA_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_parcelable_reuse_benchmark
+LOCAL_SRC_FILES := \
+    tests/android/aidl/tests/IPointCallbackBench.aidl \
+    tests/java_benchmark/src/android/aidl/tests/BenchPoint.java \
+    tests/java_benchmark/src/android/aidl/tests/ParcelableReuseBenchmark.java
+LOCAL_AIDL_INCLUDES := system/tools/aidl/tests/
+include $(BUILD_JAVA_LIBRARY)
+
+# Proxies generated with --cache-proxies, for the test below.
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl-cached-proxy-bench-stubs
+LOCAL_AIDL_FLAGS := --cache-proxies
+LOCAL_SRC_FILES := tests/android/aidl/tests/ICachedProxyBench.aidl
+include $(BUILD_STATIC_JAVA_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_proxy_cache_test
+LOCAL_STATIC_JAVA_LIBRARIES := aidl-cached-proxy-bench-stubs
+LOCAL_SRC_FILES := \
+    tests/android/aidl/tests/IPooledParcelBench.aidl \
+    tests/java_benchmark/src/android/aidl/tests/ProxyCacheTest.java
+include $(BUILD_JAVA_LIBRARY)
+
 endif  # not defined BRILLO
@@ -35,6 +35,7 @@
 #include <android-base/strings.h>
 
 #include "aidl_language.h"
+#include "bundle.h"
 #include "generate_cpp.h"
 #include "generate_java.h"
 #include "import_resolver.h"
@@ -171,11 +172,251 @@ bool gather_types(const std::string& filename,
   return success;
 }
 
+bool check_shard_key(const string& filename,
+                     const AidlMethod& m,
+                     bool interface_is_sharded) {
+  bool success = true;
+
+  if (m.GetType().IsShardKey()) {
+    cerr << filename << ":" << m.GetLine()
+         << " @shardKey may only annotate arguments, not the return type of '"
+         << m.GetName() << "'" << endl;
+    success = false;
+  }
+
+  const AidlArgument* key = nullptr;
+  for (const auto& arg : m.GetArguments()) {
+    const AidlType& type = arg->GetType();
+    if (!type.IsShardKey()) {
+      continue;
+    }
+    if (key != nullptr) {
+      cerr << filename << ":" << arg->GetLine()
+           << " method '" << m.GetName()
+           << "' has more than one @shardKey argument" << endl;
+      success = false;
+    }
+    key = arg.get();
+
+    const string& name = type.GetName();
+    if (arg->GetDirection() != AidlArgument::IN_DIR || type.IsArray() ||
+        type.IsNullable() ||
+        (name != "int" && name != "long" && name != "String" &&
+         name != "java.lang.String")) {
+      cerr << filename << ":" << arg->GetLine()
+           << " @shardKey argument '" << arg->GetName()
+           << "' must be a non-null in int, long, or String" << endl;
+      success = false;
+    }
+  }
+
+  // Methods without a key are broadcast to every shard.  There is no sensible
+  // way to merge out parameters from several shards, so don't allow them.
+  if (interface_is_sharded && key == nullptr &&
+      !m.GetOutArguments().empty()) {
+    cerr << filename << ":" << m.GetLine()
+         << " method '" << m.GetName() << "' has no @shardKey argument and "
+         << "cannot be broadcast because it has out parameters" << endl;
+    success = false;
+  }
+
+  return success;
+}
+
+bool check_delta(const string& filename, const AidlMethod& m) {
+  bool success = true;
+
+  if (m.GetType().IsDelta()) {
+    cerr << filename << ":" << m.GetLine()
+         << " @delta may only annotate arguments, not the return type of '"
+         << m.GetName() << "'" << endl;
+    success = false;
+  }
+
+  for (const auto& arg : m.GetArguments()) {
+    const AidlType& type = arg->GetType();
+    if (!type.IsDelta()) {
+      continue;
+    }
+    // The reply carries only the elements that changed, so both sides need
+    // the array as it was sent, and elements must compare by value.
+    const string& name = type.GetName();
+    if (arg->GetDirection() != AidlArgument::INOUT_DIR || !type.IsArray() ||
+        type.IsNullable() ||
+        (name != "int" && name != "long" && name != "float" &&
+         name != "double" && name != "char" && name != "boolean")) {
+      cerr << filename << ":" << arg->GetLine()
+           << " @delta argument '" << arg->GetName()
+           << "' must be a non-null inout array of int, long, float, double, "
+           << "char or boolean" << endl;
+      success = false;
+    }
+  }
+
+  return success;
+}
+
+bool check_reuse(const string& filename, const AidlMethod& m) {
+  bool success = true;
+
+  if (m.GetType().IsReuse()) {
+    cerr << filename << ":" << m.GetLine()
+         << " @reuse may only annotate arguments, not the return type of '"
+         << m.GetName() << "'" << endl;
+    success = false;
+  }
+
+  for (const auto& arg : m.GetArguments()) {
+    const AidlType& type = arg->GetType();
+    if (!type.IsReuse()) {
+      continue;
+    }
+    // Reused objects are refilled with readFromParcel(), which only
+    // parcelables declared in AIDL are required to have.
+    const ValidatableType* language_type =
+        type.GetLanguageType<ValidatableType>();
+    if (arg->GetDirection() != AidlArgument::IN_DIR || type.IsArray() ||
+        (language_type != nullptr &&
+         language_type->Kind() != ValidatableType::KIND_PARCELABLE)) {
+      cerr << filename << ":" << arg->GetLine()
+           << " @reuse argument '" << arg->GetName()
+           << "' must be an in parcelable" << endl;
+      success = false;
+    }
+  }
+
+  return success;
+}
+
+bool check_skippable(const string& filename, const AidlMethod& m) {
+  bool success = true;
+
+  if (m.GetType().IsSkippable()) {
+    cerr << filename << ":" << m.GetLine()
+         << " @skippable may only annotate arguments, not the return type of '"
+         << m.GetName() << "'" << endl;
+    success = false;
+  }
+
+  for (const auto& arg : m.GetArguments()) {
+    if (!arg->GetType().IsSkippable()) {
+      continue;
+    }
+    // An inout argument has to be sent whether or not the caller wants it
+    // back, so only pure out arguments can be skipped.
+    if (arg->GetDirection() != AidlArgument::OUT_DIR) {
+      cerr << filename << ":" << arg->GetLine()
+           << " @skippable argument '" << arg->GetName()
+           << "' must be an out parameter" << endl;
+      success = false;
+    }
+    // The mask of wanted arguments is an int32.
+    if (m.GetOutMaskBit(*arg) == 0) {
+      cerr << filename << ":" << arg->GetLine()
+           << " @skippable argument '" << arg->GetName()
+           << "' must be one of the first 32 parameters" << endl;
+      success = false;
+    }
+  }
+
+  return success;
+}
+
+bool check_mirrored(const string& filename, const AidlInterface& c,
+                    const AidlMethod& m) {
+  bool success = true;
+
+  for (const auto& arg : m.GetArguments()) {
+    if (arg->GetType().IsMirrored()) {
+      cerr << filename << ":" << arg->GetLine()
+           << " @mirrored may only annotate the return type of a method, "
+           << "not argument '" << arg->GetName() << "'" << endl;
+      success = false;
+    }
+  }
+
+  const AidlType& type = m.GetType();
+  if (!type.IsMirrored()) {
+    return success;
+  }
+  // Clients read the last snapshot the service published instead of
+  // calling it, so there must be nothing to pass and a reply to replace.
+  // Snapshots are flattened into shared memory, which parcelables
+  // without binders or file descriptors survive.
+  const ValidatableType* language_type =
+      type.GetLanguageType<ValidatableType>();
+  if (!m.GetArguments().empty() || m.IsOneway() || c.IsOneway() ||
+      type.IsArray() || type.IsNullable() ||
+      (language_type != nullptr &&
+       language_type->Kind() != ValidatableType::KIND_PARCELABLE)) {
+    cerr << filename << ":" << m.GetLine()
+         << " @mirrored method '" << m.GetName()
+         << "' must take no arguments and return a non-null parcelable"
+         << endl;
+    success = false;
+  }
+  // Snapshots are written the same way for every client, null marker
+  // included.
+  if (type.IsNonNull()) {
+    cerr << filename << ":" << m.GetLine()
+         << " @mirrored method '" << m.GetName()
+         << "' may not also be annotated with @nonnull" << endl;
+    success = false;
+  }
+
+  return success;
+}
+
+// The steps of a call chain are unpacked into calls that carry no trace
+// context, so the two don't mix.
+bool check_trace_context(const string& filename, const AidlInterface& c) {
+  if (c.IsChainable()) {
+    cerr << filename << ":" << c.GetLine()
+         << " --trace-context cannot be used with @chainable interface "
+         << c.GetName() << endl;
+    return false;
+  }
+  return true;
+}
+
+// Enums are only visible inside the interface that declares them, so they
+// are registered alongside it rather than through imports.
+bool gather_enum_types(const string& filename,
+                       const AidlInterface& c,
+                       TypeNamespace* types) {
+  bool success = true;
+  map<string, const AidlEnum*> enum_names;
+  for (const auto& e : c.GetEnums()) {
+    auto it = enum_names.find(e->GetName());
+    if (it != enum_names.end()) {
+      cerr << filename << ":" << e->GetLine()
+           << " attempt to redefine enum " << e->GetName() << "," << endl
+           << filename << ":" << it->second->GetLine()
+           << "    previously defined here." << endl;
+      success = false;
+      continue;
+    }
+    enum_names[e->GetName()] = e.get();
+    if (!types->AddEnumType(*e, c, filename)) {
+      success = false;
+    }
+  }
+  return success;
+}
+
 int check_types(const string& filename,
                 const AidlInterface* c,
                 TypeNamespace* types) {
   int err = 0;
 
+  // A chain needs the reply to each call.
+  if (c->IsChainable() && c->IsOneway()) {
+    cerr << filename << ":" << c->GetLine()
+         << " oneway interface " << c->GetName()
+         << " cannot be @chainable" << endl;
+    err = 1;
+  }
+
   // Has to be a pointer due to deleting copy constructor. No idea why.
   map<string, const AidlMethod*> method_names;
   for (const auto& m : c->GetMethods()) {
@@ -224,6 +465,26 @@ int check_types(const string& filename,
       }
     }
 
+    if (!check_shard_key(filename, *m, c->IsSharded())) {
+      err = 1;
+    }
+
+    if (!check_delta(filename, *m)) {
+      err = 1;
+    }
+
+    if (!check_reuse(filename, *m)) {
+      err = 1;
+    }
+
+    if (!check_skippable(filename, *m)) {
+      err = 1;
+    }
+
+    if (!check_mirrored(filename, *c, *m)) {
+      err = 1;
+    }
+
     auto it = method_names.find(m->GetName());
     // prevent duplicate methods
     if (it == method_names.end()) {
@@ -304,10 +565,15 @@ bool write_cpp_dep_file(const CppOptions& options,
     }
   }
 
+  vector<ClassNames> header_types = {ClassNames::CLIENT,
+                                     ClassNames::SERVER,
+                                     ClassNames::INTERFACE};
+  if (interface.IsSharded()) {
+    header_types.push_back(ClassNames::ROUTER);
+  }
+
   vector<string> headers;
-  for (ClassNames c : {ClassNames::CLIENT,
-                       ClassNames::SERVER,
-                       ClassNames::INTERFACE}) {
+  for (ClassNames c : header_types) {
     headers.push_back(options.OutputHeaderDir() + '/' +
                       HeaderFile(interface, c, false /* use_os_sep */));
   }
@@ -514,6 +780,7 @@ AidlError load_and_validate_aidl(
   std::map<AidlImport*,std::unique_ptr<AidlDocument>> docs;
 
   // import the preprocessed file
+  io_delegate.PrefetchFiles(preprocessed_files);
   for (const string& s : preprocessed_files) {
     if (!parse_preprocessed_file(io_delegate, s, types)) {
       err = AidlError::BAD_PRE_PROCESSED_FILE;
@@ -549,6 +816,16 @@ AidlError load_and_validate_aidl(
 
   // parse the imports of the input file
   ImportResolver import_resolver{io_delegate, import_paths};
+  vector<string> import_candidates;
+  for (const auto& import : p.GetImports()) {
+    if (!types->HasImportType(*import)) {
+      for (string& path :
+           import_resolver.CandidatePaths(import->GetNeededClass())) {
+        import_candidates.push_back(std::move(path));
+      }
+    }
+  }
+  io_delegate.PrefetchFiles(import_candidates);
   for (auto& import : p.GetImports()) {
     if (types->HasImportType(*import)) {
       // There are places in the Android tree where an import doesn't resolve,
@@ -587,6 +864,9 @@ AidlError load_and_validate_aidl(
   if (!types->AddBinderType(*interface.get(), input_file_name)) {
     err = AidlError::BAD_TYPE;
   }
+  if (!gather_enum_types(input_file_name, *interface.get(), types)) {
+    err = AidlError::BAD_TYPE;
+  }
 
   interface->SetLanguageType(types->GetInterfaceType(*interface));
 
@@ -647,6 +927,11 @@ int compile_aidl_to_cpp(const CppOptions& options,
     return 1;
   }
 
+  if (options.TraceContext() &&
+      !check_trace_context(options.InputFileName(), *interface)) {
+    return 1;
+  }
+
   if (!write_cpp_dep_file(options, *interface, imports, io_delegate)) {
     return 1;
   }
@@ -680,6 +965,21 @@ int compile_aidl_to_java(const JavaOptions& options,
     return 1;
   }
 
+  for (const auto& m : interface->GetMethods()) {
+    for (const auto& arg : m->GetArguments()) {
+      if (arg->GetType().IsDelta()) {
+        cerr << options.input_file_name_ << ":" << arg->GetLine()
+             << " @delta is only supported by aidl-cpp" << endl;
+        return 1;
+      }
+    }
+  }
+
+  if (options.trace_context_ &&
+      !check_trace_context(options.input_file_name_, *interface)) {
+    return 1;
+  }
+
   string output_file_name = options.output_file_name_;
   // if needed, generate the output file name from the base folder
   if (output_file_name.empty() && !options.output_base_folder_.empty()) {
@@ -696,7 +996,7 @@ int compile_aidl_to_java(const JavaOptions& options,
   }
 
   return generate_java(output_file_name, options.input_file_name_.c_str(),
-                       interface.get(), types.get(), io_delegate);
+                       interface.get(), types.get(), io_delegate, options);
 }
 
 bool preprocess_aidl(const JavaOptions& options,
@@ -730,5 +1030,145 @@ bool preprocess_aidl(const JavaOptions& options,
   return writer->Close();
 }
 
+namespace {
+
+// Returns the path of the file that declares |canonical_name| relative to
+// its import root, using '/' as the separator.
+string BundlePathFor(const string& canonical_name) {
+  string path = canonical_name;
+  for (char& c : path) {
+    if (c == '.') {
+      c = '/';
+    }
+  }
+  return path + ".aidl";
+}
+
+}  // namespace
+
+bool bundle_aidl(const JavaOptions& options,
+                 const IoDelegate& io_delegate) {
+  Bundle bundle;
+  bundle.import_roots_.push_back(Bundle::kImportRoot);
+
+  // Imports that preprocessed types satisfy are skipped when compiling, so
+  // they are not bundled either.
+  java::JavaTypeNamespace types;
+  types.Init();
+  for (size_t i = 0; i < options.preprocessed_files_.size(); ++i) {
+    const string& file = options.preprocessed_files_[i];
+    unique_ptr<string> contents = io_delegate.GetFileContents(file);
+    if (!contents || !internals::parse_preprocessed_file(io_delegate, file,
+                                                         &types)) {
+      return false;
+    }
+    const string path = "preprocessed/" + std::to_string(i);
+    if (!bundle.AddFile(path, *contents)) {
+      return false;
+    }
+    bundle.preprocessed_files_.push_back(path);
+  }
+
+  ImportResolver import_resolver{io_delegate, options.import_paths_};
+  bool success = true;
+  for (const string& input : options.files_to_bundle_) {
+    Parser p{io_delegate};
+    if (!p.ParseFile(input)) {
+      return false;
+    }
+
+    // Store inputs where the compiler expects them to be, given their
+    // package.
+    const AidlDocument* doc = p.GetDocument();
+    string canonical_name;
+    if (doc->GetInterface() != nullptr) {
+      canonical_name = doc->GetInterface()->GetCanonicalName();
+    } else if (!doc->GetParcelables().empty()) {
+      const AidlParcelable& parcelable = *doc->GetParcelables()[0];
+      canonical_name = parcelable.GetName();
+      canonical_name = canonical_name.substr(0, canonical_name.find('.'));
+      if (!parcelable.GetPackage().empty()) {
+        canonical_name = parcelable.GetPackage() + "." + canonical_name;
+      }
+    } else {
+      cerr << input << ": nothing to bundle" << endl;
+      return false;
+    }
+    const string path = "src/" + BundlePathFor(canonical_name);
+    unique_ptr<string> contents = io_delegate.GetFileContents(input);
+    if (!contents || !bundle.AddFile(path, *contents)) {
+      return false;
+    }
+    bundle.inputs_.push_back(path);
+
+    for (const auto& import : p.GetImports()) {
+      if (types.HasImportType(*import)) {
+        continue;
+      }
+      const string& needed_class = import->GetNeededClass();
+      const string import_path = import_resolver.FindImportFile(needed_class);
+      if (import_path.empty()) {
+        cerr << import->GetFileFrom() << ":" << import->GetLine()
+             << ": couldn't find import for class " << needed_class << endl;
+        success = false;
+        continue;
+      }
+      unique_ptr<string> import_contents =
+          io_delegate.GetFileContents(import_path);
+      if (!import_contents ||
+          !bundle.AddFile(string(Bundle::kImportRoot) + "/" +
+                              BundlePathFor(needed_class),
+                          *import_contents)) {
+        success = false;
+      }
+    }
+  }
+  if (!success) {
+    return false;
+  }
+
+  unique_ptr<CodeWriter> writer =
+      io_delegate.GetCodeWriter(options.output_file_name_);
+  return writer->Write("%s", bundle.Serialize().c_str()) && writer->Close();
+}
+
+int compile_bundle_to_java(JavaOptions* options,
+                           const IoDelegate& io_delegate) {
+  const string& bundle_file = options->bundle_file_name_;
+  unique_ptr<string> contents = io_delegate.GetFileContents(bundle_file);
+  if (!contents) {
+    LOG(ERROR) << "cannot open bundle: " << bundle_file;
+    return 1;
+  }
+  unique_ptr<Bundle> bundle = Bundle::Parse(*contents);
+  if (!bundle) {
+    LOG(ERROR) << "cannot read bundle: " << bundle_file;
+    return 1;
+  }
+  if (bundle->inputs_.size() != 1 && !options->output_file_name_.empty()) {
+    LOG(ERROR) << bundle_file << " has " << bundle->inputs_.size()
+               << " inputs; use -o to compile it";
+    return 1;
+  }
+
+  BundleIoDelegate bundle_io_delegate{*bundle, bundle_file, io_delegate};
+  options->import_paths_.clear();
+  for (const string& root : bundle->import_roots_) {
+    options->import_paths_.push_back(bundle_io_delegate.PathFor(root));
+  }
+  options->preprocessed_files_.clear();
+  for (const string& file : bundle->preprocessed_files_) {
+    options->preprocessed_files_.push_back(bundle_io_delegate.PathFor(file));
+  }
+  for (const string& input : bundle->inputs_) {
+    options->input_file_name_ = bundle_io_delegate.PathFor(input);
+    const int ret = compile_aidl_to_java(*options, bundle_io_delegate);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  return 0;
+}
+
 }  // namespace android
 }  // namespace aidl
@@ -50,6 +50,13 @@ int compile_aidl_to_java(const JavaOptions& options,
                          const IoDelegate& io_delegate);
 bool preprocess_aidl(const JavaOptions& options,
                      const IoDelegate& io_delegate);
+// Writes the inputs, their resolved imports and the preprocessed files they
+// need to a single bundle.
+bool bundle_aidl(const JavaOptions& options,
+                 const IoDelegate& io_delegate);
+// Compiles every input in a bundle, pointing |options| into the bundle.
+int compile_bundle_to_java(JavaOptions* options,
+                           const IoDelegate& io_delegate);
 
 namespace internals {
 
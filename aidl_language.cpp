@@ -1,6 +1,10 @@
 #include "aidl_language.h"
 
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <set>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,6 +12,7 @@
 
 #include <android-base/strings.h>
 
+#include "aidl_language_rd.h"
 #include "aidl_language_y.h"
 #include "logging.h"
 
@@ -23,10 +28,29 @@ using android::base::Join;
 using android::base::Split;
 using std::cerr;
 using std::endl;
+using std::pair;
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
-void yylex_init(void **);
+namespace {
+
+bool IsIntegerLiteral(const string& text) {
+  size_t i = (!text.empty() && (text[0] == '-' || text[0] == '+')) ? 1 : 0;
+  if (i == text.size()) {
+    return false;
+  }
+  for (; i < text.size(); ++i) {
+    if (!isdigit(static_cast<unsigned char>(text[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int yylex_init_extra(Parser*, void**);
 void yylex_destroy(void *);
 void yyset_in(FILE *f, void *);
 int yyparse(Parser*);
@@ -89,7 +113,48 @@ string AidlArgument::ToString() const {
 
 AidlConstant::AidlConstant(std::string name, int32_t value)
     : name_(name),
-      value_(value) {}
+      type_(INT),
+      value_(value),
+      value_text_(std::to_string(value)) {}
+
+AidlConstant::AidlConstant(std::string name, Type type, std::string value)
+    : name_(name),
+      type_(type),
+      value_(0),
+      value_text_(value) {}
+
+AidlEnum::AidlEnum(const string& name, const string& backing_type,
+                   vector<Enumerator> enumerators, unsigned line)
+    : name_(name),
+      backing_type_(backing_type),
+      enumerators_(std::move(enumerators)),
+      line_(line) {}
+
+const AidlEnum::Enumerator& AidlEnum::GetMin() const {
+  const Enumerator* min = &enumerators_.front();
+  for (const Enumerator& e : enumerators_) {
+    if (e.value < min->value) { min = &e; }
+  }
+  return *min;
+}
+
+const AidlEnum::Enumerator& AidlEnum::GetMax() const {
+  const Enumerator* max = &enumerators_.front();
+  for (const Enumerator& e : enumerators_) {
+    if (e.value > max->value) { max = &e; }
+  }
+  return *max;
+}
+
+bool AidlEnum::IsContiguous() const {
+  std::set<int64_t> values;
+  for (const Enumerator& e : enumerators_) {
+    values.insert(e.value);
+  }
+  // In unsigned arithmetic, so that the range of a long can't overflow.
+  return values.size() - 1 == static_cast<uint64_t>(GetMax().value) -
+                                  static_cast<uint64_t>(GetMin().value);
+}
 
 AidlMethod::AidlMethod(bool oneway, AidlType* type, std::string name,
                        std::vector<std::unique_ptr<AidlArgument>>* args,
@@ -116,9 +181,46 @@ AidlMethod::AidlMethod(bool oneway, AidlType* type, std::string name,
   has_id_ = false;
 }
 
+const AidlArgument* AidlMethod::GetShardKeyArgument() const {
+  for (const unique_ptr<AidlArgument>& a : arguments_) {
+    if (a->GetType().IsShardKey()) { return a.get(); }
+  }
+  return nullptr;
+}
+
+bool AidlMethod::HasSkippableArguments() const {
+  for (const unique_ptr<AidlArgument>& a : arguments_) {
+    if (a->GetType().IsSkippable()) { return true; }
+  }
+  return false;
+}
+
+uint32_t AidlMethod::GetOutMaskBit(const AidlArgument& arg) const {
+  for (size_t i = 0; i < arguments_.size(); ++i) {
+    if (arguments_[i].get() == &arg) {
+      return (i < 32) ? uint32_t{1} << i : 0;
+    }
+  }
+  return 0;
+}
+
+namespace {
+
+#ifdef AIDL_USE_RECURSIVE_DESCENT_PARSER
+const Parser::Implementation kDefaultImplementation = Parser::RECURSIVE_DESCENT;
+#else
+const Parser::Implementation kDefaultImplementation = Parser::BISON;
+#endif
+
+}  // namespace
+
 Parser::Parser(const IoDelegate& io_delegate)
-    : io_delegate_(io_delegate) {
-  yylex_init(&scanner_);
+    : Parser(io_delegate, kDefaultImplementation) {}
+
+Parser::Parser(const IoDelegate& io_delegate, Implementation implementation)
+    : io_delegate_(io_delegate),
+      implementation_(implementation) {
+  yylex_init_extra(this, &scanner_);
 }
 
 AidlParcelable::AidlParcelable(AidlQualifiedName* name, unsigned line,
@@ -158,13 +260,16 @@ AidlInterface::AidlInterface(const std::string& name, unsigned line,
     AidlMember* local = member.release();
     AidlMethod* method = local->AsMethod();
     AidlConstant* constant = local->AsConstant();
+    AidlEnum* an_enum = local->AsEnum();
 
     if (method) {
       methods_.emplace_back(method);
     } else if (constant) {
       constants_.emplace_back(constant);
+    } else if (an_enum) {
+      enums_.emplace_back(an_enum);
     } else {
-      LOG(FATAL) << "Member is neither method nor constant!";
+      LOG(FATAL) << "Member is neither method, constant nor enum!";
     }
   }
 
@@ -182,6 +287,20 @@ std::string AidlInterface::GetCanonicalName() const {
   return GetPackage() + "." + GetName();
 }
 
+bool AidlInterface::IsSharded() const {
+  for (const auto& method : methods_) {
+    if (method->GetShardKeyArgument() != nullptr) { return true; }
+  }
+  return false;
+}
+
+bool AidlInterface::HasMirroredMethods() const {
+  for (const auto& method : methods_) {
+    if (method->GetType().IsMirrored()) { return true; }
+  }
+  return false;
+}
+
 AidlDocument::AidlDocument(AidlInterface* interface)
     : interface_(interface) {}
 
@@ -231,19 +350,29 @@ bool Parser::ParseFile(const string& filename) {
     raw_buffer_.reset();
   }
 
-  raw_buffer_ = std::move(new_buffer);
-  // We're going to scan this buffer in place, and yacc demands we put two
-  // nulls at the end.
-  raw_buffer_->append(2u, '\0');
   filename_ = filename;
   package_.reset();
   error_ = 0;
   document_.reset();
+  quoted_stale_value_ = false;
+
+  if (implementation_ == RECURSIVE_DESCENT) {
+    if (!ParseRecursiveDescent(*new_buffer, this) || error_ != 0) {
+      return false;
+    }
+  } else {
+    raw_buffer_ = std::move(new_buffer);
+    // We're going to scan this buffer in place, and yacc demands we put two
+    // nulls at the end.
+    raw_buffer_->append(2u, '\0');
 
-  buffer_ = yy_scan_buffer(&(*raw_buffer_)[0], raw_buffer_->length(), scanner_);
+    buffer_ = yy_scan_buffer(&(*raw_buffer_)[0], raw_buffer_->length(),
+                             scanner_);
 
-  if (yy::parser(this).parse() != 0 || error_ != 0) {
-    return false;}
+    if (yy::parser(this).parse() != 0 || error_ != 0) {
+      return false;
+    }
+  }
 
   if (document_.get() != nullptr)
     return true;
@@ -257,6 +386,161 @@ void Parser::ReportError(const string& err, unsigned line) {
   error_ = 1;
 }
 
+AidlConstant* Parser::NewConstant(const string& type_name, const string& name,
+                                  const string& value, unsigned line) {
+  // The scanner only gives us integers, integers ending in L, decimals with
+  // an optional f, strings and identifiers.
+  const size_t length = value.size();
+  const bool is_string =
+      length >= 2 && value[0] == '"' && value[length - 1] == '"';
+  const bool is_integer = IsIntegerLiteral(value);
+  const bool is_long = length > 1 && value[length - 1] == 'L' &&
+                       IsIntegerLiteral(value.substr(0, length - 1));
+  const bool is_decimal = !is_string && value.find('.') != string::npos;
+
+  AidlConstant::Type type;
+  string text;
+  bool valid = false;
+  if (type_name == "int") {
+    if (is_integer) {
+      errno = 0;
+      const long long parsed = strtoll(value.c_str(), nullptr, 10);
+      if (errno == 0 && parsed >= INT32_MIN && parsed <= INT32_MAX) {
+        return new AidlConstant(name, static_cast<int>(parsed));
+      }
+    }
+    type = AidlConstant::INT;
+  } else if (type_name == "long") {
+    type = AidlConstant::LONG;
+    if (is_integer || is_long) {
+      errno = 0;
+      const long long parsed = strtoll(value.c_str(), nullptr, 10);
+      valid = errno == 0;
+      text = std::to_string(parsed);
+    }
+  } else if (type_name == "float" || type_name == "double") {
+    type = (type_name == "float") ? AidlConstant::FLOAT : AidlConstant::DOUBLE;
+    text = value;
+    if (is_decimal && type == AidlConstant::FLOAT && text.back() == 'f') {
+      text.pop_back();
+    }
+    if (!text.empty() && text[0] == '+') {
+      text.erase(0, 1);
+    }
+    if (is_integer) {
+      text += ".0";
+    }
+    if ((is_integer || is_decimal) && text.back() != 'f') {
+      errno = 0;
+      const double parsed = (type == AidlConstant::FLOAT)
+                                ? strtof(text.c_str(), nullptr)
+                                : strtod(text.c_str(), nullptr);
+      valid = errno == 0 && std::isfinite(parsed);
+    }
+  } else if (type_name == "boolean") {
+    type = AidlConstant::BOOLEAN;
+    text = value;
+    valid = value == "true" || value == "false";
+  } else if (type_name == "String") {
+    type = AidlConstant::STRING;
+    if (is_string) {
+      // Both languages would have to agree on what escapes mean.
+      text = value.substr(1, length - 2);
+      valid = text.find_first_of("\\\n") == string::npos;
+    }
+  } else {
+    ReportError("constant " + name + " has type " + type_name +
+                    ", but constants must be int, long, float, double, "
+                    "boolean or String",
+                line);
+    return new AidlConstant(name, 0);
+  }
+
+  if (!valid) {
+    ReportError(value + " is not a valid " + type_name + " value for constant " +
+                    name,
+                line);
+    return new AidlConstant(name, 0);
+  }
+  return new AidlConstant(name, type, text);
+}
+
+AidlEnum* Parser::NewEnum(const string& name, const string& backing_type,
+                          const vector<pair<string, string>>& enumerators,
+                          unsigned line) {
+  int64_t min = INT64_MIN;
+  int64_t max = INT64_MAX;
+  if (backing_type == "byte") {
+    min = INT8_MIN;
+    max = INT8_MAX;
+  } else if (backing_type == "int") {
+    min = INT32_MIN;
+    max = INT32_MAX;
+  } else if (backing_type != "long") {
+    ReportError("enum " + name + " has type " + backing_type +
+                    ", but enums must be byte, int or long",
+                line);
+  }
+
+  vector<AidlEnum::Enumerator> result;
+  std::set<string> names;
+  for (const auto& enumerator : enumerators) {
+    const string& value = enumerator.second;
+    const string qualified_name = name + "." + enumerator.first;
+    int64_t parsed = 0;
+    if (value.empty()) {
+      // One more than the enumerator before, or zero for the first.
+      if (!result.empty() && result.back().value == max) {
+        ReportError(qualified_name + " would be past the largest " +
+                        backing_type + " value",
+                    line);
+      } else if (!result.empty()) {
+        parsed = result.back().value + 1;
+      }
+    } else {
+      const size_t length = value.size();
+      const bool is_long = backing_type == "long" && length > 1 &&
+                           value[length - 1] == 'L' &&
+                           IsIntegerLiteral(value.substr(0, length - 1));
+      bool valid = false;
+      if (IsIntegerLiteral(value) || is_long) {
+        errno = 0;
+        parsed = strtoll(value.c_str(), nullptr, 10);
+        valid = errno == 0 && parsed >= min && parsed <= max;
+      }
+      if (!valid) {
+        ReportError(value + " is not a valid " + backing_type +
+                        " value for enumerator " + qualified_name,
+                    line);
+        parsed = 0;
+      }
+    }
+    if (!names.insert(enumerator.first).second) {
+      ReportError("enumerator " + qualified_name + " is declared twice", line);
+    }
+    result.push_back({enumerator.first, parsed});
+  }
+  return new AidlEnum(name, backing_type, std::move(result), line);
+}
+
+int Parser::NewMethodId(int64_t value, unsigned line) {
+  if (value < INT32_MIN || value > INT32_MAX) {
+    ReportError(std::to_string(value) + " is not a valid method id", line);
+    return 0;
+  }
+  return static_cast<int>(value);
+}
+
+int64_t Parser::ParseIntValue(const char* text, unsigned line) {
+  errno = 0;
+  const long long value = strtoll(text, nullptr, 10);
+  if (errno == ERANGE) {
+    ReportError(string(text) + " does not fit in a long", line);
+    return 0;
+  }
+  return value;
+}
+
 std::vector<std::string> Parser::Package() const {
   if (!package_) {
     return {};
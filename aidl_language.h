@@ -1,8 +1,10 @@
 #ifndef AIDL_AIDL_LANGUAGE_H_
 #define AIDL_AIDL_LANGUAGE_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <android-base/macros.h>
@@ -51,6 +53,12 @@ class AidlType : public AidlNode {
     AnnotationNullable = 1 << 0,
     AnnotationUtf8 = 1 << 1,
     AnnotationUtf8InCpp = 1 << 2,
+    AnnotationShardKey = 1 << 3,
+    AnnotationDelta = 1 << 4,
+    AnnotationReuse = 1 << 5,
+    AnnotationMirrored = 1 << 6,
+    AnnotationNonNull = 1 << 7,
+    AnnotationSkippable = 1 << 8,
   };
 
   AidlType(const std::string& name, unsigned line,
@@ -83,6 +91,24 @@ class AidlType : public AidlNode {
   bool IsUtf8InCpp() const {
     return annotations_ & AnnotationUtf8InCpp;
   }
+  bool IsShardKey() const {
+    return annotations_ & AnnotationShardKey;
+  }
+  bool IsDelta() const {
+    return annotations_ & AnnotationDelta;
+  }
+  bool IsReuse() const {
+    return annotations_ & AnnotationReuse;
+  }
+  bool IsMirrored() const {
+    return annotations_ & AnnotationMirrored;
+  }
+  bool IsNonNull() const {
+    return annotations_ & AnnotationNonNull;
+  }
+  bool IsSkippable() const {
+    return annotations_ & AnnotationSkippable;
+  }
 
  private:
   std::string name_;
@@ -128,6 +154,7 @@ class AidlArgument : public AidlNode {
 
 class AidlMethod;
 class AidlConstant;
+class AidlEnum;
 class AidlMember : public AidlNode {
  public:
   AidlMember() = default;
@@ -135,6 +162,7 @@ class AidlMember : public AidlNode {
 
   virtual AidlMethod* AsMethod() { return nullptr; }
   virtual AidlConstant* AsConstant() { return nullptr; }
+  virtual AidlEnum* AsEnum() { return nullptr; }
 
  private:
   DISALLOW_COPY_AND_ASSIGN(AidlMember);
@@ -142,21 +170,77 @@ class AidlMember : public AidlNode {
 
 class AidlConstant : public AidlMember {
  public:
+  enum Type {
+    INT,
+    LONG,
+    FLOAT,
+    DOUBLE,
+    BOOLEAN,
+    STRING,
+  };
+
   AidlConstant(std::string name, int32_t value);
+  // |value| is as GetValueText() returns it; see Parser::NewConstant().
+  AidlConstant(std::string name, Type type, std::string value);
   virtual ~AidlConstant() = default;
 
   const std::string& GetName() const { return name_; }
+  Type GetType() const { return type_; }
+  // The value of an INT constant.
   int GetValue() const { return value_; }
+  // Numbers in decimal without a suffix, "true" or "false", or the
+  // contents of a string without the quotes.
+  const std::string& GetValueText() const { return value_text_; }
 
   AidlConstant* AsConstant() override { return this; }
 
  private:
   std::string name_;
+  Type type_;
   int32_t value_;
+  std::string value_text_;
 
   DISALLOW_COPY_AND_ASSIGN(AidlConstant);
 };
 
+// An enum declared in an interface, which is passed as the byte, int or
+// long that backs it.
+class AidlEnum : public AidlMember {
+ public:
+  struct Enumerator {
+    std::string name;
+    int64_t value;
+  };
+
+  AidlEnum(const std::string& name, const std::string& backing_type,
+           std::vector<Enumerator> enumerators, unsigned line);
+  virtual ~AidlEnum() = default;
+
+  const std::string& GetName() const { return name_; }
+  // "byte", "int" or "long".
+  const std::string& GetBackingType() const { return backing_type_; }
+  const std::vector<Enumerator>& GetEnumerators() const {
+    return enumerators_;
+  }
+  unsigned GetLine() const { return line_; }
+  // The enumerators with the smallest and largest values.
+  const Enumerator& GetMin() const;
+  const Enumerator& GetMax() const;
+  // True if every value from GetMin() to GetMax() is an enumerator, so
+  // checking a value takes a single comparison.
+  bool IsContiguous() const;
+
+  AidlEnum* AsEnum() override { return this; }
+
+ private:
+  std::string name_;
+  std::string backing_type_;
+  std::vector<Enumerator> enumerators_;
+  unsigned line_;
+
+  DISALLOW_COPY_AND_ASSIGN(AidlEnum);
+};
+
 class AidlMethod : public AidlMember {
  public:
   AidlMethod(bool oneway, AidlType* type, std::string name,
@@ -191,6 +275,18 @@ class AidlMethod : public AidlMember {
   const std::vector<const AidlArgument*>& GetOutArguments() const {
     return out_arguments_;
   }
+  // Returns the argument annotated with @shardKey, or nullptr if there is
+  // none.  Routers broadcast calls to methods without a shard key.
+  const AidlArgument* GetShardKeyArgument() const;
+  // True if any out parameter is annotated with @skippable, in which case
+  // callers send a mask of the @skippable parameters they want back.
+  bool HasSkippableArguments() const;
+  // The bit for |arg| in that mask, which is its position in the
+  // parameter list, or 0 if it is too far down the list to have one.
+  uint32_t GetOutMaskBit(const AidlArgument& arg) const;
+  // True if calls to this method can be part of a call chain: they must
+  // have a reply and no out parameters.
+  bool CanBeChained() const { return !oneway_ && out_arguments_.empty(); }
 
  private:
   bool oneway_;
@@ -290,9 +386,21 @@ class AidlInterface : public AidlNode {
       { return methods_; }
   const std::vector<std::unique_ptr<AidlConstant>>& GetConstants() const
       { return constants_; }
+  const std::vector<std::unique_ptr<AidlEnum>>& GetEnums() const
+      { return enums_; }
   std::string GetPackage() const;
   std::string GetCanonicalName() const;
   const std::vector<std::string>& GetSplitPackage() const { return package_; }
+  // True if any method of this interface has a @shardKey argument, in which
+  // case we generate a router in addition to the usual classes.
+  bool IsSharded() const;
+  // True for interfaces annotated with @chainable, which accept call chains:
+  // several calls sent in one transaction.
+  bool IsChainable() const { return chainable_; }
+  void SetChainable() { chainable_ = true; }
+  // True if any method's return type is annotated with @mirrored, in which
+  // case clients may read its result from shared memory.
+  bool HasMirroredMethods() const;
 
   void SetLanguageType(const android::aidl::ValidatableType* language_type) {
     language_type_ = language_type;
@@ -308,8 +416,10 @@ class AidlInterface : public AidlNode {
   std::string comments_;
   unsigned line_;
   bool oneway_;
+  bool chainable_ = false;
   std::vector<std::unique_ptr<AidlMethod>> methods_;
   std::vector<std::unique_ptr<AidlConstant>> constants_;
+  std::vector<std::unique_ptr<AidlEnum>> enums_;
   std::vector<std::string> package_;
 
   const android::aidl::ValidatableType* language_type_ = nullptr;
@@ -341,7 +451,17 @@ class AidlImport : public AidlNode {
 
 class Parser {
  public:
+  enum Implementation {
+    // The flex scanner and bison grammar in aidl_language_[ly].
+    BISON,
+    // The hand-written parser in aidl_language_rd.
+    RECURSIVE_DESCENT,
+  };
+
+  // Uses the implementation picked at build time.
   explicit Parser(const android::aidl::IoDelegate& io_delegate);
+  Parser(const android::aidl::IoDelegate& io_delegate,
+         Implementation implementation);
   ~Parser();
 
   // Parse contents of file |filename|.
@@ -349,6 +469,25 @@ class Parser {
 
   void ReportError(const std::string& err, unsigned line);
 
+  // Makes a constant of the type named |type_name| from |value|, a token
+  // as written, reporting an error if it doesn't fit the type.
+  AidlConstant* NewConstant(const std::string& type_name,
+                            const std::string& name, const std::string& value,
+                            unsigned line);
+  // Makes an enum backed by the type named |backing_type| from the
+  // |enumerators| as written: names, and values as NewConstant() takes
+  // them, or empty strings for values one more than the one before.
+  AidlEnum* NewEnum(
+      const std::string& name, const std::string& backing_type,
+      const std::vector<std::pair<std::string, std::string>>& enumerators,
+      unsigned line);
+  // Returns |value| as written after a method, reporting an error if it
+  // doesn't fit a method id.
+  int NewMethodId(int64_t value, unsigned line);
+  // Parses an integer token the way both scanners do, reporting an error if
+  // it doesn't fit a long.
+  int64_t ParseIntValue(const char* text, unsigned line);
+
   bool FoundNoErrors() const { return error_ == 0; }
   const std::string& FileName() const { return filename_; }
   void* Scanner() const { return scanner_; }
@@ -371,8 +510,16 @@ class Parser {
       imports_.clear();
   }
 
+  // Set when an error message quoted a token that bison's error recovery
+  // takes from whichever token last had a value, which the grammar may have
+  // freed by then.  bison's message for the same input is then undefined.
+  void SetQuotedStaleValue() { quoted_stale_value_ = true; }
+  bool QuotedStaleValue() const { return quoted_stale_value_; }
+
  private:
   const android::aidl::IoDelegate& io_delegate_;
+  const Implementation implementation_;
+  bool quoted_stale_value_ = false;
   int error_ = 0;
   std::string filename_;
   std::unique_ptr<AidlQualifiedName> package_;
@@ -13,12 +13,15 @@
 %option reentrant
 %option bison-bridge
 %option bison-locations
+%option extra-type="Parser*"
 
 %x COPYING LONG_COMMENT
 
 identifier  [_a-zA-Z][_a-zA-Z0-9]*
 whitespace  ([ \t\r]+)
 intvalue    [-+]?(0|[1-9][0-9]*)
+longvalue   {intvalue}L
+floatvalue  {intvalue}\.[0-9]+([eE][-+]?[0-9]+)?f?
 
 %%
 %{
@@ -61,6 +64,7 @@ intvalue    [-+]?(0|[1-9][0-9]*)
 \]                    { return ']'; }
 \<                    { return '<'; }
 \>                    { return '>'; }
+:                     { return ':'; }
 
     /* keywords */
 parcelable            { return yy::parser::token::PARCELABLE; }
@@ -72,9 +76,17 @@ out                   { return yy::parser::token::OUT; }
 inout                 { return yy::parser::token::INOUT; }
 cpp_header            { return yy::parser::token::CPP_HEADER; }
 const                 { return yy::parser::token::CONST; }
+enum                  { return yy::parser::token::ENUM; }
 @nullable             { return yy::parser::token::ANNOTATION_NULLABLE; }
 @utf8                 { return yy::parser::token::ANNOTATION_UTF8; }
 @utf8InCpp            { return yy::parser::token::ANNOTATION_UTF8_CPP; }
+@shardKey             { return yy::parser::token::ANNOTATION_SHARD_KEY; }
+@delta                { return yy::parser::token::ANNOTATION_DELTA; }
+@reuse                { return yy::parser::token::ANNOTATION_REUSE; }
+@mirrored             { return yy::parser::token::ANNOTATION_MIRRORED; }
+@nonnull              { return yy::parser::token::ANNOTATION_NONNULL; }
+@skippable            { return yy::parser::token::ANNOTATION_SKIPPABLE; }
+@chainable            { return yy::parser::token::ANNOTATION_CHAINABLE; }
 
 interface             { yylval->token = new AidlToken("interface", extra_text);
                         return yy::parser::token::INTERFACE;
@@ -87,8 +99,13 @@ oneway                { yylval->token = new AidlToken("oneway", extra_text);
 {identifier}          { yylval->token = new AidlToken(yytext, extra_text);
                         return yy::parser::token::IDENTIFIER;
                       }
-{intvalue}            { yylval->integer = std::stoi(yytext);
+{intvalue}            { yylval->integer =
+                            yyextra->ParseIntValue(yytext, yylloc->begin.line);
                         return yy::parser::token::INTVALUE; }
+{longvalue}           { yylval->token = new AidlToken(yytext, extra_text);
+                        return yy::parser::token::LONGVALUE; }
+{floatvalue}          { yylval->token = new AidlToken(yytext, extra_text);
+                        return yy::parser::token::FLOATVALUE; }
 
     /* syntax error! */
 .                     { printf("UNKNOWN(%s)", yytext);
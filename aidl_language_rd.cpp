@@ -0,0 +1,1190 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aidl_language_rd.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "aidl_language.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+enum TokenKind {
+  kEnd,
+  // Tokens with a value that the grammar's error rules may print.
+  kIdentifier,
+  kInterface,
+  kOneway,
+  kCStr,
+  kLongValue,
+  kFloatValue,
+  // Tokens without one.
+  kIntValue,
+  kLeftParen,
+  kRightParen,
+  kComma,
+  kEquals,
+  kLeftBracket,
+  kRightBracket,
+  kLess,
+  kGreater,
+  kDot,
+  kLeftBrace,
+  kRightBrace,
+  kSemicolon,
+  kColon,
+  kIn,
+  kOut,
+  kInout,
+  kPackage,
+  kImport,
+  kParcelable,
+  kCppHeader,
+  kConst,
+  kInt,
+  kEnum,
+  kNullable,
+  kUtf8,
+  kUtf8InCpp,
+  kShardKey,
+  kDelta,
+  kReuse,
+  kMirrored,
+  kNonNull,
+  kSkippable,
+  kChainable,
+};
+
+typedef uint64_t TokenSet;
+
+constexpr TokenSet Set(TokenKind kind) { return TokenSet{1} << kind; }
+
+const TokenSet kValuedTokens =
+    Set(kIdentifier) | Set(kInterface) | Set(kOneway) | Set(kCStr) |
+    Set(kLongValue) | Set(kFloatValue);
+const TokenSet kIdentifierStart = Set(kIdentifier) | Set(kCppHeader) | Set(kInt);
+const TokenSet kConstantValueStart = kIdentifierStart | Set(kIntValue) |
+                                     Set(kLongValue) | Set(kFloatValue) |
+                                     Set(kCStr);
+const TokenSet kAnnotations = Set(kNullable) | Set(kUtf8) | Set(kUtf8InCpp) |
+                              Set(kShardKey) | Set(kDelta) | Set(kReuse) |
+                              Set(kMirrored) | Set(kNonNull) |
+                              Set(kSkippable);
+const TokenSet kTypeStart = kIdentifierStart | kAnnotations;
+const TokenSet kArgumentStart = kTypeStart | Set(kIn) | Set(kOut) | Set(kInout);
+const TokenSet kArgumentListEnd = Set(kRightParen) | Set(kComma);
+const TokenSet kMemberStart =
+    kTypeStart | Set(kOneway) | Set(kConst) | Set(kEnum);
+const TokenSet kInterfaceStart =
+    Set(kInterface) | Set(kOneway) | Set(kChainable);
+
+struct Keyword {
+  const char* text;
+  TokenKind kind;
+};
+
+const Keyword kKeywords[] = {
+  {"parcelable", kParcelable},
+  {"import", kImport},
+  {"package", kPackage},
+  {"int", kInt},
+  {"in", kIn},
+  {"out", kOut},
+  {"inout", kInout},
+  {"cpp_header", kCppHeader},
+  {"const", kConst},
+  {"enum", kEnum},
+  {"interface", kInterface},
+  {"oneway", kOneway},
+};
+
+const Keyword kAnnotationKeywords[] = {
+  {"@nullable", kNullable},
+  {"@utf8", kUtf8},
+  {"@utf8InCpp", kUtf8InCpp},
+  {"@shardKey", kShardKey},
+  {"@delta", kDelta},
+  {"@reuse", kReuse},
+  {"@mirrored", kMirrored},
+  {"@nonnull", kNonNull},
+  {"@skippable", kSkippable},
+  {"@chainable", kChainable},
+};
+
+const char kSymbols[] = ";{}=,.()[]<>:";
+const TokenKind kSymbolKinds[] = {
+  kSemicolon, kLeftBrace, kRightBrace, kEquals, kComma, kDot,
+  kLeftParen, kRightParen, kLeftBracket, kRightBracket, kLess, kGreater,
+  kColon,
+};
+
+AidlType::Annotation AnnotationFor(TokenKind kind) {
+  switch (kind) {
+    case kNullable: return AidlType::AnnotationNullable;
+    case kUtf8: return AidlType::AnnotationUtf8;
+    case kUtf8InCpp: return AidlType::AnnotationUtf8InCpp;
+    case kShardKey: return AidlType::AnnotationShardKey;
+    case kDelta: return AidlType::AnnotationDelta;
+    case kReuse: return AidlType::AnnotationReuse;
+    case kMirrored: return AidlType::AnnotationMirrored;
+    case kNonNull: return AidlType::AnnotationNonNull;
+    default: return AidlType::AnnotationSkippable;
+  }
+}
+
+bool IsIdentifierStart(char c) {
+  return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsIdentifierPart(char c) { return IsIdentifierStart(c) || IsDigit(c); }
+
+struct Token {
+  TokenKind kind = kEnd;
+  // Points into the buffer being parsed.
+  const char* text = "";
+  size_t length = 0;
+  // Comments and %%{ }%% blocks before the token if it has a value, like
+  // AidlToken::GetComments().
+  string comments;
+  unsigned line = 0;
+  // Set by the parser, which reports values that don't fit.
+  int64_t integer = 0;
+
+  string Text() const { return string(text, length); }
+};
+
+// Splits the buffer into tokens the way the flex scanner does, including
+// which comments end up on which token and which line each token is
+// reported on.
+class Lexer {
+ public:
+  explicit Lexer(const string& buffer)
+      : pos_(buffer.data()), end_(buffer.data() + buffer.size()) {}
+
+  void Lex(Token* token);
+
+ private:
+  bool LookingAt(const char* text) const {
+    const size_t length = strlen(text);
+    return static_cast<size_t>(end_ - pos_) >= length &&
+           memcmp(pos_, text, length) == 0;
+  }
+  void Emit(TokenKind kind, const char* start, Token* token) const;
+  void SkipCopyBlock(string* comments);
+  void SkipLongComment(string* comments);
+
+  const char* pos_;
+  const char* const end_;
+  // The lines that flex's yylloc begins and ends on.  The scanner only moves
+  // the beginning forward at newlines and at the end of comments.
+  unsigned line_ = 1;
+  unsigned begin_line_ = 1;
+
+  DISALLOW_COPY_AND_ASSIGN(Lexer);
+};
+
+void Lexer::Emit(TokenKind kind, const char* start, Token* token) const {
+  token->kind = kind;
+  token->text = start;
+  token->length = pos_ - start;
+  token->line = begin_line_;
+  if ((Set(kind) & kValuedTokens) == 0) {
+    token->comments.clear();
+  }
+}
+
+void Lexer::Lex(Token* token) {
+  string* comments = &token->comments;
+  comments->clear();
+  begin_line_ = line_;
+  while (pos_ < end_) {
+    const char* start = pos_;
+    const char c = *pos_;
+    if (LookingAt("%%{")) {
+      pos_ += 3;
+      comments->append("/**");
+      SkipCopyBlock(comments);
+      continue;
+    }
+    if (LookingAt("/*")) {
+      pos_ += 2;
+      comments->append("/*");
+      SkipLongComment(comments);
+      continue;
+    }
+    if (c == '"') {
+      const void* quote = memchr(pos_ + 1, '"', end_ - pos_ - 1);
+      if (quote != nullptr) {
+        // Like flex, don't count the lines inside strings.
+        pos_ = static_cast<const char*>(quote) + 1;
+        Emit(kCStr, start, token);
+        return;
+      }
+    }
+    if (LookingAt("//")) {
+      const void* newline = memchr(pos_, '\n', end_ - pos_);
+      if (newline != nullptr) {
+        pos_ = static_cast<const char*>(newline) + 1;
+        comments->append(start, pos_);
+        begin_line_ = ++line_;
+        continue;
+      }
+    }
+    if (c == '\n') {
+      while (pos_ < end_ && *pos_ == '\n') {
+        ++pos_;
+        ++line_;
+      }
+      begin_line_ = line_;
+      continue;
+    }
+    if (c == ' ' || c == '\t' || c == '\r') {
+      ++pos_;
+      continue;
+    }
+
+    const char* symbol = strchr(kSymbols, c);
+    if (c != '\0' && symbol != nullptr) {
+      ++pos_;
+      Emit(kSymbolKinds[symbol - kSymbols], start, token);
+      return;
+    }
+
+    if (IsIdentifierStart(c)) {
+      while (pos_ < end_ && IsIdentifierPart(*pos_)) {
+        ++pos_;
+      }
+      const size_t length = pos_ - start;
+      TokenKind kind = kIdentifier;
+      for (const Keyword& keyword : kKeywords) {
+        if (strlen(keyword.text) == length &&
+            memcmp(keyword.text, start, length) == 0) {
+          kind = keyword.kind;
+          break;
+        }
+      }
+      Emit(kind, start, token);
+      return;
+    }
+
+    if (c == '@') {
+      // flex takes the longest annotation that matches, and @utf8 is a
+      // prefix of @utf8InCpp.
+      const Keyword* longest = nullptr;
+      for (const Keyword& keyword : kAnnotationKeywords) {
+        if (LookingAt(keyword.text) &&
+            (longest == nullptr ||
+             strlen(keyword.text) > strlen(longest->text))) {
+          longest = &keyword;
+        }
+      }
+      if (longest != nullptr) {
+        pos_ += strlen(longest->text);
+        Emit(longest->kind, start, token);
+        return;
+      }
+    }
+
+    if (IsDigit(c) || ((c == '-' || c == '+') && end_ - pos_ > 1 &&
+                       IsDigit(pos_[1]))) {
+      if (!IsDigit(c)) {
+        ++pos_;
+      }
+      if (*pos_++ != '0') {
+        while (pos_ < end_ && IsDigit(*pos_)) {
+          ++pos_;
+        }
+      }
+      if (pos_ < end_ && *pos_ == 'L') {
+        ++pos_;
+        Emit(kLongValue, start, token);
+        return;
+      }
+      if (end_ - pos_ > 1 && *pos_ == '.' && IsDigit(pos_[1])) {
+        pos_ += 2;
+        while (pos_ < end_ && IsDigit(*pos_)) {
+          ++pos_;
+        }
+        // Like flex, only take an exponent that has digits.
+        const char* exponent = pos_;
+        if (exponent < end_ && (*exponent == 'e' || *exponent == 'E')) {
+          ++exponent;
+          if (exponent < end_ && (*exponent == '-' || *exponent == '+')) {
+            ++exponent;
+          }
+          if (exponent < end_ && IsDigit(*exponent)) {
+            while (exponent < end_ && IsDigit(*exponent)) {
+              ++exponent;
+            }
+            pos_ = exponent;
+          }
+        }
+        if (pos_ < end_ && *pos_ == 'f') {
+          ++pos_;
+        }
+        Emit(kFloatValue, start, token);
+        return;
+      }
+      Emit(kIntValue, start, token);
+      return;
+    }
+
+    // The scanner hands anything else to the grammar as an identifier.
+    ++pos_;
+    printf("UNKNOWN(%.*s)", 1, start);
+    Emit(kIdentifier, start, token);
+    return;
+  }
+  Emit(kEnd, pos_, token);
+}
+
+void Lexer::SkipCopyBlock(string* comments) {
+  while (pos_ < end_) {
+    const char* start = pos_;
+    if (*pos_ == '\n') {
+      while (pos_ < end_ && *pos_ == '\n') {
+        ++pos_;
+        ++line_;
+      }
+      comments->append(start, pos_);
+      continue;
+    }
+    const void* newline = memchr(pos_, '\n', end_ - pos_);
+    const char* line_end =
+        newline ? static_cast<const char*>(newline) : end_;
+    // flex prefers the rule copying the rest of the line when it is longer,
+    // so "}%%" only closes the block when nothing follows it on its line.
+    if (line_end - pos_ == 3 && LookingAt("}%%")) {
+      pos_ += 3;
+      comments->append("**/");
+      begin_line_ = line_;
+      return;
+    }
+    comments->append(pos_, line_end);
+    pos_ = line_end;
+  }
+}
+
+void Lexer::SkipLongComment(string* comments) {
+  while (pos_ < end_) {
+    const char* start = pos_;
+    if (*pos_ == '*') {
+      while (pos_ < end_ && *pos_ == '*') {
+        ++pos_;
+      }
+      if (pos_ < end_ && *pos_ == '/') {
+        ++pos_;
+        comments->append(start, pos_);
+        begin_line_ = line_;
+        return;
+      }
+    } else if (*pos_ == '\n') {
+      while (pos_ < end_ && *pos_ == '\n') {
+        ++pos_;
+        ++line_;
+      }
+    } else {
+      while (pos_ < end_ && *pos_ != '*' && *pos_ != '\n') {
+        ++pos_;
+      }
+    }
+    comments->append(start, pos_);
+  }
+}
+
+// Parses the grammar in aidl_language_y.yy.  Functions named after a
+// nonterminal return true once they have built it.  They return false when
+// they hit a syntax error that they can't recover from, after which their
+// caller either recovers like the matching error rule of the grammar or
+// returns false itself.
+//
+// bison detects errors in the same places: it only consults the lookahead in
+// states without a default reduction, and those are the places we check it.
+// When it finds an error it reports it unless it is still recovering from
+// another, then pops its stack to the nearest state that can shift the
+// error token.  That state is the closest caller with an error rule.  Until
+// it shifts three more tokens, later errors in a state only discard
+// lookahead tokens until one that the state accepts.
+class RecursiveDescentParser {
+ public:
+  RecursiveDescentParser(const string& buffer, Parser* ps)
+      : lexer_(buffer), ps_(ps) {}
+
+  bool ParseDocument();
+
+ private:
+  enum Recovery {
+    // Tokens were discarded until one that the state accepts.
+    kRetry,
+    // Pop to the closest caller with an error rule.
+    kPop,
+    // The end of the input was reached while discarding tokens.
+    kAbort,
+  };
+
+  const Token& Peek();
+  // Consumes the lookahead, moving it into |token| if it is not null.
+  void Shift(Token* token);
+  // Handles a lookahead that the current state does not accept.
+  // |accepted| lists the tokens that it does.
+  Recovery SyntaxError(TokenSet accepted);
+  // Called by error rules that caught an error.
+  void ShiftError() { error_state_ = 3; }
+  // The value bison gave the error token of the last error rule that
+  // caught an error.
+  const char* ErrorValue();
+
+  bool Expect(TokenKind kind, Token* token);
+  bool ExpectIdentifier(Token* token);
+
+  bool ParsePackage();
+  bool ParseImport();
+  bool ParseQualifiedNameAndSemicolon(unique_ptr<AidlQualifiedName>* name);
+  bool ParseParcelableDecls();
+  bool ParseParcelableDecl(AidlDocument* document);
+  bool ParseParcelableName(AidlDocument* document);
+  bool ParseInterfaceDecl(unique_ptr<AidlInterface>* interface);
+  bool ParseMembers(vector<unique_ptr<AidlMember>>* members);
+  bool ParseConstantDecl(vector<unique_ptr<AidlMember>>* members);
+  bool ParseEnumDecl(vector<unique_ptr<AidlMember>>* members);
+  // Returns the text of a constant_value, shifting it.
+  bool ParseConstantValue(string* text);
+  bool ParseMethodDecl(vector<unique_ptr<AidlMember>>* members);
+  bool ParseFirstArg(vector<unique_ptr<AidlArgument>>* args);
+  bool ParseArgList(vector<unique_ptr<AidlArgument>>* args);
+  bool ParseMethodEnd(bool* has_id, int* id);
+  bool ParseArg(vector<unique_ptr<AidlArgument>>* args);
+  bool ParseType(unique_ptr<AidlType>* type);
+  bool ParseTypeName(string* name);
+
+  Lexer lexer_;
+  Parser* const ps_;
+  Token lookahead_;
+  bool have_lookahead_ = false;
+  // bison's yylval: the text of the last token the scanner gave a value.
+  const char* value_text_ = "";
+  size_t value_length_ = 0;
+  // yyerrState.
+  int error_state_ = 0;
+  string error_value_;
+  bool error_value_is_stale_ = false;
+  bool aborted_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(RecursiveDescentParser);
+};
+
+const Token& RecursiveDescentParser::Peek() {
+  if (!have_lookahead_) {
+    lexer_.Lex(&lookahead_);
+    have_lookahead_ = true;
+    if (lookahead_.kind == kIntValue) {
+      // As the flex scanner does, as soon as it scans the token.
+      lookahead_.integer =
+          ps_->ParseIntValue(lookahead_.Text().c_str(), lookahead_.line);
+    }
+    if ((Set(lookahead_.kind) & kValuedTokens) ||
+        lookahead_.kind == kIntValue) {
+      value_text_ = lookahead_.text;
+      value_length_ = lookahead_.length;
+    }
+  }
+  return lookahead_;
+}
+
+void RecursiveDescentParser::Shift(Token* token) {
+  if (token != nullptr) {
+    std::swap(*token, lookahead_);
+  }
+  have_lookahead_ = false;
+  if (error_state_ > 0) {
+    --error_state_;
+  }
+}
+
+RecursiveDescentParser::Recovery RecursiveDescentParser::SyntaxError(
+    TokenSet accepted) {
+  if (error_state_ == 0) {
+    ps_->ReportError("syntax error", Peek().line);
+  }
+  if (error_state_ < 3) {
+    // bison gives the error token whatever is in yylval.  Tokens without a
+    // value leave the previous one there, and the grammar may have freed
+    // it since.
+    error_value_.assign(value_text_, value_length_);
+    error_value_is_stale_ = (Set(Peek().kind) & kValuedTokens) == 0;
+    return kPop;
+  }
+  while (Peek().kind != kEnd) {
+    have_lookahead_ = false;
+    if (accepted & Set(Peek().kind)) {
+      return kRetry;
+    }
+  }
+  aborted_ = true;
+  return kAbort;
+}
+
+const char* RecursiveDescentParser::ErrorValue() {
+  if (error_value_is_stale_) {
+    ps_->SetQuotedStaleValue();
+  }
+  return error_value_.c_str();
+}
+
+bool RecursiveDescentParser::Expect(TokenKind kind, Token* token) {
+  while (Peek().kind != kind) {
+    if (SyntaxError(Set(kind)) != kRetry) {
+      return false;
+    }
+  }
+  Shift(token);
+  return true;
+}
+
+bool RecursiveDescentParser::ExpectIdentifier(Token* token) {
+  while ((Set(Peek().kind) & kIdentifierStart) == 0) {
+    if (SyntaxError(kIdentifierStart) != kRetry) {
+      return false;
+    }
+  }
+  Shift(token);
+  return true;
+}
+
+bool RecursiveDescentParser::ParseDocument() {
+  if (Peek().kind == kPackage && !ParsePackage()) {
+    return false;
+  }
+  while (Peek().kind == kImport) {
+    if (!ParseImport()) {
+      return false;
+    }
+  }
+  if ((Set(Peek().kind) & kInterfaceStart) == 0) {
+    return ParseParcelableDecls();
+  }
+
+  unique_ptr<AidlInterface> interface;
+  if (!ParseInterfaceDecl(&interface)) {
+    return false;
+  }
+  ps_->SetDocument(new AidlDocument(interface.release()));
+  while (Peek().kind != kEnd) {
+    if (SyntaxError(Set(kEnd)) != kRetry) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RecursiveDescentParser::ParsePackage() {
+  Shift(nullptr);
+  unique_ptr<AidlQualifiedName> name;
+  if (!ParseQualifiedNameAndSemicolon(&name)) {
+    return false;
+  }
+  ps_->SetPackage(name.release());
+  return true;
+}
+
+bool RecursiveDescentParser::ParseImport() {
+  Token keyword;
+  Shift(&keyword);
+  unique_ptr<AidlQualifiedName> name;
+  if (!ParseQualifiedNameAndSemicolon(&name)) {
+    return false;
+  }
+  ps_->AddImport(name.release(), keyword.line);
+  return true;
+}
+
+bool RecursiveDescentParser::ParseQualifiedNameAndSemicolon(
+    unique_ptr<AidlQualifiedName>* name) {
+  Token term;
+  if (!ExpectIdentifier(&term)) {
+    return false;
+  }
+  name->reset(new AidlQualifiedName(term.Text(), term.comments));
+  while (true) {
+    if (Peek().kind == kDot) {
+      Shift(nullptr);
+      if (!ExpectIdentifier(&term)) {
+        return false;
+      }
+      (*name)->AddTerm(term.Text());
+      continue;
+    }
+    if (Peek().kind == kSemicolon) {
+      Shift(nullptr);
+      return true;
+    }
+    if (SyntaxError(Set(kDot) | Set(kSemicolon)) != kRetry) {
+      return false;
+    }
+  }
+}
+
+bool RecursiveDescentParser::ParseParcelableDecls() {
+  unique_ptr<AidlDocument> document(new AidlDocument());
+  while (true) {
+    if (Peek().kind == kEnd) {
+      ps_->SetDocument(document.release());
+      return true;
+    }
+    if (Peek().kind == kParcelable) {
+      if (!ParseParcelableDecl(document.get())) {
+        return false;
+      }
+      continue;
+    }
+    Recovery recovery = SyntaxError(Set(kEnd) | Set(kParcelable));
+    if (recovery == kRetry) {
+      continue;
+    }
+    if (recovery == kAbort) {
+      return false;
+    }
+    // parcelable_decls: parcelable_decls error
+    ShiftError();
+    fprintf(stderr, "%s:%d: syntax error don't know what to do with \"%s\"\n",
+            ps_->FileName().c_str(), Peek().line, ErrorValue());
+  }
+}
+
+bool RecursiveDescentParser::ParseParcelableDecl(AidlDocument* document) {
+  Token keyword;
+  Shift(&keyword);
+  // bison reports errors caught by "PARCELABLE error ';'" at the token after
+  // the keyword.
+  const unsigned error_line = Peek().line;
+  bool success = false;
+  while (true) {
+    if (Peek().kind == kSemicolon) {
+      Shift(nullptr);
+      fprintf(stderr, "%s:%d syntax error in parcelable declaration. "
+                      "Expected type name.\n",
+              ps_->FileName().c_str(), keyword.line);
+      document->AddParcelable(nullptr);
+      return true;
+    }
+    if (Set(Peek().kind) & kIdentifierStart) {
+      success = ParseParcelableName(document);
+      break;
+    }
+    if (SyntaxError(kIdentifierStart | Set(kSemicolon)) != kRetry) {
+      break;
+    }
+  }
+  if (success || aborted_) {
+    return success;
+  }
+
+  // parcelable_decl: PARCELABLE error ';'
+  ShiftError();
+  if (!Expect(kSemicolon, nullptr)) {
+    return false;
+  }
+  fprintf(stderr, "%s:%d syntax error in parcelable declaration. "
+                  "Expected type name, saw \"%s\".\n",
+          ps_->FileName().c_str(), error_line, ErrorValue());
+  document->AddParcelable(nullptr);
+  return true;
+}
+
+bool RecursiveDescentParser::ParseParcelableName(AidlDocument* document) {
+  Token first;
+  Shift(&first);
+  unique_ptr<AidlQualifiedName> name(
+      new AidlQualifiedName(first.Text(), first.comments));
+  while (true) {
+    if (Peek().kind == kDot) {
+      Shift(nullptr);
+      Token term;
+      if (!ExpectIdentifier(&term)) {
+        return false;
+      }
+      name->AddTerm(term.Text());
+      continue;
+    }
+    if (Peek().kind == kSemicolon) {
+      Shift(nullptr);
+      document->AddParcelable(
+          new AidlParcelable(name.release(), first.line, ps_->Package()));
+      return true;
+    }
+    if (Peek().kind == kCppHeader) {
+      Shift(nullptr);
+      Token header;
+      if (!Expect(kCStr, &header) || !Expect(kSemicolon, nullptr)) {
+        return false;
+      }
+      document->AddParcelable(new AidlParcelable(
+          name.release(), first.line, ps_->Package(), header.Text()));
+      return true;
+    }
+    if (SyntaxError(Set(kDot) | Set(kSemicolon) | Set(kCppHeader)) !=
+        kRetry) {
+      return false;
+    }
+  }
+}
+
+bool RecursiveDescentParser::ParseInterfaceDecl(
+    unique_ptr<AidlInterface>* interface) {
+  unique_ptr<vector<unique_ptr<AidlMember>>> members(
+      new vector<unique_ptr<AidlMember>>());
+  Token name;
+
+  if (Peek().kind == kChainable) {
+    Shift(nullptr);
+    while ((Set(Peek().kind) & kInterfaceStart) == 0) {
+      if (SyntaxError(kInterfaceStart) != kRetry) {
+        return false;
+      }
+    }
+    if (!ParseInterfaceDecl(interface)) {
+      return false;
+    }
+    if (*interface) {
+      (*interface)->SetChainable();
+    }
+    return true;
+  }
+
+  if (Peek().kind == kOneway) {
+    Token oneway;
+    Shift(&oneway);
+    if (!Expect(kInterface, nullptr) || !ExpectIdentifier(&name) ||
+        !Expect(kLeftBrace, nullptr) || !ParseMembers(members.get())) {
+      return false;
+    }
+    Shift(nullptr);
+    interface->reset(new AidlInterface(name.Text(), name.line,
+                                       oneway.comments, true,
+                                       members.release(), ps_->Package()));
+    return true;
+  }
+
+  Token keyword;
+  Shift(&keyword);
+  // bison reports errors caught by "INTERFACE error" at the token after the
+  // keyword.
+  const unsigned error_line = Peek().line;
+  if (ExpectIdentifier(&name) && Expect(kLeftBrace, nullptr)) {
+    if (!ParseMembers(members.get())) {
+      return false;
+    }
+    Shift(nullptr);
+    interface->reset(new AidlInterface(name.Text(), name.line,
+                                       keyword.comments, false,
+                                       members.release(), ps_->Package()));
+    return true;
+  }
+  if (aborted_) {
+    return false;
+  }
+
+  // interface_decl: INTERFACE error '{' members '}' | INTERFACE error '}'
+  ShiftError();
+  // The rule quotes the error token once it is reduced, after any errors
+  // in the members have been reported.
+  const string error_value = error_value_;
+  const bool error_value_is_stale = error_value_is_stale_;
+  while (true) {
+    if (Peek().kind == kLeftBrace) {
+      Shift(nullptr);
+      if (!ParseMembers(members.get())) {
+        return false;
+      }
+      Shift(nullptr);
+      break;
+    }
+    if (Peek().kind == kRightBrace) {
+      Shift(nullptr);
+      break;
+    }
+    if (SyntaxError(Set(kLeftBrace) | Set(kRightBrace)) != kRetry) {
+      return false;
+    }
+  }
+  if (error_value_is_stale) {
+    ps_->SetQuotedStaleValue();
+  }
+  fprintf(stderr, "%s:%d: syntax error in interface declaration.  "
+                  "Expected type name, saw \"%s\"\n",
+          ps_->FileName().c_str(), error_line, error_value.c_str());
+  interface->reset();
+  return true;
+}
+
+// Leaves the closing brace as the lookahead.
+bool RecursiveDescentParser::ParseMembers(
+    vector<unique_ptr<AidlMember>>* members) {
+  while (true) {
+    bool success;
+    const TokenSet lookahead = Set(Peek().kind);
+    if (lookahead & Set(kRightBrace)) {
+      return true;
+    } else if (lookahead & Set(kConst)) {
+      success = ParseConstantDecl(members);
+    } else if (lookahead & Set(kEnum)) {
+      success = ParseEnumDecl(members);
+    } else if (lookahead & kMemberStart) {
+      success = ParseMethodDecl(members);
+    } else {
+      Recovery recovery = SyntaxError(kMemberStart | Set(kRightBrace));
+      if (recovery == kRetry) {
+        continue;
+      }
+      success = false;
+    }
+    if (success) {
+      continue;
+    }
+    if (aborted_) {
+      return false;
+    }
+
+    // members: members error ';'
+    ShiftError();
+    Token semicolon;
+    if (!Expect(kSemicolon, &semicolon)) {
+      return false;
+    }
+    fprintf(stderr, "%s:%d: syntax error before ';' "
+                    "(expected method or constant declaration)\n",
+            ps_->FileName().c_str(), semicolon.line);
+  }
+}
+
+bool RecursiveDescentParser::ParseConstantDecl(
+    vector<unique_ptr<AidlMember>>* members) {
+  Shift(nullptr);
+  Token type;
+  Token name;
+  string value_text;
+  if (!ExpectIdentifier(&type) || !ExpectIdentifier(&name) ||
+      !Expect(kEquals, nullptr) || !ParseConstantValue(&value_text) ||
+      !Expect(kSemicolon, nullptr)) {
+    return false;
+  }
+  members->emplace_back(ps_->NewConstant(type.Text(), name.Text(), value_text,
+                                         name.line));
+  return true;
+}
+
+bool RecursiveDescentParser::ParseEnumDecl(
+    vector<unique_ptr<AidlMember>>* members) {
+  Shift(nullptr);
+  Token name;
+  Token backing_type;
+  if (!ExpectIdentifier(&name) || !Expect(kColon, nullptr) ||
+      !ExpectIdentifier(&backing_type) || !Expect(kLeftBrace, nullptr)) {
+    return false;
+  }
+  std::vector<std::pair<string, string>> enumerators;
+  while (true) {
+    Token enumerator;
+    string value_text;
+    if (!ExpectIdentifier(&enumerator)) {
+      return false;
+    }
+    if (Peek().kind == kEquals) {
+      Shift(nullptr);
+      if (!ParseConstantValue(&value_text)) {
+        return false;
+      }
+    }
+    enumerators.emplace_back(enumerator.Text(), value_text);
+    while (Peek().kind != kComma && Peek().kind != kRightBrace) {
+      if (SyntaxError(Set(kComma) | Set(kRightBrace)) != kRetry) {
+        return false;
+      }
+    }
+    const bool more = Peek().kind == kComma;
+    Shift(nullptr);
+    if (!more) {
+      break;
+    }
+  }
+  members->emplace_back(ps_->NewEnum(name.Text(), backing_type.Text(),
+                                     enumerators, name.line));
+  return true;
+}
+
+bool RecursiveDescentParser::ParseConstantValue(string* text) {
+  while ((Set(Peek().kind) & kConstantValueStart) == 0) {
+    if (SyntaxError(kConstantValueStart) != kRetry) {
+      return false;
+    }
+  }
+  Token value;
+  Shift(&value);
+  // The grammar hands integers over as the int the scanner made of them.
+  *text = (value.kind == kIntValue) ? std::to_string(value.integer)
+                                    : value.Text();
+  return true;
+}
+
+bool RecursiveDescentParser::ParseMethodDecl(
+    vector<unique_ptr<AidlMember>>* members) {
+  Token oneway;
+  const bool is_oneway = Peek().kind == kOneway;
+  if (is_oneway) {
+    Shift(&oneway);
+    while ((Set(Peek().kind) & kTypeStart) == 0) {
+      if (SyntaxError(kTypeStart) != kRetry) {
+        return false;
+      }
+    }
+  }
+  unique_ptr<AidlType> type;
+  Token name;
+  Token paren;
+  if (!ParseType(&type) || !ExpectIdentifier(&name) ||
+      !Expect(kLeftParen, &paren)) {
+    return false;
+  }
+
+  // "arg_list: error" catches every error from here to the end of the
+  // method.  bison reports them where the argument list starts: at the
+  // parenthesis when the list is empty, or else at the token after it.
+  const unsigned args_line =
+      (Set(Peek().kind) & kArgumentListEnd) ? paren.line : Peek().line;
+  unique_ptr<vector<unique_ptr<AidlArgument>>> args(
+      new vector<unique_ptr<AidlArgument>>());
+  bool has_id = false;
+  int id = 0;
+  bool success = ParseFirstArg(args.get()) && ParseArgList(args.get()) &&
+                 ParseMethodEnd(&has_id, &id);
+  while (!success) {
+    if (aborted_) {
+      return false;
+    }
+    ShiftError();
+    fprintf(stderr, "%s:%d: syntax error in parameter list\n",
+            ps_->FileName().c_str(), args_line);
+    args->clear();
+    success = ParseArgList(args.get()) && ParseMethodEnd(&has_id, &id);
+  }
+
+  const string& comments = is_oneway ? oneway.comments : type->GetComments();
+  AidlMethod* method;
+  if (has_id) {
+    method = new AidlMethod(is_oneway, type.get(), name.Text(),
+                            args.release(), name.line, comments, id);
+  } else {
+    method = new AidlMethod(is_oneway, type.get(), name.Text(),
+                            args.release(), name.line, comments);
+  }
+  type.release();
+  members->emplace_back(method);
+  return true;
+}
+
+bool RecursiveDescentParser::ParseFirstArg(
+    vector<unique_ptr<AidlArgument>>* args) {
+  while (true) {
+    const TokenSet lookahead = Set(Peek().kind);
+    if (lookahead & kArgumentListEnd) {
+      return true;
+    }
+    if (lookahead & kArgumentStart) {
+      return ParseArg(args);
+    }
+    if (SyntaxError(kArgumentStart | kArgumentListEnd) != kRetry) {
+      return false;
+    }
+  }
+}
+
+// Leaves the closing parenthesis as the lookahead.
+bool RecursiveDescentParser::ParseArgList(
+    vector<unique_ptr<AidlArgument>>* args) {
+  while (true) {
+    if (Peek().kind == kRightParen) {
+      return true;
+    }
+    if (Peek().kind == kComma) {
+      Shift(nullptr);
+      while ((Set(Peek().kind) & kArgumentStart) == 0) {
+        if (SyntaxError(kArgumentStart) != kRetry) {
+          return false;
+        }
+      }
+      if (!ParseArg(args)) {
+        return false;
+      }
+      continue;
+    }
+    if (SyntaxError(kArgumentListEnd) != kRetry) {
+      return false;
+    }
+  }
+}
+
+bool RecursiveDescentParser::ParseMethodEnd(bool* has_id, int* id) {
+  Shift(nullptr);
+  while (true) {
+    if (Peek().kind == kSemicolon) {
+      Shift(nullptr);
+      *has_id = false;
+      return true;
+    }
+    if (Peek().kind == kEquals) {
+      Shift(nullptr);
+      Token value;
+      if (!Expect(kIntValue, &value) || !Expect(kSemicolon, nullptr)) {
+        return false;
+      }
+      *has_id = true;
+      *id = ps_->NewMethodId(value.integer, value.line);
+      return true;
+    }
+    if (SyntaxError(Set(kSemicolon) | Set(kEquals)) != kRetry) {
+      return false;
+    }
+  }
+}
+
+bool RecursiveDescentParser::ParseArg(vector<unique_ptr<AidlArgument>>* args) {
+  AidlArgument::Direction direction = AidlArgument::IN_DIR;
+  bool has_direction = true;
+  switch (Peek().kind) {
+    case kIn: direction = AidlArgument::IN_DIR; break;
+    case kOut: direction = AidlArgument::OUT_DIR; break;
+    case kInout: direction = AidlArgument::INOUT_DIR; break;
+    default: has_direction = false; break;
+  }
+  if (has_direction) {
+    Shift(nullptr);
+    while ((Set(Peek().kind) & kTypeStart) == 0) {
+      if (SyntaxError(kTypeStart) != kRetry) {
+        return false;
+      }
+    }
+  }
+  unique_ptr<AidlType> type;
+  Token name;
+  if (!ParseType(&type) || !ExpectIdentifier(&name)) {
+    return false;
+  }
+  if (has_direction) {
+    args->emplace_back(new AidlArgument(direction, type.release(),
+                                        name.Text(), name.line));
+  } else {
+    args->emplace_back(new AidlArgument(type.release(), name.Text(),
+                                        name.line));
+  }
+  return true;
+}
+
+// The lookahead must be able to start a type.
+bool RecursiveDescentParser::ParseType(unique_ptr<AidlType>* type) {
+  uint32_t annotations = 0;
+  bool annotated = false;
+  while ((Set(Peek().kind) & kIdentifierStart) == 0) {
+    if (Set(Peek().kind) & kAnnotations) {
+      annotations |= AnnotationFor(Peek().kind);
+      annotated = true;
+      Shift(nullptr);
+      continue;
+    }
+    if (SyntaxError(kTypeStart) != kRetry) {
+      return false;
+    }
+  }
+
+  Token first;
+  Shift(&first);
+  string name = first.Text();
+  if (!ParseTypeName(&name)) {
+    return false;
+  }
+  bool is_array = false;
+  if (Peek().kind == kLeftBracket) {
+    Shift(nullptr);
+    if (!Expect(kRightBracket, nullptr)) {
+      return false;
+    }
+    is_array = true;
+  } else if (Peek().kind == kLess) {
+    Shift(nullptr);
+    name += '<';
+    while (true) {
+      Token term;
+      if (!ExpectIdentifier(&term)) {
+        return false;
+      }
+      name.append(term.text, term.length);
+      if (!ParseTypeName(&name)) {
+        return false;
+      }
+      while (Peek().kind != kComma && Peek().kind != kGreater) {
+        if (SyntaxError(Set(kComma) | Set(kGreater)) != kRetry) {
+          return false;
+        }
+      }
+      const bool more = Peek().kind == kComma;
+      Shift(nullptr);
+      if (!more) {
+        break;
+      }
+      name += ',';
+    }
+    name += '>';
+  }
+
+  type->reset(new AidlType(name, first.line, first.comments, is_array));
+  if (annotated) {
+    (*type)->Annotate(static_cast<AidlType::Annotation>(annotations));
+  }
+  return true;
+}
+
+// Appends the rest of a qualified name to |name|.
+bool RecursiveDescentParser::ParseTypeName(string* name) {
+  while (Peek().kind == kDot) {
+    Shift(nullptr);
+    Token term;
+    if (!ExpectIdentifier(&term)) {
+      return false;
+    }
+    *name += '.';
+    name->append(term.text, term.length);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ParseRecursiveDescent(const string& buffer, Parser* ps) {
+  return RecursiveDescentParser(buffer, ps).ParseDocument();
+}
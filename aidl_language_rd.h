@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_AIDL_LANGUAGE_RD_H_
+#define AIDL_AIDL_LANGUAGE_RD_H_
+
+#include <string>
+
+class Parser;
+
+// Parses |buffer|, the contents of ps->FileName(), with a hand-written
+// scanner and recursive descent parser.  It hands |ps| the same objects and
+// prints the same diagnostics as the flex scanner and bison grammar in
+// aidl_language_l.ll and aidl_language_y.yy, including bison's error
+// recovery.  Returns false when yy::parser::parse() would.
+bool ParseRecursiveDescent(const std::string& buffer, Parser* ps);
+
+#endif  // AIDL_AIDL_LANGUAGE_RD_H_
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <gtest/gtest.h>
+
+#include "aidl_language.h"
+#include "tests/fake_io_delegate.h"
+#include "tests/test_data.h"
+
+using android::aidl::test::FakeIoDelegate;
+using android::base::Join;
+using android::base::StringAppendF;
+using std::string;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace {
+
+const char kFileName[] = "a/IFoo.aidl";
+
+// Everything a parse leaves behind that the rest of the compiler could see.
+struct ParseResult {
+  bool success;
+  string stdout_text;
+  string stderr_text;
+  string ast;
+  bool quoted_stale_value;
+};
+
+string DumpType(const AidlType& type) {
+  return android::base::StringPrintf(
+      "%s%s@%u annotations=%d%d%d%d%d%d comments=[%s]",
+      type.GetName().c_str(), type.IsArray() ? "[]" : "", type.GetLine(),
+      type.IsNullable(), type.IsUtf8(), type.IsUtf8InCpp(), type.IsShardKey(),
+      type.IsDelta(), type.IsReuse(), type.GetComments().c_str());
+}
+
+string DumpDocument(const AidlDocument* document) {
+  if (document == nullptr) {
+    return "no document\n";
+  }
+  string ast;
+  for (const auto& parcelable : document->GetParcelables()) {
+    if (parcelable == nullptr) {
+      ast += "parcelable (null)\n";
+      continue;
+    }
+    StringAppendF(&ast, "parcelable %s@%u header=[%s]\n",
+                  parcelable->GetCanonicalName().c_str(),
+                  parcelable->GetLine(),
+                  parcelable->GetCppHeader().c_str());
+  }
+  const AidlInterface* interface = document->GetInterface();
+  if (interface == nullptr) {
+    return ast + "interface (null)\n";
+  }
+  StringAppendF(&ast, "interface %s@%u oneway=%d chainable=%d comments=[%s]\n",
+                interface->GetCanonicalName().c_str(), interface->GetLine(),
+                interface->IsOneway(), interface->IsChainable(),
+                interface->GetComments().c_str());
+  for (const auto& constant : interface->GetConstants()) {
+    StringAppendF(&ast, "  const %s:%d=%d [%s]\n", constant->GetName().c_str(),
+                  constant->GetType(), constant->GetValue(),
+                  constant->GetValueText().c_str());
+  }
+  for (const auto& an_enum : interface->GetEnums()) {
+    StringAppendF(&ast, "  enum %s@%u : %s\n", an_enum->GetName().c_str(),
+                  an_enum->GetLine(), an_enum->GetBackingType().c_str());
+    for (const auto& enumerator : an_enum->GetEnumerators()) {
+      StringAppendF(&ast, "    %s=%lld\n", enumerator.name.c_str(),
+                    static_cast<long long>(enumerator.value));
+    }
+  }
+  for (const auto& method : interface->GetMethods()) {
+    StringAppendF(&ast, "  method %s@%u oneway=%d id=%d:%d comments=[%s]\n",
+                  method->GetName().c_str(), method->GetLine(),
+                  method->IsOneway(), method->HasId(), method->GetId(),
+                  method->GetComments().c_str());
+    StringAppendF(&ast, "    returns %s\n",
+                  DumpType(method->GetType()).c_str());
+    for (const auto& arg : method->GetArguments()) {
+      StringAppendF(&ast, "    arg %s@%d direction=%d:%d %s\n",
+                    arg->GetName().c_str(), arg->GetLine(),
+                    arg->DirectionWasSpecified(), arg->GetDirection(),
+                    DumpType(arg->GetType()).c_str());
+    }
+  }
+  return ast;
+}
+
+ParseResult Parse(Parser::Implementation implementation,
+                  const string& contents) {
+  FakeIoDelegate io_delegate;
+  io_delegate.SetFileContents(kFileName, contents);
+  Parser parser(io_delegate, implementation);
+  ParseResult result;
+  testing::internal::CaptureStdout();
+  testing::internal::CaptureStderr();
+  result.success = parser.ParseFile(kFileName);
+  result.stderr_text = testing::internal::GetCapturedStderr();
+  result.stdout_text = testing::internal::GetCapturedStdout();
+  result.quoted_stale_value = parser.QuotedStaleValue();
+  result.ast = DumpDocument(parser.GetDocument());
+  for (const auto& import : parser.GetImports()) {
+    StringAppendF(&result.ast, "import %s@%u\n",
+                  import->GetNeededClass().c_str(), import->GetLine());
+  }
+  return result;
+}
+
+// Checks that both parsers treat |contents| the same way.
+void ExpectSameParse(const string& contents) {
+  SCOPED_TRACE(contents);
+  const ParseResult rd = Parse(Parser::RECURSIVE_DESCENT, contents);
+  if (rd.quoted_stale_value) {
+    // bison's message for this input depends on freed memory.
+    return;
+  }
+  const ParseResult bison = Parse(Parser::BISON, contents);
+  EXPECT_EQ(bison.success, rd.success);
+  EXPECT_EQ(bison.stdout_text, rd.stdout_text);
+  EXPECT_EQ(bison.stderr_text, rd.stderr_text);
+  EXPECT_EQ(bison.ast, rd.ast);
+}
+
+const char* kValidInputs[] = {
+  "",
+  "parcelable Foo;",
+  "package a.b;\nimport c.D;\nimport e.F;\n"
+  "parcelable Foo;\nparcelable a.Bar cpp_header \"a/bar.h\";\n",
+  "/** Comments */ package a; // a comment\n"
+  "interface IFoo { void f(); }",
+  "package a;\n%%{\ncopied\n}%%\n"
+  "oneway interface IFoo {\n"
+  "  /* c */ oneway void f(in int[] a, out List<String> b);\n"
+  "  const int X = -1;\n"
+  "  @nullable @utf8InCpp String g(inout Map<String,a.Bar> c) = 7;\n"
+  "}\n",
+  "@chainable interface IFoo {\n"
+  "  @shardKey int a(in @delta @reuse cpp_header int, int x);\n"
+  "  String int(int int);\n"
+  "  @nonnull Bar b(in @mirrored @nonnull Bar[] c, out @skippable int[] d);\n"
+  "}\n",
+  "interface IFoo {\r\n\tvoid f(in\n\nint\na\n);\n}\n",
+  "interface IFoo {\n"
+  "  const long L = -5000000000L;\n"
+  "  const long M = 7;\n"
+  "  const long N = 4000000000;\n"
+  "  const float F = 1.5e-3f;\n"
+  "  const double D = +2;\n"
+  "  const boolean B = true;\n"
+  "  const String S = \"v1.0\";\n"
+  "}\n",
+  "interface IFoo {\n"
+  "  enum Color : byte { RED, GREEN = 5, BLUE }\n"
+  "  enum Big : long { MIN = -9223372036854775808L, ZERO = 0,"
+  " LARGE = 4000000000 }\n"
+  "  Color f(in Color[] c);\n"
+  "}\n",
+};
+
+const char* kInvalidInputs[] = {
+  "package",
+  "package a.;",
+  "import a b;",
+  "parcelable;",
+  "parcelable ; parcelable Foo;",
+  "parcelable Foo",
+  "parcelable a.b cpp_header;",
+  "parcelable x y z;\nparcelable Foo;",
+  "parcelable Foo; x interface",
+  "interface x.y { }",
+  "interface IFoo { void f(); } junk",
+  "interface IFoo {\n void f(in int a b);\n void g();\n}",
+  "interface IFoo {\n void f(, int a);\n}",
+  "interface IFoo {\n void f() = ;\n x y z;\n void g(int a);\n}",
+  "interface IFoo {\n const int x = y;\n const float y = 1;\n}",
+  "interface IFoo {\n const long a = 1.5;\n const double b = 1.5f;\n"
+  " const float c = 1e5;\n const String d = x;\n const boolean e = 1;\n"
+  " const Foo f = 1;\n const int g = 1L;\n const long h = 9223372036854775808L;\n}",
+  "interface IFoo {\n oneway void f(\n in int a,,\n out int b);\n}",
+  "interface IFoo {\n List<int x> f();\n}",
+  "interface IFoo {\n void f(); }\n oneway interface",
+  "oneway interface IFoo;",
+  "@chainable parcelable Foo;",
+  "interface IFoo { void f(int a) }",
+  "interface IFoo { void f() x; void g(); }",
+  "interface IFoo { void f(int a",
+  "interface ! { void f(); }",
+  "interface IFoo { void f(\"str\" a); }",
+  "interface IFoo { void f(int a); }}",
+  "interface IFoo { @foo void f(); }",
+  "interface IFoo { void f(); // trailing",
+  "interface IFoo { void f(); /* unterminated",
+  "%%{ unterminated",
+  "interface IFoo {\n void f(in int a) = 1 2;\n}",
+  "interface IFoo {\n enum E : short { A }\n enum F : byte { A = 128, B = 1L }\n"
+  " enum G : byte { A = 127, B }\n enum H : int { A, A = \"x\" }\n}",
+  "interface IFoo {\n enum E byte { A }\n void f();\n}",
+  "interface IFoo {\n const long a = 99999999999999999999;\n"
+  " const int b = 4000000000;\n"
+  " enum E : long { A = -99999999999999999999 }\n"
+  " void f() = 4294967297;\n}",
+  "interface IFoo {\n enum E : byte { A, }\n void f();\n}",
+  "interface IFoo {\n enum E : byte { A B };\n void f();\n}",
+};
+
+TEST(RecursiveDescentParserTest, MatchesBisonOnTestData) {
+  ExpectSameParse(test_data::example_interface::kInterfaceDefinition);
+  ExpectSameParse(test_data::ping_responder::kInterfaceDefinition);
+  for (const char* input : kValidInputs) {
+    ExpectSameParse(input);
+    EXPECT_TRUE(Parse(Parser::RECURSIVE_DESCENT, input).success) << input;
+  }
+}
+
+TEST(RecursiveDescentParserTest, MatchesBisonOnSyntaxErrors) {
+  for (const char* input : kInvalidInputs) {
+    ExpectSameParse(input);
+  }
+}
+
+// Mutates the inputs above a token at a time, which gets into error
+// recovery states that handwritten inputs rarely reach.
+TEST(RecursiveDescentParserTest, MatchesBisonOnFuzzedInputs) {
+  const vector<string> vocabulary = {
+    "interface", "oneway", "parcelable", "package", "import", "const", "int",
+    "in", "out", "inout", "cpp_header", "enum", ":", "@nullable", "@utf8",
+    "@utf8InCpp",
+    "@shardKey", "@delta", "@reuse", "@mirrored", "@nonnull", "@skippable",
+    "@chainable", "x", "y", "\"s\"", "1",
+    "-2", "3L", "4.5", "-6.7e8f", "(", ")", ",", "=", "[", "]", "<", ">", ".",
+    "{", "}", ";", "\n",
+    "/* c */", "// c\n", "%%{\nc\n}%%\n", "#",
+  };
+  vector<vector<string>> seeds;
+  for (const char* input : kValidInputs) {
+    seeds.push_back(android::base::Split(input, " "));
+  }
+
+  std::mt19937 random(115);
+  for (int i = 0; i < 1000; ++i) {
+    vector<string> pieces =
+        seeds[std::uniform_int_distribution<size_t>(0, seeds.size() - 1)(
+            random)];
+    const int mutations = std::uniform_int_distribution<int>(1, 3)(random);
+    for (int m = 0; m < mutations; ++m) {
+      std::uniform_int_distribution<size_t> position(0, pieces.size());
+      const string& word = vocabulary[std::uniform_int_distribution<size_t>(
+          0, vocabulary.size() - 1)(random)];
+      const size_t at = position(random);
+      switch (std::uniform_int_distribution<int>(0, 2)(random)) {
+        case 0:
+          pieces.insert(pieces.begin() + at, word);
+          break;
+        case 1:
+          if (at < pieces.size()) {
+            pieces.erase(pieces.begin() + at);
+          }
+          break;
+        default:
+          if (at < pieces.size()) {
+            pieces[at] = word;
+          }
+          break;
+      }
+    }
+    ExpectSameParse(Join(pieces, " "));
+    if (HasFailure()) {
+      return;
+    }
+  }
+}
+
+TEST(RecursiveDescentParserTest, ReportsErrorRecovery) {
+  ParseResult result = Parse(Parser::RECURSIVE_DESCENT,
+                             "interface IFoo {\n"
+                             "  void f(int a b);\n"
+                             "  x;\n"
+                             "  void g();\n"
+                             "}\n");
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ("a/IFoo.aidl:2: syntax error\n"
+            "a/IFoo.aidl:2: syntax error in parameter list\n"
+            "a/IFoo.aidl:3: syntax error\n"
+            "a/IFoo.aidl:3: syntax error before ';' "
+            "(expected method or constant declaration)\n",
+            result.stderr_text);
+  EXPECT_EQ("interface IFoo@1 oneway=0 chainable=0 comments=[]\n"
+            "  method f@2 oneway=0 id=0:0 comments=[]\n"
+            "    returns void@2 annotations=000000 comments=[]\n"
+            "  method g@4 oneway=0 id=0:0 comments=[]\n"
+            "    returns void@4 annotations=000000 comments=[]\n",
+            result.ast);
+  EXPECT_FALSE(result.quoted_stale_value);
+}
+
+TEST(RecursiveDescentParserTest, FlagsStaleErrorValues) {
+  // bison quotes "x", the last token with a value, because '.' has none.
+  // Whether that token is still alive depends on the rules reduced since.
+  ParseResult result =
+      Parse(Parser::RECURSIVE_DESCENT, "interface x.y { }");
+  EXPECT_FALSE(result.success);
+  EXPECT_NE(string::npos, result.stderr_text.find("saw \"x\""));
+  EXPECT_TRUE(result.quoted_stale_value);
+
+  result = Parse(Parser::RECURSIVE_DESCENT, "parcelable a b;");
+  EXPECT_NE(string::npos, result.stderr_text.find("saw \"b\"."));
+  EXPECT_FALSE(result.quoted_stale_value);
+}
+
+}  // namespace
+}  // namespace aidl
+}  // namespace android
@@ -19,7 +19,7 @@ int yylex(yy::parser::semantic_type *, yy::parser::location_type *, void *);
 
 %union {
     AidlToken* token;
-    int integer;
+    int64_t integer;
     std::string *str;
     AidlType::Annotation annotation;
     AidlType::Annotation annotation_list;
@@ -30,6 +30,8 @@ int yylex(yy::parser::semantic_type *, yy::parser::location_type *, void *);
     std::vector<std::unique_ptr<AidlArgument>>* arg_list;
     AidlMethod* method;
     AidlConstant* constant;
+    AidlEnum* enum_decl;
+    std::vector<std::pair<std::string, std::string>>* enumerators;
     std::vector<std::unique_ptr<AidlMember>>* members;
     AidlQualifiedName* qname;
     AidlInterface* interface_obj;
@@ -37,12 +39,15 @@ int yylex(yy::parser::semantic_type *, yy::parser::location_type *, void *);
     AidlDocument* parcelable_list;
 }
 
-%token<token> IDENTIFIER INTERFACE ONEWAY C_STR
+%token<token> IDENTIFIER INTERFACE ONEWAY C_STR LONGVALUE FLOATVALUE
 %token<integer> INTVALUE
 
-%token '(' ')' ',' '=' '[' ']' '<' '>' '.' '{' '}' ';'
-%token IN OUT INOUT PACKAGE IMPORT PARCELABLE CPP_HEADER CONST INT
+%token '(' ')' ',' '=' '[' ']' '<' '>' '.' '{' '}' ';' ':'
+%token IN OUT INOUT PACKAGE IMPORT PARCELABLE CPP_HEADER CONST INT ENUM
 %token ANNOTATION_NULLABLE ANNOTATION_UTF8 ANNOTATION_UTF8_CPP
+%token ANNOTATION_SHARD_KEY ANNOTATION_DELTA ANNOTATION_CHAINABLE
+%token ANNOTATION_REUSE ANNOTATION_MIRRORED ANNOTATION_NONNULL
+%token ANNOTATION_SKIPPABLE
 
 %type<parcelable_list> parcelable_decls
 %type<parcelable> parcelable_decl
@@ -50,6 +55,9 @@ int yylex(yy::parser::semantic_type *, yy::parser::location_type *, void *);
 %type<interface_obj> interface_decl
 %type<method> method_decl
 %type<constant> constant_decl
+%type<token> constant_value
+%type<enum_decl> enum_decl
+%type<enumerators> enumerators
 %type<annotation> annotation
 %type<annotation_list>annotation_list
 %type<type> type
@@ -150,6 +158,12 @@ interface_decl
     delete $2;
     delete $3;
   }
+ | ANNOTATION_CHAINABLE interface_decl {
+    $$ = $2;
+    if ($$ != NULL) {
+      $$->SetChainable();
+    }
+  }
  | INTERFACE error '{' members '}' {
     fprintf(stderr, "%s:%d: syntax error in interface declaration.  Expected type name, saw \"%s\"\n",
             ps->FileName().c_str(), @2.begin.line, $2->GetText().c_str());
@@ -172,6 +186,8 @@ members
   { $1->push_back(std::unique_ptr<AidlMember>($2)); }
  | members constant_decl
   { $1->push_back(std::unique_ptr<AidlMember>($2)); }
+ | members enum_decl
+  { $1->push_back(std::unique_ptr<AidlMember>($2)); }
  | members error ';' {
     fprintf(stderr, "%s:%d: syntax error before ';' "
                     "(expected method or constant declaration)\n",
@@ -180,10 +196,58 @@ members
   };
 
 constant_decl
- : CONST INT identifier '=' INTVALUE ';' {
-    $$ = new AidlConstant($3->GetText(), $5);
+ : CONST identifier identifier '=' constant_value ';' {
+    $$ = ps->NewConstant($2->GetText(), $3->GetText(), $5->GetText(),
+                         @3.begin.line);
+    delete $2;
+    delete $3;
+    delete $5;
+ };
+
+constant_value
+ : INTVALUE
+  { $$ = new AidlToken(std::to_string($1), ""); }
+ | LONGVALUE
+  { $$ = $1; }
+ | FLOATVALUE
+  { $$ = $1; }
+ | C_STR
+  { $$ = $1; }
+ | identifier
+  { $$ = $1; };
+
+enum_decl
+ : ENUM identifier ':' identifier '{' enumerators '}' {
+    $$ = ps->NewEnum($2->GetText(), $4->GetText(), *$6, @2.begin.line);
+    delete $2;
+    delete $4;
+    delete $6;
  };
 
+enumerators
+ : identifier {
+    $$ = new std::vector<std::pair<std::string, std::string>>();
+    $$->emplace_back($1->GetText(), "");
+    delete $1;
+  }
+ | identifier '=' constant_value {
+    $$ = new std::vector<std::pair<std::string, std::string>>();
+    $$->emplace_back($1->GetText(), $3->GetText());
+    delete $1;
+    delete $3;
+  }
+ | enumerators ',' identifier {
+    $$ = $1;
+    $$->emplace_back($3->GetText(), "");
+    delete $3;
+  }
+ | enumerators ',' identifier '=' constant_value {
+    $$ = $1;
+    $$->emplace_back($3->GetText(), $5->GetText());
+    delete $3;
+    delete $5;
+  };
+
 method_decl
  : type identifier '(' arg_list ')' ';' {
     $$ = new AidlMethod(false, $1, $2->GetText(), $4, @2.begin.line,
@@ -198,12 +262,14 @@ method_decl
   }
  | type identifier '(' arg_list ')' '=' INTVALUE ';' {
     $$ = new AidlMethod(false, $1, $2->GetText(), $4, @2.begin.line,
-                        $1->GetComments(), $7);
+                        $1->GetComments(),
+                        ps->NewMethodId($7, @7.begin.line));
     delete $2;
   }
  | ONEWAY type identifier '(' arg_list ')' '=' INTVALUE ';' {
     $$ = new AidlMethod(true, $2, $3->GetText(), $5, @3.begin.line,
-                        $1->GetComments(), $8);
+                        $1->GetComments(),
+                        ps->NewMethodId($8, @8.begin.line));
     delete $1;
     delete $3;
   };
@@ -284,7 +350,19 @@ annotation
  | ANNOTATION_UTF8
   { $$ = AidlType::AnnotationUtf8; }
  | ANNOTATION_UTF8_CPP
-  { $$ = AidlType::AnnotationUtf8InCpp; };
+  { $$ = AidlType::AnnotationUtf8InCpp; }
+ | ANNOTATION_SHARD_KEY
+  { $$ = AidlType::AnnotationShardKey; }
+ | ANNOTATION_DELTA
+  { $$ = AidlType::AnnotationDelta; }
+ | ANNOTATION_REUSE
+  { $$ = AidlType::AnnotationReuse; }
+ | ANNOTATION_MIRRORED
+  { $$ = AidlType::AnnotationMirrored; }
+ | ANNOTATION_NONNULL
+  { $$ = AidlType::AnnotationNonNull; }
+ | ANNOTATION_SKIPPABLE
+  { $$ = AidlType::AnnotationSkippable; };
 
 direction
  : IN
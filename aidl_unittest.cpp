@@ -24,6 +24,7 @@
 
 #include "aidl.h"
 #include "aidl_language.h"
+#include "bundle.h"
 #include "tests/fake_io_delegate.h"
 #include "type_cpp.h"
 #include "type_java.h"
@@ -55,6 +56,1991 @@ R"( : \
 p/Foo.aidl :
 )";
 
+const char kExpectedRouterJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IStore.aidl
+ */
+package p;
+public interface IStore extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IStore
+{
+private static final java.lang.String DESCRIPTOR = "p.IStore";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IStore interface,
+ * generating a proxy if needed.
+ */
+public static p.IStore asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IStore))) {
+return ((p.IStore)iin);
+}
+return new p.IStore.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_get:
+{
+data.enforceInterface(DESCRIPTOR);
+java.lang.String _arg0;
+_arg0 = data.readString();
+java.lang.String _result = this.get(_arg0);
+reply.writeNoException();
+reply.writeString(_result);
+return true;
+}
+case TRANSACTION_put:
+{
+data.enforceInterface(DESCRIPTOR);
+long _arg0;
+_arg0 = data.readLong();
+java.lang.String _arg1;
+_arg1 = data.readString();
+this.put(_arg0, _arg1);
+reply.writeNoException();
+return true;
+}
+case TRANSACTION_count:
+{
+data.enforceInterface(DESCRIPTOR);
+int _result = this.count();
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IStore
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public java.lang.String get(java.lang.String key) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+java.lang.String _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeString(key);
+mRemote.transact(Stub.TRANSACTION_get, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readString();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+@Override public void put(long id, java.lang.String v) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeLong(id);
+_data.writeString(v);
+mRemote.transact(Stub.TRANSACTION_put, _data, _reply, 0);
+_reply.readException();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+}
+@Override public int count() throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+int _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+mRemote.transact(Stub.TRANSACTION_count, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readInt();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+}
+static final int TRANSACTION_get = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+static final int TRANSACTION_put = (android.os.IBinder.FIRST_CALL_TRANSACTION + 1);
+static final int TRANSACTION_count = (android.os.IBinder.FIRST_CALL_TRANSACTION + 2);
+}
+public java.lang.String get(java.lang.String key) throws android.os.RemoteException;
+public void put(long id, java.lang.String v) throws android.os.RemoteException;
+public int count() throws android.os.RemoteException;
+/**
+ * Spreads calls across several instances of the interface.  Methods
+ * with a @shardKey argument go to the shard picked by hashing the
+ * key, all other methods are sent to every shard in turn.
+ */
+public static class Router implements p.IStore
+{
+private final p.IStore[] mShards;
+private final java.util.concurrent.atomic.AtomicLongArray mCalls;
+private final java.util.concurrent.atomic.AtomicLongArray mErrors;
+public Router(p.IStore[] shards)
+{
+mShards = shards.clone();
+mCalls = new java.util.concurrent.atomic.AtomicLongArray(shards.length);
+mErrors = new java.util.concurrent.atomic.AtomicLongArray(shards.length);
+}
+public int getShardCount()
+{
+return mShards.length;
+}
+public long getShardCallCount(int shard)
+{
+if (((shard<0)||(shard>=mShards.length))) {
+return 0;
+}
+return mCalls.get(shard);
+}
+public long getShardErrorCount(int shard)
+{
+if (((shard<0)||(shard>=mShards.length))) {
+return 0;
+}
+return mErrors.get(shard);
+}
+@Override public android.os.IBinder asBinder()
+{
+return null;
+}
+private int shardIndex(long hash)
+{
+return (int) ((hash & 0x7fffffffffffffffL) % mShards.length);
+}
+private static long mixShardKey(long hash, long value, int bytes)
+{
+for (int i = 0; i < bytes; i++) {
+hash ^= (value >>> (8 * i)) & 0xff;
+hash *= 0x100000001b3L;
+}
+return hash;
+}
+private static long hashShardKey(long key)
+{
+return mixShardKey(0xcbf29ce484222325L, key, 8);
+}
+private static long hashShardKey(java.lang.String key)
+{
+long hash = 0xcbf29ce484222325L;
+for (int i = 0; i < key.length(); i++) {
+hash = mixShardKey(hash, key.charAt(i), 2);
+}
+return hash;
+}
+@Override public java.lang.String get(java.lang.String key) throws android.os.RemoteException
+{
+if ((mShards.length==0)) {
+throw new java.lang.IllegalStateException("no shards");
+}
+if ((key==null)) {
+throw new java.lang.NullPointerException("key is null");
+}
+int _shard = shardIndex(hashShardKey(key));
+mCalls.incrementAndGet(_shard);
+try {
+return mShards[_shard].get(key);
+}
+catch (android.os.RemoteException e) {
+mErrors.incrementAndGet(_shard);
+throw e;
+}
+catch (java.lang.RuntimeException e) {
+mErrors.incrementAndGet(_shard);
+throw e;
+}
+}
+@Override public void put(long id, java.lang.String v) throws android.os.RemoteException
+{
+if ((mShards.length==0)) {
+throw new java.lang.IllegalStateException("no shards");
+}
+int _shard = shardIndex(hashShardKey(id));
+mCalls.incrementAndGet(_shard);
+try {
+mShards[_shard].put(id, v);
+}
+catch (android.os.RemoteException e) {
+mErrors.incrementAndGet(_shard);
+throw e;
+}
+catch (java.lang.RuntimeException e) {
+mErrors.incrementAndGet(_shard);
+throw e;
+}
+}
+@Override public int count() throws android.os.RemoteException
+{
+if ((mShards.length==0)) {
+throw new java.lang.IllegalStateException("no shards");
+}
+int _result = 0;
+for (int _shard = 0; _shard < mShards.length; _shard++) {
+mCalls.incrementAndGet(_shard);
+try {
+int _shardResult = mShards[_shard].count();
+if ((_shard==0)) {
+_result = _shardResult;
+}
+}
+catch (android.os.RemoteException e) {
+mErrors.incrementAndGet(_shard);
+throw e;
+}
+catch (java.lang.RuntimeException e) {
+mErrors.incrementAndGet(_shard);
+throw e;
+}
+}
+return _result;
+}
+}
+}
+)";
+
+const char kExpectedSharedRuntimeJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.aidl.runtime.AidlStub implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+super(DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override protected boolean dispatch(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case TRANSACTION_add:
+{
+data.enforceInterface(DESCRIPTOR);
+int _arg0;
+_arg0 = data.readInt();
+int _arg1;
+_arg1 = data.readInt();
+int _result = this.add(_arg0, _arg1);
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+case TRANSACTION_fire:
+{
+data.enforceInterface(DESCRIPTOR);
+java.lang.String _arg0;
+_arg0 = data.readString();
+this.fire(_arg0);
+return true;
+}
+}
+return false;
+}
+private static class Proxy extends android.aidl.runtime.AidlProxy implements p.IFoo
+{
+Proxy(android.os.IBinder remote)
+{
+super(remote, DESCRIPTOR);
+}
+@Override public int add(int x, int y) throws android.os.RemoteException
+{
+android.os.Parcel _data = this.obtainRequest();
+boolean _written = false;
+try {
+_data.writeInt(x);
+_data.writeInt(y);
+_written = true;
+}
+finally {
+if (!_written) {
+_data.recycle();
+}
+}
+android.os.Parcel _reply = this.call(Stub.TRANSACTION_add, _data);
+try {
+int _result;
+_result = _reply.readInt();
+return _result;
+}
+finally {
+_reply.recycle();
+}
+}
+@Override public void fire(java.lang.String s) throws android.os.RemoteException
+{
+android.os.Parcel _data = this.obtainRequest();
+boolean _written = false;
+try {
+_data.writeString(s);
+_written = true;
+}
+finally {
+if (!_written) {
+_data.recycle();
+}
+}
+this.callOneway(Stub.TRANSACTION_fire, _data);
+}
+}
+static final int TRANSACTION_add = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+static final int TRANSACTION_fire = (android.os.IBinder.FIRST_CALL_TRANSACTION + 1);
+}
+public int add(int x, int y) throws android.os.RemoteException;
+public void fire(java.lang.String s) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedCallChainJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: a/IFoo.aidl
+ */
+package a;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements a.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "a.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an a.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static a.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof a.IFoo))) {
+return ((a.IFoo)iin);
+}
+return new a.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_f:
+{
+data.enforceInterface(DESCRIPTOR);
+java.lang.String _arg0;
+_arg0 = data.readString();
+int _result = this.f(_arg0);
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+case TRANSACTION_g:
+{
+data.enforceInterface(DESCRIPTOR);
+int _arg0;
+_arg0 = data.readInt();
+int[] _arg1;
+int _arg1_length = data.readInt();
+if ((_arg1_length<0)) {
+_arg1 = null;
+}
+else {
+_arg1 = new int[_arg1_length];
+}
+this.g(_arg0, _arg1);
+reply.writeNoException();
+reply.writeIntArray(_arg1);
+return true;
+}
+case TRANSACTION_CALL_CHAIN:
+{
+data.enforceInterface(DESCRIPTOR);
+this.runCallChain(data, reply);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements a.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public int f(java.lang.String a) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+int _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeString(a);
+mRemote.transact(Stub.TRANSACTION_f, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readInt();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+@Override public void g(int b, int[] c) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(b);
+if ((c==null)) {
+_data.writeInt(-1);
+}
+else {
+_data.writeInt(c.length);
+}
+mRemote.transact(Stub.TRANSACTION_g, _data, _reply, 0);
+_reply.readException();
+_reply.readIntArray(c);
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+}
+}
+static final int TRANSACTION_f = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+static final int TRANSACTION_g = (android.os.IBinder.FIRST_CALL_TRANSACTION + 1);
+static final int TRANSACTION_CALL_CHAIN = android.os.IBinder.LAST_CALL_TRANSACTION;
+private void runCallChain(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+int stepCount = data.readInt();
+// Every step takes up at least 8 bytes of the request.
+if (stepCount < 0 || stepCount > data.dataAvail() / 8) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+android.os.Parcel[] results = new android.os.Parcel[stepCount];
+int[] resultStarts = new int[stepCount];
+int completed = 0;
+try {
+while (completed < stepCount) {
+int code = data.readInt();
+int argumentCount = data.readInt();
+if (!isChainableTransaction(code) || argumentCount < 0) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+android.os.Parcel stepData = android.os.Parcel.obtain();
+android.os.Parcel result = android.os.Parcel.obtain();
+results[completed] = result;
+try {
+stepData.writeInterfaceToken(DESCRIPTOR);
+for (int i = 0; i < argumentCount; i++) {
+int source = data.readInt();
+if (source >= 0) {
+if (source >= completed) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+stepData.appendFrom(results[source], resultStarts[source], results[source].dataSize() - resultStarts[source]);
+continue;
+}
+int size = data.readInt();
+int start = data.dataPosition();
+if (size < 0 || size > data.dataAvail()) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+stepData.appendFrom(data, start, size);
+data.setDataPosition(start + size);
+}
+stepData.setDataPosition(0);
+try {
+if (!this.onTransact(code, stepData, result, 0)) {
+throw new java.lang.IllegalArgumentException("unknown call in call chain");
+}
+}
+catch (java.lang.RuntimeException e) {
+result.setDataSize(0);
+result.writeException(e);
+}
+}
+finally {
+stepData.recycle();
+}
+completed++;
+result.setDataPosition(0);
+int exceptionCode = result.readExceptionCode();
+resultStarts[completed - 1] = result.dataPosition();
+if (exceptionCode != 0) {
+break;
+}
+}
+reply.writeNoException();
+reply.writeInt(completed);
+for (int i = 0; i < completed; i++) {
+reply.writeInt(results[i].dataSize());
+reply.appendFrom(results[i], 0, results[i].dataSize());
+}
+}
+finally {
+for (android.os.Parcel result : results) {
+if (result != null) {
+result.recycle();
+}
+}
+}
+}
+private static boolean isChainableTransaction(int code)
+{
+switch (code) {
+case TRANSACTION_f:
+return true;
+}
+return false;
+}
+}
+public int f(java.lang.String a) throws android.os.RemoteException;
+public void g(int b, int[] c) throws android.os.RemoteException;
+/**
+ * Collects calls to make with a single transaction.  Calls may take
+ * the results of earlier calls in the chain as arguments, without
+ * those results making a round trip through the caller.
+ */
+public static class CallChain
+{
+/**
+ * An argument to a chained call: either a value, which is written out
+ * when the call is added to the chain, or the Result of an earlier call.
+ */
+public static class Arg<T>
+{
+T value;
+int step = -1;
+public static <T> Arg<T> of(T value)
+{
+Arg<T> arg = new Arg<T>();
+arg.value = value;
+return arg;
+}
+}
+/** The result of a chained call, available once the chain has run. */
+public static final class Result<T> extends Arg<T>
+{
+private boolean mDone = false;
+public T get()
+{
+if (!mDone) {
+throw new java.lang.IllegalStateException("call chain has not run yet");
+}
+return value;
+}
+@SuppressWarnings("unchecked")
+void set(java.lang.Object value)
+{
+this.value = (T) value;
+mDone = true;
+}
+}
+private android.os.Parcel mData = android.os.Parcel.obtain();
+private final java.util.ArrayList<java.lang.Integer> mCodes = new java.util.ArrayList<java.lang.Integer>();
+private final java.util.ArrayList<Result<?>> mResults = new java.util.ArrayList<Result<?>>();
+private <T> Result<T> beginStep(int code, int argumentCount)
+{
+if (mData == null) {
+throw new java.lang.IllegalStateException("call chain has already run");
+}
+Result<T> result = new Result<T>();
+result.step = mResults.size();
+mCodes.add(code);
+mResults.add(result);
+mData.writeInt(code);
+mData.writeInt(argumentCount);
+return result;
+}
+private int mSizePosition;
+// Returns true if the caller should write out the argument's value.
+private boolean beginArgument(Arg<?> arg)
+{
+if (arg.step >= 0) {
+if (arg.step + 1 >= mResults.size()) {
+throw new java.lang.IllegalArgumentException("result is not from an earlier call in this chain");
+}
+mData.writeInt(arg.step);
+return false;
+}
+mData.writeInt(-1);
+mSizePosition = mData.dataPosition();
+mData.writeInt(0);
+return true;
+}
+private void endArgument()
+{
+int end = mData.dataPosition();
+mData.setDataPosition(mSizePosition);
+mData.writeInt(end - mSizePosition - 4);
+mData.setDataPosition(end);
+}
+/**
+ * Makes the calls added so far.  The first call to fail stops the
+ * chain, and its exception is thrown here.
+ */
+public void transact(a.IFoo service) throws android.os.RemoteException
+{
+if ((mData==null)) {
+throw new java.lang.IllegalStateException("call chain has already run");
+}
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(Stub.DESCRIPTOR);
+_data.writeInt(mResults.size());
+_data.appendFrom(mData, 0, mData.dataSize());
+service.asBinder().transact(Stub.TRANSACTION_CALL_CHAIN, _data, _reply, 0);
+_reply.readException();
+int _completed = _reply.readInt();
+if (_completed < 0 || _completed > mResults.size()) {
+throw new android.os.RemoteException("malformed call chain reply");
+}
+android.os.Parcel _stepReply = android.os.Parcel.obtain();
+try {
+for (int i = 0; i < _completed; i++) {
+int _size = _reply.readInt();
+int _start = _reply.dataPosition();
+if (_size < 0 || _size > _reply.dataAvail()) {
+throw new android.os.RemoteException("malformed call chain reply");
+}
+_stepReply.setDataSize(0);
+_stepReply.appendFrom(_reply, _start, _size);
+_reply.setDataPosition(_start + _size);
+_stepReply.setDataPosition(0);
+_stepReply.readException();
+this.readResult(mCodes.get(i), _stepReply, mResults.get(i));
+}
+}
+finally {
+_stepReply.recycle();
+}
+if (_completed != mResults.size()) {
+throw new android.os.RemoteException("malformed call chain reply");
+}
+}
+finally {
+_reply.recycle();
+_data.recycle();
+mData.recycle();
+mData = null;
+}
+}
+private void readResult(int code, android.os.Parcel reply, Result<?> result)
+{
+switch (code)
+{
+case Stub.TRANSACTION_f:
+{
+int _value;
+_value = reply.readInt();
+result.set(_value);
+break;
+}
+}
+}
+public Result<java.lang.Integer> f(Arg<java.lang.String> a)
+{
+Result<java.lang.Integer> _result = this.beginStep(Stub.TRANSACTION_f, 1);
+if (this.beginArgument(a)) {
+java.lang.String _a = a.value;
+mData.writeString(_a);
+this.endArgument();
+}
+return _result;
+}
+}
+}
+)";
+
+const char kExpectedBundleJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: foo.aidlbundle/src/a/IFoo.aidl
+ */
+package a;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements a.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "a.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an a.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static a.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof a.IFoo))) {
+return ((a.IFoo)iin);
+}
+return new a.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_f:
+{
+data.enforceInterface(DESCRIPTOR);
+b.Bar _arg0;
+if ((0!=data.readInt())) {
+_arg0 = b.Bar.CREATOR.createFromParcel(data);
+}
+else {
+_arg0 = null;
+}
+this.f(_arg0);
+reply.writeNoException();
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements a.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public void f(b.Bar b) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+if ((b!=null)) {
+_data.writeInt(1);
+b.writeToParcel(_data, 0);
+}
+else {
+_data.writeInt(0);
+}
+mRemote.transact(Stub.TRANSACTION_f, _data, _reply, 0);
+_reply.readException();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+}
+}
+static final int TRANSACTION_f = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+}
+public void f(b.Bar b) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedThreadLocalParcelsJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_add:
+{
+data.enforceInterface(DESCRIPTOR);
+int _arg0;
+_arg0 = data.readInt();
+int _arg1;
+_arg1 = data.readInt();
+int _result = this.add(_arg0, _arg1);
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+case TRANSACTION_fire:
+{
+data.enforceInterface(DESCRIPTOR);
+java.lang.String _arg0;
+_arg0 = data.readString();
+this.fire(_arg0);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+private static final int MAX_KEPT_PARCEL_CAPACITY = 64 * 1024;
+private static final class ThreadParcels
+{
+android.os.Parcel data = android.os.Parcel.obtain();
+android.os.Parcel reply = android.os.Parcel.obtain();
+int depth;
+}
+private static final java.lang.ThreadLocal<ThreadParcels> sThreadParcels = new java.lang.ThreadLocal<ThreadParcels>() {
+@Override protected ThreadParcels initialValue()
+{
+return new ThreadParcels();
+}
+};
+private static android.os.Parcel resetThreadParcel(android.os.Parcel parcel)
+{
+if (parcel.dataCapacity() > MAX_KEPT_PARCEL_CAPACITY) {
+parcel.recycle();
+return android.os.Parcel.obtain();
+}
+parcel.setDataSize(0);
+return parcel;
+}
+private static void releaseThreadParcels(ThreadParcels parcels, android.os.Parcel data, android.os.Parcel reply)
+{
+if (--parcels.depth != 0) {
+if (reply != null) {
+reply.recycle();
+}
+data.recycle();
+return;
+}
+parcels.data = resetThreadParcel(parcels.data);
+parcels.reply = resetThreadParcel(parcels.reply);
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public int add(int x, int y) throws android.os.RemoteException
+{
+ThreadParcels _parcels = sThreadParcels.get();
+boolean _nested = (_parcels.depth++ != 0);
+android.os.Parcel _data = ((_nested)?(android.os.Parcel.obtain()):(_parcels.data));
+android.os.Parcel _reply = ((_nested)?(android.os.Parcel.obtain()):(_parcels.reply));
+int _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(x);
+_data.writeInt(y);
+mRemote.transact(Stub.TRANSACTION_add, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readInt();
+}
+finally {
+releaseThreadParcels(_parcels, _data, _reply);
+}
+return _result;
+}
+@Override public void fire(java.lang.String s) throws android.os.RemoteException
+{
+ThreadParcels _parcels = sThreadParcels.get();
+boolean _nested = (_parcels.depth++ != 0);
+android.os.Parcel _data = ((_nested)?(android.os.Parcel.obtain()):(_parcels.data));
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeString(s);
+mRemote.transact(Stub.TRANSACTION_fire, _data, null, android.os.IBinder.FLAG_ONEWAY);
+}
+finally {
+releaseThreadParcels(_parcels, _data, null);
+}
+}
+}
+static final int TRANSACTION_add = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+static final int TRANSACTION_fire = (android.os.IBinder.FIRST_CALL_TRANSACTION + 1);
+}
+public int add(int x, int y) throws android.os.RemoteException;
+public void fire(java.lang.String s) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedAddJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_add:
+{
+data.enforceInterface(DESCRIPTOR);
+int _arg0;
+_arg0 = data.readInt();
+int _arg1;
+_arg1 = data.readInt();
+int _result = this.add(_arg0, _arg1);
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public int add(int x, int y) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+int _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(x);
+_data.writeInt(y);
+mRemote.transact(Stub.TRANSACTION_add, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readInt();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+}
+static final int TRANSACTION_add = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+}
+public int add(int x, int y) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedProxyCacheJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * reusing the proxy for that object if there is one.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return getCachedProxy(obj);
+}
+private static final java.util.WeakHashMap<android.os.IBinder, java.lang.ref.WeakReference<Proxy>> sProxies = new java.util.WeakHashMap<android.os.IBinder, java.lang.ref.WeakReference<Proxy>>();
+private static Proxy getCachedProxy(android.os.IBinder obj)
+{
+synchronized (sProxies) {
+java.lang.ref.WeakReference<Proxy> ref = sProxies.get(obj);
+Proxy proxy = (ref != null) ? ref.get() : null;
+if (proxy == null) {
+proxy = new Proxy(obj);
+sProxies.put(obj, new java.lang.ref.WeakReference<Proxy>(proxy));
+}
+return proxy;
+}
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_add:
+{
+data.enforceInterface(DESCRIPTOR);
+int _arg0;
+_arg0 = data.readInt();
+int _arg1;
+_arg1 = data.readInt();
+int _result = this.add(_arg0, _arg1);
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public int add(int x, int y) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+int _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(x);
+_data.writeInt(y);
+mRemote.transact(Stub.TRANSACTION_add, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readInt();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+}
+static final int TRANSACTION_add = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+}
+public int add(int x, int y) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedReusedParcelablesJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_onBar:
+{
+data.enforceInterface(DESCRIPTOR);
+p.Bar _arg0;
+if ((0!=data.readInt())) {
+_arg0 = sReused_onBar_bar.get();
+if ((_arg0==null)) {
+_arg0 = new p.Bar();
+}
+else {
+sReused_onBar_bar.set(null);
+}
+_arg0.readFromParcel(data);
+}
+else {
+_arg0 = null;
+}
+p.Bar _arg1;
+if ((0!=data.readInt())) {
+_arg1 = p.Bar.CREATOR.createFromParcel(data);
+}
+else {
+_arg1 = null;
+}
+this.onBar(_arg0, _arg1);
+reply.writeNoException();
+if ((_arg0!=null)) {
+sReused_onBar_bar.set(_arg0);
+}
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+/** Called a lot. */
+@Override public void onBar(p.Bar bar, p.Bar other) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+if ((bar!=null)) {
+_data.writeInt(1);
+bar.writeToParcel(_data, 0);
+}
+else {
+_data.writeInt(0);
+}
+if ((other!=null)) {
+_data.writeInt(1);
+other.writeToParcel(_data, 0);
+}
+else {
+_data.writeInt(0);
+}
+mRemote.transact(Stub.TRANSACTION_onBar, _data, _reply, 0);
+_reply.readException();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+}
+}
+static final int TRANSACTION_onBar = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+private static final java.lang.ThreadLocal<p.Bar> sReused_onBar_bar = new java.lang.ThreadLocal<p.Bar>();
+}
+/** Called a lot. 
+ * <p>The stub reuses the object it passes as {@code bar}
+ * for later calls on the same thread.  It is only valid until this
+ * method returns and must not be kept or handed to other threads.
+ */
+public void onBar(p.Bar bar, p.Bar other) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedTraceContextJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_add:
+{
+data.enforceInterface(DESCRIPTOR);
+android.aidl.runtime.TraceContext _aidl_trace = android.aidl.runtime.TraceContext.enterFrom(data);
+try {
+int _arg0;
+_arg0 = data.readInt();
+int _arg1;
+_arg1 = data.readInt();
+int _result = this.add(_arg0, _arg1);
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+finally {
+android.aidl.runtime.TraceContext.restore(_aidl_trace);
+}
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public int add(int x, int y) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+int _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+android.aidl.runtime.TraceContext.writeCurrent(_data);
+_data.writeInt(x);
+_data.writeInt(y);
+mRemote.transact(Stub.TRANSACTION_add, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readInt();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+}
+static final int TRANSACTION_add = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+}
+public int add(int x, int y) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedTypedConstantsJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+}
+}
+public static final long L = -3L;
+public static final float F = 0.5f;
+public static final double D = 1.0e-3;
+public static final boolean B = true;
+public static final java.lang.String S = "name";
+}
+)";
+
+const char kExpectedEnumsJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_mix:
+{
+data.enforceInterface(DESCRIPTOR);
+byte[] _arg0;
+_arg0 = p.IFoo.Color.checked(data.createByteArray());
+byte _result = this.mix(_arg0);
+reply.writeNoException();
+reply.writeByte(_result);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public byte mix(byte[] colors) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+byte _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeByteArray(colors);
+mRemote.transact(Stub.TRANSACTION_mix, _data, _reply, 0);
+_reply.readException();
+_result = p.IFoo.Color.checked(_reply.readByte());
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+}
+static final int TRANSACTION_mix = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+}
+public static final class Color
+{
+public static final byte RED = 1;
+public static final byte GREEN = 2;
+public static final byte BLUE = 3;
+private Color() {}
+public static boolean isValid(long value)
+{
+return value - RED + Long.MIN_VALUE <= BLUE - RED + Long.MIN_VALUE;
+}
+public static byte checked(byte value)
+{
+if (!isValid(value)) {
+throw new IllegalArgumentException("Bad Color value " + value);
+}
+return value;
+}
+public static byte[] checked(byte[] values)
+{
+if (values != null) {
+for (byte value : values) {
+checked(value);
+}
+}
+return values;
+}
+}
+public byte mix(byte[] colors) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedNonNullParcelablesJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_sort:
+{
+data.enforceInterface(DESCRIPTOR);
+p.Bar[] _arg0;
+int _arg0_length = data.readInt();
+if ((_arg0_length<0)) {
+throw new android.os.BadParcelableException("bad array length");
+}
+_arg0 = new p.Bar[_arg0_length];
+for (int _i = 0; _i < _arg0.length; _i++) {
+_arg0[_i] = p.Bar.CREATOR.createFromParcel(data);
+}
+p.Bar _arg1;
+_arg1 = p.Bar.CREATOR.createFromParcel(data);
+p.Bar _arg2;
+if ((0!=data.readInt())) {
+_arg2 = p.Bar.CREATOR.createFromParcel(data);
+}
+else {
+_arg2 = null;
+}
+p.Bar[] _result = this.sort(_arg0, _arg1, _arg2);
+reply.writeNoException();
+reply.writeInt(_result.length);
+for (int _i = 0; _i < _result.length; _i++) {
+_result[_i].writeToParcel(reply, android.os.Parcelable.PARCELABLE_WRITE_RETURN_VALUE);
+}
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public p.Bar[] sort(p.Bar[] bars, p.Bar pivot, p.Bar other) throws android.os.RemoteException
+{
+if ((bars==null)) {
+throw new java.lang.NullPointerException("bars is @nonnull");
+}
+if ((pivot==null)) {
+throw new java.lang.NullPointerException("pivot is @nonnull");
+}
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+p.Bar[] _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(bars.length);
+for (int _i = 0; _i < bars.length; _i++) {
+bars[_i].writeToParcel(_data, 0);
+}
+pivot.writeToParcel(_data, 0);
+if ((other!=null)) {
+_data.writeInt(1);
+other.writeToParcel(_data, 0);
+}
+else {
+_data.writeInt(0);
+}
+mRemote.transact(Stub.TRANSACTION_sort, _data, _reply, 0);
+_reply.readException();
+int _result_length = _reply.readInt();
+if ((_result_length<0)) {
+throw new android.os.BadParcelableException("bad array length");
+}
+_result = new p.Bar[_result_length];
+for (int _i = 0; _i < _result.length; _i++) {
+_result[_i] = p.Bar.CREATOR.createFromParcel(_reply);
+}
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+}
+static final int TRANSACTION_sort = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+}
+public p.Bar[] sort(p.Bar[] bars, p.Bar pivot, p.Bar other) throws android.os.RemoteException;
+}
+)";
+
+const char kExpectedSkippableArgumentsJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: p/IFoo.aidl
+ */
+package p;
+public interface IFoo extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements p.IFoo
+{
+private static final java.lang.String DESCRIPTOR = "p.IFoo";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an p.IFoo interface,
+ * generating a proxy if needed.
+ */
+public static p.IFoo asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof p.IFoo))) {
+return ((p.IFoo)iin);
+}
+return new p.IFoo.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_f:
+{
+data.enforceInterface(DESCRIPTOR);
+int _aidl_out_mask = data.readInt();
+int _arg0;
+_arg0 = data.readInt();
+int[] _arg1;
+int _arg1_length = data.readInt();
+if ((_arg1_length<0)) {
+_arg1 = null;
+}
+else {
+_arg1 = new int[_arg1_length];
+}
+java.util.List _arg2;
+_arg2 = ((((_aidl_out_mask&0x4)!=0))?(new java.util.ArrayList()):(null));
+int[] _arg3;
+int _arg3_length = data.readInt();
+if ((_arg3_length<0)) {
+_arg3 = null;
+}
+else {
+_arg3 = new int[_arg3_length];
+}
+this.f(_arg0, _arg1, _arg2, _arg3);
+reply.writeNoException();
+if (((_aidl_out_mask&0x2)!=0)) {
+reply.writeIntArray(_arg1);
+}
+if (((_aidl_out_mask&0x4)!=0)) {
+reply.writeList(_arg2);
+}
+reply.writeIntArray(_arg3);
+return true;
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private static class Proxy implements p.IFoo
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public void f(int a, int[] b, java.util.List c, int[] d) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(((b!=null)?0x2:0)|((c!=null)?0x4:0));
+_data.writeInt(a);
+if ((b==null)) {
+_data.writeInt(-1);
+}
+else {
+_data.writeInt(b.length);
+}
+if ((d==null)) {
+_data.writeInt(-1);
+}
+else {
+_data.writeInt(d.length);
+}
+mRemote.transact(Stub.TRANSACTION_f, _data, _reply, 0);
+_reply.readException();
+if ((b!=null)) {
+_reply.readIntArray(b);
+}
+if ((c!=null)) {
+java.lang.ClassLoader cl = (java.lang.ClassLoader)this.getClass().getClassLoader();
+_reply.readList(c, cl);
+}
+_reply.readIntArray(d);
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+}
+}
+static final int TRANSACTION_f = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+}
+public void f(int a, int[] b, java.util.List c, int[] d) throws android.os.RemoteException;
+}
+)";
+
 }  // namespace
 
 class AidlTest : public ::testing::Test {
@@ -171,6 +2157,193 @@ TEST_F(AidlTest, AcceptsOneway) {
   EXPECT_NE(nullptr, Parse("a/IBar.aidl", oneway_interface, &java_types_));
 }
 
+TEST_F(AidlTest, ParsesShardKeyAnnotation) {
+  auto parse_result = Parse(
+      "a/IFoo.aidl",
+      "package a; interface IFoo { void f(int a, @shardKey String b); "
+      "int g(); }",
+      &cpp_types_);
+  ASSERT_NE(nullptr, parse_result);
+  ASSERT_EQ(2u, parse_result->GetMethods().size());
+  EXPECT_TRUE(parse_result->IsSharded());
+  const AidlArgument* key =
+      parse_result->GetMethods()[0]->GetShardKeyArgument();
+  ASSERT_NE(nullptr, key);
+  EXPECT_EQ("b", key->GetName());
+  EXPECT_EQ(nullptr, parse_result->GetMethods()[1]->GetShardKeyArgument());
+
+  EXPECT_FALSE(Parse("a/IBar.aidl", "package a; interface IBar { void f(); }",
+                     &cpp_types_)->IsSharded());
+}
+
+TEST_F(AidlTest, RejectsBadShardKeys) {
+  for (const char* method : {"void f(@shardKey int a, @shardKey int b);",
+                             "void f(out @shardKey int[] a);",
+                             "void f(in @shardKey int[] a);",
+                             "void f(in @shardKey byte a);",
+                             "void f(@shardKey @nullable String a);",
+                             "@shardKey int f(int a);"}) {
+    string contents = StringPrintf("package a; interface IFoo { %s }", method);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_)) << method;
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &java_types_)) << method;
+  }
+}
+
+TEST_F(AidlTest, GeneratesRouterInJava) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IStore.aidl";
+  options.output_file_name_ = "p/IStore.java";
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IStore {\n"
+                               "  String get(in @shardKey String key);\n"
+                               "  void put(@shardKey long id, in String v);\n"
+                               "  int count();\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string actual_contents;
+  EXPECT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &actual_contents));
+  EXPECT_EQ(kExpectedRouterJava, actual_contents);
+}
+
+TEST_F(AidlTest, RejectsBroadcastWithOutParameters) {
+  string contents = "package a; interface IFoo { void f(@shardKey long a); "
+                    "void g(out int[] b); }";
+  EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_));
+  EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &java_types_));
+  // Out parameters are fine on methods that go to exactly one shard.
+  contents = "package a; interface IFoo { void f(@shardKey long a, "
+             "out int[] b); }";
+  EXPECT_NE(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_));
+  EXPECT_NE(nullptr, Parse("a/IFoo.aidl", contents, &java_types_));
+}
+
+TEST_F(AidlTest, ParsesDeltaAnnotation) {
+  auto parse_result = Parse(
+      "a/IFoo.aidl",
+      "package a; interface IFoo { void f(inout @delta int[] a, "
+      "inout long[] b); }",
+      &cpp_types_);
+  ASSERT_NE(nullptr, parse_result);
+  const auto& arguments = parse_result->GetMethods()[0]->GetArguments();
+  EXPECT_TRUE(arguments[0]->GetType().IsDelta());
+  EXPECT_FALSE(arguments[1]->GetType().IsDelta());
+}
+
+TEST_F(AidlTest, RejectsBadDeltaArguments) {
+  for (const char* method : {"void f(in @delta int[] a);",
+                             "void f(out @delta int[] a);",
+                             "void f(inout @delta String[] a);",
+                             "void f(inout @delta byte[] a);",
+                             "void f(inout @nullable @delta int[] a);",
+                             "@delta int[] f();"}) {
+    const string contents =
+        StringPrintf("package a; interface IFoo { %s }", method);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_))
+        << method;
+  }
+}
+
+TEST_F(AidlTest, RejectsBadReuseArguments) {
+  io_delegate_.SetFileContents("a/Foo.aidl", "package a; parcelable Foo;");
+  import_paths_.push_back("");
+  for (const char* method : {"void f(out @reuse Foo a);",
+                             "void f(inout @reuse Foo a);",
+                             "void f(in @reuse Foo[] a);",
+                             "void f(in @reuse int a);",
+                             "void f(in @reuse String a);",
+                             "@reuse Foo f();"}) {
+    const string contents =
+        StringPrintf("package a; import a.Foo; interface IFoo { %s }", method);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &java_types_))
+        << method;
+  }
+  EXPECT_NE(nullptr, Parse("a/IFoo.aidl",
+                           "package a; import a.Foo; "
+                           "interface IFoo { void f(in @reuse Foo a); }",
+                           &java_types_));
+}
+
+TEST_F(AidlTest, RejectsBadMirroredMethods) {
+  io_delegate_.SetFileContents("a/Foo.aidl",
+                               "package a; parcelable Foo cpp_header \"a/Foo.h\";");
+  import_paths_.push_back("");
+  for (const char* method : {"@mirrored Foo f(int a);",
+                             "oneway @mirrored void f();",
+                             "@mirrored Foo[] f();",
+                             "@mirrored @nullable Foo f();",
+                             "@mirrored int f();",
+                             "@mirrored String f();",
+                             "void f(in @mirrored Foo a);"}) {
+    const string contents =
+        StringPrintf("package a; import a.Foo; interface IFoo { %s }", method);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_))
+        << method;
+  }
+  EXPECT_EQ(nullptr, Parse("a/IFoo.aidl",
+                           "package a; import a.Foo; "
+                           "oneway interface IFoo { @mirrored Foo f(); }",
+                           &cpp_types_));
+  unique_ptr<AidlInterface> interface =
+      Parse("a/IFoo.aidl",
+            "package a; import a.Foo; "
+            "interface IFoo { @mirrored Foo f(); Foo g(); }",
+            &cpp_types_);
+  ASSERT_NE(nullptr, interface);
+  EXPECT_TRUE(interface->HasMirroredMethods());
+  EXPECT_TRUE(interface->GetMethods()[0]->GetType().IsMirrored());
+  EXPECT_FALSE(interface->GetMethods()[1]->GetType().IsMirrored());
+}
+
+TEST_F(AidlTest, JavaRejectsDelta) {
+  JavaOptions options;
+  options.input_file_name_ = "a/IFoo.aidl";
+  options.output_file_name_ = "a/IFoo.java";
+  io_delegate_.SetFileContents(
+      options.input_file_name_,
+      "package a; interface IFoo { void f(inout @delta int[] a); }");
+  EXPECT_NE(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+}
+
+TEST_F(AidlTest, ParsesChainableAnnotation) {
+  auto parse_result = Parse(
+      "a/IFoo.aidl",
+      "package a; @chainable interface IFoo { int f(int a); "
+      "void g(out int[] b); oneway void h(); }",
+      &cpp_types_);
+  ASSERT_NE(nullptr, parse_result);
+  EXPECT_TRUE(parse_result->IsChainable());
+  const auto& methods = parse_result->GetMethods();
+  EXPECT_TRUE(methods[0]->CanBeChained());
+  EXPECT_FALSE(methods[1]->CanBeChained());
+  EXPECT_FALSE(methods[2]->CanBeChained());
+  EXPECT_FALSE(Parse("a/IBar.aidl", "package a; interface IBar { void f(); }",
+                     &cpp_types_)->IsChainable());
+}
+
+TEST_F(AidlTest, RejectsOnewayChainable) {
+  const string contents =
+      "package a; @chainable oneway interface IFoo { void f(int a); }";
+  EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_));
+  EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &java_types_));
+}
+
+TEST_F(AidlTest, JavaGeneratesCallChain) {
+  JavaOptions options;
+  options.input_file_name_ = "a/IFoo.aidl";
+  options.output_file_name_ = "a/IFoo.java";
+  io_delegate_.SetFileContents(
+      options.input_file_name_,
+      "package a; @chainable interface IFoo { int f(String a); "
+      "void g(int b, out int[] c); }");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedCallChainJava, output);
+}
+
 TEST_F(AidlTest, ParsesPreprocessedFile) {
   string simple_content = "parcelable a.Foo;\ninterface b.IBar;";
   io_delegate_.SetFileContents("path", simple_content);
@@ -227,6 +2400,63 @@ TEST_F(AidlTest, WritePreprocessedFile) {
   EXPECT_EQ("parcelable p.Outer.Inner;\ninterface one.IBar;\n", output);
 }
 
+TEST_F(AidlTest, BundlesImportClosure) {
+  io_delegate_.SetFileContents("src/a/IFoo.aidl",
+                               "package a; import b.Bar; import c.Baz;"
+                               "interface IFoo { void f(in Bar b, in Baz z); }");
+  io_delegate_.SetFileContents("other/b/Bar.aidl",
+                               "package b; parcelable Bar;");
+  io_delegate_.SetFileContents("other/b/Unused.aidl",
+                               "package b; parcelable Unused;");
+  io_delegate_.SetFileContents("preprocessed", "parcelable c.Baz;\n");
+
+  JavaOptions options;
+  options.task = JavaOptions::BUNDLE_AIDL;
+  options.import_paths_.push_back("other");
+  options.preprocessed_files_.push_back("preprocessed");
+  options.output_file_name_ = "foo.aidlbundle";
+  options.files_to_bundle_.push_back("src/a/IFoo.aidl");
+  EXPECT_TRUE(::android::aidl::bundle_aidl(options, io_delegate_));
+
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("foo.aidlbundle", &output));
+  unique_ptr<Bundle> bundle = Bundle::Parse(output);
+  ASSERT_NE(nullptr, bundle);
+  EXPECT_EQ(vector<string>{"src/a/IFoo.aidl"}, bundle->inputs_);
+  EXPECT_EQ(vector<string>{"preprocessed/0"}, bundle->preprocessed_files_);
+  EXPECT_EQ(vector<string>{"import"}, bundle->import_roots_);
+  EXPECT_NE(nullptr, bundle->GetFile("import/b/Bar.aidl"));
+  // Neither unreferenced files nor preprocessed types are bundled.
+  EXPECT_EQ(nullptr, bundle->GetFile("import/b/Unused.aidl"));
+  EXPECT_EQ(nullptr, bundle->GetFile("import/c/Baz.aidl"));
+}
+
+TEST_F(AidlTest, CompilesFromBundle) {
+  Bundle bundle;
+  bundle.inputs_.push_back("src/a/IFoo.aidl");
+  bundle.import_roots_.push_back("import");
+  bundle.AddFile("src/a/IFoo.aidl",
+                 "package a; import b.Bar;"
+                 "interface IFoo { void f(in Bar b); }");
+  bundle.AddFile("import/b/Bar.aidl", "package b; parcelable Bar;");
+  io_delegate_.SetFileContents("foo.aidlbundle", bundle.Serialize());
+
+  JavaOptions options;
+  options.task = JavaOptions::COMPILE_BUNDLE_TO_JAVA;
+  options.bundle_file_name_ = "foo.aidlbundle";
+  options.output_file_name_ = "IFoo.java";
+  EXPECT_EQ(0, ::android::aidl::compile_bundle_to_java(&options,
+                                                       io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("IFoo.java", &output));
+  EXPECT_EQ(kExpectedBundleJava, output);
+
+  // Truncated bundles are rejected.
+  const string serialized = bundle.Serialize();
+  EXPECT_EQ(nullptr,
+            Bundle::Parse(serialized.substr(0, serialized.size() - 2)));
+}
+
 TEST_F(AidlTest, RequireOuterClass) {
   io_delegate_.SetFileContents("p/Outer.aidl",
                                "package p; parcelable Outer.Inner;");
@@ -326,5 +2556,375 @@ TEST_F(AidlTest, WritesTrivialDependencyFileForParcelable) {
   EXPECT_EQ(actual_dep_file_contents, kExpectedParcelableDepFileContents);
 }
 
+TEST_F(AidlTest, GeneratesJavaForSharedRuntime) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  options.use_shared_runtime_ = true;
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IFoo {\n"
+                               "  int add(int x, int y);\n"
+                               "  oneway void fire(String s);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string actual_contents;
+  EXPECT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &actual_contents));
+  EXPECT_EQ(kExpectedSharedRuntimeJava, actual_contents);
+}
+
+TEST_F(AidlTest, GeneratesThreadLocalParcels) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  options.use_thread_local_parcels_ = true;
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IFoo {\n"
+                               "  int add(int x, int y);\n"
+                               "  oneway void fire(String s);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedThreadLocalParcelsJava, output);
+}
+
+TEST_F(AidlTest, GeneratesReusedParcelables) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  options.import_paths_.push_back("");
+  io_delegate_.SetFileContents("p/Bar.aidl", "package p; parcelable Bar;");
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "import p.Bar;\n"
+                               "interface IFoo {\n"
+                               "  /** Called a lot. */\n"
+                               "  void onBar(in @reuse Bar bar, in Bar other);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedReusedParcelablesJava, output);
+}
+
+TEST_F(AidlTest, GeneratesProxyCache) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IFoo {\n"
+                               "  int add(int x, int y);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedAddJava, output);
+
+  options.cache_proxies_ = true;
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedProxyCacheJava, output);
+}
+
+TEST_F(AidlTest, ParsesTypedConstants) {
+  auto parse_result = Parse(
+      "a/IFoo.aidl",
+      "package a; interface IFoo {\n"
+      "  const int I = -1;\n"
+      "  const long L = 10000000000L;\n"
+      "  const long SMALL_L = 5;\n"
+      "  const long BIG = 4000000000;\n"
+      "  const float F = +2.5f;\n"
+      "  const double D = 3;\n"
+      "  const boolean B = false;\n"
+      "  const String S = \"v1.0\";\n"
+      "}",
+      &cpp_types_);
+  ASSERT_NE(nullptr, parse_result);
+  const auto& constants = parse_result->GetConstants();
+  ASSERT_EQ(8u, constants.size());
+  EXPECT_EQ(AidlConstant::INT, constants[0]->GetType());
+  EXPECT_EQ(-1, constants[0]->GetValue());
+  EXPECT_EQ(AidlConstant::LONG, constants[1]->GetType());
+  EXPECT_EQ("10000000000", constants[1]->GetValueText());
+  EXPECT_EQ("5", constants[2]->GetValueText());
+  // Long constants don't need an L if they don't fit an int.
+  EXPECT_EQ(AidlConstant::LONG, constants[3]->GetType());
+  EXPECT_EQ("4000000000", constants[3]->GetValueText());
+  EXPECT_EQ(AidlConstant::FLOAT, constants[4]->GetType());
+  EXPECT_EQ("2.5", constants[4]->GetValueText());
+  EXPECT_EQ(AidlConstant::DOUBLE, constants[5]->GetType());
+  EXPECT_EQ("3.0", constants[5]->GetValueText());
+  EXPECT_EQ(AidlConstant::BOOLEAN, constants[6]->GetType());
+  EXPECT_EQ("false", constants[6]->GetValueText());
+  EXPECT_EQ(AidlConstant::STRING, constants[7]->GetType());
+  EXPECT_EQ("v1.0", constants[7]->GetValueText());
+}
+
+TEST_F(AidlTest, RejectsBadConstants) {
+  for (const char* constant : {"int X = 1L", "int X = 1.0", "long X = 1.0",
+                               "long X = 9223372036854775808L",
+                               "double X = 1.0f", "float X = 1.0e99f",
+                               "boolean X = 1", "String X = x",
+                               "String X = \"a\\n\"", "Foo X = 1"}) {
+    const string contents =
+        StringPrintf("package a; interface IFoo { const %s; }", constant);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &java_types_))
+        << constant;
+  }
+}
+
+TEST_F(AidlTest, RejectsIntegersOutOfRange) {
+  for (const char* member : {"const int X = 4000000000;",
+                             "const long X = 99999999999999999999;",
+                             "enum E : int { A = 4000000000 }",
+                             "enum E : long { A = -99999999999999999999 }",
+                             "void f() = 4294967297;"}) {
+    const string contents =
+        StringPrintf("package a; interface IFoo { %s }", member);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_))
+        << member;
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &java_types_))
+        << member;
+  }
+}
+
+TEST_F(AidlTest, GeneratesTypedConstantsInJava) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IFoo {\n"
+                               "  const long L = -3L;\n"
+                               "  const float F = 0.5;\n"
+                               "  const double D = 1.0e-3;\n"
+                               "  const boolean B = true;\n"
+                               "  const String S = \"name\";\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedTypedConstantsJava, output);
+}
+
+TEST_F(AidlTest, ParsesEnums) {
+  auto parse_result = Parse(
+      "a/IFoo.aidl",
+      "package a; interface IFoo {\n"
+      "  enum Color : byte { RED, GREEN = 4, BLUE }\n"
+      "  enum Size : long { SMALL = -9223372036854775808L, MEDIUM = 1L,"
+      " LARGE = 4000000000 }\n"
+      "  Color f(in Color[] colors, Size size);\n"
+      "}",
+      &cpp_types_);
+  ASSERT_NE(nullptr, parse_result);
+  const auto& enums = parse_result->GetEnums();
+  ASSERT_EQ(2u, enums.size());
+  EXPECT_EQ("byte", enums[0]->GetBackingType());
+  const auto& colors = enums[0]->GetEnumerators();
+  ASSERT_EQ(3u, colors.size());
+  EXPECT_EQ(0, colors[0].value);
+  EXPECT_EQ(4, colors[1].value);
+  EXPECT_EQ(5, colors[2].value);
+  EXPECT_FALSE(enums[0]->IsContiguous());
+  EXPECT_EQ(INT64_MIN, enums[1]->GetMin().value);
+  EXPECT_EQ("LARGE", enums[1]->GetMax().name);
+  EXPECT_EQ(4000000000, enums[1]->GetMax().value);
+  EXPECT_FALSE(enums[1]->IsContiguous());
+
+  const auto& method = parse_result->GetMethods()[0];
+  EXPECT_EQ("a.IFoo.Color",
+            method->GetType().GetLanguageType<ValidatableType>()
+                ->CanonicalName());
+}
+
+TEST_F(AidlTest, KnowsContiguousEnums) {
+  auto parse_result = Parse(
+      "a/IFoo.aidl",
+      "package a; interface IFoo {\n"
+      "  enum A : int { X = -1, Y, Z, ALIAS = 0 }\n"
+      "  enum B : byte { ONLY = 5 }\n"
+      "  enum C : long { LOW = -9223372036854775808L,"
+      " HIGH = 9223372036854775807L }\n"
+      "}",
+      &java_types_);
+  ASSERT_NE(nullptr, parse_result);
+  const auto& enums = parse_result->GetEnums();
+  ASSERT_EQ(3u, enums.size());
+  EXPECT_TRUE(enums[0]->IsContiguous());
+  EXPECT_TRUE(enums[1]->IsContiguous());
+  EXPECT_FALSE(enums[2]->IsContiguous());
+}
+
+TEST_F(AidlTest, RejectsBadEnums) {
+  for (const char* decl : {"enum E : short { A }",
+                           "enum E : Foo { A }",
+                           "enum E : byte { A = 128 }",
+                           "enum E : byte { A = 127, B }",
+                           "enum E : int { A = 1L }",
+                           "enum E : long { A = 1.0 }",
+                           "enum E : int { A = \"x\" }",
+                           "enum E : int { A, A }",
+                           "enum E : int { A } enum E : int { B }",
+                           "enum E : int { A } void f(in List<E> e);",
+                           "enum E : int { A } void f(out E e);"}) {
+    const string contents =
+        StringPrintf("package a; interface IFoo { %s }", decl);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_)) << decl;
+  }
+}
+
+TEST_F(AidlTest, GeneratesEnumsInJava) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IFoo {\n"
+                               "  enum Color : byte { RED = 1, GREEN, BLUE }\n"
+                               "  Color mix(in Color[] colors);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedEnumsJava, output);
+}
+
+TEST_F(AidlTest, GeneratesTraceContext) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IFoo {\n"
+                               "  int add(int x, int y);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedAddJava, output);
+
+  options.trace_context_ = true;
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedTraceContextJava, output);
+
+  // Call chain steps would arrive without one.
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "@chainable interface IFoo {\n"
+                               "  int add(int x, int y);\n"
+                               "}\n");
+  EXPECT_NE(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+}
+
+TEST_F(AidlTest, RejectsBadNonNullTypes) {
+  io_delegate_.SetFileContents("a/Foo.aidl",
+                               "package a; parcelable Foo cpp_header \"a/Foo.h\";");
+  import_paths_.push_back("");
+  for (const char* method : {"void f(in @nonnull int a);",
+                             "void f(in @nonnull String a);",
+                             "void f(in @nonnull List<Foo> a);",
+                             "void f(in @nullable @nonnull Foo a);",
+                             "@nonnull void f();",
+                             "@mirrored @nonnull Foo f();"}) {
+    const string contents =
+        StringPrintf("package a; import a.Foo; interface IFoo { %s }", method);
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_))
+        << method;
+  }
+  for (TypeNamespace* types :
+       {static_cast<TypeNamespace*>(&cpp_types_),
+        static_cast<TypeNamespace*>(&java_types_)}) {
+    unique_ptr<AidlInterface> interface = Parse(
+        "a/IFoo.aidl",
+        "package a; import a.Foo; interface IFoo {"
+        "  @nonnull Foo[] f(in @nonnull Foo a, out @nonnull Foo[] b);"
+        "}",
+        types);
+    ASSERT_NE(nullptr, interface);
+    const AidlMethod& method = *interface->GetMethods()[0];
+    EXPECT_TRUE(method.GetType().IsNonNull());
+    EXPECT_TRUE(method.GetArguments()[0]->GetType().IsNonNull());
+  }
+}
+
+TEST_F(AidlTest, GeneratesNonNullParcelablesInJava) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  options.import_paths_.push_back("");
+  io_delegate_.SetFileContents("p/Bar.aidl", "package p; parcelable Bar;");
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "import p.Bar;\n"
+                               "interface IFoo {\n"
+                               "  @nonnull Bar[] sort(in @nonnull Bar[] bars,"
+                               " in @nonnull Bar pivot, in Bar other);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedNonNullParcelablesJava, output);
+}
+
+TEST_F(AidlTest, RejectsBadSkippableArguments) {
+  string many_args;
+  for (int i = 0; i < 32; ++i) {
+    many_args += StringPrintf("in int a%d, ", i);
+  }
+  const string too_late = "void f(" + many_args + "out @skippable int[] b);";
+  for (const string& method : {string("void f(in @skippable int[] a);"),
+                               string("void f(inout @skippable int[] a);"),
+                               string("@skippable int[] f();"),
+                               too_late}) {
+    const string contents =
+        StringPrintf("package a; interface IFoo { %s }", method.c_str());
+    EXPECT_EQ(nullptr, Parse("a/IFoo.aidl", contents, &cpp_types_))
+        << method;
+  }
+  unique_ptr<AidlInterface> interface = Parse(
+      "a/IFoo.aidl",
+      "package a; interface IFoo {"
+      "  void f(in int a, out @skippable int[] b, out int[] c);"
+      "}",
+      &cpp_types_);
+  ASSERT_NE(nullptr, interface);
+  const AidlMethod& method = *interface->GetMethods()[0];
+  EXPECT_TRUE(method.HasSkippableArguments());
+  EXPECT_EQ(0x2u, method.GetOutMaskBit(*method.GetArguments()[1]));
+}
+
+TEST_F(AidlTest, GeneratesSkippableArgumentsInJava) {
+  JavaOptions options;
+  options.input_file_name_ = "p/IFoo.aidl";
+  options.output_file_name_ = "p/IFoo.java";
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               "package p;\n"
+                               "interface IFoo {\n"
+                               "  void f(in int a, out @skippable int[] b,"
+                               " out @skippable List c, out int[] d);\n"
+                               "}\n");
+  EXPECT_EQ(0, ::android::aidl::compile_aidl_to_java(options, io_delegate_));
+  string output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents(options.output_file_name_,
+                                              &output));
+  EXPECT_EQ(kExpectedSkippableArgumentsJava, output);
+}
+
 }  // namespace aidl
 }  // namespace android
@@ -76,16 +76,18 @@ Enum::EnumField::EnumField(const string& k, const string& v)
     : key(k),
       value(v) {}
 
-Enum::Enum(const string& name, const string& base_type)
-    : enum_name_(name), underlying_type_(base_type) {}
+Enum::Enum(const string& name, const string& base_type, bool is_class)
+    : enum_name_(name), underlying_type_(base_type), is_class_(is_class) {}
 
 Enum::Enum(const string& name) : Enum(name, "") {}
 
 void Enum::Write(CodeWriter* to) const {
+  const char* keyword = (is_class_) ? "enum class" : "enum";
   if (underlying_type_.empty()) {
-    to->Write("enum %s {\n", enum_name_.c_str());
+    to->Write("%s %s {\n", keyword, enum_name_.c_str());
   } else {
-    to->Write("enum %s : %s {\n", enum_name_.c_str(), underlying_type_.c_str());
+    to->Write("%s %s : %s {\n", keyword, enum_name_.c_str(),
+              underlying_type_.c_str());
   }
   for (const auto& field : fields_) {
     if (field.value.empty()) {
@@ -172,13 +174,21 @@ MethodDecl::MethodDecl(const std::string& return_type,
       is_const_(modifiers & IS_CONST),
       is_virtual_(modifiers & IS_VIRTUAL),
       is_override_(modifiers & IS_OVERRIDE),
-      is_pure_virtual_(modifiers & IS_PURE_VIRTUAL) {}
+      is_pure_virtual_(modifiers & IS_PURE_VIRTUAL),
+      is_static_(modifiers & IS_STATIC) {}
 
 void MethodDecl::Write(CodeWriter* to) const {
   if (is_virtual_)
     to->Write("virtual ");
 
-  to->Write("%s %s", return_type_.c_str(), name_.c_str());
+  if (is_static_)
+    to->Write("static ");
+
+  // Conversion operators have no return type.
+  if (!return_type_.empty())
+    to->Write("%s ", return_type_.c_str());
+
+  to->Write("%s", name_.c_str());
 
   arguments_.Write(to);
 
@@ -194,6 +204,13 @@ void MethodDecl::Write(CodeWriter* to) const {
   to->Write(";\n");
 }
 
+LiteralDecl::LiteralDecl(const std::string& expression)
+    : expression_(expression) {}
+
+void LiteralDecl::Write(CodeWriter* to) const {
+  to->Write("%s", expression_.c_str());
+}
+
 void StatementBlock::AddStatement(unique_ptr<AstNode> statement) {
   statements_.push_back(std::move(statement));
 }
@@ -264,7 +281,9 @@ StatementBlock* MethodImpl::GetStatementBlock() {
 }
 
 void MethodImpl::Write(CodeWriter* to) const {
-  to->Write("%s %s", return_type_.c_str(), method_name_.c_str());
+  if (!return_type_.empty())
+    to->Write("%s ", return_type_.c_str());
+  to->Write("%s", method_name_.c_str());
   arguments_.Write(to);
   to->Write("%s ", (is_const_method_) ? " const" : "");
   statements_.Write(to);
@@ -301,6 +320,18 @@ void SwitchStatement::Write(CodeWriter* to) const {
   to->Write("}\n");
 }
 
+ForStatement::ForStatement(const std::string& index,
+                           const std::string& begin,
+                           const std::string& end)
+    : index_(index),
+      begin_(begin),
+      end_(end) {}
+
+void ForStatement::Write(CodeWriter* to) const {
+  to->Write("for (size_t %s = %s; %s < %s; ++%s) ", index_.c_str(),
+            begin_.c_str(), index_.c_str(), end_.c_str(), index_.c_str());
+  body_.Write(to);
+}
 
 Assignment::Assignment(const std::string& left, const std::string& right)
     : Assignment(left, new LiteralExpression{right}) {}
@@ -75,7 +75,8 @@ class ClassDecl : public Declaration {
 
 class Enum : public Declaration {
  public:
-  Enum(const std::string& name, const std::string& base_type);
+  Enum(const std::string& name, const std::string& base_type,
+       bool is_class = false);
   explicit Enum(const std::string& name);
   virtual ~Enum() = default;
 
@@ -93,6 +94,7 @@ class Enum : public Declaration {
 
   std::string enum_name_;
   std::string underlying_type_;
+  bool is_class_;
   std::vector<EnumField> fields_;
 
   DISALLOW_COPY_AND_ASSIGN(Enum);
@@ -148,6 +150,7 @@ class MethodDecl : public Declaration {
     IS_VIRTUAL = 1 << 1,
     IS_OVERRIDE = 1 << 2,
     IS_PURE_VIRTUAL = 1 << 3,
+    IS_STATIC = 1 << 4,
   };
 
   MethodDecl(const std::string& return_type,
@@ -169,10 +172,23 @@ class MethodDecl : public Declaration {
   bool is_virtual_ = false;
   bool is_override_ = false;
   bool is_pure_virtual_ = false;
+  bool is_static_ = false;
 
   DISALLOW_COPY_AND_ASSIGN(MethodDecl);
 };  // class MethodDecl
 
+class LiteralDecl : public Declaration {
+ public:
+  explicit LiteralDecl(const std::string& expression);
+  ~LiteralDecl() = default;
+  void Write(CodeWriter* to) const override;
+
+ private:
+  const std::string expression_;
+
+  DISALLOW_COPY_AND_ASSIGN(LiteralDecl);
+};  // class LiteralDecl
+
 class StatementBlock : public Declaration {
  public:
   StatementBlock() = default;
@@ -256,6 +272,25 @@ class SwitchStatement : public AstNode {
   DISALLOW_COPY_AND_ASSIGN(SwitchStatement);
 };  // class SwitchStatement
 
+class ForStatement : public AstNode {
+ public:
+  // Loops a size_t named |index| over the half open range [|begin|, |end|).
+  ForStatement(const std::string& index,
+               const std::string& begin,
+               const std::string& end);
+  virtual ~ForStatement() = default;
+  StatementBlock* Body() { return &body_; }
+  void Write(CodeWriter* to) const override;
+
+ private:
+  const std::string index_;
+  const std::string begin_;
+  const std::string end_;
+  StatementBlock body_;
+
+  DISALLOW_COPY_AND_ASSIGN(ForStatement);
+};  // class ForStatement
+
 class Assignment : public AstNode {
  public:
   Assignment(const std::string& left, const std::string& right);
@@ -65,6 +65,13 @@ R"(enum Foo {
 };
 )";
 
+const char kExpectedEnumClassOutput[] =
+R"(enum class Color : int8_t {
+  RED = 0,
+  GREEN = 5,
+};
+)";
+
 const char kExpectedSwitchOutput[] =
 R"(switch (var) {
 case 2:
@@ -151,6 +158,13 @@ TEST_F(AstCppTests, GeneratesEnum) {
   CompareGeneratedCode(e, kExpectedEnumOutput);
 }
 
+TEST_F(AstCppTests, GeneratesEnumClass) {
+  Enum e("Color", "int8_t", true);
+  e.AddValue("RED", "0");
+  e.AddValue("GREEN", "5");
+  CompareGeneratedCode(e, kExpectedEnumClassOutput);
+}
+
 TEST_F(AstCppTests, GeneratesArgList) {
   ArgList simple("foo");
   CompareGeneratedCode(simple, "(foo)");
@@ -218,6 +232,17 @@ TEST_F(AstCppTests, GeneratesIfStatement) {
   CompareGeneratedCode(s2, "if (bar) {\non true1;\n}\n");
 }
 
+TEST_F(AstCppTests, GeneratesForStatement) {
+  ForStatement s("i", "0", "limit");
+  s.Body()->AddLiteral("foo(i)");
+  CompareGeneratedCode(s, "for (size_t i = 0; i < limit; ++i) {\nfoo(i);\n}\n");
+}
+
+TEST_F(AstCppTests, GeneratesLiteralDecl) {
+  LiteralDecl d("int32_t foo_;\n");
+  CompareGeneratedCode(d, "int32_t foo_;\n");
+}
+
 TEST_F(AstCppTests, GeneratesSwitchStatement) {
   SwitchStatement s("var");
   // These are intentionally out of alphanumeric order.  We're testing
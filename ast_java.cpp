@@ -71,8 +71,7 @@ void Field::Write(CodeWriter* to) const {
     to->Write("%s\n", this->comment.c_str());
   }
   WriteModifiers(to, this->modifiers, SCOPE_MASK | STATIC | FINAL | OVERRIDE);
-  to->Write("%s %s", this->variable->type->JavaType().c_str(),
-            this->variable->name.c_str());
+  this->variable->WriteDeclaration(to);
   if (this->value.length() != 0) {
     to->Write(" = %s", this->value.c_str());
   }
@@ -335,6 +334,24 @@ void FinallyStatement::Write(CodeWriter* to) const {
   this->statements->Write(to);
 }
 
+ForStatement::ForStatement(Variable* i, Expression* b, Expression* e)
+    : index(i), begin(b), end(e) {}
+
+void ForStatement::Write(CodeWriter* to) const {
+  to->Write("for (");
+  this->index->WriteDeclaration(to);
+  to->Write(" = ");
+  this->begin->Write(to);
+  to->Write("; ");
+  this->index->Write(to);
+  to->Write(" < ");
+  this->end->Write(to);
+  to->Write("; ");
+  this->index->Write(to);
+  to->Write("++) ");
+  this->statements->Write(to);
+}
+
 Case::Case(const string& c) { cases.push_back(c); }
 
 void Case::Write(CodeWriter* to) const {
@@ -419,7 +436,14 @@ void Method::Write(CodeWriter* to) const {
 
 void Constant::Write(CodeWriter* to) const {
   WriteModifiers(to, STATIC | FINAL | PUBLIC, ALL_MODIFIERS);
-  to->Write("int %s = %d;\n", name.c_str(), value);
+  to->Write("%s %s = %s;\n", type.c_str(), name.c_str(), value.c_str());
+}
+
+LiteralClassElement::LiteralClassElement(const std::string& value)
+    : value(value) {}
+
+void LiteralClassElement::Write(CodeWriter* to) const {
+  to->Write("%s", value.c_str());
 }
 
 void Class::Write(CodeWriter* to) const {
@@ -285,6 +285,18 @@ struct FinallyStatement : public Statement {
   void Write(CodeWriter* to) const override;
 };
 
+struct ForStatement : public Statement {
+  Variable* index;
+  Expression* begin;
+  Expression* end;
+  StatementBlock* statements = new StatementBlock;
+
+  // Loops |index| over the half open range [|begin|, |end|).
+  ForStatement(Variable* index, Expression* begin, Expression* end);
+  virtual ~ForStatement() = default;
+  void Write(CodeWriter* to) const override;
+};
+
 struct Case {
   std::vector<std::string> cases;
   StatementBlock* statements = new StatementBlock;
@@ -327,8 +339,10 @@ struct Method : public ClassElement {
 };
 
 struct Constant : public ClassElement {
+  std::string type = "int";
   std::string name;
-  int value;
+  // As a Java literal.
+  std::string value;
 
   Constant() = default;
   virtual ~Constant() = default;
@@ -336,6 +350,17 @@ struct Constant : public ClassElement {
   void Write(CodeWriter* to) const override;
 };
 
+// Members that are simpler to write out by hand than to build up from the
+// other elements, such as helper methods that do not depend on the input.
+struct LiteralClassElement : public ClassElement {
+  std::string value;
+
+  LiteralClassElement(const std::string& value);
+  virtual ~LiteralClassElement() = default;
+
+  void Write(CodeWriter* to) const override;
+};
+
 struct Class : public ClassElement {
   enum { CLASS, INTERFACE };
 
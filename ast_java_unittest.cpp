@@ -58,6 +58,37 @@ TEST(AstJavaTests, GeneratesClass) {
   EXPECT_EQ(string(kExpectedClassOutput), actual_output);
 }
 
+TEST(AstJavaTests, GeneratesLiteralClassElement) {
+  JavaTypeNamespace types;
+  types.Init();
+  Type class_type(&types, "TestClass", ValidatableType::KIND_GENERATED,
+                  false, false);
+  Class a_class;
+  a_class.what = Class::CLASS;
+  a_class.type = &class_type;
+  a_class.elements.push_back(new LiteralClassElement("int mCount;\n"));
+
+  string actual_output;
+  CodeWriterPtr writer = GetStringWriter(&actual_output);
+  a_class.Write(writer.get());
+  EXPECT_EQ(string("class TestClass\n{\nint mCount;\n}\n"), actual_output);
+}
+
+TEST(AstJavaTests, GeneratesForStatement) {
+  JavaTypeNamespace types;
+  types.Init();
+  ForStatement loop(new Variable(types.IntType(), "i"),
+                    new LiteralExpression("0"),
+                    new LiteralExpression("limit"));
+  loop.statements->Add(new MethodCall("foo", 1, loop.index));
+
+  string actual_output;
+  CodeWriterPtr writer = GetStringWriter(&actual_output);
+  loop.Write(writer.get());
+  EXPECT_EQ(string("for (int i = 0; i < limit; i++) {\nfoo(i);\n}\n"),
+            actual_output);
+}
+
 }  // namespace java
 }  // namespace aidl
 }  // namespace android
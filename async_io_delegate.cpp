@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "async_io_delegate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+
+#include <android-base/stringprintf.h>
+
+#include "logging.h"
+
+using android::base::StringAppendV;
+using std::future;
+using std::mutex;
+using std::packaged_task;
+using std::shared_ptr;
+using std::string;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+
+namespace {
+
+// How long a thread without a jobserver token waits for one before looking
+// at the queue again.
+const std::chrono::milliseconds kTokenPollInterval(10);
+
+// Collects everything written to it and hands it to the AsyncIoDelegate
+// when closed.
+class AsyncCodeWriter : public CodeWriter {
+ public:
+  AsyncCodeWriter(const AsyncIoDelegate* io_delegate, const string& file_path)
+      : io_delegate_(io_delegate),
+        file_path_(file_path),
+        contents_(new string) {}
+  virtual ~AsyncCodeWriter() { Close(); }
+
+  bool Write(const char* format, ...) override {
+    if (!contents_) {
+      return false;
+    }
+    va_list ap;
+    va_start(ap, format);
+    StringAppendV(contents_.get(), format, ap);
+    va_end(ap);
+    return true;
+  }
+
+  bool Close() override {
+    if (contents_) {
+      io_delegate_->QueueWrite(file_path_, std::move(contents_));
+    }
+    return true;
+  }
+
+ private:
+  const AsyncIoDelegate* io_delegate_;
+  const string file_path_;
+  unique_ptr<string> contents_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncCodeWriter);
+};  // class AsyncCodeWriter
+
+}  // namespace
+
+template <typename Result>
+future<Result> AsyncIoDelegate::Async(
+    std::function<Result()> function) const {
+  // std::function needs a copyable target, and tasks are move only.
+  shared_ptr<packaged_task<Result()>> task(
+      new packaged_task<Result()>(std::move(function)));
+  future<Result> result = task->get_future();
+  Post([task]() { (*task)(); });
+  return result;
+}
+
+AsyncIoDelegate::AsyncIoDelegate(const IoDelegate& io_delegate,
+                                 size_t thread_count,
+                                 JobserverClient* jobserver)
+    : io_delegate_(io_delegate), jobserver_(jobserver) {
+  for (size_t i = 0; i < std::max<size_t>(thread_count, 1); ++i) {
+    // The first thread runs on the token make gave this process.
+    const bool needs_token = jobserver_ != nullptr && i > 0;
+    threads_.emplace_back(&AsyncIoDelegate::Work, this, needs_token);
+  }
+}
+
+AsyncIoDelegate::~AsyncIoDelegate() {
+  FinishWrites();
+  {
+    std::lock_guard<mutex> guard(lock_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+future<unique_ptr<string>> AsyncIoDelegate::GetFileContentsAsync(
+    const string& filename,
+    const string& content_suffix) const {
+  // A task can't wait for a prefetch queued behind it, which may only run
+  // once this task is done.
+  return Async<unique_ptr<string>>([this, filename, content_suffix]() {
+    return ReadFileContents(filename, content_suffix, false);
+  });
+}
+
+future<bool> AsyncIoDelegate::FileIsReadableAsync(const string& path) const {
+  return Async<bool>([this, path]() { return LookUpFile(path, false); });
+}
+
+future<bool> AsyncIoDelegate::CreatedNestedDirsAsync(
+    const string& base_dir,
+    const vector<string>& nested_subdirs) const {
+  return Async<bool>([this, base_dir, nested_subdirs]() {
+    return io_delegate_.CreatedNestedDirs(base_dir, nested_subdirs);
+  });
+}
+
+bool AsyncIoDelegate::FinishWrites() const {
+  unique_lock<mutex> guard(lock_);
+  writes_done_.wait(guard, [this]() { return pending_writes_ == 0; });
+  return !write_failed_;
+}
+
+unique_ptr<string> AsyncIoDelegate::GetFileContents(
+    const string& filename,
+    const string& content_suffix) const {
+  return ReadFileContents(filename, content_suffix, true);
+}
+
+unique_ptr<LineReader> AsyncIoDelegate::GetLineReader(
+    const string& file_path) const {
+  shared_ptr<const string> prefetched;
+  if (!GetPrefetched(file_path, true, true, &prefetched)) {
+    return io_delegate_.GetLineReader(file_path);
+  }
+  if (!prefetched) {
+    return nullptr;
+  }
+  return LineReader::ReadFromMemory(*prefetched);
+}
+
+bool AsyncIoDelegate::FileIsReadable(const string& path) const {
+  return LookUpFile(path, true);
+}
+
+bool AsyncIoDelegate::CreatedNestedDirs(
+    const string& base_dir,
+    const vector<string>& nested_subdirs) const {
+  return io_delegate_.CreatedNestedDirs(base_dir, nested_subdirs);
+}
+
+unique_ptr<CodeWriter> AsyncIoDelegate::GetCodeWriter(
+    const string& file_path) const {
+  ForgetPrefetched(file_path);
+  return unique_ptr<CodeWriter>(new AsyncCodeWriter(this, file_path));
+}
+
+void AsyncIoDelegate::RemovePath(const string& file_path) const {
+  // The path may be a file we are still writing.
+  FinishWrites();
+  ForgetPrefetched(file_path);
+  io_delegate_.RemovePath(file_path);
+}
+
+void AsyncIoDelegate::PrefetchFiles(const vector<string>& paths) const {
+  for (const string& path : paths) {
+    shared_ptr<packaged_task<shared_ptr<const string>()>> task(
+        new packaged_task<shared_ptr<const string>()>([this, path]() {
+          shared_ptr<const string> contents;
+          if (io_delegate_.FileIsReadable(path)) {
+            contents = io_delegate_.GetFileContents(path);
+          }
+          return contents;
+        }));
+    {
+      std::lock_guard<mutex> guard(lock_);
+      if (prefetched_.count(path) > 0) {
+        continue;
+      }
+      prefetched_[path] = task->get_future().share();
+    }
+    Post([task]() { (*task)(); });
+  }
+}
+
+void AsyncIoDelegate::QueueWrite(const string& file_path,
+                                 unique_ptr<string> contents) const {
+  {
+    std::lock_guard<mutex> guard(lock_);
+    ++pending_writes_;
+  }
+  shared_ptr<string> shared_contents(std::move(contents));
+  Post([this, file_path, shared_contents]() {
+    unique_ptr<CodeWriter> writer = io_delegate_.GetCodeWriter(file_path);
+    bool success = writer != nullptr &&
+                   writer->Write("%s", shared_contents->c_str()) &&
+                   writer->Close();
+    if (!success) {
+      LOG(ERROR) << "Failed to write " << file_path;
+    }
+    std::lock_guard<mutex> guard(lock_);
+    write_failed_ = write_failed_ || !success;
+    if (--pending_writes_ == 0) {
+      writes_done_.notify_all();
+    }
+  });
+}
+
+void AsyncIoDelegate::Post(std::function<void()> task) const {
+  {
+    std::lock_guard<mutex> guard(lock_);
+    tasks_.push_back(std::move(task));
+  }
+  work_available_.notify_one();
+}
+
+void AsyncIoDelegate::Work(bool needs_token) const {
+  bool has_token = !needs_token;
+  while (true) {
+    std::function<void()> task;
+    {
+      unique_lock<mutex> guard(lock_);
+      if (needs_token && has_token && tasks_.empty()) {
+        // Hand the slot back to the build as soon as we run dry.
+        guard.unlock();
+        jobserver_->Release();
+        has_token = false;
+        guard.lock();
+      }
+      work_available_.wait(guard,
+                           [this]() { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        break;
+      }
+      if (has_token) {
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+    }
+    if (task) {
+      task();
+    } else if (!jobserver_->TryAcquire()) {
+      // Leave the work to the other threads until a slot frees up.
+      jobserver_->WaitForToken(kTokenPollInterval);
+    } else {
+      has_token = true;
+    }
+  }
+  if (needs_token && has_token) {
+    jobserver_->Release();
+  }
+}
+
+unique_ptr<string> AsyncIoDelegate::ReadFileContents(
+    const string& filename,
+    const string& content_suffix,
+    bool wait) const {
+  shared_ptr<const string> prefetched;
+  if (!GetPrefetched(filename, true, wait, &prefetched)) {
+    return io_delegate_.GetFileContents(filename, content_suffix);
+  }
+  if (!prefetched) {
+    return nullptr;
+  }
+  return unique_ptr<string>(new string(*prefetched + content_suffix));
+}
+
+bool AsyncIoDelegate::LookUpFile(const string& path, bool wait) const {
+  shared_ptr<const string> prefetched;
+  if (!GetPrefetched(path, false, wait, &prefetched)) {
+    return io_delegate_.FileIsReadable(path);
+  }
+  return prefetched != nullptr;
+}
+
+bool AsyncIoDelegate::GetPrefetched(const string& path, bool consume,
+                                    bool wait,
+                                    shared_ptr<const string>* contents) const {
+  Prefetched prefetched;
+  {
+    std::lock_guard<mutex> guard(lock_);
+    auto it = prefetched_.find(path);
+    if (it == prefetched_.end()) {
+      return false;
+    }
+    if (!wait && it->second.wait_for(std::chrono::seconds(0)) !=
+                     std::future_status::ready) {
+      return false;
+    }
+    prefetched = it->second;
+    if (consume) {
+      prefetched_.erase(it);
+    }
+  }
+  *contents = prefetched.get();
+  return true;
+}
+
+void AsyncIoDelegate::ForgetPrefetched(const string& path) const {
+  std::lock_guard<mutex> guard(lock_);
+  prefetched_.erase(path);
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_ASYNC_IO_DELEGATE_H_
+#define AIDL_ASYNC_IO_DELEGATE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "io_delegate.h"
+#include "jobserver.h"
+
+namespace android {
+namespace aidl {
+
+// Runs the operations of another IoDelegate on a pool of threads, so that
+// the compiler can look for imports and write outputs while it works on
+// something else.
+//
+// Files passed to PrefetchFiles() are read in the background and later
+// reads of them are served from memory.  Closing a CodeWriter from
+// GetCodeWriter() only queues its contents to be written; failures to write
+// are reported by FinishWrites().  |io_delegate| must be safe to call from
+// several threads at once.
+//
+// Given a |jobserver|, every thread but one holds a token from it while it
+// has work, so that the pool stays within the job slots of the build that
+// runs the compiler.  The one thread left always makes progress, even if
+// the build has no slots to spare.
+class AsyncIoDelegate : public IoDelegate {
+ public:
+  // Uses at least one thread.  |jobserver| may be null, and must outlive
+  // the AsyncIoDelegate.
+  AsyncIoDelegate(const IoDelegate& io_delegate, size_t thread_count,
+                  JobserverClient* jobserver = nullptr);
+  // Waits for queued writes to finish.
+  virtual ~AsyncIoDelegate();
+
+  // Asynchronous variants of the IoDelegate methods.
+  std::future<std::unique_ptr<std::string>> GetFileContentsAsync(
+      const std::string& filename,
+      const std::string& content_suffix = "") const;
+  std::future<bool> FileIsReadableAsync(const std::string& path) const;
+  std::future<bool> CreatedNestedDirsAsync(
+      const std::string& base_dir,
+      const std::vector<std::string>& nested_subdirs) const;
+
+  // Waits for every write queued so far and returns false if any of them
+  // failed.
+  bool FinishWrites() const;
+
+  // Overrides from IoDelegate
+  std::unique_ptr<std::string> GetFileContents(
+      const std::string& filename,
+      const std::string& content_suffix = "") const override;
+  std::unique_ptr<LineReader> GetLineReader(
+      const std::string& file_path) const override;
+  bool FileIsReadable(const std::string& path) const override;
+  bool CreatedNestedDirs(
+      const std::string& base_dir,
+      const std::vector<std::string>& nested_subdirs) const override;
+  std::unique_ptr<CodeWriter> GetCodeWriter(
+      const std::string& file_path) const override;
+  void RemovePath(const std::string& file_path) const override;
+  void PrefetchFiles(const std::vector<std::string>& paths) const override;
+
+  // Queues |contents| to be written to |file_path|.  Used by the writers
+  // that GetCodeWriter() returns.
+  void QueueWrite(const std::string& file_path,
+                  std::unique_ptr<std::string> contents) const;
+
+ private:
+  // Contents of a prefetched file, or nullptr if it could not be read.
+  using Prefetched = std::shared_future<std::shared_ptr<const std::string>>;
+
+  // Runs |function| on one of the threads and returns its result.
+  template <typename Result>
+  std::future<Result> Async(std::function<Result()> function) const;
+  // Runs |task| on one of the threads.
+  void Post(std::function<void()> task) const;
+  // Runs tasks until the AsyncIoDelegate stops.  If |needs_token|, only
+  // while holding a jobserver token.
+  void Work(bool needs_token) const;
+  // GetFileContents() and FileIsReadable(), which only use prefetched
+  // contents that are already read unless |wait| is set.
+  std::unique_ptr<std::string> ReadFileContents(
+      const std::string& filename, const std::string& content_suffix,
+      bool wait) const;
+  bool LookUpFile(const std::string& path, bool wait) const;
+  // Returns false if |path| was not prefetched, or is still being read and
+  // |wait| is not set.  Otherwise waits for it to be read, stores its
+  // contents to |*contents|, and forgets them if |consume| is set.
+  bool GetPrefetched(const std::string& path, bool consume, bool wait,
+                     std::shared_ptr<const std::string>* contents) const;
+  void ForgetPrefetched(const std::string& path) const;
+
+  const IoDelegate& io_delegate_;
+  JobserverClient* const jobserver_;
+
+  mutable std::mutex lock_;
+  mutable std::condition_variable work_available_;
+  mutable std::condition_variable writes_done_;
+  mutable std::deque<std::function<void()>> tasks_;
+  mutable std::map<std::string, Prefetched> prefetched_;
+  mutable size_t pending_writes_ = 0;
+  mutable bool write_failed_ = false;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncIoDelegate);
+};  // class AsyncIoDelegate
+
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_ASYNC_IO_DELEGATE_H_
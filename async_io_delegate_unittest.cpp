@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android-base/stringprintf.h>
+#include <gtest/gtest.h>
+
+#include "aidl.h"
+#include "async_io_delegate.h"
+#include "options.h"
+#include "tests/slow_io_delegate.h"
+
+using android::aidl::test::SlowIoDelegate;
+using android::base::StringPrintf;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+
+class AsyncIoDelegateTest : public ::testing::Test {
+ protected:
+  SlowIoDelegate slow_io_delegate_;
+};
+
+TEST_F(AsyncIoDelegateTest, ServesPrefetchedFiles) {
+  slow_io_delegate_.SetFileContents("a/Foo.aidl", "contents");
+  AsyncIoDelegate io_delegate(slow_io_delegate_, 2);
+  io_delegate.PrefetchFiles({"a/Foo.aidl", "b/Foo.aidl"});
+
+  EXPECT_FALSE(io_delegate.FileIsReadable("b/Foo.aidl"));
+  EXPECT_TRUE(io_delegate.FileIsReadable("a/Foo.aidl"));
+  unique_ptr<string> contents =
+      io_delegate.GetFileContents("a/Foo.aidl", "!");
+  ASSERT_NE(nullptr, contents);
+  EXPECT_EQ("contents!", *contents);
+  // Each file was looked up once and only the one that exists was read.
+  EXPECT_EQ(2u, slow_io_delegate_.GetCallCount(SlowIoDelegate::FILE_IS_READABLE));
+  EXPECT_EQ(1u, slow_io_delegate_.GetCallCount(SlowIoDelegate::GET_FILE_CONTENTS));
+
+  // Prefetched contents are only used once.
+  contents = io_delegate.GetFileContents("a/Foo.aidl");
+  ASSERT_NE(nullptr, contents);
+  EXPECT_EQ("contents", *contents);
+  EXPECT_EQ(2u, slow_io_delegate_.GetCallCount(SlowIoDelegate::GET_FILE_CONTENTS));
+}
+
+TEST_F(AsyncIoDelegateTest, RunsAsyncVariants) {
+  slow_io_delegate_.SetFileContents("a/Foo.aidl", "contents");
+  AsyncIoDelegate io_delegate(slow_io_delegate_, 2);
+  auto readable = io_delegate.FileIsReadableAsync("a/Foo.aidl");
+  auto missing = io_delegate.FileIsReadableAsync("a/Bar.aidl");
+  auto contents = io_delegate.GetFileContentsAsync("a/Foo.aidl");
+  auto dirs = io_delegate.CreatedNestedDirsAsync("out", {"a", "b"});
+  EXPECT_TRUE(readable.get());
+  EXPECT_FALSE(missing.get());
+  unique_ptr<string> read = contents.get();
+  ASSERT_NE(nullptr, read);
+  EXPECT_EQ("contents", *read);
+  EXPECT_TRUE(dirs.get());
+}
+
+TEST_F(AsyncIoDelegateTest, RunsAsyncVariantsAheadOfPrefetches) {
+  slow_io_delegate_.SetFileContents("a/Foo.aidl", "contents");
+  slow_io_delegate_.SetLatency(SlowIoDelegate::FILE_IS_READABLE,
+                               std::chrono::milliseconds(20));
+  AsyncIoDelegate io_delegate(slow_io_delegate_, 1);
+  // Keeps the only thread busy while the rest is queued behind it.
+  io_delegate.PrefetchFiles({"busy"});
+  auto contents = io_delegate.GetFileContentsAsync("a/Foo.aidl");
+  auto readable = io_delegate.FileIsReadableAsync("a/Foo.aidl");
+  io_delegate.PrefetchFiles({"a/Foo.aidl"});
+
+  // Neither waits for the prefetch that is queued after it.
+  ASSERT_EQ(std::future_status::ready,
+            contents.wait_for(std::chrono::seconds(10)));
+  unique_ptr<string> read = contents.get();
+  ASSERT_NE(nullptr, read);
+  EXPECT_EQ("contents", *read);
+  ASSERT_EQ(std::future_status::ready,
+            readable.wait_for(std::chrono::seconds(10)));
+  EXPECT_TRUE(readable.get());
+}
+
+TEST_F(AsyncIoDelegateTest, WritesOnClose) {
+  string written;
+  {
+    AsyncIoDelegate io_delegate(slow_io_delegate_, 2);
+    unique_ptr<CodeWriter> writer = io_delegate.GetCodeWriter("out/a.txt");
+    EXPECT_TRUE(writer->Write("%s %d", "one", 2));
+    EXPECT_FALSE(slow_io_delegate_.GetWrittenContents("out/a.txt", nullptr));
+    EXPECT_TRUE(writer->Close());
+    EXPECT_TRUE(io_delegate.FinishWrites());
+    EXPECT_TRUE(slow_io_delegate_.GetWrittenContents("out/a.txt", &written));
+    EXPECT_EQ("one 2", written);
+
+    // Writers that are dropped without being closed are still written.
+    writer = io_delegate.GetCodeWriter("out/b.txt");
+    writer->Write("three");
+  }
+  EXPECT_TRUE(slow_io_delegate_.GetWrittenContents("out/b.txt", &written));
+  EXPECT_EQ("three", written);
+}
+
+TEST_F(AsyncIoDelegateTest, ReportsFailedWrites) {
+  slow_io_delegate_.AddBrokenFilePath("out/a.txt");
+  AsyncIoDelegate io_delegate(slow_io_delegate_, 1);
+  unique_ptr<CodeWriter> writer = io_delegate.GetCodeWriter("out/a.txt");
+  writer->Write("contents");
+  writer->Close();
+  EXPECT_FALSE(io_delegate.FinishWrites());
+}
+
+TEST_F(AsyncIoDelegateTest, RemovesAfterWriting) {
+  AsyncIoDelegate io_delegate(slow_io_delegate_, 2);
+  slow_io_delegate_.SetLatency(SlowIoDelegate::GET_CODE_WRITER,
+                               std::chrono::milliseconds(10));
+  unique_ptr<CodeWriter> writer = io_delegate.GetCodeWriter("out/a.txt");
+  writer->Write("contents");
+  writer->Close();
+  io_delegate.RemovePath("out/a.txt");
+  EXPECT_TRUE(slow_io_delegate_.PathWasRemoved("out/a.txt"));
+}
+
+TEST_F(AsyncIoDelegateTest, CompilesJava) {
+  const char* argv[] = {"aidl", "-Iinclude0", "-Iinclude1", "src/p/IFoo.aidl",
+                        "out/IFoo.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(nullptr, options);
+  slow_io_delegate_.SetFileContents(
+      "src/p/IFoo.aidl",
+      "package p; import q.Bar; interface IFoo { void f(in Bar b); }");
+  slow_io_delegate_.SetFileContents("include1/q/Bar.aidl",
+                                    "package q; parcelable Bar;");
+
+  string sync_output;
+  ASSERT_EQ(0, compile_aidl_to_java(*options, slow_io_delegate_));
+  ASSERT_TRUE(slow_io_delegate_.GetWrittenContents("out/IFoo.java",
+                                                   &sync_output));
+
+  slow_io_delegate_.ResetCallCounts();
+  {
+    AsyncIoDelegate io_delegate(slow_io_delegate_, 4);
+    ASSERT_EQ(0, compile_aidl_to_java(*options, io_delegate));
+    EXPECT_TRUE(io_delegate.FinishWrites());
+  }
+  string async_output;
+  ASSERT_TRUE(slow_io_delegate_.GetWrittenContents("out/IFoo.java",
+                                                   &async_output));
+  EXPECT_EQ(sync_output, async_output);
+  // Both candidate paths for the import were prefetched.
+  EXPECT_EQ(2u, slow_io_delegate_.GetCallCount(SlowIoDelegate::FILE_IS_READABLE));
+}
+
+TEST_F(AsyncIoDelegateTest, StaysWithinJobserverSlots) {
+  const auto latency = std::chrono::milliseconds(50);
+  slow_io_delegate_.SetLatency(SlowIoDelegate::FILE_IS_READABLE, latency);
+  const vector<string> paths = {"a", "b", "c", "d", "e", "f", "g", "h"};
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  unique_ptr<JobserverClient> jobserver = JobserverClient::FromMakeflags(
+      StringPrintf("-j4 --jobserver-auth=%d,%d", fds[0], fds[1]));
+  ASSERT_NE(nullptr, jobserver);
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+  // Time to look up every path with |tokens| slots free besides our own.
+  auto look_up = [&](size_t tokens) {
+    EXPECT_EQ(static_cast<ssize_t>(tokens),
+              write(fds[1], "+++", tokens));
+    const auto start = std::chrono::steady_clock::now();
+    {
+      AsyncIoDelegate io_delegate(slow_io_delegate_, 4, jobserver.get());
+      io_delegate.PrefetchFiles(paths);
+      for (const string& path : paths) {
+        EXPECT_FALSE(io_delegate.FileIsReadable(path));
+      }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    // Every token came back.
+    EXPECT_EQ(0u, jobserver->HeldTokens());
+    char drained[4];
+    const ssize_t returned = read(fds[0], drained, sizeof(drained));
+    EXPECT_EQ(static_cast<ssize_t>(tokens), std::max<ssize_t>(returned, 0));
+    return elapsed;
+  };
+
+  // With no slots to spare a single thread does all the work.
+  EXPECT_LE(latency * paths.size(), look_up(0));
+  EXPECT_GT(latency * paths.size(), look_up(3));
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+}  // namespace aidl
+}  // namespace android
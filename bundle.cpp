@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bundle.h"
+
+#include <cstdlib>
+
+#include <android-base/stringprintf.h>
+
+#include "logging.h"
+#include "os.h"
+
+using android::base::StringAppendF;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+
+// A bundle is a short text manifest followed by length prefixed files:
+//
+//   aidl-bundle 1
+//   input src/foo/IFoo.aidl
+//   preprocessed preprocessed/0
+//   import-root import
+//   file import/foo/Bar.aidl 36
+//   <36 bytes of contents>
+//
+// Each file's contents are followed by a newline to keep the bundle
+// readable.
+
+namespace {
+
+const char kHeader[] = "aidl-bundle 1";
+const char kInput[] = "input";
+const char kPreprocessed[] = "preprocessed";
+const char kImportRootEntry[] = "import-root";
+const char kFile[] = "file";
+
+// Moves |*pos| past the next line of |contents| and stores the line without
+// its newline in |*line|.
+bool NextLine(const string& contents, size_t* pos, string* line) {
+  if (*pos >= contents.size()) {
+    return false;
+  }
+  size_t end = contents.find('\n', *pos);
+  if (end == string::npos) {
+    return false;
+  }
+  *line = contents.substr(*pos, end - *pos);
+  *pos = end + 1;
+  return true;
+}
+
+// Splits "<keyword> <value>" in two.
+bool SplitEntry(const string& line, string* keyword, string* value) {
+  size_t space = line.find(' ');
+  if (space == string::npos || space == 0 || space + 1 == line.size()) {
+    return false;
+  }
+  *keyword = line.substr(0, space);
+  *value = line.substr(space + 1);
+  return true;
+}
+
+string ToBundlePath(const string& path) {
+  string bundle_path = path;
+  for (char& c : bundle_path) {
+    if (c == OS_PATH_SEPARATOR) {
+      c = '/';
+    }
+  }
+  return bundle_path;
+}
+
+}  // namespace
+
+const char Bundle::kSuffix[] = ".aidlbundle";
+const char Bundle::kImportRoot[] = "import";
+
+unique_ptr<Bundle> Bundle::Parse(const string& contents) {
+  unique_ptr<Bundle> bundle(new Bundle);
+  size_t pos = 0;
+  string line;
+  if (!NextLine(contents, &pos, &line) || line != kHeader) {
+    LOG(ERROR) << "Not an aidl bundle";
+    return nullptr;
+  }
+
+  while (NextLine(contents, &pos, &line)) {
+    string keyword, value;
+    if (!SplitEntry(line, &keyword, &value)) {
+      LOG(ERROR) << "Malformed bundle entry: '" << line << "'";
+      return nullptr;
+    }
+    if (keyword == kInput) {
+      bundle->inputs_.push_back(value);
+    } else if (keyword == kPreprocessed) {
+      bundle->preprocessed_files_.push_back(value);
+    } else if (keyword == kImportRootEntry) {
+      bundle->import_roots_.push_back(value);
+    } else if (keyword == kFile) {
+      string path, size_string;
+      if (!SplitEntry(value, &path, &size_string)) {
+        LOG(ERROR) << "Malformed bundle entry: '" << line << "'";
+        return nullptr;
+      }
+      char* end = nullptr;
+      const unsigned long long size =
+          strtoull(size_string.c_str(), &end, 10);
+      // The contents must fit, along with their trailing newline.
+      if (*end != '\0' || size >= contents.size() - pos ||
+          contents[pos + size] != '\n') {
+        LOG(ERROR) << "Bundle is truncated at " << path;
+        return nullptr;
+      }
+      if (!bundle->AddFile(path, contents.substr(pos, size))) {
+        return nullptr;
+      }
+      pos += size + 1;
+    } else {
+      LOG(ERROR) << "Unknown bundle entry: '" << keyword << "'";
+      return nullptr;
+    }
+  }
+  if (pos != contents.size()) {
+    LOG(ERROR) << "Bundle has trailing data";
+    return nullptr;
+  }
+
+  for (const string& path : bundle->inputs_) {
+    if (bundle->GetFile(path) == nullptr) {
+      LOG(ERROR) << "Bundle does not contain input " << path;
+      return nullptr;
+    }
+  }
+  for (const string& path : bundle->preprocessed_files_) {
+    if (bundle->GetFile(path) == nullptr) {
+      LOG(ERROR) << "Bundle does not contain preprocessed file " << path;
+      return nullptr;
+    }
+  }
+  return bundle;
+}
+
+string Bundle::Serialize() const {
+  string contents = kHeader;
+  contents += '\n';
+  for (const string& path : inputs_) {
+    StringAppendF(&contents, "%s %s\n", kInput, path.c_str());
+  }
+  for (const string& path : preprocessed_files_) {
+    StringAppendF(&contents, "%s %s\n", kPreprocessed, path.c_str());
+  }
+  for (const string& root : import_roots_) {
+    StringAppendF(&contents, "%s %s\n", kImportRootEntry, root.c_str());
+  }
+  for (const auto& file : files_) {
+    StringAppendF(&contents, "%s %s %s\n", kFile, file.first.c_str(),
+                  std::to_string(file.second.size()).c_str());
+    contents += file.second;
+    contents += '\n';
+  }
+  return contents;
+}
+
+bool Bundle::AddFile(const string& path, const string& contents) {
+  if (path.empty() || path.find(' ') != string::npos ||
+      path.find('\n') != string::npos) {
+    LOG(ERROR) << "Cannot bundle a file at '" << path << "'";
+    return false;
+  }
+  auto it = files_.find(path);
+  if (it != files_.end()) {
+    if (it->second != contents) {
+      LOG(ERROR) << "Bundle has two different files at " << path;
+      return false;
+    }
+    return true;
+  }
+  files_[path] = contents;
+  return true;
+}
+
+const string* Bundle::GetFile(const string& path) const {
+  auto it = files_.find(path);
+  if (it == files_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+BundleIoDelegate::BundleIoDelegate(const Bundle& bundle, const string& root,
+                                   const IoDelegate& io_delegate)
+    : bundle_(bundle),
+      root_(root),
+      io_delegate_(io_delegate) {}
+
+unique_ptr<string> BundleIoDelegate::GetFileContents(
+    const string& filename,
+    const string& content_suffix) const {
+  const string* contents = Find(filename);
+  if (contents == nullptr) {
+    return io_delegate_.GetFileContents(filename, content_suffix);
+  }
+  return unique_ptr<string>(new string(*contents + content_suffix));
+}
+
+unique_ptr<LineReader> BundleIoDelegate::GetLineReader(
+    const string& file_path) const {
+  const string* contents = Find(file_path);
+  if (contents == nullptr) {
+    return io_delegate_.GetLineReader(file_path);
+  }
+  return LineReader::ReadFromMemory(*contents);
+}
+
+bool BundleIoDelegate::FileIsReadable(const string& path) const {
+  return Find(path) != nullptr || io_delegate_.FileIsReadable(path);
+}
+
+bool BundleIoDelegate::CreatedNestedDirs(
+    const string& base_dir,
+    const vector<string>& nested_subdirs) const {
+  return io_delegate_.CreatedNestedDirs(base_dir, nested_subdirs);
+}
+
+unique_ptr<CodeWriter> BundleIoDelegate::GetCodeWriter(
+    const string& file_path) const {
+  return io_delegate_.GetCodeWriter(file_path);
+}
+
+void BundleIoDelegate::RemovePath(const string& file_path) const {
+  io_delegate_.RemovePath(file_path);
+}
+
+string BundleIoDelegate::PathFor(const string& path) const {
+  string full_path = root_ + OS_PATH_SEPARATOR + path;
+  for (size_t i = root_.size(); i < full_path.size(); ++i) {
+    if (full_path[i] == '/') {
+      full_path[i] = OS_PATH_SEPARATOR;
+    }
+  }
+  return full_path;
+}
+
+const string* BundleIoDelegate::Find(const string& path) const {
+  if (path.size() <= root_.size() + 1 ||
+      path.compare(0, root_.size(), root_) != 0 ||
+      path[root_.size()] != OS_PATH_SEPARATOR) {
+    return nullptr;
+  }
+  return bundle_.GetFile(ToBundlePath(path.substr(root_.size() + 1)));
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_BUNDLE_H_
+#define AIDL_BUNDLE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "io_delegate.h"
+
+namespace android {
+namespace aidl {
+
+// An archive of every file that compiling a set of inputs reads, written by
+// aidl --bundle.  Paths in the archive are relative to the archive itself and
+// always use '/' as the separator.  The manifest lists the inputs, the
+// preprocessed files and the import roots to compile them with.
+class Bundle {
+ public:
+  // File name suffix that marks a bundle on the command line.
+  static const char kSuffix[];
+  // Import root that resolved imports are stored under.
+  static const char kImportRoot[];
+
+  Bundle() = default;
+  ~Bundle() = default;
+
+  // Returns nullptr if |contents| is not a well formed bundle.
+  static std::unique_ptr<Bundle> Parse(const std::string& contents);
+  std::string Serialize() const;
+
+  // Returns false if a different file is already stored at |path|.
+  bool AddFile(const std::string& path, const std::string& contents);
+  // Returns nullptr if there is no file at |path|.
+  const std::string* GetFile(const std::string& path) const;
+
+  std::vector<std::string> inputs_;
+  std::vector<std::string> preprocessed_files_;
+  std::vector<std::string> import_roots_;
+
+ private:
+  std::map<std::string, std::string> files_;
+
+  DISALLOW_COPY_AND_ASSIGN(Bundle);
+};
+
+// Serves reads below |root| from |bundle| and passes everything else,
+// including all writes, on to |io_delegate|.
+class BundleIoDelegate : public IoDelegate {
+ public:
+  BundleIoDelegate(const Bundle& bundle, const std::string& root,
+                   const IoDelegate& io_delegate);
+  virtual ~BundleIoDelegate() = default;
+
+  std::unique_ptr<std::string> GetFileContents(
+      const std::string& filename,
+      const std::string& content_suffix = "") const override;
+  std::unique_ptr<LineReader> GetLineReader(
+      const std::string& file_path) const override;
+  bool FileIsReadable(const std::string& path) const override;
+  bool CreatedNestedDirs(
+      const std::string& base_dir,
+      const std::vector<std::string>& nested_subdirs) const override;
+  std::unique_ptr<CodeWriter> GetCodeWriter(
+      const std::string& file_path) const override;
+  void RemovePath(const std::string& file_path) const override;
+
+  // Returns |path| inside the bundle as a path this delegate serves.
+  std::string PathFor(const std::string& path) const;
+
+ private:
+  // Returns the file |path| refers to, or nullptr if |path| is not below
+  // |root_| or there is no such file.
+  const std::string* Find(const std::string& path) const;
+
+  const Bundle& bundle_;
+  const std::string root_;
+  const IoDelegate& io_delegate_;
+
+  DISALLOW_COPY_AND_ASSIGN(BundleIoDelegate);
+};  // class BundleIoDelegate
+
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_BUNDLE_H_
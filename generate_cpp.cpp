@@ -17,6 +17,7 @@
 #include "generate_cpp.h"
 
 #include <cctype>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <random>
@@ -24,6 +25,7 @@
 #include <string>
 
 #include <android-base/stringprintf.h>
+#include <android-base/strings.h>
 
 #include "aidl_language.h"
 #include "ast_cpp.h"
@@ -31,6 +33,7 @@
 #include "logging.h"
 #include "os.h"
 
+using android::base::Join;
 using android::base::StringPrintf;
 using std::string;
 using std::unique_ptr;
@@ -61,6 +64,46 @@ const char kIInterfaceHeader[] = "binder/IInterface.h";
 const char kParcelHeader[] = "binder/Parcel.h";
 const char kStatusHeader[] = "binder/Status.h";
 const char kStrongPointerHeader[] = "utils/StrongPointer.h";
+const char kString16Header[] = "utils/String16.h";
+const char kShardsVarName[] = "_aidl_shards";
+const char kShardVarName[] = "_aidl_shard";
+const char kShardCallsVarName[] = "_aidl_calls";
+const char kShardErrorsVarName[] = "_aidl_errors";
+const char kFnvOffsetBasis[] = "0xcbf29ce484222325ULL";
+const char kCallChainCode[] = "CALL_CHAIN";
+const char kChainRequestVarName[] = "_aidl_request";
+const char kChainStepsVarName[] = "_aidl_steps";
+const char kChainSizePositionVarName[] = "_aidl_size_position";
+const char kChainBuildStatusVarName[] = "_aidl_build_status";
+const char kMetricsVarName[] = "_aidl_metrics";
+const char kTimerVarName[] = "_aidl_timer";
+const char kTransactionMetricsLiteral[] =
+    "::android::aidl::transport::TransactionMetrics";
+const char kTransactionTimerLiteral[] =
+    "::android::aidl::transport::TransactionTimer";
+const char kTransactionMetricsHeader[] = "transport/transaction_metrics.h";
+const char kWatchTableVarName[] = "_aidl_watch";
+const char kWatchScopeVarName[] = "_aidl_watch_scope";
+const char kCallWatchTableLiteral[] =
+    "::android::aidl::transport::CallWatchTable";
+const char kCallWatchScopeLiteral[] =
+    "::android::aidl::transport::CallWatchScope";
+const char kCallWatchdogHeader[] = "transport/call_watchdog.h";
+const char kTraceContextHeader[] = "transport/trace_context.h";
+const char kTraceContextLiteral[] = "::android::aidl::transport::TraceContext";
+const char kScopedTraceContextLiteral[] =
+    "::android::aidl::transport::ScopedTraceContext";
+const char kTraceVarName[] = "_aidl_trace";
+const char kTraceScopeVarName[] = "_aidl_trace_scope";
+const char kStateMirrorCode[] = "STATE_MIRROR";
+const char kStateMirrorHeader[] = "transport/state_mirror.h";
+const char kSnapshotVarName[] = "_aidl_snapshot";
+const char kMirrorMethodVarName[] = "_aidl_method";
+const char kStateMirrorPublisherLiteral[] =
+    "::android::aidl::transport::StateMirrorPublisher";
+const char kStateMirrorSubscriberLiteral[] =
+    "::android::aidl::transport::StateMirrorSubscriber";
+const char kOutMaskVarName[] = "_aidl_out_mask";
 
 unique_ptr<AstNode> BreakOnStatusNotOk() {
   IfStatement* ret = new IfStatement(new Comparison(
@@ -87,6 +130,412 @@ unique_ptr<AstNode> ReturnOnStatusNotOk() {
   return unique_ptr<AstNode>(ret);
 }
 
+// Helpers for @delta arrays, emitted into the sources that need them.  The
+// reply holds the array's new size, then (start, count, elements...) ranges,
+// then a start of -1.
+const char kWriteDeltaArrayHelper[] =
+R"(namespace {
+
+// Writes |current| as the ranges in which it differs from |base|, or as one
+// range covering everything when that is no larger.
+template <typename T>
+::android::status_t _aidl_WriteDeltaArray(::android::Parcel* parcel, const ::std::vector<T>& base, const ::std::vector<T>& current, ::android::status_t (::android::Parcel::*write)(T)) {
+const size_t size = current.size();
+if (size > static_cast<size_t>(INT32_MAX)) {
+return ::android::BAD_VALUE;
+}
+auto changed = [&base, &current](size_t i) {
+return i >= base.size() || base[i] != current[i];
+};
+// Parcels pad everything to four bytes.
+const size_t wire_size = (sizeof(T) < 4) ? 4 : sizeof(T);
+size_t delta_size = 0;
+for (size_t i = 0; i < size; ++i) {
+if (changed(i)) {
+delta_size += wire_size;
+if (i == 0 || !changed(i - 1)) {
+delta_size += 2 * sizeof(int32_t);
+}
+}
+}
+const bool whole = delta_size >= 2 * sizeof(int32_t) + size * wire_size;
+::android::status_t status = parcel->writeInt32(static_cast<int32_t>(size));
+for (size_t i = 0; status == ::android::OK && i < size;) {
+if (!whole && !changed(i)) {
+++i;
+continue;
+}
+size_t end = i + 1;
+while (end < size && (whole || changed(end))) {
+++end;
+}
+status = parcel->writeInt32(static_cast<int32_t>(i));
+if (status == ::android::OK) {
+status = parcel->writeInt32(static_cast<int32_t>(end - i));
+}
+for (; status == ::android::OK && i < end; ++i) {
+status = (parcel->*write)(current[i]);
+}
+}
+if (status == ::android::OK) {
+status = parcel->writeInt32(-1);
+}
+return status;
+}
+
+}  // namespace
+)";
+
+const char kReadDeltaArrayHelper[] =
+R"(namespace {
+
+// Applies the ranges written by _aidl_WriteDeltaArray() to |array|, which
+// still holds the elements we sent.
+template <typename T>
+::android::status_t _aidl_ReadDeltaArray(const ::android::Parcel& parcel, ::std::vector<T>* array, ::android::status_t (::android::Parcel::*read)(T*) const) {
+const size_t wire_size = (sizeof(T) < 4) ? 4 : sizeof(T);
+int32_t size;
+::android::status_t status = parcel.readInt32(&size);
+if (status != ::android::OK) {
+return status;
+}
+// Elements past the end of what we sent are always in the reply, so a bad
+// size can't make us allocate more than the reply could fill.
+if (size < 0 || (static_cast<size_t>(size) > array->size() && static_cast<size_t>(size) - array->size() > parcel.dataAvail() / wire_size)) {
+return ::android::BAD_VALUE;
+}
+array->resize(size);
+while (true) {
+int32_t start;
+status = parcel.readInt32(&start);
+if (status != ::android::OK || start == -1) {
+return status;
+}
+int32_t count;
+status = parcel.readInt32(&count);
+if (status != ::android::OK) {
+return status;
+}
+if (start < 0 || start > size || count < 0 || count > size - start) {
+return ::android::BAD_VALUE;
+}
+for (int32_t i = start; i < start + count; ++i) {
+T value;
+status = (parcel.*read)(&value);
+if (status != ::android::OK) {
+return status;
+}
+(*array)[i] = value;
+}
+}
+}
+
+}  // namespace
+)";
+
+// Helpers for @nonnull parcelables, emitted into the sources that need them.
+// Values go straight to Parcelable::writeToParcel(), without the marker
+// Parcel::writeParcelable() puts in front of each one, since a C++ value can
+// never be null.
+const char kNonNullParcelableHelpers[] =
+R"(namespace {
+
+template <typename T>
+::android::status_t _aidl_WriteNonNullParcelable(::android::Parcel* parcel, const T& value) {
+return value.writeToParcel(parcel);
+}
+
+template <typename T>
+::android::status_t _aidl_ReadNonNullParcelable(const ::android::Parcel& parcel, T* value) {
+return value->readFromParcel(&parcel);
+}
+
+template <typename T>
+::android::status_t _aidl_WriteNonNullParcelableVector(::android::Parcel* parcel, const ::std::vector<T>& value) {
+if (value.size() > static_cast<size_t>(INT32_MAX)) {
+return ::android::BAD_VALUE;
+}
+::android::status_t status = parcel->writeInt32(static_cast<int32_t>(value.size()));
+for (size_t i = 0; status == ::android::OK && i < value.size(); ++i) {
+status = value[i].writeToParcel(parcel);
+}
+return status;
+}
+
+template <typename T>
+::android::status_t _aidl_ReadNonNullParcelableVector(const ::android::Parcel& parcel, ::std::vector<T>* value) {
+int32_t size;
+::android::status_t status = parcel.readInt32(&size);
+if (status != ::android::OK) {
+return status;
+}
+if (size == -1) {
+return ::android::UNEXPECTED_NULL;
+}
+if (size < 0) {
+return ::android::BAD_VALUE;
+}
+value->resize(size);
+for (int32_t i = 0; status == ::android::OK && i < size; ++i) {
+status = (*value)[i].readFromParcel(&parcel);
+}
+return status;
+}
+
+}  // namespace
+)";
+
+const char kWriteTraceContextHelper[] =
+R"(namespace {
+
+// Writes the calling thread's trace context after the interface token.
+::android::status_t _aidl_WriteTraceContext(::android::Parcel* data) {
+const ::android::aidl::transport::TraceContext& trace = ::android::aidl::transport::TraceContext::Current();
+::android::status_t status = data->writeInt32(trace.WireFlags());
+if (status == ::android::OK && trace.IsValid()) {
+status = data->writeInt64(static_cast<int64_t>(trace.trace_id));
+if (status == ::android::OK) {
+status = data->writeInt64(static_cast<int64_t>(trace.span_id));
+}
+}
+return status;
+}
+
+}  // namespace
+)";
+
+const char kReadTraceContextHelper[] =
+R"(namespace {
+
+// Reads the trace context the caller wrote after the interface token.
+::android::status_t _aidl_ReadTraceContext(const ::android::Parcel& data, ::android::aidl::transport::TraceContext* caller) {
+int32_t flags;
+::android::status_t status = data.readInt32(&flags);
+if (status != ::android::OK || !(flags & ::android::aidl::transport::TraceContext::kPresent)) {
+return status;
+}
+int64_t trace_id;
+int64_t span_id;
+status = data.readInt64(&trace_id);
+if (status == ::android::OK) {
+status = data.readInt64(&span_id);
+}
+if (status == ::android::OK) {
+*caller = ::android::aidl::transport::TraceContext::FromWire(flags, static_cast<uint64_t>(trace_id), static_cast<uint64_t>(span_id));
+}
+return status;
+}
+
+}  // namespace
+)";
+
+// Executes call chains for @chainable interfaces.  A chain request holds the
+// number of steps, then for each step its transaction code, its argument
+// count and its arguments.  Each argument is either -1, a size and that many
+// bytes of a value, or the index of an earlier step whose result it is.  The
+// reply holds a status, the number of steps run, then each step's reply
+// preceded by its size.
+// Only the |chainable_codes| can be steps, which keeps out the chain call
+// itself and the meta transactions.
+const char kRunCallChainHelper[] =
+R"(namespace {
+
+// Makes the calls in a chain one after the other, stopping after the first
+// one that fails.
+::android::status_t _aidl_RunCallChain(::android::IBinder* binder, const uint32_t* chainable_codes, size_t chainable_count, const ::android::Parcel& data, ::android::Parcel* reply) {
+int32_t step_count;
+::android::status_t status = data.readInt32(&step_count);
+if (status != ::android::OK) {
+return status;
+}
+// Every step takes up at least 8 bytes of the request.
+if (step_count < 0 || static_cast<size_t>(step_count) > data.dataAvail() / 8) {
+return ::android::BAD_VALUE;
+}
+::std::vector<::android::Parcel> results(step_count);
+::std::vector<size_t> result_starts(step_count);
+int32_t completed = 0;
+while (completed < step_count) {
+int32_t code;
+int32_t argument_count;
+status = data.readInt32(&code);
+if (status == ::android::OK) {
+status = data.readInt32(&argument_count);
+}
+if (status != ::android::OK) {
+return status;
+}
+bool chainable = false;
+for (size_t i = 0; i < chainable_count; ++i) {
+chainable = chainable || chainable_codes[i] == static_cast<uint32_t>(code);
+}
+if (!chainable || argument_count < 0) {
+return ::android::BAD_VALUE;
+}
+::android::Parcel step_data;
+status = step_data.writeInterfaceToken(binder->getInterfaceDescriptor());
+for (int32_t i = 0; status == ::android::OK && i < argument_count; ++i) {
+int32_t source;
+status = data.readInt32(&source);
+if (status != ::android::OK) {
+break;
+}
+if (source >= 0) {
+if (source >= completed) {
+return ::android::BAD_VALUE;
+}
+const ::android::Parcel& result = results[source];
+status = step_data.appendFrom(&result, result_starts[source], result.dataSize() - result_starts[source]);
+continue;
+}
+int32_t size;
+status = data.readInt32(&size);
+const size_t start = data.dataPosition();
+if (status == ::android::OK && (size < 0 || static_cast<size_t>(size) > data.dataAvail())) {
+status = ::android::BAD_VALUE;
+}
+if (status == ::android::OK) {
+status = step_data.appendFrom(&data, start, size);
+data.setDataPosition(start + size);
+}
+}
+if (status != ::android::OK) {
+return status;
+}
+step_data.setDataPosition(0);
+::android::Parcel& result = results[completed++];
+status = binder->transact(code, step_data, &result);
+if (status != ::android::OK) {
+return status;
+}
+::android::binder::Status step_status;
+result.setDataPosition(0);
+status = step_status.readFromParcel(result);
+if (status != ::android::OK) {
+return status;
+}
+result_starts[completed - 1] = result.dataPosition();
+if (!step_status.isOk()) {
+break;
+}
+}
+status = ::android::binder::Status::ok().writeToParcel(reply);
+if (status == ::android::OK) {
+status = reply->writeInt32(completed);
+}
+for (int32_t i = 0; status == ::android::OK && i < completed; ++i) {
+status = reply->writeInt32(results[i].dataSize());
+if (status == ::android::OK) {
+status = reply->appendFrom(&results[i], 0, results[i].dataSize());
+}
+}
+return status;
+}
+
+}  // namespace
+)";
+
+// The argument and result types of FooCallChain, formatted with the name of
+// the chain class.
+const char kCallChainArgumentTypes[] =
+R"(// The result of an earlier call in the chain, which later calls can take
+// as an argument.
+template <typename T>
+class Result {
+public:
+int32_t step() const { return step_; }
+private:
+friend class %s;
+explicit Result(int32_t step) : step_(step) {}
+int32_t step_;
+};  // class Result
+
+// An argument to a chained call: either a value, which is copied when the
+// call is added to the chain, or the Result of an earlier call.
+template <typename T>
+class Arg {
+public:
+Arg(const T& value) : value_(&value) {}
+Arg(const Result<T>& result) : step_(result.step()) {}
+const T* value() const { return value_; }
+int32_t step() const { return step_; }
+private:
+const T* value_ = nullptr;
+int32_t step_ = -1;
+};  // class Arg
+
+)";
+
+bool HasDeltaArguments(const AidlInterface& interface) {
+  for (const auto& method : interface.GetMethods()) {
+    for (const auto& a : method->GetArguments()) {
+      if (a->GetType().IsDelta()) { return true; }
+    }
+  }
+  return false;
+}
+
+bool HasNonNullTypes(const AidlInterface& interface) {
+  for (const auto& method : interface.GetMethods()) {
+    if (method->GetType().IsNonNull()) { return true; }
+    for (const auto& a : method->GetArguments()) {
+      if (a->GetType().IsNonNull()) { return true; }
+    }
+  }
+  return false;
+}
+
+// Returns the suffix of the Parcel methods that read and write one element
+// of a @delta array, as in readInt32() and writeInt32().
+string DeltaElementMethodSuffix(const AidlType& type) {
+  const string& name = type.GetName();
+  if (name == "int") { return "Int32"; }
+  if (name == "long") { return "Int64"; }
+  if (name == "float") { return "Float"; }
+  if (name == "double") { return "Double"; }
+  if (name == "char") { return "Char"; }
+  return "Bool";  // check_delta() allows nothing else.
+}
+
+// Returns the number of bytes |a| takes up in a Parcel if that is always
+// the same, or 0 otherwise.
+size_t FixedWireSize(const AidlArgument& a) {
+  if (a.GetType().IsArray()) { return 0; }
+  const string& name = a.GetType().GetName();
+  if (name == "long" || name == "double") { return 8; }
+  // Parcels pad these out to four bytes.
+  if (name == "int" || name == "float" || name == "boolean" ||
+      name == "char" || name == "byte") {
+    return 4;
+  }
+  return 0;
+}
+
+// Reads a |type| out of the Parcel object |parcel| into the pointer |var|.
+MethodCall* BuildReadFromParcel(const Type& type, const string& parcel,
+                                const string& var) {
+  if (type.HasParcelHelpers()) {
+    return new MethodCall(type.ReadFromParcelMethod(), ArgList{{parcel, var}});
+  }
+  return new MethodCall(StringPrintf("%s.%s", parcel.c_str(),
+                                     type.ReadFromParcelMethod().c_str()),
+                        ArgList(var));
+}
+
+// Writes |value| of |type| to |parcel|, which names either a Parcel object
+// or a pointer to one.
+MethodCall* BuildWriteToParcel(const Type& type, const string& parcel,
+                               bool parcel_is_pointer, const string& value) {
+  if (type.HasParcelHelpers()) {
+    return new MethodCall(type.WriteToParcelMethod(), ArgList{{
+        (parcel_is_pointer) ? parcel : "&" + parcel, type.WriteCast(value)}});
+  }
+  return new MethodCall(StringPrintf("%s%s%s", parcel.c_str(),
+                                     (parcel_is_pointer) ? "->" : ".",
+                                     type.WriteToParcelMethod().c_str()),
+                        ArgList(type.WriteCast(value)));
+}
+
 string UpperCase(const std::string& s) {
   string result = s;
   for (char& c : result)
@@ -94,6 +543,43 @@ string UpperCase(const std::string& s) {
   return result;
 }
 
+// The StateMirrorPublisher in BnFoo, or StateMirrorSubscriber in BpFoo, for
+// a @mirrored method.
+string MirrorVarName(const AidlMethod& method) {
+  return "_aidl_mirror_" + method.GetName();
+}
+
+// The mask of @skippable out parameters the caller wants back, with a bit
+// set for each one it passed a pointer for.
+string BuildOutMask(const AidlMethod& method) {
+  vector<string> bits;
+  for (const AidlArgument* a : method.GetOutArguments()) {
+    if (!a->GetType().IsSkippable()) { continue; }
+    bits.push_back(StringPrintf("((%s != nullptr) ? 0x%x : 0)",
+                                a->GetName().c_str(),
+                                method.GetOutMaskBit(*a)));
+  }
+  return "static_cast<int32_t>(" + Join(bits, " | ") + ")";
+}
+
+// True if the caller asked for the @skippable out parameter |a| back.
+string IsOutWanted(const AidlMethod& method, const AidlArgument& a) {
+  return StringPrintf("(%s & 0x%x) != 0", kOutMaskVarName,
+                      method.GetOutMaskBit(a));
+}
+
+// PublishState() for GetState() or state(), since the service publishes
+// the state rather than a call.
+string PublishMethodName(const AidlMethod& method) {
+  string state = method.GetName();
+  if (state.size() > 3 && (state.compare(0, 3, "Get") == 0 ||
+                           state.compare(0, 3, "get") == 0)) {
+    state = state.substr(3);
+  }
+  state[0] = toupper(state[0]);
+  return "Publish" + state;
+}
+
 string BuildVarName(const AidlArgument& a) {
   string prefix = "out_";
   if (a.GetDirection() & AidlArgument::IN_DIR) {
@@ -127,6 +613,12 @@ ArgList BuildArgList(const TypeNamespace& types,
       }
 
       literal += " " + a->GetName();
+    } else if (a->GetType().IsSkippable()) {
+      // Implementations can tell from the null pointer that the caller
+      // won't read the value, and skip computing it.
+      literal = StringPrintf("(%s) ? &%s : nullptr",
+                             IsOutWanted(method, *a).c_str(),
+                             BuildVarName(*a).c_str());
     } else {
       if (a->IsOut()) { literal = "&"; }
       literal += BuildVarName(*a);
@@ -221,6 +713,12 @@ string ClassName(const AidlInterface& interface, ClassNames type) {
     case ClassNames::INTERFACE:
       c_name = "I" + c_name;
       break;
+    case ClassNames::ROUTER:
+      c_name = "Sharded" + c_name;
+      break;
+    case ClassNames::CHAIN:
+      c_name += "CallChain";
+      break;
     case ClassNames::BASE:
       break;
   }
@@ -250,7 +748,8 @@ string BuildHeaderGuard(const AidlInterface& interface,
 
 unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
                                                 const AidlInterface& interface,
-                                                const AidlMethod& method) {
+                                                const AidlMethod& method,
+                                                bool trace_context) {
   const string i_name = ClassName(interface, ClassNames::INTERFACE);
   const string bp_name = ClassName(interface, ClassNames::CLIENT);
   unique_ptr<MethodImpl> ret{new MethodImpl{
@@ -258,6 +757,25 @@ unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
       ArgList{BuildArgList(types, method, true /* for method decl */)}}};
   StatementBlock* b = ret->GetStatementBlock();
 
+  // Answer @mirrored methods from the service's last snapshot if we can.
+  const Type* return_type = method.GetType().GetLanguageType<Type>();
+  if (method.GetType().IsMirrored()) {
+    b->AddLiteral(StringPrintf("%s %s", kAndroidParcelLiteral,
+                               kSnapshotVarName));
+    IfStatement* from_mirror = new IfStatement(new LiteralExpression(
+        StringPrintf("%s.Read(remote(), getInterfaceDescriptor(), %s::%s, "
+                     "%s::%s, &%s) && %s.%s(%s) == %s",
+                     MirrorVarName(method).c_str(), i_name.c_str(),
+                     kStateMirrorCode, i_name.c_str(),
+                     UpperCase(method.GetName()).c_str(), kSnapshotVarName,
+                     kSnapshotVarName,
+                     return_type->ReadFromParcelMethod().c_str(),
+                     kReturnVarName, kAndroidStatusOk)));
+    b->AddStatement(from_mirror);
+    from_mirror->OnTrue()->AddLiteral(
+        StringPrintf("return %s::ok()", kBinderStatusLiteral));
+  }
+
   // Declare parcels to hold our query and the response.
   b->AddLiteral(StringPrintf("%s %s", kAndroidParcelLiteral, kDataVarName));
   // Even if we're oneway, the transact method still takes a parcel.
@@ -278,19 +796,31 @@ unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
                      "getInterfaceDescriptor()")));
   b->AddStatement(GotoErrorOnBadStatus());
 
+  if (trace_context) {
+    b->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        new MethodCall("_aidl_WriteTraceContext", "&" + string(kDataVarName))));
+    b->AddStatement(GotoErrorOnBadStatus());
+  }
+
+  // Tell the server which @skippable out parameters to send back.
+  if (method.HasSkippableArguments()) {
+    b->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        new MethodCall(StringPrintf("%s.writeInt32", kDataVarName),
+                       BuildOutMask(method))));
+    b->AddStatement(GotoErrorOnBadStatus());
+  }
+
   // Serialization looks roughly like:
   //     _aidl_ret_status = _aidl_data.WriteInt32(in_param_name);
   //     if (_aidl_ret_status != ::android::OK) { goto error; }
   for (const AidlArgument* a : method.GetInArguments()) {
     const Type* type = a->GetType().GetLanguageType<Type>();
-    string method = type->WriteToParcelMethod();
-
     string var_name = ((a->IsOut()) ? "*" : "") + a->GetName();
-    var_name = type->WriteCast(var_name);
     b->AddStatement(new Assignment(
         kAndroidStatusVarName,
-        new MethodCall(StringPrintf("%s.%s", kDataVarName, method.c_str()),
-                       ArgList(var_name))));
+        BuildWriteToParcel(*type, kDataVarName, false, var_name)));
     b->AddStatement(GotoErrorOnBadStatus());
   }
 
@@ -331,30 +861,41 @@ unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
   // status" if we are a oneway method, so no more fear of accessing reply.
 
   // If the method is expected to return something, read it first by convention.
-  const Type* return_type = method.GetType().GetLanguageType<Type>();
   if (return_type != types.VoidType()) {
-    string method_call = return_type->ReadFromParcelMethod();
     b->AddStatement(new Assignment(
         kAndroidStatusVarName,
-        new MethodCall(StringPrintf("%s.%s", kReplyVarName,
-                                    method_call.c_str()),
-                       ArgList(kReturnVarName))));
+        BuildReadFromParcel(*return_type, kReplyVarName, kReturnVarName)));
     b->AddStatement(GotoErrorOnBadStatus());
   }
 
   for (const AidlArgument* a : method.GetOutArguments()) {
+    if (a->GetType().IsDelta()) {
+      // Patch the changed ranges into the array we sent.
+      b->AddStatement(new Assignment(
+          kAndroidStatusVarName,
+          new MethodCall("_aidl_ReadDeltaArray", ArgList{{
+              kReplyVarName, a->GetName(),
+              "&::android::Parcel::read" +
+                  DeltaElementMethodSuffix(a->GetType())}})));
+      b->AddStatement(GotoErrorOnBadStatus());
+      continue;
+    }
+
     // Deserialization looks roughly like:
     //     _aidl_ret_status = _aidl_reply.ReadInt32(out_param_name);
     //     if (_aidl_status != ::android::OK) { goto _aidl_error; }
-    string method =
-      a->GetType().GetLanguageType<Type>()->ReadFromParcelMethod();
-
-    b->AddStatement(new Assignment(
+    StatementBlock* read = b;
+    if (a->GetType().IsSkippable()) {
+      IfStatement* wanted = new IfStatement(new LiteralExpression(
+          StringPrintf("%s != nullptr", a->GetName().c_str())));
+      b->AddStatement(wanted);
+      read = wanted->OnTrue();
+    }
+    read->AddStatement(new Assignment(
         kAndroidStatusVarName,
-        new MethodCall(StringPrintf("%s.%s", kReplyVarName,
-                                    method.c_str()),
-                       ArgList(a->GetName()))));
-    b->AddStatement(GotoErrorOnBadStatus());
+        BuildReadFromParcel(*a->GetType().GetLanguageType<Type>(),
+                            kReplyVarName, a->GetName())));
+    read->AddStatement(GotoErrorOnBadStatus());
   }
 
   // If we've gotten to here, one of two things is true:
@@ -374,13 +915,25 @@ unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
 }  // namespace
 
 unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
-                                       const AidlInterface& interface) {
+                                       const AidlInterface& interface,
+                                       bool trace_context) {
   vector<string> include_list = {
       HeaderFile(interface, ClassNames::CLIENT, false),
       kParcelHeader
   };
   vector<unique_ptr<Declaration>> file_decls;
 
+  if (HasDeltaArguments(interface)) {
+    file_decls.emplace_back(new LiteralDecl(kReadDeltaArrayHelper));
+  }
+  if (HasNonNullTypes(interface)) {
+    file_decls.emplace_back(new LiteralDecl(kNonNullParcelableHelpers));
+  }
+  if (trace_context) {
+    include_list.push_back(kTraceContextHeader);
+    file_decls.emplace_back(new LiteralDecl(kWriteTraceContextHelper));
+  }
+
   // The constructor just passes the IBinder instance up to the super
   // class.
   const string i_name = ClassName(interface, ClassNames::INTERFACE);
@@ -393,7 +946,7 @@ unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
   // Clients define a method per transaction.
   for (const auto& method : interface.GetMethods()) {
     unique_ptr<Declaration> m = DefineClientTransaction(
-        types, interface, *method);
+        types, interface, *method, trace_context);
     if (!m) { return nullptr; }
     file_decls.push_back(std::move(m));
   }
@@ -404,8 +957,54 @@ unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
 
 namespace {
 
+// When every "in" parameter of |method| has a fixed size, and there is more
+// than one, checks that they are all there at once and then reads them
+// without checking each one:
+//     if (_aidl_data.dataAvail() < 12) { ... break; }
+//     in_param_name = _aidl_data.readInt32();
+// Returns false, having added nothing to |b|, otherwise.
+bool ReadFixedSizeInArguments(const AidlMethod& method, StatementBlock* b) {
+  const vector<const AidlArgument*>& in_arguments = method.GetInArguments();
+  if (in_arguments.size() < 2) { return false; }
+  size_t fixed_size = 0;
+  for (const AidlArgument* a : in_arguments) {
+    const size_t size = FixedWireSize(*a);
+    if (size == 0) { return false; }
+    fixed_size += size;
+  }
+
+  IfStatement* size_check = new IfStatement(new Comparison(
+      new LiteralExpression(StringPrintf("%s.dataAvail()", kDataVarName)),
+      "<", new LiteralExpression(std::to_string(fixed_size))));
+  b->AddStatement(size_check);
+  size_check->OnTrue()->AddStatement(
+      new Assignment(kAndroidStatusVarName, "::android::NOT_ENOUGH_DATA"));
+  size_check->OnTrue()->AddLiteral("break");
+  for (const AidlArgument* a : in_arguments) {
+    const Type* type = a->GetType().GetLanguageType<Type>();
+    b->AddStatement(new Assignment(
+        BuildVarName(*a),
+        new MethodCall(StringPrintf("%s.%s", kDataVarName,
+                                    type->ReadFromParcelMethod().c_str()),
+                       ArgList{})));
+  }
+  return true;
+}
+
+void AddInterfaceCheck(StatementBlock* b) {
+  IfStatement* interface_check = new IfStatement(
+      new MethodCall(StringPrintf("%s.checkInterface",
+                                  kDataVarName), "this"),
+      true /* invert the check */);
+  b->AddStatement(interface_check);
+  interface_check->OnTrue()->AddStatement(
+      new Assignment(kAndroidStatusVarName, "::android::BAD_TYPE"));
+  interface_check->OnTrue()->AddLiteral("break");
+}
+
 bool HandleServerTransaction(const TypeNamespace& types,
                              const AidlMethod& method,
+                             bool trace_context,
                              StatementBlock* b) {
   // Declare all the parameters now.  In the common case, we expect no errors
   // in serialization.
@@ -422,30 +1021,55 @@ bool HandleServerTransaction(const TypeNamespace& types,
   }
 
   // Check that the client is calling the correct interface.
-  IfStatement* interface_check = new IfStatement(
-      new MethodCall(StringPrintf("%s.checkInterface",
-                                  kDataVarName), "this"),
-      true /* invert the check */);
-  b->AddStatement(interface_check);
-  interface_check->OnTrue()->AddStatement(
-      new Assignment(kAndroidStatusVarName, "::android::BAD_TYPE"));
-  interface_check->OnTrue()->AddLiteral("break");
+  AddInterfaceCheck(b);
 
-  // Deserialize each "in" parameter to the transaction.
-  for (const AidlArgument* a : method.GetInArguments()) {
-    // Deserialization looks roughly like:
-    //     _aidl_ret_status = _aidl_data.ReadInt32(&in_param_name);
-    //     if (_aidl_ret_status != ::android::OK) { break; }
-    const Type* type = a->GetType().GetLanguageType<Type>();
-    string readMethod = type->ReadFromParcelMethod();
+  // The call runs in a child span of the caller's, if it sent one.
+  if (trace_context) {
+    b->AddLiteral(StringPrintf("%s %s", kTraceContextLiteral, kTraceVarName));
+    b->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        new MethodCall("_aidl_ReadTraceContext",
+                       ArgList{{kDataVarName,
+                                StringPrintf("&%s", kTraceVarName)}})));
+    b->AddStatement(BreakOnStatusNotOk());
+    b->AddLiteral(StringPrintf("%s %s(%s.NewChild())",
+                               kScopedTraceContextLiteral, kTraceScopeVarName,
+                               kTraceVarName));
+  }
 
+  // Find out which @skippable out parameters the caller wants back.
+  if (method.HasSkippableArguments()) {
+    b->AddLiteral(StringPrintf("int32_t %s", kOutMaskVarName));
     b->AddStatement(new Assignment{
         kAndroidStatusVarName,
-        new MethodCall{string(kDataVarName) + "." + readMethod,
-                       "&" + BuildVarName(*a)}});
+        new MethodCall(StringPrintf("%s.readInt32", kDataVarName),
+                       "&" + string(kOutMaskVarName))});
     b->AddStatement(BreakOnStatusNotOk());
   }
 
+  // Deserialize each "in" parameter to the transaction.
+  if (!ReadFixedSizeInArguments(method, b)) {
+    for (const AidlArgument* a : method.GetInArguments()) {
+      // Deserialization looks roughly like:
+      //     _aidl_ret_status = _aidl_data.ReadInt32(&in_param_name);
+      //     if (_aidl_ret_status != ::android::OK) { break; }
+      const Type* type = a->GetType().GetLanguageType<Type>();
+      b->AddStatement(new Assignment{
+          kAndroidStatusVarName,
+          BuildReadFromParcel(*type, kDataVarName, "&" + BuildVarName(*a))});
+      b->AddStatement(BreakOnStatusNotOk());
+    }
+  }
+
+  // Keep what we received for @delta arrays, to diff the results against.
+  for (const AidlArgument* a : method.GetInArguments()) {
+    if (!a->GetType().IsDelta()) { continue; }
+    const Type* type = a->GetType().GetLanguageType<Type>();
+    b->AddLiteral(StringPrintf("%s _aidl_%s_base(%s)",
+                               type->CppType().c_str(), a->GetName().c_str(),
+                               BuildVarName(*a).c_str()));
+  }
+
   // Call the actual method.  This is implemented by the subclass.
   vector<unique_ptr<AstNode>> status_args;
   status_args.emplace_back(new MethodCall(
@@ -469,12 +1093,10 @@ bool HandleServerTransaction(const TypeNamespace& types,
 
   // If we have a return value, write it first.
   if (return_type != types.VoidType()) {
-    string writeMethod =
-        string(kReplyVarName) + "->" +
-        return_type->WriteToParcelMethod();
     b->AddStatement(new Assignment{
-        kAndroidStatusVarName, new MethodCall{writeMethod,
-        ArgList{return_type->WriteCast(kReturnVarName)}}});
+        kAndroidStatusVarName,
+        BuildWriteToParcel(*return_type, kReplyVarName, true,
+                           kReturnVarName)});
     b->AddStatement(BreakOnStatusNotOk());
   }
 
@@ -483,14 +1105,31 @@ bool HandleServerTransaction(const TypeNamespace& types,
     // Serialization looks roughly like:
     //     _aidl_ret_status = data.WriteInt32(out_param_name);
     //     if (_aidl_ret_status != ::android::OK) { break; }
-    const Type* type = a->GetType().GetLanguageType<Type>();
-    string writeMethod = type->WriteToParcelMethod();
+    if (a->GetType().IsDelta()) {
+      b->AddStatement(new Assignment{
+          kAndroidStatusVarName,
+          new MethodCall{"_aidl_WriteDeltaArray", ArgList{{
+              kReplyVarName,
+              StringPrintf("_aidl_%s_base", a->GetName().c_str()),
+              BuildVarName(*a),
+              "&::android::Parcel::write" +
+                  DeltaElementMethodSuffix(a->GetType())}}}});
+      b->AddStatement(BreakOnStatusNotOk());
+      continue;
+    }
 
-    b->AddStatement(new Assignment{
+    StatementBlock* write = b;
+    if (a->GetType().IsSkippable()) {
+      IfStatement* wanted = new IfStatement(
+          new LiteralExpression(IsOutWanted(method, *a)));
+      b->AddStatement(wanted);
+      write = wanted->OnTrue();
+    }
+    const Type* type = a->GetType().GetLanguageType<Type>();
+    write->AddStatement(new Assignment{
         kAndroidStatusVarName,
-        new MethodCall{string(kReplyVarName) + "->" + writeMethod,
-                       type->WriteCast(BuildVarName(*a))}});
-    b->AddStatement(BreakOnStatusNotOk());
+        BuildWriteToParcel(*type, kReplyVarName, true, BuildVarName(*a))});
+    write->AddStatement(BreakOnStatusNotOk());
   }
 
   return true;
@@ -499,12 +1138,18 @@ bool HandleServerTransaction(const TypeNamespace& types,
 }  // namespace
 
 unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
-                                       const AidlInterface& interface) {
+                                       const AidlInterface& interface,
+                                       bool server_metrics,
+                                       bool trace_context,
+                                       bool server_watchdog) {
   const string bn_name = ClassName(interface, ClassNames::SERVER);
   vector<string> include_list{
       HeaderFile(interface, ClassNames::SERVER, false),
       kParcelHeader
   };
+  if (trace_context) {
+    include_list.push_back(kTraceContextHeader);
+  }
   unique_ptr<MethodImpl> on_transact{new MethodImpl{
       kAndroidStatusLiteral, bn_name, "onTransact",
       ArgList{{StringPrintf("uint32_t %s", kCodeVarName),
@@ -524,11 +1169,79 @@ unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
   on_transact->GetStatementBlock()->AddStatement(s);
 
   // The switch statement has a case statement for each transaction code.
+  size_t method_index = 0;
   for (const auto& method : interface.GetMethods()) {
     StatementBlock* b = s->AddCase("Call::" + UpperCase(method->GetName()));
     if (!b) { return nullptr; }
 
-    if (!HandleServerTransaction(types, *method, b)) { return nullptr; }
+    // The timer lasts until the end of the case, reply and all.
+    if (server_metrics) {
+      b->AddLiteral(StringPrintf(
+          "%s %s(&%s, %zu)", kTransactionTimerLiteral, kTimerVarName,
+          kMetricsVarName, method_index));
+    }
+    if (server_watchdog) {
+      b->AddLiteral(StringPrintf(
+          "%s %s(&%s, %zu)", kCallWatchScopeLiteral, kWatchScopeVarName,
+          kWatchTableVarName, method_index));
+    }
+    ++method_index;
+
+    if (!HandleServerTransaction(types, *method, trace_context, b)) {
+      return nullptr;
+    }
+  }
+
+  // Call chains are unpacked into ordinary transactions on ourselves.
+  if (interface.IsChainable()) {
+    StatementBlock* chain = s->AddCase(
+        StringPrintf("Call::%s", kCallChainCode));
+    AddInterfaceCheck(chain);
+    vector<string> chainable_codes;
+    for (const auto& method : interface.GetMethods()) {
+      if (method->CanBeChained()) {
+        chainable_codes.push_back("Call::" + UpperCase(method->GetName()));
+      }
+    }
+    string codes_name = "nullptr";
+    if (!chainable_codes.empty()) {
+      codes_name = "_aidl_chainable_codes";
+      chain->AddLiteral(StringPrintf(
+          "static const uint32_t %s[] = {%s}", codes_name.c_str(),
+          Join(chainable_codes, ", ").c_str()));
+    }
+    chain->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        new MethodCall("_aidl_RunCallChain", ArgList{{
+            "this", codes_name, std::to_string(chainable_codes.size()),
+            kDataVarName, kReplyVarName}})));
+  }
+
+  // Clients ask for the region holding the snapshots of a @mirrored method.
+  if (interface.HasMirroredMethods()) {
+    StatementBlock* mirror = s->AddCase(
+        StringPrintf("Call::%s", kStateMirrorCode));
+    AddInterfaceCheck(mirror);
+    mirror->AddLiteral(StringPrintf("int32_t %s", kMirrorMethodVarName));
+    mirror->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        StringPrintf("%s.readInt32(&%s)", kDataVarName,
+                     kMirrorMethodVarName)));
+    mirror->AddStatement(BreakOnStatusNotOk());
+    for (const auto& method : interface.GetMethods()) {
+      if (!method->GetType().IsMirrored()) { continue; }
+      IfStatement* is_method = new IfStatement(new LiteralExpression(
+          StringPrintf("%s == Call::%s", kMirrorMethodVarName,
+                       UpperCase(method->GetName()).c_str())));
+      mirror->AddStatement(is_method);
+      is_method->OnTrue()->AddStatement(new Assignment(
+          kAndroidStatusVarName,
+          new MethodCall(MirrorVarName(*method) + ".WriteRegion",
+                         kReplyVarName)));
+      is_method->OnTrue()->AddLiteral("break");
+    }
+    mirror->AddStatement(new Assignment(kAndroidStatusVarName,
+                                        "::android::BAD_VALUE"));
   }
 
   // The switch statement has a default case which defers to the super class.
@@ -555,11 +1268,262 @@ unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
   on_transact->GetStatementBlock()->AddLiteral(
       StringPrintf("return %s", kAndroidStatusVarName));
 
+  vector<unique_ptr<Declaration>> file_decls;
+  if (HasDeltaArguments(interface)) {
+    file_decls.emplace_back(new LiteralDecl(kWriteDeltaArrayHelper));
+  }
+  if (HasNonNullTypes(interface)) {
+    file_decls.emplace_back(new LiteralDecl(kNonNullParcelableHelpers));
+  }
+  if (server_watchdog) {
+    // Shared by every BnFoo, and never destroyed while calls are in flight.
+    string method_names;
+    for (const auto& method : interface.GetMethods()) {
+      if (!method_names.empty()) {
+        method_names += ", ";
+      }
+      method_names += "\"" + method->GetName() + "\"";
+    }
+    file_decls.emplace_back(new LiteralDecl(StringPrintf(
+        "%s %s::%s{\"%s\", {%s}};\n", kCallWatchTableLiteral, bn_name.c_str(),
+        kWatchTableVarName, interface.GetCanonicalName().c_str(),
+        method_names.c_str())));
+  }
+  if (interface.IsChainable()) {
+    file_decls.emplace_back(new LiteralDecl(kRunCallChainHelper));
+  }
+  if (trace_context) {
+    file_decls.emplace_back(new LiteralDecl(kReadTraceContextHelper));
+  }
+  file_decls.push_back(std::move(on_transact));
+
+  for (const auto& method : interface.GetMethods()) {
+    if (!method->GetType().IsMirrored()) { continue; }
+    const Type* return_type = method->GetType().GetLanguageType<Type>();
+    unique_ptr<MethodImpl> publish{new MethodImpl{
+        kAndroidStatusLiteral, bn_name, PublishMethodName(*method),
+        ArgList{StringPrintf("const %s& state",
+                             return_type->CppType().c_str())}}};
+    StatementBlock* body = publish->GetStatementBlock();
+    body->AddLiteral(StringPrintf("%s %s", kAndroidParcelLiteral,
+                               kSnapshotVarName));
+    body->AddLiteral(StringPrintf("%s %s = %s.%s(%s)", kAndroidStatusLiteral,
+                               kAndroidStatusVarName, kSnapshotVarName,
+                               return_type->WriteToParcelMethod().c_str(),
+                               return_type->WriteCast("state").c_str()));
+    IfStatement* write_failed = new IfStatement(new LiteralExpression(
+        StringPrintf("%s != %s", kAndroidStatusVarName, kAndroidStatusOk)));
+    body->AddStatement(write_failed);
+    write_failed->OnTrue()->AddLiteral(
+        StringPrintf("return %s", kAndroidStatusVarName));
+    body->AddLiteral(StringPrintf("return %s.Publish(%s)",
+                               MirrorVarName(*method).c_str(),
+                               kSnapshotVarName));
+    file_decls.push_back(std::move(publish));
+  }
+
   return unique_ptr<Document>{new CppSource{
       include_list,
-      NestInNamespaces(std::move(on_transact), interface.GetSplitPackage())}};
+      NestInNamespaces(std::move(file_decls), interface.GetSplitPackage())}};
+}
+
+namespace {
+
+// Ints go in an enum.  Other constants are static constexpr members, which
+// need a definition in the interface source as well.  Strings are char
+// arrays, so they cost no initialization at startup.
+// Declares |name|, which is |constant|'s name, qualified or not.
+string ConstantDeclarator(const AidlConstant& constant, const string& name) {
+  const char* type = "int32_t";
+  switch (constant.GetType()) {
+    case AidlConstant::LONG: type = "int64_t"; break;
+    case AidlConstant::FLOAT: type = "float"; break;
+    case AidlConstant::DOUBLE: type = "double"; break;
+    case AidlConstant::BOOLEAN: type = "bool"; break;
+    case AidlConstant::STRING: return "char " + name + "[]";
+    case AidlConstant::INT: break;
+  }
+  return StringPrintf("%s %s", type, name.c_str());
+}
+
+string Int64Literal(const string& value) {
+  // The literal for INT64_MIN would negate a number too big for int64_t.
+  if (value == std::to_string(INT64_MIN)) {
+    return "(-9223372036854775807LL - 1)";
+  }
+  return value + "LL";
+}
+
+string ConstantInitializer(const AidlConstant& constant) {
+  const string& value = constant.GetValueText();
+  switch (constant.GetType()) {
+    case AidlConstant::LONG: return Int64Literal(value);
+    case AidlConstant::FLOAT: return value + "f";
+    case AidlConstant::STRING: return "\"" + value + "\"";
+    default: return value;
+  }
+}
+
+// Enums are an enum class of their backing type, which is also what goes on
+// the wire.  Arrays of byte enums go as a byte vector, one byte per element.
+string EnumRawType(const AidlEnum& e) {
+  if (e.GetBackingType() == "byte") return "int8_t";
+  if (e.GetBackingType() == "int") return "int32_t";
+  return "int64_t";
+}
+
+string EnumVectorRawType(const AidlEnum& e) {
+  return (e.GetBackingType() == "byte") ? "uint8_t" : EnumRawType(e);
+}
+
+string EnumParcelSuffix(const AidlEnum& e) {
+  if (e.GetBackingType() == "byte") return "Byte";
+  if (e.GetBackingType() == "int") return "Int32";
+  return "Int64";
+}
+
+void BuildEnumDecls(const AidlEnum& e, ClassDecl* if_class) {
+  const string& name = e.GetName();
+  unique_ptr<Enum> decl{new Enum{name, EnumRawType(e), true}};
+  for (const auto& enumerator : e.GetEnumerators()) {
+    const string value = std::to_string(enumerator.value);
+    decl->AddValue(enumerator.name, (e.GetBackingType() == "long")
+                                        ? Int64Literal(value) : value);
+  }
+  if_class->AddPublic(std::move(decl));
+  if_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      "bool", "IsValid" + name, ArgList{name + " value"},
+      MethodDecl::IS_STATIC}});
+  if_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      kAndroidStatusLiteral, "_aidl_Read" + name,
+      ArgList{{"const ::android::Parcel& parcel", name + "* value"}},
+      MethodDecl::IS_STATIC}});
+  if_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      kAndroidStatusLiteral, "_aidl_Write" + name,
+      ArgList{{"::android::Parcel* parcel", name + " value"}},
+      MethodDecl::IS_STATIC}});
+  if_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      kAndroidStatusLiteral, "_aidl_Read" + name + "Vector",
+      ArgList{{"const ::android::Parcel& parcel",
+               "::std::vector<" + name + ">* value"}},
+      MethodDecl::IS_STATIC}});
+  if_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      kAndroidStatusLiteral, "_aidl_Write" + name + "Vector",
+      ArgList{{"::android::Parcel* parcel",
+               "const ::std::vector<" + name + ">& value"}},
+      MethodDecl::IS_STATIC}});
 }
 
+// Values whose enumerators are contiguous are checked with one unsigned
+// compare: anything below the smallest enumerator wraps around to a huge
+// offset from it.
+string EnumValidityCheck(const AidlEnum& e) {
+  const string& name = e.GetName();
+  if (e.IsContiguous()) {
+    auto as_unsigned = [](const string& v) {
+      return "static_cast<uint64_t>(" + v + ")";
+    };
+    const string min = as_unsigned(name + "::" + e.GetMin().name);
+    const string max = as_unsigned(name + "::" + e.GetMax().name);
+    if (e.GetMin().value == 0) {
+      return as_unsigned("value") + " <= " + max;
+    }
+    return StringPrintf("%s - %s <= %s - %s", as_unsigned("value").c_str(),
+                        min.c_str(), max.c_str(), min.c_str());
+  }
+  vector<string> checks;
+  set<int64_t> seen;
+  for (const auto& enumerator : e.GetEnumerators()) {
+    if (seen.insert(enumerator.value).second) {
+      checks.push_back("value == " + name + "::" + enumerator.name);
+    }
+  }
+  return Join(checks, " || ");
+}
+
+void BuildEnumImpls(const string& i_name, const AidlEnum& e,
+                    vector<unique_ptr<Declaration>>* decls) {
+  const string& name = e.GetName();
+  const string raw_type = EnumRawType(e);
+  const string suffix = EnumParcelSuffix(e);
+  const string is_valid = "IsValid" + name;
+  const string bad_value = "return ::android::BAD_VALUE";
+  const string status_decl = StringPrintf(
+      "%s %s", kAndroidStatusLiteral, kAndroidStatusVarName);
+
+  unique_ptr<MethodImpl> valid{new MethodImpl{
+      "bool", i_name, is_valid, ArgList{name + " value"}}};
+  valid->GetStatementBlock()->AddLiteral("return " + EnumValidityCheck(e));
+  decls->push_back(std::move(valid));
+
+  unique_ptr<MethodImpl> read{new MethodImpl{
+      kAndroidStatusLiteral, i_name, "_aidl_Read" + name,
+      ArgList{{"const ::android::Parcel& parcel", name + "* value"}}}};
+  StatementBlock* b = read->GetStatementBlock();
+  b->AddLiteral(raw_type + " raw");
+  b->AddLiteral(StringPrintf("%s = parcel.read%s(&raw)", status_decl.c_str(),
+                             suffix.c_str()));
+  b->AddStatement(ReturnOnStatusNotOk());
+  IfStatement* invalid = new IfStatement(new LiteralExpression(StringPrintf(
+      "!%s(static_cast<%s>(raw))", is_valid.c_str(), name.c_str())));
+  invalid->OnTrue()->AddLiteral(bad_value);
+  b->AddStatement(invalid);
+  b->AddLiteral("*value = static_cast<" + name + ">(raw)");
+  b->AddLiteral(StringPrintf("return %s", kAndroidStatusOk));
+  decls->push_back(std::move(read));
+
+  unique_ptr<MethodImpl> write{new MethodImpl{
+      kAndroidStatusLiteral, i_name, "_aidl_Write" + name,
+      ArgList{{"::android::Parcel* parcel", name + " value"}}}};
+  write->GetStatementBlock()->AddLiteral(StringPrintf(
+      "return parcel->write%s(static_cast<%s>(value))", suffix.c_str(),
+      raw_type.c_str()));
+  decls->push_back(std::move(write));
+
+  const string raw_vector =
+      "::std::vector<" + EnumVectorRawType(e) + ">";
+  // Byte vectors hold uint8_t, which must narrow to int8_t first.
+  const string from_raw = (e.GetBackingType() == "byte")
+      ? "static_cast<" + name + ">(static_cast<int8_t>(raw[i]))"
+      : "static_cast<" + name + ">(raw[i])";
+
+  unique_ptr<MethodImpl> read_vector{new MethodImpl{
+      kAndroidStatusLiteral, i_name, "_aidl_Read" + name + "Vector",
+      ArgList{{"const ::android::Parcel& parcel",
+               "::std::vector<" + name + ">* value"}}}};
+  b = read_vector->GetStatementBlock();
+  b->AddLiteral(raw_vector + " raw");
+  b->AddLiteral(StringPrintf("%s = parcel.read%sVector(&raw)",
+                             status_decl.c_str(), suffix.c_str()));
+  b->AddStatement(ReturnOnStatusNotOk());
+  b->AddLiteral("value->resize(raw.size())");
+  ForStatement* loop = new ForStatement("i", "0", "raw.size()");
+  loop->Body()->AddLiteral("(*value)[i] = " + from_raw);
+  invalid = new IfStatement(new LiteralExpression(
+      "!" + is_valid + "((*value)[i])"));
+  invalid->OnTrue()->AddLiteral(bad_value);
+  loop->Body()->AddStatement(invalid);
+  b->AddStatement(loop);
+  b->AddLiteral(StringPrintf("return %s", kAndroidStatusOk));
+  decls->push_back(std::move(read_vector));
+
+  unique_ptr<MethodImpl> write_vector{new MethodImpl{
+      kAndroidStatusLiteral, i_name, "_aidl_Write" + name + "Vector",
+      ArgList{{"::android::Parcel* parcel",
+               "const ::std::vector<" + name + ">& value"}}}};
+  b = write_vector->GetStatementBlock();
+  b->AddLiteral(raw_vector + " raw(value.size())");
+  loop = new ForStatement("i", "0", "value.size()");
+  loop->Body()->AddLiteral(StringPrintf(
+      "raw[i] = static_cast<%s>(value[i])", EnumVectorRawType(e).c_str()));
+  b->AddStatement(loop);
+  b->AddLiteral(StringPrintf("return parcel->write%sVector(raw)",
+                             suffix.c_str()));
+  decls->push_back(std::move(write_vector));
+}
+
+}  // namespace
+
 unique_ptr<Document> BuildInterfaceSource(const TypeNamespace& /* types */,
                                           const AidlInterface& interface) {
   vector<string> include_list{
@@ -567,19 +1531,636 @@ unique_ptr<Document> BuildInterfaceSource(const TypeNamespace& /* types */,
       HeaderFile(interface, ClassNames::CLIENT, false),
   };
 
-  string fq_name = ClassName(interface, ClassNames::INTERFACE);
+  const string i_name = ClassName(interface, ClassNames::INTERFACE);
+  const string bp_name = ClassName(interface, ClassNames::CLIENT);
+  string fq_name = i_name;
   if (!interface.GetPackage().empty()) {
     fq_name = interface.GetPackage() + "." + fq_name;
   }
 
-  unique_ptr<ConstructorDecl> meta_if{new ConstructorDecl{
-      "IMPLEMENT_META_INTERFACE",
-      ArgList{vector<string>{ClassName(interface, ClassNames::BASE),
-                             '"' + fq_name + '"'}}}};
+  // This replaces IMPLEMENT_META_INTERFACE, which defines the descriptor as a
+  // global String16 and so costs every process a dynamic initializer and a
+  // heap allocation per interface at startup.  The descriptor below is
+  // constant initialized, and the String16 is only built on first use.
+  vector<unique_ptr<Declaration>> decls;
+  string definitions = StringPrintf(
+      "constexpr %s::DescriptorLiteral %s::descriptor;\n",
+      i_name.c_str(), i_name.c_str());
+  for (const auto& constant : interface.GetConstants()) {
+    if (constant->GetType() == AidlConstant::INT) { continue; }
+    definitions += StringPrintf(
+        "constexpr %s;\n",
+        ConstantDeclarator(*constant, i_name + "::" + constant->GetName())
+            .c_str());
+  }
+  decls.emplace_back(new LiteralDecl(definitions));
+
+  unique_ptr<MethodImpl> to_string16{new MethodImpl{
+      "", i_name + "::DescriptorLiteral", "operator const ::android::String16&",
+      ArgList{}, true /* const method */}};
+  // Deliberately leaked, like any other never destroyed static.
+  to_string16->GetStatementBlock()->AddLiteral(StringPrintf(
+      "static const ::android::String16* const _aidl_descriptor = "
+      "new ::android::String16(u\"%s\")", fq_name.c_str()));
+  to_string16->GetStatementBlock()->AddLiteral("return *_aidl_descriptor");
+  decls.push_back(std::move(to_string16));
+
+  unique_ptr<MethodImpl> get_descriptor{new MethodImpl{
+      "const ::android::String16&", i_name, "getInterfaceDescriptor",
+      ArgList{}, true /* const method */}};
+  get_descriptor->GetStatementBlock()->AddLiteral("return descriptor");
+  decls.push_back(std::move(get_descriptor));
+
+  unique_ptr<MethodImpl> as_interface{new MethodImpl{
+      StringPrintf("::android::sp<%s>", i_name.c_str()), i_name,
+      "asInterface", ArgList{"const ::android::sp<::android::IBinder>& obj"}}};
+  StatementBlock* b = as_interface->GetStatementBlock();
+  b->AddLiteral(StringPrintf("::android::sp<%s> _aidl_intr", i_name.c_str()));
+  IfStatement* non_null = new IfStatement(new LiteralExpression("obj != nullptr"));
+  non_null->OnTrue()->AddLiteral(StringPrintf(
+      "_aidl_intr = static_cast<%s*>(obj->queryLocalInterface(descriptor).get())",
+      i_name.c_str()));
+  IfStatement* not_local =
+      new IfStatement(new LiteralExpression("_aidl_intr == nullptr"));
+  not_local->OnTrue()->AddLiteral(
+      StringPrintf("_aidl_intr = new %s(obj)", bp_name.c_str()));
+  non_null->OnTrue()->AddStatement(not_local);
+  b->AddStatement(non_null);
+  b->AddLiteral("return _aidl_intr");
+  decls.push_back(std::move(as_interface));
+
+  for (const auto& e : interface.GetEnums()) {
+    BuildEnumImpls(i_name, *e, &decls);
+  }
+
+  return unique_ptr<Document>{new CppSource{
+      include_list,
+      NestInNamespaces(std::move(decls), interface.GetSplitPackage())}};
+}
+
+namespace {
+
+string BuildShardListType(const AidlInterface& interface) {
+  return StringPrintf("::std::vector<::android::sp<%s>>",
+                      ClassName(interface, ClassNames::INTERFACE).c_str());
+}
+
+// Returns the argument types we need HashShardKey() overloads for.
+set<string> GetShardKeyTypes(const AidlInterface& interface) {
+  set<string> key_types;
+  for (const auto& method : interface.GetMethods()) {
+    const AidlArgument* key = method->GetShardKeyArgument();
+    if (key == nullptr) { continue; }
+    const string cpp_type = key->GetType().GetLanguageType<Type>()->CppType();
+    key_types.insert(cpp_type);
+    if (cpp_type == "::std::string") {
+      // UTF-8 keys are hashed through their UTF-16 form.
+      key_types.insert("::android::String16");
+    }
+  }
+  return key_types;
+}
+
+string BuildShardKeyParameter(const string& cpp_type) {
+  if (cpp_type == "int32_t" || cpp_type == "int64_t") {
+    return cpp_type + " key";
+  }
+  return "const " + cpp_type + "& key";
+}
+
+// Forwards the arguments of a router method to the same method on a shard.
+// |return_value| is passed in place of _aidl_return.
+ArgList BuildForwardedArgList(const TypeNamespace& types,
+                              const AidlMethod& method,
+                              const string& return_value) {
+  vector<string> arguments;
+  for (const unique_ptr<AidlArgument>& a : method.GetArguments()) {
+    arguments.push_back(a->GetName());
+  }
+  if (method.GetType().GetLanguageType<Type>() != types.VoidType()) {
+    arguments.push_back(return_value);
+  }
+  return ArgList(arguments);
+}
+
+unique_ptr<Declaration> DefineRouterMethod(const TypeNamespace& types,
+                                           const AidlInterface& interface,
+                                           const AidlMethod& method) {
+  unique_ptr<MethodImpl> ret{new MethodImpl{
+      kBinderStatusLiteral, ClassName(interface, ClassNames::ROUTER),
+      method.GetName(),
+      ArgList{BuildArgList(types, method, true /* for method decl */)}}};
+  StatementBlock* b = ret->GetStatementBlock();
+
+  IfStatement* no_shards = new IfStatement(
+      new LiteralExpression(StringPrintf("%s.empty()", kShardsVarName)));
+  no_shards->OnTrue()->AddLiteral(StringPrintf(
+      "return %s::fromExceptionCode(%s::EX_ILLEGAL_STATE)",
+      kBinderStatusLiteral, kBinderStatusLiteral));
+  b->AddStatement(no_shards);
+
+  const string shard_call = StringPrintf("%s[%s]->%s", kShardsVarName,
+                                         kShardVarName,
+                                         method.GetName().c_str());
+  const string record_call = StringPrintf("RecordCall(%s, %s)", kShardVarName,
+                                          kStatusVarName);
+
+  const AidlArgument* key = method.GetShardKeyArgument();
+  if (key != nullptr) {
+    // Keyed calls go to exactly one shard.
+    b->AddLiteral(StringPrintf("size_t %s = ShardIndex(HashShardKey(%s))",
+                               kShardVarName, key->GetName().c_str()));
+    b->AddStatement(new Assignment(
+        StringPrintf("%s %s", kBinderStatusLiteral, kStatusVarName),
+        new MethodCall(shard_call,
+                       BuildForwardedArgList(types, method, kReturnVarName))));
+    b->AddLiteral(record_call);
+    b->AddLiteral(StringPrintf("return %s", kStatusVarName));
+    return unique_ptr<Declaration>(ret.release());
+  }
+
+  // Calls without a key are broadcast to every shard in order.  We stop at
+  // the first failure, and only the first shard's return value is kept.
+  b->AddLiteral(StringPrintf("%s %s", kBinderStatusLiteral, kStatusVarName));
+  const Type* return_type = method.GetType().GetLanguageType<Type>();
+  string return_value = kReturnVarName;
+  if (return_type != types.VoidType()) {
+    b->AddLiteral(StringPrintf("%s _aidl_ignored_return",
+                               return_type->CppType().c_str()));
+    return_value = StringPrintf("(%s == 0) ? %s : &_aidl_ignored_return",
+                                kShardVarName, kReturnVarName);
+  }
+  ForStatement* loop = new ForStatement(
+      kShardVarName, "0", StringPrintf("%s.size()", kShardsVarName));
+  b->AddStatement(loop);
+  loop->Body()->AddStatement(new Assignment(
+      kStatusVarName,
+      new MethodCall(shard_call,
+                     BuildForwardedArgList(types, method, return_value))));
+  loop->Body()->AddLiteral(record_call);
+  IfStatement* failure = new IfStatement(
+      new LiteralExpression(StringPrintf("!%s.isOk()", kStatusVarName)));
+  failure->OnTrue()->AddLiteral("break");
+  loop->Body()->AddStatement(failure);
+  b->AddLiteral(StringPrintf("return %s", kStatusVarName));
+
+  return unique_ptr<Declaration>(ret.release());
+}
+
+}  // namespace
+
+unique_ptr<Document> BuildRouterSource(const TypeNamespace& types,
+                                       const AidlInterface& interface) {
+  const string router_name = ClassName(interface, ClassNames::ROUTER);
+  vector<string> include_list{HeaderFile(interface, ClassNames::ROUTER, false)};
+  vector<unique_ptr<Declaration>> file_decls;
+
+  file_decls.push_back(unique_ptr<Declaration>{new ConstructorImpl{
+      router_name,
+      ArgList{StringPrintf("const %s& shards",
+                           BuildShardListType(interface).c_str())},
+      {StringPrintf("%s(shards)", kShardsVarName),
+       StringPrintf("%s(new ::std::atomic<uint64_t>[shards.size()]())",
+                    kShardCallsVarName),
+       StringPrintf("%s(new ::std::atomic<uint64_t>[shards.size()]())",
+                    kShardErrorsVarName)}}});
+
+  unique_ptr<MethodImpl> shard_count{new MethodImpl{
+      "size_t", router_name, "ShardCount", ArgList{}, true}};
+  shard_count->GetStatementBlock()->AddLiteral(
+      StringPrintf("return %s.size()", kShardsVarName));
+  file_decls.push_back(std::move(shard_count));
+
+  for (const auto& counter : {std::make_pair("ShardCallCount",
+                                             kShardCallsVarName),
+                              std::make_pair("ShardErrorCount",
+                                             kShardErrorsVarName)}) {
+    unique_ptr<MethodImpl> m{new MethodImpl{
+        "uint64_t", router_name, counter.first, ArgList{"size_t shard"},
+        true}};
+    IfStatement* range_check = new IfStatement(new LiteralExpression(
+        StringPrintf("shard >= %s.size()", kShardsVarName)));
+    range_check->OnTrue()->AddLiteral("return 0");
+    m->GetStatementBlock()->AddStatement(range_check);
+    m->GetStatementBlock()->AddLiteral(StringPrintf(
+        "return %s[shard].load(::std::memory_order_relaxed)", counter.second));
+    file_decls.push_back(std::move(m));
+  }
+
+  // A router is a purely local object, so there is no binder to hand out.
+  unique_ptr<MethodImpl> as_binder{new MethodImpl{
+      "::android::IBinder*", router_name, "onAsBinder", ArgList{}}};
+  as_binder->GetStatementBlock()->AddLiteral("return nullptr");
+  file_decls.push_back(std::move(as_binder));
+
+  unique_ptr<MethodImpl> shard_index{new MethodImpl{
+      "size_t", router_name, "ShardIndex", ArgList{"uint64_t key_hash"},
+      true}};
+  shard_index->GetStatementBlock()->AddLiteral(StringPrintf(
+      "return (key_hash & 0x7fffffffffffffffULL) %% %s.size()",
+      kShardsVarName));
+  file_decls.push_back(std::move(shard_index));
+
+  unique_ptr<MethodImpl> record_call{new MethodImpl{
+      "void", router_name, "RecordCall",
+      ArgList{{"size_t shard",
+               StringPrintf("const %s& status", kBinderStatusLiteral)}}}};
+  record_call->GetStatementBlock()->AddLiteral(StringPrintf(
+      "%s[shard].fetch_add(1, ::std::memory_order_relaxed)",
+      kShardCallsVarName));
+  IfStatement* error_check = new IfStatement(
+      new LiteralExpression("!status.isOk()"));
+  error_check->OnTrue()->AddLiteral(StringPrintf(
+      "%s[shard].fetch_add(1, ::std::memory_order_relaxed)",
+      kShardErrorsVarName));
+  record_call->GetStatementBlock()->AddStatement(error_check);
+  file_decls.push_back(std::move(record_call));
+
+  // Keys are hashed with 64 bit FNV-1a over their little endian bytes (UTF-16
+  // code units for strings).  The Java router uses the same function, so a
+  // given key lands on the same shard regardless of the client's language.
+  unique_ptr<MethodImpl> mix{new MethodImpl{
+      "uint64_t", router_name, "MixShardKey",
+      ArgList{{"uint64_t hash", "uint64_t value", "size_t bytes"}}}};
+  ForStatement* mix_loop = new ForStatement("i", "0", "bytes");
+  mix_loop->Body()->AddLiteral("hash ^= (value >> (8 * i)) & 0xff");
+  mix_loop->Body()->AddLiteral("hash *= 0x100000001b3ULL");
+  mix->GetStatementBlock()->AddStatement(mix_loop);
+  mix->GetStatementBlock()->AddLiteral("return hash");
+  file_decls.push_back(std::move(mix));
+
+  for (const string& key_type : GetShardKeyTypes(interface)) {
+    unique_ptr<MethodImpl> hash{new MethodImpl{
+        "uint64_t", router_name, "HashShardKey",
+        ArgList{BuildShardKeyParameter(key_type)}}};
+    StatementBlock* b = hash->GetStatementBlock();
+    if (key_type == "int32_t") {
+      b->AddLiteral(StringPrintf(
+          "return MixShardKey(%s, static_cast<uint32_t>(key), 4)",
+          kFnvOffsetBasis));
+    } else if (key_type == "int64_t") {
+      b->AddLiteral(StringPrintf(
+          "return MixShardKey(%s, static_cast<uint64_t>(key), 8)",
+          kFnvOffsetBasis));
+    } else if (key_type == "::std::string") {
+      b->AddLiteral(
+          "return HashShardKey(::android::String16(key.c_str(), key.size()))");
+    } else {
+      b->AddLiteral(StringPrintf("uint64_t hash = %s", kFnvOffsetBasis));
+      ForStatement* loop = new ForStatement("i", "0", "key.size()");
+      loop->Body()->AddLiteral("hash = MixShardKey(hash, key.string()[i], 2)");
+      b->AddStatement(loop);
+      b->AddLiteral("return hash");
+    }
+    file_decls.push_back(std::move(hash));
+  }
+
+  for (const auto& method : interface.GetMethods()) {
+    file_decls.push_back(DefineRouterMethod(types, interface, *method));
+  }
 
   return unique_ptr<Document>{new CppSource{
       include_list,
-      NestInNamespaces(std::move(meta_if), interface.GetSplitPackage())}};
+      NestInNamespaces(std::move(file_decls), interface.GetSplitPackage())}};
+}
+
+namespace {
+
+// Calls to methods returning a value give back a Result<T>, which later
+// calls in the chain can take as an argument.
+string ChainResultType(const TypeNamespace& types, const AidlMethod& method) {
+  const Type* return_type = method.GetType().GetLanguageType<Type>();
+  if (return_type == types.VoidType()) {
+    return "void";
+  }
+  return StringPrintf("Result<%s>", return_type->CppType().c_str());
+}
+
+ArgList BuildChainArgList(const TypeNamespace& types,
+                          const AidlMethod& method) {
+  vector<string> arguments;
+  for (const AidlArgument* a : method.GetInArguments()) {
+    arguments.push_back(StringPrintf(
+        "Arg<%s> %s", a->GetType().GetLanguageType<Type>()->CppType().c_str(),
+        a->GetName().c_str()));
+  }
+  const Type* return_type = method.GetType().GetLanguageType<Type>();
+  if (return_type != types.VoidType()) {
+    arguments.push_back(StringPrintf("%s* %s", return_type->CppType().c_str(),
+                                     kReturnVarName));
+  }
+  return ArgList(arguments);
+}
+
+bool HasChainResults(const TypeNamespace& types,
+                     const AidlInterface& interface) {
+  for (const auto& method : interface.GetMethods()) {
+    if (method->CanBeChained() &&
+        method->GetType().GetLanguageType<Type>() != types.VoidType()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+unique_ptr<Declaration> DefineChainMethod(const TypeNamespace& types,
+                                          const AidlInterface& interface,
+                                          const AidlMethod& method) {
+  const string chain_name = ClassName(interface, ClassNames::CHAIN);
+  const string result_type = ChainResultType(types, method);
+  const bool has_result = result_type != "void";
+  unique_ptr<MethodImpl> ret{new MethodImpl{
+      has_result ? chain_name + "::" + result_type : result_type,
+      chain_name, method.GetName(), BuildChainArgList(types, method)}};
+  StatementBlock* b = ret->GetStatementBlock();
+
+  if (has_result) {
+    b->AddLiteral(StringPrintf("const int32_t _aidl_step = %s.size()",
+                               kChainStepsVarName));
+  }
+  b->AddLiteral(StringPrintf(
+      "%s %s = BeginStep(%s::%s, %zu, %s)", kAndroidStatusLiteral,
+      kAndroidStatusVarName, ClassName(interface, ClassNames::INTERFACE).c_str(),
+      UpperCase(method.GetName()).c_str(), method.GetInArguments().size(),
+      has_result ? kReturnVarName : "nullptr"));
+  b->AddStatement(GotoErrorOnBadStatus());
+
+  // Arguments look roughly like:
+  //     _aidl_ret_status = BeginArgument(param_name.step());
+  //     if (param_name.value() != nullptr) {
+  //       _aidl_ret_status = _aidl_request.writeInt32(*param_name.value());
+  //       _aidl_ret_status = EndArgument();
+  //     }
+  for (const AidlArgument* a : method.GetInArguments()) {
+    const Type* type = a->GetType().GetLanguageType<Type>();
+    const string& name = a->GetName();
+    b->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        new MethodCall("BeginArgument", ArgList(name + ".step()"))));
+    b->AddStatement(GotoErrorOnBadStatus());
+    IfStatement* has_value = new IfStatement(new LiteralExpression(
+        StringPrintf("%s.value() != nullptr", name.c_str())));
+    b->AddStatement(has_value);
+    has_value->OnTrue()->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        BuildWriteToParcel(*type, kChainRequestVarName, false,
+                           "*" + name + ".value()")));
+    has_value->OnTrue()->AddStatement(GotoErrorOnBadStatus());
+    has_value->OnTrue()->AddStatement(new Assignment(
+        kAndroidStatusVarName, new MethodCall("EndArgument", ArgList{})));
+    has_value->OnTrue()->AddStatement(GotoErrorOnBadStatus());
+  }
+
+  // Errors are reported by Transact().
+  b->AddLiteral(StringPrintf("%s:\n", kErrorLabel), false /* no semicolon */);
+  b->AddLiteral(StringPrintf("%s = %s", kChainBuildStatusVarName,
+                             kAndroidStatusVarName));
+  if (has_result) {
+    b->AddLiteral(StringPrintf("return %s(_aidl_step)", result_type.c_str()));
+  }
+
+  return unique_ptr<Declaration>(ret.release());
+}
+
+unique_ptr<Declaration> DefineChainTransact(const TypeNamespace& types,
+                                            const AidlInterface& interface) {
+  const string i_name = ClassName(interface, ClassNames::INTERFACE);
+  unique_ptr<MethodImpl> ret{new MethodImpl{
+      kBinderStatusLiteral, ClassName(interface, ClassNames::CHAIN),
+      "Transact",
+      ArgList{StringPrintf("const ::android::sp<%s>& service",
+                           i_name.c_str())}}};
+  StatementBlock* b = ret->GetStatementBlock();
+
+  b->AddLiteral(StringPrintf("%s %s", kAndroidParcelLiteral, kDataVarName));
+  b->AddLiteral(StringPrintf("%s %s", kAndroidParcelLiteral, kReplyVarName));
+  b->AddLiteral(StringPrintf("%s %s = %s", kAndroidStatusLiteral,
+                             kAndroidStatusVarName, kChainBuildStatusVarName));
+  b->AddLiteral(StringPrintf("%s %s", kBinderStatusLiteral, kStatusVarName));
+  b->AddLiteral("int32_t _aidl_completed = 0");
+  b->AddStatement(GotoErrorOnBadStatus());
+
+  b->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      new MethodCall(StringPrintf("%s.writeInterfaceToken", kDataVarName),
+                     ArgList(i_name + "::descriptor"))));
+  b->AddStatement(GotoErrorOnBadStatus());
+  b->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      new MethodCall(StringPrintf("%s.writeInt32", kDataVarName),
+                     ArgList(StringPrintf("%s.size()", kChainStepsVarName)))));
+  b->AddStatement(GotoErrorOnBadStatus());
+  b->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      new MethodCall(StringPrintf("%s.appendFrom", kDataVarName),
+                     ArgList{{StringPrintf("&%s", kChainRequestVarName), "0",
+                              StringPrintf("%s.dataSize()",
+                                           kChainRequestVarName)}})));
+  b->AddStatement(GotoErrorOnBadStatus());
+  b->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      new MethodCall("::android::IInterface::asBinder(service)->transact",
+                     ArgList{{StringPrintf("%s::%s", i_name.c_str(),
+                                           kCallChainCode),
+                              kDataVarName,
+                              StringPrintf("&%s", kReplyVarName)}})));
+  b->AddStatement(GotoErrorOnBadStatus());
+  b->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      StringPrintf("%s.readFromParcel(%s)", kStatusVarName, kReplyVarName)));
+  b->AddStatement(GotoErrorOnBadStatus());
+  IfStatement* exception_check = new IfStatement(
+      new LiteralExpression(StringPrintf("!%s.isOk()", kStatusVarName)));
+  exception_check->OnTrue()->AddLiteral(
+      StringPrintf("return %s", kStatusVarName));
+  b->AddStatement(exception_check);
+  b->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      StringPrintf("%s.readInt32(&_aidl_completed)", kReplyVarName)));
+  b->AddStatement(GotoErrorOnBadStatus());
+  IfStatement* count_check = new IfStatement(new LiteralExpression(
+      StringPrintf("_aidl_completed < 0 || "
+                   "static_cast<size_t>(_aidl_completed) > %s.size()",
+                   kChainStepsVarName)));
+  count_check->OnTrue()->AddStatement(
+      new Assignment(kAndroidStatusVarName, "::android::BAD_VALUE"));
+  count_check->OnTrue()->AddLiteral(StringPrintf("goto %s", kErrorLabel));
+  b->AddStatement(count_check);
+
+  // Each step's reply is exactly what the call would have replied on its own.
+  ForStatement* loop = new ForStatement(
+      "i", "0", "static_cast<size_t>(_aidl_completed)");
+  b->AddStatement(loop);
+  StatementBlock* body = loop->Body();
+  body->AddLiteral("int32_t _aidl_size");
+  body->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      StringPrintf("%s.readInt32(&_aidl_size)", kReplyVarName)));
+  body->AddStatement(GotoErrorOnBadStatus());
+  body->AddLiteral(StringPrintf("const size_t _aidl_start = %s.dataPosition()",
+                                kReplyVarName));
+  IfStatement* size_check = new IfStatement(new LiteralExpression(
+      StringPrintf("_aidl_size < 0 || "
+                   "static_cast<size_t>(_aidl_size) > %s.dataAvail()",
+                   kReplyVarName)));
+  size_check->OnTrue()->AddStatement(
+      new Assignment(kAndroidStatusVarName, "::android::BAD_VALUE"));
+  size_check->OnTrue()->AddLiteral(StringPrintf("goto %s", kErrorLabel));
+  body->AddStatement(size_check);
+  body->AddLiteral(StringPrintf("%s _aidl_step_reply", kAndroidParcelLiteral));
+  body->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      StringPrintf("_aidl_step_reply.appendFrom(&%s, _aidl_start, _aidl_size)",
+                   kReplyVarName)));
+  body->AddStatement(GotoErrorOnBadStatus());
+  body->AddLiteral(StringPrintf("%s.setDataPosition(_aidl_start + _aidl_size)",
+                                kReplyVarName));
+  body->AddLiteral("_aidl_step_reply.setDataPosition(0)");
+  body->AddStatement(new Assignment(
+      kAndroidStatusVarName,
+      StringPrintf("%s.readFromParcel(_aidl_step_reply)", kStatusVarName)));
+  body->AddStatement(GotoErrorOnBadStatus());
+  IfStatement* step_exception_check = new IfStatement(
+      new LiteralExpression(StringPrintf("!%s.isOk()", kStatusVarName)));
+  step_exception_check->OnTrue()->AddLiteral(
+      StringPrintf("return %s", kStatusVarName));
+  body->AddStatement(step_exception_check);
+  if (HasChainResults(types, interface)) {
+    body->AddStatement(new Assignment(
+        kAndroidStatusVarName,
+        StringPrintf("ReadResult(%s[i].code, _aidl_step_reply, %s[i].result)",
+                     kChainStepsVarName, kChainStepsVarName)));
+    body->AddStatement(GotoErrorOnBadStatus());
+  }
+
+  // The service only stops early after a call that fails.
+  IfStatement* completion_check = new IfStatement(new LiteralExpression(
+      StringPrintf("static_cast<size_t>(_aidl_completed) != %s.size()",
+                   kChainStepsVarName)));
+  completion_check->OnTrue()->AddStatement(
+      new Assignment(kAndroidStatusVarName, "::android::BAD_VALUE"));
+  b->AddStatement(completion_check);
+
+  b->AddLiteral(StringPrintf("%s:\n", kErrorLabel), false /* no semicolon */);
+  b->AddLiteral(
+      StringPrintf("%s.setFromStatusT(%s)", kStatusVarName,
+                   kAndroidStatusVarName));
+  b->AddLiteral(StringPrintf("return %s", kStatusVarName));
+
+  return unique_ptr<Declaration>(ret.release());
+}
+
+}  // namespace
+
+unique_ptr<Document> BuildCallChainSource(const TypeNamespace& types,
+                                          const AidlInterface& interface) {
+  const string chain_name = ClassName(interface, ClassNames::CHAIN);
+  vector<string> include_list{HeaderFile(interface, ClassNames::CHAIN, false)};
+  vector<unique_ptr<Declaration>> file_decls;
+  if (HasNonNullTypes(interface)) {
+    file_decls.emplace_back(new LiteralDecl(kNonNullParcelableHelpers));
+  }
+
+  for (const auto& method : interface.GetMethods()) {
+    if (method->CanBeChained()) {
+      file_decls.push_back(DefineChainMethod(types, interface, *method));
+    }
+  }
+  file_decls.push_back(DefineChainTransact(types, interface));
+
+  unique_ptr<MethodImpl> begin_step{new MethodImpl{
+      kAndroidStatusLiteral, chain_name, "BeginStep",
+      ArgList{{"uint32_t code", "int32_t argument_count", "void* result"}}}};
+  StatementBlock* b = begin_step->GetStatementBlock();
+  IfStatement* failed = new IfStatement(new Comparison(
+      new LiteralExpression(kChainBuildStatusVarName), "!=",
+      new LiteralExpression(kAndroidStatusOk)));
+  failed->OnTrue()->AddLiteral(
+      StringPrintf("return %s", kChainBuildStatusVarName));
+  b->AddStatement(failed);
+  b->AddLiteral(StringPrintf("%s.push_back(Step{code, result})",
+                             kChainStepsVarName));
+  b->AddLiteral(StringPrintf(
+      "%s %s = %s.writeInt32(static_cast<int32_t>(code))",
+      kAndroidStatusLiteral, kAndroidStatusVarName, kChainRequestVarName));
+  b->AddStatement(ReturnOnStatusNotOk());
+  b->AddLiteral(StringPrintf("return %s.writeInt32(argument_count)",
+                             kChainRequestVarName));
+  file_decls.push_back(std::move(begin_step));
+
+  unique_ptr<MethodImpl> begin_argument{new MethodImpl{
+      kAndroidStatusLiteral, chain_name, "BeginArgument",
+      ArgList{"int32_t step"}}};
+  b = begin_argument->GetStatementBlock();
+  IfStatement* is_result = new IfStatement(
+      new LiteralExpression("step >= 0"));
+  // Only results of earlier calls in this chain can be passed on.
+  IfStatement* range_check = new IfStatement(new LiteralExpression(
+      StringPrintf("static_cast<size_t>(step) + 1 >= %s.size()",
+                   kChainStepsVarName)));
+  range_check->OnTrue()->AddLiteral("return ::android::BAD_VALUE");
+  is_result->OnTrue()->AddStatement(range_check);
+  is_result->OnTrue()->AddLiteral(StringPrintf(
+      "return %s.writeInt32(step)", kChainRequestVarName));
+  b->AddStatement(is_result);
+  b->AddLiteral(StringPrintf("%s %s = %s.writeInt32(-1)",
+                             kAndroidStatusLiteral, kAndroidStatusVarName,
+                             kChainRequestVarName));
+  b->AddStatement(ReturnOnStatusNotOk());
+  // EndArgument() fills in the size once the value has been written.
+  b->AddLiteral(StringPrintf("%s = %s.dataPosition()",
+                             kChainSizePositionVarName, kChainRequestVarName));
+  b->AddLiteral(StringPrintf("return %s.writeInt32(0)", kChainRequestVarName));
+  file_decls.push_back(std::move(begin_argument));
+
+  unique_ptr<MethodImpl> end_argument{new MethodImpl{
+      kAndroidStatusLiteral, chain_name, "EndArgument", ArgList{}}};
+  b = end_argument->GetStatementBlock();
+  b->AddLiteral(StringPrintf("const size_t _aidl_end = %s.dataPosition()",
+                             kChainRequestVarName));
+  b->AddLiteral(StringPrintf("%s.setDataPosition(%s)", kChainRequestVarName,
+                             kChainSizePositionVarName));
+  b->AddLiteral(StringPrintf(
+      "%s %s = %s.writeInt32(static_cast<int32_t>(_aidl_end - %s - "
+      "sizeof(int32_t)))",
+      kAndroidStatusLiteral, kAndroidStatusVarName, kChainRequestVarName,
+      kChainSizePositionVarName));
+  b->AddLiteral(StringPrintf("%s.setDataPosition(_aidl_end)",
+                             kChainRequestVarName));
+  b->AddLiteral(StringPrintf("return %s", kAndroidStatusVarName));
+  file_decls.push_back(std::move(end_argument));
+
+  if (HasChainResults(types, interface)) {
+    unique_ptr<MethodImpl> read_result{new MethodImpl{
+        kAndroidStatusLiteral, chain_name, "ReadResult",
+        ArgList{{"uint32_t code", "const ::android::Parcel& reply",
+                 "void* result"}}}};
+    b = read_result->GetStatementBlock();
+    b->AddLiteral(StringPrintf("%s %s = %s", kAndroidStatusLiteral,
+                               kAndroidStatusVarName, kAndroidStatusOk));
+    SwitchStatement* s = new SwitchStatement{"code"};
+    b->AddStatement(s);
+    const string i_name = ClassName(interface, ClassNames::INTERFACE);
+    for (const auto& method : interface.GetMethods()) {
+      const Type* return_type = method->GetType().GetLanguageType<Type>();
+      if (!method->CanBeChained() || return_type == types.VoidType()) {
+        continue;
+      }
+      StatementBlock* c = s->AddCase(StringPrintf(
+          "%s::%s", i_name.c_str(), UpperCase(method->GetName()).c_str()));
+      c->AddStatement(new Assignment(
+          kAndroidStatusVarName,
+          BuildReadFromParcel(*return_type, "reply",
+                              StringPrintf("static_cast<%s*>(result)",
+                                           return_type->CppType().c_str()))));
+    }
+    b->AddLiteral(StringPrintf("return %s", kAndroidStatusVarName));
+    file_decls.push_back(std::move(read_result));
+  }
+
+  return unique_ptr<Document>{new CppSource{
+      include_list,
+      NestInNamespaces(std::move(file_decls), interface.GetSplitPackage())}};
 }
 
 unique_ptr<Document> BuildClientHeader(const TypeNamespace& types,
@@ -602,28 +2183,41 @@ unique_ptr<Document> BuildClientHeader(const TypeNamespace& types,
   publics.push_back(std::move(constructor));
   publics.push_back(std::move(destructor));
 
+  vector<unique_ptr<Declaration>> privates;
   for (const auto& method: interface.GetMethods()) {
     publics.push_back(BuildMethodDecl(*method, types, false));
+    if (method->GetType().IsMirrored()) {
+      privates.emplace_back(new LiteralDecl(StringPrintf(
+          "%s %s;\n", kStateMirrorSubscriberLiteral,
+          MirrorVarName(*method).c_str())));
+    }
   }
 
   unique_ptr<ClassDecl> bp_class{
       new ClassDecl{bp_name,
                     "::android::BpInterface<" + i_name + ">",
                     std::move(publics),
-                    {}
+                    std::move(privates)
       }};
 
+  vector<string> includes{kIBinderHeader,
+                          kIInterfaceHeader,
+                          "utils/Errors.h",
+                          HeaderFile(interface, ClassNames::INTERFACE, false)};
+  if (interface.HasMirroredMethods()) {
+    includes.push_back(kStateMirrorHeader);
+  }
+
   return unique_ptr<Document>{new CppHeader{
       BuildHeaderGuard(interface, ClassNames::CLIENT),
-      {kIBinderHeader,
-       kIInterfaceHeader,
-       "utils/Errors.h",
-       HeaderFile(interface, ClassNames::INTERFACE, false)},
+      includes,
       NestInNamespaces(std::move(bp_class), interface.GetSplitPackage())}};
 }
 
 unique_ptr<Document> BuildServerHeader(const TypeNamespace& /* types */,
-                                       const AidlInterface& interface) {
+                                       const AidlInterface& interface,
+                                       bool server_metrics,
+                                       bool server_watchdog) {
   const string i_name = ClassName(interface, ClassNames::INTERFACE);
   const string bn_name = ClassName(interface, ClassNames::SERVER);
 
@@ -639,25 +2233,62 @@ unique_ptr<Document> BuildServerHeader(const TypeNamespace& /* types */,
 
   std::vector<unique_ptr<Declaration>> publics;
   publics.push_back(std::move(on_transact));
+  std::vector<unique_ptr<Declaration>> privates;
+  vector<string> includes{"binder/IInterface.h",
+                          HeaderFile(interface, ClassNames::INTERFACE, false)};
+  if (server_metrics) {
+    // Counters per method, in the order they are declared.
+    publics.emplace_back(new LiteralDecl(StringPrintf(
+        "const %s& GetTransactionMetrics() const { return %s; }\n",
+        kTransactionMetricsLiteral, kMetricsVarName)));
+    privates.emplace_back(new LiteralDecl(StringPrintf(
+        "%s %s{%zu};\n", kTransactionMetricsLiteral, kMetricsVarName,
+        interface.GetMethods().size())));
+    includes.push_back(kTransactionMetricsHeader);
+  }
+  if (server_watchdog) {
+    // Thresholds per method, in the order they are declared.
+    publics.emplace_back(new LiteralDecl(StringPrintf(
+        "static %s& GetCallWatchTable() { return %s; }\n",
+        kCallWatchTableLiteral, kWatchTableVarName)));
+    privates.emplace_back(new LiteralDecl(StringPrintf(
+        "static %s %s;\n", kCallWatchTableLiteral, kWatchTableVarName)));
+    includes.push_back(kCallWatchdogHeader);
+  }
+  for (const auto& method : interface.GetMethods()) {
+    if (!method->GetType().IsMirrored()) { continue; }
+    // Clients read what the service last published instead of calling it.
+    const Type* return_type = method->GetType().GetLanguageType<Type>();
+    publics.emplace_back(new MethodDecl{
+        kAndroidStatusLiteral, PublishMethodName(*method),
+        ArgList{StringPrintf("const %s& state",
+                             return_type->CppType().c_str())}});
+    privates.emplace_back(new LiteralDecl(StringPrintf(
+        "%s %s;\n", kStateMirrorPublisherLiteral,
+        MirrorVarName(*method).c_str())));
+  }
+  if (interface.HasMirroredMethods()) {
+    includes.push_back(kStateMirrorHeader);
+  }
 
   unique_ptr<ClassDecl> bn_class{
       new ClassDecl{bn_name,
                     "::android::BnInterface<" + i_name + ">",
                     std::move(publics),
-                    {}
+                    std::move(privates)
       }};
 
   return unique_ptr<Document>{new CppHeader{
       BuildHeaderGuard(interface, ClassNames::SERVER),
-      {"binder/IInterface.h",
-       HeaderFile(interface, ClassNames::INTERFACE, false)},
+      includes,
       NestInNamespaces(std::move(bn_class), interface.GetSplitPackage())}};
 }
 
 unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
                                           const AidlInterface& interface) {
   set<string> includes = { kIBinderHeader, kIInterfaceHeader,
-                           kStatusHeader, kStrongPointerHeader };
+                           kStatusHeader, kString16Header,
+                           kStrongPointerHeader };
 
   for (const auto& method : interface.GetMethods()) {
     for (const auto& argument : method->GetArguments()) {
@@ -668,22 +2299,56 @@ unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
     const Type* return_type = method->GetType().GetLanguageType<Type>();
     return_type->GetHeaders(&includes);
   }
+  if (!interface.GetEnums().empty()) {
+    includes.insert({"cstdint", "vector", kParcelHeader});
+  }
 
+  const string i_name = ClassName(interface, ClassNames::INTERFACE);
   unique_ptr<ClassDecl> if_class{
-      new ClassDecl{ClassName(interface, ClassNames::INTERFACE),
-                    "::android::IInterface"}};
+      new ClassDecl{i_name, "::android::IInterface"}};
+
+  // What DECLARE_META_INTERFACE would give us, except that |descriptor| is a
+  // constant that only turns into a String16 when something asks for one.
+  unique_ptr<ClassDecl> descriptor_class{
+      new ClassDecl{"DescriptorLiteral", ""}};
+  descriptor_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      "", "operator const ::android::String16&", ArgList{},
+      MethodDecl::IS_CONST}});
+  if_class->AddPublic(std::move(descriptor_class));
+  if_class->AddPublic(unique_ptr<Declaration>{new LiteralDecl{
+      "static constexpr DescriptorLiteral descriptor{};\n"}});
+  if_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      "::android::sp<" + i_name + ">", "asInterface",
+      ArgList{"const ::android::sp<::android::IBinder>& obj"},
+      MethodDecl::IS_STATIC}});
+  if_class->AddPublic(unique_ptr<Declaration>{new MethodDecl{
+      "const ::android::String16&", "getInterfaceDescriptor", ArgList{},
+      MethodDecl::IS_VIRTUAL | MethodDecl::IS_CONST}});
+  if_class->AddPublic(unique_ptr<Declaration>{new ConstructorDecl{
+      i_name, ArgList{}, ConstructorDecl::IS_DEFAULT}});
   if_class->AddPublic(unique_ptr<Declaration>{new ConstructorDecl{
-      "DECLARE_META_INTERFACE",
-      ArgList{vector<string>{ClassName(interface, ClassNames::BASE)}}}});
+      "~" + i_name, ArgList{},
+      ConstructorDecl::IS_VIRTUAL | ConstructorDecl::IS_DEFAULT}});
 
   unique_ptr<Enum> constant_enum{new Enum{"", "int32_t"}};
   for (const auto& constant : interface.GetConstants()) {
+    if (constant->GetType() != AidlConstant::INT) { continue; }
     constant_enum->AddValue(
         constant->GetName(), std::to_string(constant->GetValue()));
   }
   if (constant_enum->HasValues()) {
     if_class->AddPublic(std::move(constant_enum));
   }
+  for (const auto& constant : interface.GetConstants()) {
+    if (constant->GetType() == AidlConstant::INT) { continue; }
+    if_class->AddPublic(unique_ptr<Declaration>{new LiteralDecl{StringPrintf(
+        "static constexpr %s = %s;\n",
+        ConstantDeclarator(*constant, constant->GetName()).c_str(),
+        ConstantInitializer(*constant).c_str())}});
+  }
+  for (const auto& e : interface.GetEnums()) {
+    BuildEnumDecls(*e, if_class.get());
+  }
 
   unique_ptr<Enum> call_enum{new Enum{"Call"}};
   for (const auto& method : interface.GetMethods()) {
@@ -694,6 +2359,14 @@ unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
         StringPrintf("::android::IBinder::FIRST_CALL_TRANSACTION + %d",
                      method->GetId()));
   }
+  if (interface.IsChainable()) {
+    call_enum->AddValue(kCallChainCode,
+                        "::android::IBinder::LAST_CALL_TRANSACTION");
+  }
+  if (interface.HasMirroredMethods()) {
+    call_enum->AddValue(kStateMirrorCode,
+                        "::android::IBinder::LAST_CALL_TRANSACTION - 1");
+  }
   if_class->AddPublic(std::move(call_enum));
 
   return unique_ptr<Document>{new CppHeader{
@@ -702,6 +2375,140 @@ unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
       NestInNamespaces(std::move(if_class), interface.GetSplitPackage())}};
 }
 
+unique_ptr<Document> BuildRouterHeader(const TypeNamespace& types,
+                                       const AidlInterface& interface) {
+  const string i_name = ClassName(interface, ClassNames::INTERFACE);
+  const string router_name = ClassName(interface, ClassNames::ROUTER);
+  const string shard_list = BuildShardListType(interface);
+
+  vector<unique_ptr<Declaration>> publics;
+  publics.emplace_back(new ConstructorDecl{
+      router_name,
+      ArgList{StringPrintf("const %s& shards", shard_list.c_str())},
+      ConstructorDecl::IS_EXPLICIT});
+  publics.emplace_back(new ConstructorDecl{
+      "~" + router_name,
+      ArgList{},
+      ConstructorDecl::IS_VIRTUAL | ConstructorDecl::IS_DEFAULT});
+  publics.emplace_back(new MethodDecl{
+      "size_t", "ShardCount", ArgList{}, MethodDecl::IS_CONST});
+  publics.emplace_back(new MethodDecl{
+      "uint64_t", "ShardCallCount", ArgList{"size_t shard"},
+      MethodDecl::IS_CONST});
+  publics.emplace_back(new MethodDecl{
+      "uint64_t", "ShardErrorCount", ArgList{"size_t shard"},
+      MethodDecl::IS_CONST});
+  for (const auto& method : interface.GetMethods()) {
+    publics.push_back(BuildMethodDecl(*method, types, false));
+  }
+
+  vector<unique_ptr<Declaration>> privates;
+  privates.emplace_back(new MethodDecl{
+      "::android::IBinder*", "onAsBinder", ArgList{},
+      MethodDecl::IS_OVERRIDE});
+  privates.emplace_back(new MethodDecl{
+      "size_t", "ShardIndex", ArgList{"uint64_t key_hash"},
+      MethodDecl::IS_CONST});
+  privates.emplace_back(new MethodDecl{
+      "void", "RecordCall",
+      ArgList{{"size_t shard",
+               StringPrintf("const %s& status", kBinderStatusLiteral)}}});
+  privates.emplace_back(new MethodDecl{
+      "uint64_t", "MixShardKey",
+      ArgList{{"uint64_t hash", "uint64_t value", "size_t bytes"}},
+      MethodDecl::IS_STATIC});
+  for (const string& key_type : GetShardKeyTypes(interface)) {
+    privates.emplace_back(new MethodDecl{
+        "uint64_t", "HashShardKey", ArgList{BuildShardKeyParameter(key_type)},
+        MethodDecl::IS_STATIC});
+  }
+  privates.emplace_back(new LiteralDecl{StringPrintf(
+      "const %s %s;\n", shard_list.c_str(), kShardsVarName)});
+  for (const char* counter : {kShardCallsVarName, kShardErrorsVarName}) {
+    privates.emplace_back(new LiteralDecl{StringPrintf(
+        "const ::std::unique_ptr<::std::atomic<uint64_t>[]> %s;\n", counter)});
+  }
+
+  unique_ptr<ClassDecl> router_class{
+      new ClassDecl{router_name, i_name, std::move(publics),
+                    std::move(privates)}};
+
+  return unique_ptr<Document>{new CppHeader{
+      BuildHeaderGuard(interface, ClassNames::ROUTER),
+      {"atomic",
+       "cstdint",
+       "memory",
+       "vector",
+       kIBinderHeader,
+       kStatusHeader,
+       kString16Header,
+       kStrongPointerHeader,
+       HeaderFile(interface, ClassNames::INTERFACE, false)},
+      NestInNamespaces(std::move(router_class), interface.GetSplitPackage())}};
+}
+
+unique_ptr<Document> BuildCallChainHeader(const TypeNamespace& types,
+                                          const AidlInterface& interface) {
+  const string i_name = ClassName(interface, ClassNames::INTERFACE);
+  const string chain_name = ClassName(interface, ClassNames::CHAIN);
+
+  vector<unique_ptr<Declaration>> publics;
+  publics.emplace_back(new LiteralDecl{
+      StringPrintf(kCallChainArgumentTypes, chain_name.c_str())});
+  publics.emplace_back(new ConstructorDecl{
+      chain_name, ArgList{}, ConstructorDecl::IS_DEFAULT});
+  for (const auto& method : interface.GetMethods()) {
+    if (method->CanBeChained()) {
+      publics.emplace_back(new MethodDecl{
+          ChainResultType(types, *method), method->GetName(),
+          BuildChainArgList(types, *method)});
+    }
+  }
+  publics.emplace_back(new LiteralDecl{
+      "// Makes the calls added so far with one transaction to |service|,\n"
+      "// stopping at the first one that fails and returning its status.\n"});
+  publics.emplace_back(new MethodDecl{
+      kBinderStatusLiteral, "Transact",
+      ArgList{StringPrintf("const ::android::sp<%s>& service",
+                           i_name.c_str())}});
+
+  vector<unique_ptr<Declaration>> privates;
+  privates.emplace_back(new LiteralDecl{
+      "struct Step {\nuint32_t code;\nvoid* result;\n};\n"});
+  privates.emplace_back(new MethodDecl{
+      kAndroidStatusLiteral, "BeginStep",
+      ArgList{{"uint32_t code", "int32_t argument_count", "void* result"}}});
+  privates.emplace_back(new MethodDecl{
+      kAndroidStatusLiteral, "BeginArgument", ArgList{"int32_t step"}});
+  privates.emplace_back(new MethodDecl{
+      kAndroidStatusLiteral, "EndArgument", ArgList{}});
+  if (HasChainResults(types, interface)) {
+    privates.emplace_back(new MethodDecl{
+        kAndroidStatusLiteral, "ReadResult",
+        ArgList{{"uint32_t code", "const ::android::Parcel& reply",
+                 "void* result"}},
+        MethodDecl::IS_STATIC});
+  }
+  privates.emplace_back(new LiteralDecl{StringPrintf(
+      "%s %s;\n::std::vector<Step> %s;\nsize_t %s = 0;\n%s %s = %s;\n",
+      kAndroidParcelLiteral, kChainRequestVarName, kChainStepsVarName,
+      kChainSizePositionVarName, kAndroidStatusLiteral,
+      kChainBuildStatusVarName, kAndroidStatusOk)});
+
+  unique_ptr<ClassDecl> chain_class{
+      new ClassDecl{chain_name, "", std::move(publics), std::move(privates)}};
+
+  return unique_ptr<Document>{new CppHeader{
+      BuildHeaderGuard(interface, ClassNames::CHAIN),
+      {"cstdint",
+       "vector",
+       kParcelHeader,
+       kStatusHeader,
+       kStrongPointerHeader,
+       HeaderFile(interface, ClassNames::INTERFACE, false)},
+      NestInNamespaces(std::move(chain_class), interface.GetSplitPackage())}};
+}
+
 bool WriteHeader(const CppOptions& options,
                  const TypeNamespace& types,
                  const AidlInterface& interface,
@@ -716,7 +2523,14 @@ bool WriteHeader(const CppOptions& options,
       header = BuildClientHeader(types, interface);
       break;
     case ClassNames::SERVER:
-      header = BuildServerHeader(types, interface);
+      header = BuildServerHeader(types, interface, options.ServerMetrics(),
+                                 options.ServerWatchdog());
+      break;
+    case ClassNames::ROUTER:
+      header = BuildRouterHeader(types, interface);
+      break;
+    case ClassNames::CHAIN:
+      header = BuildCallChainHeader(types, interface);
       break;
     default:
       LOG(FATAL) << "aidl internal error";
@@ -766,8 +2580,26 @@ bool GenerateCpp(const CppOptions& options,
                  const AidlInterface& interface,
                  const IoDelegate& io_delegate) {
   auto interface_src = BuildInterfaceSource(types, interface);
-  auto client_src = BuildClientSource(types, interface);
-  auto server_src = BuildServerSource(types, interface);
+  auto client_src =
+      BuildClientSource(types, interface, options.TraceContext());
+  auto server_src = BuildServerSource(types, interface,
+                                      options.ServerMetrics(),
+                                      options.TraceContext(),
+                                      options.ServerWatchdog());
+  unique_ptr<Document> router_src;
+  if (interface.IsSharded()) {
+    router_src = BuildRouterSource(types, interface);
+    if (!router_src) {
+      return false;
+    }
+  }
+  unique_ptr<Document> chain_src;
+  if (interface.IsChainable()) {
+    chain_src = BuildCallChainSource(types, interface);
+    if (!chain_src) {
+      return false;
+    }
+  }
 
   if (!interface_src || !client_src || !server_src) {
     return false;
@@ -784,7 +2616,11 @@ bool GenerateCpp(const CppOptions& options,
       !WriteHeader(options, types, interface, io_delegate,
                    ClassNames::CLIENT) ||
       !WriteHeader(options, types, interface, io_delegate,
-                   ClassNames::SERVER)) {
+                   ClassNames::SERVER) ||
+      (router_src && !WriteHeader(options, types, interface, io_delegate,
+                                  ClassNames::ROUTER)) ||
+      (chain_src && !WriteHeader(options, types, interface, io_delegate,
+                                 ClassNames::CHAIN))) {
     return false;
   }
 
@@ -793,6 +2629,12 @@ bool GenerateCpp(const CppOptions& options,
   interface_src->Write(writer.get());
   client_src->Write(writer.get());
   server_src->Write(writer.get());
+  if (router_src) {
+    router_src->Write(writer.get());
+  }
+  if (chain_src) {
+    chain_src->Write(writer.get());
+  }
 
   const bool success = writer->Close();
   if (!success) {
@@ -40,6 +40,8 @@ enum class ClassNames {
   CLIENT,     // BpFoo
   SERVER,     // BnFoo
   INTERFACE,  // IFoo
+  ROUTER,     // ShardedFoo (only for interfaces with @shardKey arguments)
+  CHAIN,      // FooCallChain (only for @chainable interfaces)
 };
 
 // Generate the relative path to a header file.  If |use_os_sep| we'll use the
@@ -49,18 +51,39 @@ std::string HeaderFile(const AidlInterface& interface, ClassNames class_type,
                        bool use_os_sep = true);
 
 namespace internals {
+// With |trace_context|, BpFoo sends the calling thread's
+// ::android::aidl::transport::TraceContext with each call, and BnFoo runs
+// each call in a child of the one it receives.
 std::unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
-                                            const AidlInterface& parsed_doc);
+                                            const AidlInterface& parsed_doc,
+                                            bool trace_context = false);
+// With |server_metrics|, BnFoo times each transaction into a
+// ::android::aidl::transport::TransactionMetrics.
+// With |server_watchdog|, BnFoo publishes each call in flight for a
+// ::android::aidl::transport::CallWatchdog to look at.
 std::unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
-                                            const AidlInterface& parsed_doc);
+                                            const AidlInterface& parsed_doc,
+                                            bool server_metrics = false,
+                                            bool trace_context = false,
+                                            bool server_watchdog = false);
 std::unique_ptr<Document> BuildInterfaceSource(const TypeNamespace& types,
                                                const AidlInterface& parsed_doc);
 std::unique_ptr<Document> BuildClientHeader(const TypeNamespace& types,
                                             const AidlInterface& parsed_doc);
 std::unique_ptr<Document> BuildServerHeader(const TypeNamespace& types,
-                                            const AidlInterface& parsed_doc);
+                                            const AidlInterface& parsed_doc,
+                                            bool server_metrics = false,
+                                            bool server_watchdog = false);
 std::unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
                                                const AidlInterface& parsed_doc);
+std::unique_ptr<Document> BuildRouterSource(const TypeNamespace& types,
+                                            const AidlInterface& parsed_doc);
+std::unique_ptr<Document> BuildRouterHeader(const TypeNamespace& types,
+                                            const AidlInterface& parsed_doc);
+std::unique_ptr<Document> BuildCallChainSource(const TypeNamespace& types,
+                                               const AidlInterface& parsed_doc);
+std::unique_ptr<Document> BuildCallChainHeader(const TypeNamespace& types,
+                                               const AidlInterface& parsed_doc);
 }
 }  // namespace cpp
 }  // namespace aidl
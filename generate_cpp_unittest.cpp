@@ -606,7 +606,15 @@ namespace os {
 
 class IComplexTypeInterface : public ::android::IInterface {
 public:
-DECLARE_META_INTERFACE(ComplexTypeInterface);
+class DescriptorLiteral {
+public:
+operator const ::android::String16&() const;
+};  // class DescriptorLiteral
+static constexpr DescriptorLiteral descriptor{};
+static ::android::sp<IComplexTypeInterface> asInterface(const ::android::sp<::android::IBinder>& obj);
+virtual const ::android::String16& getInterfaceDescriptor() const;
+IComplexTypeInterface() = default;
+virtual ~IComplexTypeInterface() = default;
 enum  : int32_t {
   MY_CONSTANT = 3,
 };
@@ -632,24 +640,2343 @@ enum Call {
 
 }  // namespace android
 
-#endif  // AIDL_GENERATED_ANDROID_OS_I_COMPLEX_TYPE_INTERFACE_H_)";
+#endif  // AIDL_GENERATED_ANDROID_OS_I_COMPLEX_TYPE_INTERFACE_H_)";
+
+const char kExpectedComplexTypeInterfaceSourceOutput[] =
+R"(#include <android/os/IComplexTypeInterface.h>
+#include <android/os/BpComplexTypeInterface.h>
+
+namespace android {
+
+namespace os {
+
+constexpr IComplexTypeInterface::DescriptorLiteral IComplexTypeInterface::descriptor;
+
+IComplexTypeInterface::DescriptorLiteral::operator const ::android::String16&() const {
+static const ::android::String16* const _aidl_descriptor = new ::android::String16(u"android.os.IComplexTypeInterface");
+return *_aidl_descriptor;
+}
+
+const ::android::String16& IComplexTypeInterface::getInterfaceDescriptor() const {
+return descriptor;
+}
+
+::android::sp<IComplexTypeInterface> IComplexTypeInterface::asInterface(const ::android::sp<::android::IBinder>& obj) {
+::android::sp<IComplexTypeInterface> _aidl_intr;
+if (obj != nullptr) {
+_aidl_intr = static_cast<IComplexTypeInterface*>(obj->queryLocalInterface(descriptor).get());
+if (_aidl_intr == nullptr) {
+_aidl_intr = new BpComplexTypeInterface(obj);
+}
+}
+return _aidl_intr;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kShardedInterfaceAIDL =
+R"(package android.os;
+interface IKeyValueStore {
+  String Get(in @shardKey String key);
+  void Put(@shardKey long id, int value);
+  int Count();
+})";
+
+const char kExpectedRouterHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_SHARDED_KEY_VALUE_STORE_H_
+#define AIDL_GENERATED_ANDROID_OS_SHARDED_KEY_VALUE_STORE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <binder/IBinder.h>
+#include <binder/Status.h>
+#include <utils/String16.h>
+#include <utils/StrongPointer.h>
+#include <android/os/IKeyValueStore.h>
+
+namespace android {
+
+namespace os {
+
+class ShardedKeyValueStore : public IKeyValueStore {
+public:
+explicit ShardedKeyValueStore(const ::std::vector<::android::sp<IKeyValueStore>>& shards);
+virtual ~ShardedKeyValueStore() = default;
+size_t ShardCount() const;
+uint64_t ShardCallCount(size_t shard) const;
+uint64_t ShardErrorCount(size_t shard) const;
+::android::binder::Status Get(const ::android::String16& key, ::android::String16* _aidl_return) override;
+::android::binder::Status Put(int64_t id, int32_t value) override;
+::android::binder::Status Count(int32_t* _aidl_return) override;
+private:
+::android::IBinder* onAsBinder() override;
+size_t ShardIndex(uint64_t key_hash) const;
+void RecordCall(size_t shard, const ::android::binder::Status& status);
+static uint64_t MixShardKey(uint64_t hash, uint64_t value, size_t bytes);
+static uint64_t HashShardKey(const ::android::String16& key);
+static uint64_t HashShardKey(int64_t key);
+const ::std::vector<::android::sp<IKeyValueStore>> _aidl_shards;
+const ::std::unique_ptr<::std::atomic<uint64_t>[]> _aidl_calls;
+const ::std::unique_ptr<::std::atomic<uint64_t>[]> _aidl_errors;
+};  // class ShardedKeyValueStore
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_SHARDED_KEY_VALUE_STORE_H_)";
+
+const char kExpectedRouterSourceOutput[] =
+R"(#include <android/os/ShardedKeyValueStore.h>
+
+namespace android {
+
+namespace os {
+
+ShardedKeyValueStore::ShardedKeyValueStore(const ::std::vector<::android::sp<IKeyValueStore>>& shards)
+    : _aidl_shards(shards),
+      _aidl_calls(new ::std::atomic<uint64_t>[shards.size()]()),
+      _aidl_errors(new ::std::atomic<uint64_t>[shards.size()]()){
+}
+
+size_t ShardedKeyValueStore::ShardCount() const {
+return _aidl_shards.size();
+}
+
+uint64_t ShardedKeyValueStore::ShardCallCount(size_t shard) const {
+if (shard >= _aidl_shards.size()) {
+return 0;
+}
+return _aidl_calls[shard].load(::std::memory_order_relaxed);
+}
+
+uint64_t ShardedKeyValueStore::ShardErrorCount(size_t shard) const {
+if (shard >= _aidl_shards.size()) {
+return 0;
+}
+return _aidl_errors[shard].load(::std::memory_order_relaxed);
+}
+
+::android::IBinder* ShardedKeyValueStore::onAsBinder() {
+return nullptr;
+}
+
+size_t ShardedKeyValueStore::ShardIndex(uint64_t key_hash) const {
+return (key_hash & 0x7fffffffffffffffULL) % _aidl_shards.size();
+}
+
+void ShardedKeyValueStore::RecordCall(size_t shard, const ::android::binder::Status& status) {
+_aidl_calls[shard].fetch_add(1, ::std::memory_order_relaxed);
+if (!status.isOk()) {
+_aidl_errors[shard].fetch_add(1, ::std::memory_order_relaxed);
+}
+}
+
+uint64_t ShardedKeyValueStore::MixShardKey(uint64_t hash, uint64_t value, size_t bytes) {
+for (size_t i = 0; i < bytes; ++i) {
+hash ^= (value >> (8 * i)) & 0xff;
+hash *= 0x100000001b3ULL;
+}
+return hash;
+}
+
+uint64_t ShardedKeyValueStore::HashShardKey(const ::android::String16& key) {
+uint64_t hash = 0xcbf29ce484222325ULL;
+for (size_t i = 0; i < key.size(); ++i) {
+hash = MixShardKey(hash, key.string()[i], 2);
+}
+return hash;
+}
+
+uint64_t ShardedKeyValueStore::HashShardKey(int64_t key) {
+return MixShardKey(0xcbf29ce484222325ULL, static_cast<uint64_t>(key), 8);
+}
+
+::android::binder::Status ShardedKeyValueStore::Get(const ::android::String16& key, ::android::String16* _aidl_return) {
+if (_aidl_shards.empty()) {
+return ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_ILLEGAL_STATE);
+}
+size_t _aidl_shard = ShardIndex(HashShardKey(key));
+::android::binder::Status _aidl_status = _aidl_shards[_aidl_shard]->Get(key, _aidl_return);
+RecordCall(_aidl_shard, _aidl_status);
+return _aidl_status;
+}
+
+::android::binder::Status ShardedKeyValueStore::Put(int64_t id, int32_t value) {
+if (_aidl_shards.empty()) {
+return ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_ILLEGAL_STATE);
+}
+size_t _aidl_shard = ShardIndex(HashShardKey(id));
+::android::binder::Status _aidl_status = _aidl_shards[_aidl_shard]->Put(id, value);
+RecordCall(_aidl_shard, _aidl_status);
+return _aidl_status;
+}
+
+::android::binder::Status ShardedKeyValueStore::Count(int32_t* _aidl_return) {
+if (_aidl_shards.empty()) {
+return ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_ILLEGAL_STATE);
+}
+::android::binder::Status _aidl_status;
+int32_t _aidl_ignored_return;
+for (size_t _aidl_shard = 0; _aidl_shard < _aidl_shards.size(); ++_aidl_shard) {
+_aidl_status = _aidl_shards[_aidl_shard]->Count((_aidl_shard == 0) ? _aidl_return : &_aidl_ignored_return);
+RecordCall(_aidl_shard, _aidl_status);
+if (!_aidl_status.isOk()) {
+break;
+}
+}
+return _aidl_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kDeltaInterfaceAIDL =
+R"(package android.os;
+interface IDeltaBuffer {
+  void Scale(inout @delta float[] values, float factor);
+})";
+
+const char kExpectedDeltaClientSourceOutput[] =
+R"(#include <android/os/BpDeltaBuffer.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+namespace {
+
+// Applies the ranges written by _aidl_WriteDeltaArray() to |array|, which
+// still holds the elements we sent.
+template <typename T>
+::android::status_t _aidl_ReadDeltaArray(const ::android::Parcel& parcel, ::std::vector<T>* array, ::android::status_t (::android::Parcel::*read)(T*) const) {
+const size_t wire_size = (sizeof(T) < 4) ? 4 : sizeof(T);
+int32_t size;
+::android::status_t status = parcel.readInt32(&size);
+if (status != ::android::OK) {
+return status;
+}
+// Elements past the end of what we sent are always in the reply, so a bad
+// size can't make us allocate more than the reply could fill.
+if (size < 0 || (static_cast<size_t>(size) > array->size() && static_cast<size_t>(size) - array->size() > parcel.dataAvail() / wire_size)) {
+return ::android::BAD_VALUE;
+}
+array->resize(size);
+while (true) {
+int32_t start;
+status = parcel.readInt32(&start);
+if (status != ::android::OK || start == -1) {
+return status;
+}
+int32_t count;
+status = parcel.readInt32(&count);
+if (status != ::android::OK) {
+return status;
+}
+if (start < 0 || start > size || count < 0 || count > size - start) {
+return ::android::BAD_VALUE;
+}
+for (int32_t i = start; i < start + count; ++i) {
+T value;
+status = (parcel.*read)(&value);
+if (status != ::android::OK) {
+return status;
+}
+(*array)[i] = value;
+}
+}
+}
+
+}  // namespace
+
+BpDeltaBuffer::BpDeltaBuffer(const ::android::sp<::android::IBinder>& _aidl_impl)
+    : BpInterface<IDeltaBuffer>(_aidl_impl){
+}
+
+::android::binder::Status BpDeltaBuffer::Scale(::std::vector<float>* values, float factor) {
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = ::android::OK;
+::android::binder::Status _aidl_status;
+_aidl_ret_status = _aidl_data.writeInterfaceToken(getInterfaceDescriptor());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeFloatVector(*values);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeFloat(factor);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = remote()->transact(IDeltaBuffer::SCALE, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = _aidl_ReadDeltaArray(_aidl_reply, values, &::android::Parcel::readFloat);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedDeltaServerSourceOutput[] =
+R"(#include <android/os/BnDeltaBuffer.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+namespace {
+
+// Writes |current| as the ranges in which it differs from |base|, or as one
+// range covering everything when that is no larger.
+template <typename T>
+::android::status_t _aidl_WriteDeltaArray(::android::Parcel* parcel, const ::std::vector<T>& base, const ::std::vector<T>& current, ::android::status_t (::android::Parcel::*write)(T)) {
+const size_t size = current.size();
+if (size > static_cast<size_t>(INT32_MAX)) {
+return ::android::BAD_VALUE;
+}
+auto changed = [&base, &current](size_t i) {
+return i >= base.size() || base[i] != current[i];
+};
+// Parcels pad everything to four bytes.
+const size_t wire_size = (sizeof(T) < 4) ? 4 : sizeof(T);
+size_t delta_size = 0;
+for (size_t i = 0; i < size; ++i) {
+if (changed(i)) {
+delta_size += wire_size;
+if (i == 0 || !changed(i - 1)) {
+delta_size += 2 * sizeof(int32_t);
+}
+}
+}
+const bool whole = delta_size >= 2 * sizeof(int32_t) + size * wire_size;
+::android::status_t status = parcel->writeInt32(static_cast<int32_t>(size));
+for (size_t i = 0; status == ::android::OK && i < size;) {
+if (!whole && !changed(i)) {
+++i;
+continue;
+}
+size_t end = i + 1;
+while (end < size && (whole || changed(end))) {
+++end;
+}
+status = parcel->writeInt32(static_cast<int32_t>(i));
+if (status == ::android::OK) {
+status = parcel->writeInt32(static_cast<int32_t>(end - i));
+}
+for (; status == ::android::OK && i < end; ++i) {
+status = (parcel->*write)(current[i]);
+}
+}
+if (status == ::android::OK) {
+status = parcel->writeInt32(-1);
+}
+return status;
+}
+
+}  // namespace
+
+::android::status_t BnDeltaBuffer::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::SCALE:
+{
+::std::vector<float> in_values;
+float in_factor;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readFloatVector(&in_values);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+_aidl_ret_status = _aidl_data.readFloat(&in_factor);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::std::vector<float> _aidl_values_base(in_values);
+::android::binder::Status _aidl_status(Scale(&in_values, in_factor));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_WriteDeltaArray(_aidl_reply, _aidl_values_base, in_values, &::android::Parcel::writeFloat);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kFixedSizeInterfaceAIDL =
+R"(package android.os;
+interface IMotion {
+  int Move(int x, long y, float dz);
+  void Rename(String name, int id);
+})";
+
+const char kExpectedFixedSizeServerSourceOutput[] =
+R"(#include <android/os/BnMotion.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+::android::status_t BnMotion::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::MOVE:
+{
+int32_t in_x;
+int64_t in_y;
+float in_dz;
+int32_t _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+if (((_aidl_data.dataAvail()) < (16))) {
+_aidl_ret_status = ::android::NOT_ENOUGH_DATA;
+break;
+}
+in_x = _aidl_data.readInt32();
+in_y = _aidl_data.readInt64();
+in_dz = _aidl_data.readFloat();
+::android::binder::Status _aidl_status(Move(in_x, in_y, in_dz, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+case Call::RENAME:
+{
+::android::String16 in_name;
+int32_t in_id;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readString16(&in_name);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+_aidl_ret_status = _aidl_data.readInt32(&in_id);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Rename(in_name, in_id));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kTypedConstantInterfaceAIDL =
+R"(package android.os;
+interface IConfig {
+  const int VERSION = 3;
+  const long MAX_BYTES = 10000000000L;
+  const long MIN_OFFSET = -9223372036854775808L;
+  const float SCALE = 1.5f;
+  const double RATIO = -2;
+  const boolean ENABLED = true;
+  const String NAME = "config v1";
+  void Reload();
+})";
+
+const char kExpectedTypedConstantInterfaceHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_I_CONFIG_H_
+#define AIDL_GENERATED_ANDROID_OS_I_CONFIG_H_
+
+#include <binder/IBinder.h>
+#include <binder/IInterface.h>
+#include <binder/Status.h>
+#include <utils/String16.h>
+#include <utils/StrongPointer.h>
+
+namespace android {
+
+namespace os {
+
+class IConfig : public ::android::IInterface {
+public:
+class DescriptorLiteral {
+public:
+operator const ::android::String16&() const;
+};  // class DescriptorLiteral
+static constexpr DescriptorLiteral descriptor{};
+static ::android::sp<IConfig> asInterface(const ::android::sp<::android::IBinder>& obj);
+virtual const ::android::String16& getInterfaceDescriptor() const;
+IConfig() = default;
+virtual ~IConfig() = default;
+enum  : int32_t {
+  VERSION = 3,
+};
+static constexpr int64_t MAX_BYTES = 10000000000LL;
+static constexpr int64_t MIN_OFFSET = (-9223372036854775807LL - 1);
+static constexpr float SCALE = 1.5f;
+static constexpr double RATIO = -2.0;
+static constexpr bool ENABLED = true;
+static constexpr char NAME[] = "config v1";
+virtual ::android::binder::Status Reload() = 0;
+enum Call {
+  RELOAD = ::android::IBinder::FIRST_CALL_TRANSACTION + 0,
+};
+};  // class IConfig
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_I_CONFIG_H_)";
+
+const char kExpectedTypedConstantInterfaceSourceOutput[] =
+R"(#include <android/os/IConfig.h>
+#include <android/os/BpConfig.h>
+
+namespace android {
+
+namespace os {
+
+constexpr IConfig::DescriptorLiteral IConfig::descriptor;
+constexpr int64_t IConfig::MAX_BYTES;
+constexpr int64_t IConfig::MIN_OFFSET;
+constexpr float IConfig::SCALE;
+constexpr double IConfig::RATIO;
+constexpr bool IConfig::ENABLED;
+constexpr char IConfig::NAME[];
+
+IConfig::DescriptorLiteral::operator const ::android::String16&() const {
+static const ::android::String16* const _aidl_descriptor = new ::android::String16(u"android.os.IConfig");
+return *_aidl_descriptor;
+}
+
+const ::android::String16& IConfig::getInterfaceDescriptor() const {
+return descriptor;
+}
+
+::android::sp<IConfig> IConfig::asInterface(const ::android::sp<::android::IBinder>& obj) {
+::android::sp<IConfig> _aidl_intr;
+if (obj != nullptr) {
+_aidl_intr = static_cast<IConfig*>(obj->queryLocalInterface(descriptor).get());
+if (_aidl_intr == nullptr) {
+_aidl_intr = new BpConfig(obj);
+}
+}
+return _aidl_intr;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kEnumInterfaceAIDL =
+R"(package android.os;
+interface IPalette {
+  enum Color : byte { RED, GREEN, BLUE }
+  enum Code : int { FAILED = -1, RETRY = 7 }
+  Color Blend(Color a, in Color[] b, Code c);
+})";
+
+const char kExpectedEnumInterfaceHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_I_PALETTE_H_
+#define AIDL_GENERATED_ANDROID_OS_I_PALETTE_H_
+
+#include <binder/IBinder.h>
+#include <binder/IInterface.h>
+#include <binder/Parcel.h>
+#include <binder/Status.h>
+#include <cstdint>
+#include <utils/String16.h>
+#include <utils/StrongPointer.h>
+#include <vector>
+
+namespace android {
+
+namespace os {
+
+class IPalette : public ::android::IInterface {
+public:
+class DescriptorLiteral {
+public:
+operator const ::android::String16&() const;
+};  // class DescriptorLiteral
+static constexpr DescriptorLiteral descriptor{};
+static ::android::sp<IPalette> asInterface(const ::android::sp<::android::IBinder>& obj);
+virtual const ::android::String16& getInterfaceDescriptor() const;
+IPalette() = default;
+virtual ~IPalette() = default;
+enum class Color : int8_t {
+  RED = 0,
+  GREEN = 1,
+  BLUE = 2,
+};
+static bool IsValidColor(Color value);
+static ::android::status_t _aidl_ReadColor(const ::android::Parcel& parcel, Color* value);
+static ::android::status_t _aidl_WriteColor(::android::Parcel* parcel, Color value);
+static ::android::status_t _aidl_ReadColorVector(const ::android::Parcel& parcel, ::std::vector<Color>* value);
+static ::android::status_t _aidl_WriteColorVector(::android::Parcel* parcel, const ::std::vector<Color>& value);
+enum class Code : int32_t {
+  FAILED = -1,
+  RETRY = 7,
+};
+static bool IsValidCode(Code value);
+static ::android::status_t _aidl_ReadCode(const ::android::Parcel& parcel, Code* value);
+static ::android::status_t _aidl_WriteCode(::android::Parcel* parcel, Code value);
+static ::android::status_t _aidl_ReadCodeVector(const ::android::Parcel& parcel, ::std::vector<Code>* value);
+static ::android::status_t _aidl_WriteCodeVector(::android::Parcel* parcel, const ::std::vector<Code>& value);
+virtual ::android::binder::Status Blend(::android::os::IPalette::Color a, const ::std::vector<::android::os::IPalette::Color>& b, ::android::os::IPalette::Code c, ::android::os::IPalette::Color* _aidl_return) = 0;
+enum Call {
+  BLEND = ::android::IBinder::FIRST_CALL_TRANSACTION + 0,
+};
+};  // class IPalette
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_I_PALETTE_H_)";
+
+const char kExpectedEnumInterfaceSourceOutput[] =
+R"(#include <android/os/IPalette.h>
+#include <android/os/BpPalette.h>
+
+namespace android {
+
+namespace os {
+
+constexpr IPalette::DescriptorLiteral IPalette::descriptor;
+
+IPalette::DescriptorLiteral::operator const ::android::String16&() const {
+static const ::android::String16* const _aidl_descriptor = new ::android::String16(u"android.os.IPalette");
+return *_aidl_descriptor;
+}
+
+const ::android::String16& IPalette::getInterfaceDescriptor() const {
+return descriptor;
+}
+
+::android::sp<IPalette> IPalette::asInterface(const ::android::sp<::android::IBinder>& obj) {
+::android::sp<IPalette> _aidl_intr;
+if (obj != nullptr) {
+_aidl_intr = static_cast<IPalette*>(obj->queryLocalInterface(descriptor).get());
+if (_aidl_intr == nullptr) {
+_aidl_intr = new BpPalette(obj);
+}
+}
+return _aidl_intr;
+}
+
+bool IPalette::IsValidColor(Color value) {
+return static_cast<uint64_t>(value) <= static_cast<uint64_t>(Color::BLUE);
+}
+
+::android::status_t IPalette::_aidl_ReadColor(const ::android::Parcel& parcel, Color* value) {
+int8_t raw;
+::android::status_t _aidl_ret_status = parcel.readByte(&raw);
+if (((_aidl_ret_status) != (::android::OK))) {
+return _aidl_ret_status;
+}
+if (!IsValidColor(static_cast<Color>(raw))) {
+return ::android::BAD_VALUE;
+}
+*value = static_cast<Color>(raw);
+return ::android::OK;
+}
+
+::android::status_t IPalette::_aidl_WriteColor(::android::Parcel* parcel, Color value) {
+return parcel->writeByte(static_cast<int8_t>(value));
+}
+
+::android::status_t IPalette::_aidl_ReadColorVector(const ::android::Parcel& parcel, ::std::vector<Color>* value) {
+::std::vector<uint8_t> raw;
+::android::status_t _aidl_ret_status = parcel.readByteVector(&raw);
+if (((_aidl_ret_status) != (::android::OK))) {
+return _aidl_ret_status;
+}
+value->resize(raw.size());
+for (size_t i = 0; i < raw.size(); ++i) {
+(*value)[i] = static_cast<Color>(static_cast<int8_t>(raw[i]));
+if (!IsValidColor((*value)[i])) {
+return ::android::BAD_VALUE;
+}
+}
+return ::android::OK;
+}
+
+::android::status_t IPalette::_aidl_WriteColorVector(::android::Parcel* parcel, const ::std::vector<Color>& value) {
+::std::vector<uint8_t> raw(value.size());
+for (size_t i = 0; i < value.size(); ++i) {
+raw[i] = static_cast<uint8_t>(value[i]);
+}
+return parcel->writeByteVector(raw);
+}
+
+bool IPalette::IsValidCode(Code value) {
+return value == Code::FAILED || value == Code::RETRY;
+}
+
+::android::status_t IPalette::_aidl_ReadCode(const ::android::Parcel& parcel, Code* value) {
+int32_t raw;
+::android::status_t _aidl_ret_status = parcel.readInt32(&raw);
+if (((_aidl_ret_status) != (::android::OK))) {
+return _aidl_ret_status;
+}
+if (!IsValidCode(static_cast<Code>(raw))) {
+return ::android::BAD_VALUE;
+}
+*value = static_cast<Code>(raw);
+return ::android::OK;
+}
+
+::android::status_t IPalette::_aidl_WriteCode(::android::Parcel* parcel, Code value) {
+return parcel->writeInt32(static_cast<int32_t>(value));
+}
+
+::android::status_t IPalette::_aidl_ReadCodeVector(const ::android::Parcel& parcel, ::std::vector<Code>* value) {
+::std::vector<int32_t> raw;
+::android::status_t _aidl_ret_status = parcel.readInt32Vector(&raw);
+if (((_aidl_ret_status) != (::android::OK))) {
+return _aidl_ret_status;
+}
+value->resize(raw.size());
+for (size_t i = 0; i < raw.size(); ++i) {
+(*value)[i] = static_cast<Code>(raw[i]);
+if (!IsValidCode((*value)[i])) {
+return ::android::BAD_VALUE;
+}
+}
+return ::android::OK;
+}
+
+::android::status_t IPalette::_aidl_WriteCodeVector(::android::Parcel* parcel, const ::std::vector<Code>& value) {
+::std::vector<int32_t> raw(value.size());
+for (size_t i = 0; i < value.size(); ++i) {
+raw[i] = static_cast<int32_t>(value[i]);
+}
+return parcel->writeInt32Vector(raw);
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedEnumClientSourceOutput[] =
+R"(#include <android/os/BpPalette.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+BpPalette::BpPalette(const ::android::sp<::android::IBinder>& _aidl_impl)
+    : BpInterface<IPalette>(_aidl_impl){
+}
+
+::android::binder::Status BpPalette::Blend(::android::os::IPalette::Color a, const ::std::vector<::android::os::IPalette::Color>& b, ::android::os::IPalette::Code c, ::android::os::IPalette::Color* _aidl_return) {
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = ::android::OK;
+::android::binder::Status _aidl_status;
+_aidl_ret_status = _aidl_data.writeInterfaceToken(getInterfaceDescriptor());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_WriteColor(&_aidl_data, a);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_WriteColorVector(&_aidl_data, b);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_WriteCode(&_aidl_data, c);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = remote()->transact(IPalette::BLEND, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_ReadColor(_aidl_reply, _aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedEnumServerSourceOutput[] =
+R"(#include <android/os/BnPalette.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+::android::status_t BnPalette::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::BLEND:
+{
+::android::os::IPalette::Color in_a;
+::std::vector<::android::os::IPalette::Color> in_b;
+::android::os::IPalette::Code in_c;
+::android::os::IPalette::Color _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_ReadColor(_aidl_data, &in_a);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_ReadColorVector(_aidl_data, &in_b);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_ReadCode(_aidl_data, &in_c);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Blend(in_a, in_b, in_c, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = ::android::os::IPalette::_aidl_WriteColor(_aidl_reply, _aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedMetricsServerHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_BN_MOTION_H_
+#define AIDL_GENERATED_ANDROID_OS_BN_MOTION_H_
+
+#include <binder/IInterface.h>
+#include <android/os/IMotion.h>
+#include <transport/transaction_metrics.h>
+
+namespace android {
+
+namespace os {
+
+class BnMotion : public ::android::BnInterface<IMotion> {
+public:
+::android::status_t onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags = 0) override;
+const ::android::aidl::transport::TransactionMetrics& GetTransactionMetrics() const { return _aidl_metrics; }
+private:
+::android::aidl::transport::TransactionMetrics _aidl_metrics{2};
+};  // class BnMotion
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_BN_MOTION_H_)";
+
+const char kExpectedMetricsServerSourceOutput[] =
+R"(#include <android/os/BnMotion.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+::android::status_t BnMotion::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::MOVE:
+{
+::android::aidl::transport::TransactionTimer _aidl_timer(&_aidl_metrics, 0);
+int32_t in_x;
+int64_t in_y;
+float in_dz;
+int32_t _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+if (((_aidl_data.dataAvail()) < (16))) {
+_aidl_ret_status = ::android::NOT_ENOUGH_DATA;
+break;
+}
+in_x = _aidl_data.readInt32();
+in_y = _aidl_data.readInt64();
+in_dz = _aidl_data.readFloat();
+::android::binder::Status _aidl_status(Move(in_x, in_y, in_dz, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+case Call::RENAME:
+{
+::android::aidl::transport::TransactionTimer _aidl_timer(&_aidl_metrics, 1);
+::android::String16 in_name;
+int32_t in_id;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readString16(&in_name);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+_aidl_ret_status = _aidl_data.readInt32(&in_id);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Rename(in_name, in_id));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedWatchdogServerHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_BN_MOTION_H_
+#define AIDL_GENERATED_ANDROID_OS_BN_MOTION_H_
+
+#include <binder/IInterface.h>
+#include <android/os/IMotion.h>
+#include <transport/call_watchdog.h>
+
+namespace android {
+
+namespace os {
+
+class BnMotion : public ::android::BnInterface<IMotion> {
+public:
+::android::status_t onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags = 0) override;
+static ::android::aidl::transport::CallWatchTable& GetCallWatchTable() { return _aidl_watch; }
+private:
+static ::android::aidl::transport::CallWatchTable _aidl_watch;
+};  // class BnMotion
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_BN_MOTION_H_)";
+
+const char kExpectedWatchdogServerSourceOutput[] =
+R"(#include <android/os/BnMotion.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+::android::aidl::transport::CallWatchTable BnMotion::_aidl_watch{"android.os.IMotion", {"Move", "Rename"}};
+
+::android::status_t BnMotion::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::MOVE:
+{
+::android::aidl::transport::CallWatchScope _aidl_watch_scope(&_aidl_watch, 0);
+int32_t in_x;
+int64_t in_y;
+float in_dz;
+int32_t _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+if (((_aidl_data.dataAvail()) < (16))) {
+_aidl_ret_status = ::android::NOT_ENOUGH_DATA;
+break;
+}
+in_x = _aidl_data.readInt32();
+in_y = _aidl_data.readInt64();
+in_dz = _aidl_data.readFloat();
+::android::binder::Status _aidl_status(Move(in_x, in_y, in_dz, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+case Call::RENAME:
+{
+::android::aidl::transport::CallWatchScope _aidl_watch_scope(&_aidl_watch, 1);
+::android::String16 in_name;
+int32_t in_id;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readString16(&in_name);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+_aidl_ret_status = _aidl_data.readInt32(&in_id);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Rename(in_name, in_id));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+}  // namespace
+
+const string kChainableInterfaceAIDL =
+R"(package android.os;
+@chainable
+interface IDirectory {
+  int Lookup(String name);
+  String Describe(int id);
+  void Touch(int id);
+  void List(out int[] ids);
+})";
+
+const char kExpectedChainableServerSourceOutput[] =
+R"(#include <android/os/BnDirectory.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+namespace {
+
+// Makes the calls in a chain one after the other, stopping after the first
+// one that fails.
+::android::status_t _aidl_RunCallChain(::android::IBinder* binder, const uint32_t* chainable_codes, size_t chainable_count, const ::android::Parcel& data, ::android::Parcel* reply) {
+int32_t step_count;
+::android::status_t status = data.readInt32(&step_count);
+if (status != ::android::OK) {
+return status;
+}
+// Every step takes up at least 8 bytes of the request.
+if (step_count < 0 || static_cast<size_t>(step_count) > data.dataAvail() / 8) {
+return ::android::BAD_VALUE;
+}
+::std::vector<::android::Parcel> results(step_count);
+::std::vector<size_t> result_starts(step_count);
+int32_t completed = 0;
+while (completed < step_count) {
+int32_t code;
+int32_t argument_count;
+status = data.readInt32(&code);
+if (status == ::android::OK) {
+status = data.readInt32(&argument_count);
+}
+if (status != ::android::OK) {
+return status;
+}
+bool chainable = false;
+for (size_t i = 0; i < chainable_count; ++i) {
+chainable = chainable || chainable_codes[i] == static_cast<uint32_t>(code);
+}
+if (!chainable || argument_count < 0) {
+return ::android::BAD_VALUE;
+}
+::android::Parcel step_data;
+status = step_data.writeInterfaceToken(binder->getInterfaceDescriptor());
+for (int32_t i = 0; status == ::android::OK && i < argument_count; ++i) {
+int32_t source;
+status = data.readInt32(&source);
+if (status != ::android::OK) {
+break;
+}
+if (source >= 0) {
+if (source >= completed) {
+return ::android::BAD_VALUE;
+}
+const ::android::Parcel& result = results[source];
+status = step_data.appendFrom(&result, result_starts[source], result.dataSize() - result_starts[source]);
+continue;
+}
+int32_t size;
+status = data.readInt32(&size);
+const size_t start = data.dataPosition();
+if (status == ::android::OK && (size < 0 || static_cast<size_t>(size) > data.dataAvail())) {
+status = ::android::BAD_VALUE;
+}
+if (status == ::android::OK) {
+status = step_data.appendFrom(&data, start, size);
+data.setDataPosition(start + size);
+}
+}
+if (status != ::android::OK) {
+return status;
+}
+step_data.setDataPosition(0);
+::android::Parcel& result = results[completed++];
+status = binder->transact(code, step_data, &result);
+if (status != ::android::OK) {
+return status;
+}
+::android::binder::Status step_status;
+result.setDataPosition(0);
+status = step_status.readFromParcel(result);
+if (status != ::android::OK) {
+return status;
+}
+result_starts[completed - 1] = result.dataPosition();
+if (!step_status.isOk()) {
+break;
+}
+}
+status = ::android::binder::Status::ok().writeToParcel(reply);
+if (status == ::android::OK) {
+status = reply->writeInt32(completed);
+}
+for (int32_t i = 0; status == ::android::OK && i < completed; ++i) {
+status = reply->writeInt32(results[i].dataSize());
+if (status == ::android::OK) {
+status = reply->appendFrom(&results[i], 0, results[i].dataSize());
+}
+}
+return status;
+}
+
+}  // namespace
+
+::android::status_t BnDirectory::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::LOOKUP:
+{
+::android::String16 in_name;
+int32_t _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readString16(&in_name);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Lookup(in_name, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+case Call::DESCRIBE:
+{
+int32_t in_id;
+::android::String16 _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readInt32(&in_id);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Describe(in_id, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeString16(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+case Call::TOUCH:
+{
+int32_t in_id;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readInt32(&in_id);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Touch(in_id));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+}
+break;
+case Call::LIST:
+{
+::std::vector<int32_t> out_ids;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+::android::binder::Status _aidl_status(List(&out_ids));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeInt32Vector(out_ids);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+case Call::CALL_CHAIN:
+{
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+static const uint32_t _aidl_chainable_codes[] = {Call::LOOKUP, Call::DESCRIBE, Call::TOUCH};
+_aidl_ret_status = _aidl_RunCallChain(this, _aidl_chainable_codes, 3, _aidl_data, _aidl_reply);
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedCallChainHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_DIRECTORY_CALL_CHAIN_H_
+#define AIDL_GENERATED_ANDROID_OS_DIRECTORY_CALL_CHAIN_H_
+
+#include <cstdint>
+#include <vector>
+#include <binder/Parcel.h>
+#include <binder/Status.h>
+#include <utils/StrongPointer.h>
+#include <android/os/IDirectory.h>
+
+namespace android {
+
+namespace os {
+
+class DirectoryCallChain {
+public:
+// The result of an earlier call in the chain, which later calls can take
+// as an argument.
+template <typename T>
+class Result {
+public:
+int32_t step() const { return step_; }
+private:
+friend class DirectoryCallChain;
+explicit Result(int32_t step) : step_(step) {}
+int32_t step_;
+};  // class Result
+
+// An argument to a chained call: either a value, which is copied when the
+// call is added to the chain, or the Result of an earlier call.
+template <typename T>
+class Arg {
+public:
+Arg(const T& value) : value_(&value) {}
+Arg(const Result<T>& result) : step_(result.step()) {}
+const T* value() const { return value_; }
+int32_t step() const { return step_; }
+private:
+const T* value_ = nullptr;
+int32_t step_ = -1;
+};  // class Arg
+
+DirectoryCallChain() = default;
+Result<int32_t> Lookup(Arg<::android::String16> name, int32_t* _aidl_return);
+Result<::android::String16> Describe(Arg<int32_t> id, ::android::String16* _aidl_return);
+void Touch(Arg<int32_t> id);
+// Makes the calls added so far with one transaction to |service|,
+// stopping at the first one that fails and returning its status.
+::android::binder::Status Transact(const ::android::sp<IDirectory>& service);
+private:
+struct Step {
+uint32_t code;
+void* result;
+};
+::android::status_t BeginStep(uint32_t code, int32_t argument_count, void* result);
+::android::status_t BeginArgument(int32_t step);
+::android::status_t EndArgument();
+static ::android::status_t ReadResult(uint32_t code, const ::android::Parcel& reply, void* result);
+::android::Parcel _aidl_request;
+::std::vector<Step> _aidl_steps;
+size_t _aidl_size_position = 0;
+::android::status_t _aidl_build_status = ::android::OK;
+};  // class DirectoryCallChain
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_DIRECTORY_CALL_CHAIN_H_)";
+
+const char kExpectedCallChainSourceOutput[] =
+R"(#include <android/os/DirectoryCallChain.h>
+
+namespace android {
+
+namespace os {
+
+DirectoryCallChain::Result<int32_t> DirectoryCallChain::Lookup(Arg<::android::String16> name, int32_t* _aidl_return) {
+const int32_t _aidl_step = _aidl_steps.size();
+::android::status_t _aidl_ret_status = BeginStep(IDirectory::LOOKUP, 1, _aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = BeginArgument(name.step());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (name.value() != nullptr) {
+_aidl_ret_status = _aidl_request.writeString16(*name.value());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = EndArgument();
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+}
+_aidl_error:
+_aidl_build_status = _aidl_ret_status;
+return Result<int32_t>(_aidl_step);
+}
+
+DirectoryCallChain::Result<::android::String16> DirectoryCallChain::Describe(Arg<int32_t> id, ::android::String16* _aidl_return) {
+const int32_t _aidl_step = _aidl_steps.size();
+::android::status_t _aidl_ret_status = BeginStep(IDirectory::DESCRIBE, 1, _aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = BeginArgument(id.step());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (id.value() != nullptr) {
+_aidl_ret_status = _aidl_request.writeInt32(*id.value());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = EndArgument();
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+}
+_aidl_error:
+_aidl_build_status = _aidl_ret_status;
+return Result<::android::String16>(_aidl_step);
+}
+
+void DirectoryCallChain::Touch(Arg<int32_t> id) {
+::android::status_t _aidl_ret_status = BeginStep(IDirectory::TOUCH, 1, nullptr);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = BeginArgument(id.step());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (id.value() != nullptr) {
+_aidl_ret_status = _aidl_request.writeInt32(*id.value());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = EndArgument();
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+}
+_aidl_error:
+_aidl_build_status = _aidl_ret_status;
+}
+
+::android::binder::Status DirectoryCallChain::Transact(const ::android::sp<IDirectory>& service) {
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = _aidl_build_status;
+::android::binder::Status _aidl_status;
+int32_t _aidl_completed = 0;
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeInterfaceToken(IDirectory::descriptor);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeInt32(_aidl_steps.size());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.appendFrom(&_aidl_request, 0, _aidl_request.dataSize());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = ::android::IInterface::asBinder(service)->transact(IDirectory::CALL_CHAIN, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = _aidl_reply.readInt32(&_aidl_completed);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (_aidl_completed < 0 || static_cast<size_t>(_aidl_completed) > _aidl_steps.size()) {
+_aidl_ret_status = ::android::BAD_VALUE;
+goto _aidl_error;
+}
+for (size_t i = 0; i < static_cast<size_t>(_aidl_completed); ++i) {
+int32_t _aidl_size;
+_aidl_ret_status = _aidl_reply.readInt32(&_aidl_size);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+const size_t _aidl_start = _aidl_reply.dataPosition();
+if (_aidl_size < 0 || static_cast<size_t>(_aidl_size) > _aidl_reply.dataAvail()) {
+_aidl_ret_status = ::android::BAD_VALUE;
+goto _aidl_error;
+}
+::android::Parcel _aidl_step_reply;
+_aidl_ret_status = _aidl_step_reply.appendFrom(&_aidl_reply, _aidl_start, _aidl_size);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_reply.setDataPosition(_aidl_start + _aidl_size);
+_aidl_step_reply.setDataPosition(0);
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_step_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = ReadResult(_aidl_steps[i].code, _aidl_step_reply, _aidl_steps[i].result);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+}
+if (static_cast<size_t>(_aidl_completed) != _aidl_steps.size()) {
+_aidl_ret_status = ::android::BAD_VALUE;
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
+
+::android::status_t DirectoryCallChain::BeginStep(uint32_t code, int32_t argument_count, void* result) {
+if (((_aidl_build_status) != (::android::OK))) {
+return _aidl_build_status;
+}
+_aidl_steps.push_back(Step{code, result});
+::android::status_t _aidl_ret_status = _aidl_request.writeInt32(static_cast<int32_t>(code));
+if (((_aidl_ret_status) != (::android::OK))) {
+return _aidl_ret_status;
+}
+return _aidl_request.writeInt32(argument_count);
+}
+
+::android::status_t DirectoryCallChain::BeginArgument(int32_t step) {
+if (step >= 0) {
+if (static_cast<size_t>(step) + 1 >= _aidl_steps.size()) {
+return ::android::BAD_VALUE;
+}
+return _aidl_request.writeInt32(step);
+}
+::android::status_t _aidl_ret_status = _aidl_request.writeInt32(-1);
+if (((_aidl_ret_status) != (::android::OK))) {
+return _aidl_ret_status;
+}
+_aidl_size_position = _aidl_request.dataPosition();
+return _aidl_request.writeInt32(0);
+}
+
+::android::status_t DirectoryCallChain::EndArgument() {
+const size_t _aidl_end = _aidl_request.dataPosition();
+_aidl_request.setDataPosition(_aidl_size_position);
+::android::status_t _aidl_ret_status = _aidl_request.writeInt32(static_cast<int32_t>(_aidl_end - _aidl_size_position - sizeof(int32_t)));
+_aidl_request.setDataPosition(_aidl_end);
+return _aidl_ret_status;
+}
+
+::android::status_t DirectoryCallChain::ReadResult(uint32_t code, const ::android::Parcel& reply, void* result) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (code) {
+case IDirectory::LOOKUP:
+{
+_aidl_ret_status = reply.readInt32(static_cast<int32_t*>(result));
+}
+break;
+case IDirectory::DESCRIBE:
+{
+_aidl_ret_status = reply.readString16(static_cast<::android::String16*>(result));
+}
+break;
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kMirroredInterfaceAIDL =
+R"(package android.os;
+import android.os.Reading;
+interface ISensor {
+  @mirrored Reading GetReading();
+  void Calibrate(int offset);
+})";
+
+const char kExpectedMirrorClientHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_BP_SENSOR_H_
+#define AIDL_GENERATED_ANDROID_OS_BP_SENSOR_H_
+
+#include <binder/IBinder.h>
+#include <binder/IInterface.h>
+#include <utils/Errors.h>
+#include <android/os/ISensor.h>
+#include <transport/state_mirror.h>
+
+namespace android {
+
+namespace os {
+
+class BpSensor : public ::android::BpInterface<ISensor> {
+public:
+explicit BpSensor(const ::android::sp<::android::IBinder>& _aidl_impl);
+virtual ~BpSensor() = default;
+::android::binder::Status GetReading(::android::os::Reading* _aidl_return) override;
+::android::binder::Status Calibrate(int32_t offset) override;
+private:
+::android::aidl::transport::StateMirrorSubscriber _aidl_mirror_GetReading;
+};  // class BpSensor
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_BP_SENSOR_H_)";
+
+const char kExpectedMirrorClientSourceOutput[] =
+R"(#include <android/os/BpSensor.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+BpSensor::BpSensor(const ::android::sp<::android::IBinder>& _aidl_impl)
+    : BpInterface<ISensor>(_aidl_impl){
+}
+
+::android::binder::Status BpSensor::GetReading(::android::os::Reading* _aidl_return) {
+::android::Parcel _aidl_snapshot;
+if (_aidl_mirror_GetReading.Read(remote(), getInterfaceDescriptor(), ISensor::STATE_MIRROR, ISensor::GETREADING, &_aidl_snapshot) && _aidl_snapshot.readParcelable(_aidl_return) == ::android::OK) {
+return ::android::binder::Status::ok();
+}
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = ::android::OK;
+::android::binder::Status _aidl_status;
+_aidl_ret_status = _aidl_data.writeInterfaceToken(getInterfaceDescriptor());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = remote()->transact(ISensor::GETREADING, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = _aidl_reply.readParcelable(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
+
+::android::binder::Status BpSensor::Calibrate(int32_t offset) {
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = ::android::OK;
+::android::binder::Status _aidl_status;
+_aidl_ret_status = _aidl_data.writeInterfaceToken(getInterfaceDescriptor());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeInt32(offset);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = remote()->transact(ISensor::CALIBRATE, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedMirrorServerHeaderOutput[] =
+R"(#ifndef AIDL_GENERATED_ANDROID_OS_BN_SENSOR_H_
+#define AIDL_GENERATED_ANDROID_OS_BN_SENSOR_H_
+
+#include <binder/IInterface.h>
+#include <android/os/ISensor.h>
+#include <transport/state_mirror.h>
+
+namespace android {
+
+namespace os {
+
+class BnSensor : public ::android::BnInterface<ISensor> {
+public:
+::android::status_t onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags = 0) override;
+::android::status_t PublishReading(const ::android::os::Reading& state);
+private:
+::android::aidl::transport::StateMirrorPublisher _aidl_mirror_GetReading;
+};  // class BnSensor
+
+}  // namespace os
+
+}  // namespace android
+
+#endif  // AIDL_GENERATED_ANDROID_OS_BN_SENSOR_H_)";
+
+const char kExpectedMirrorServerSourceOutput[] =
+R"(#include <android/os/BnSensor.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+::android::status_t BnSensor::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::GETREADING:
+{
+::android::os::Reading _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+::android::binder::Status _aidl_status(GetReading(&_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeParcelable(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+case Call::CALIBRATE:
+{
+int32_t in_offset;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+_aidl_ret_status = _aidl_data.readInt32(&in_offset);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Calibrate(in_offset));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+}
+break;
+case Call::STATE_MIRROR:
+{
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+int32_t _aidl_method;
+_aidl_ret_status = _aidl_data.readInt32(&_aidl_method);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (_aidl_method == Call::GETREADING) {
+_aidl_ret_status = _aidl_mirror_GetReading.WriteRegion(_aidl_reply);
+break;
+}
+_aidl_ret_status = ::android::BAD_VALUE;
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+::android::status_t BnSensor::PublishReading(const ::android::os::Reading& state) {
+::android::Parcel _aidl_snapshot;
+::android::status_t _aidl_ret_status = _aidl_snapshot.writeParcelable(state);
+if (_aidl_ret_status != ::android::OK) {
+return _aidl_ret_status;
+}
+return _aidl_mirror_GetReading.Publish(_aidl_snapshot);
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kTracedInterfaceAIDL =
+R"(package android.os;
+interface ITraced {
+  int Add(int x, int y);
+})";
+
+const char kExpectedTraceContextClientSourceOutput[] =
+R"(#include <android/os/BpTraced.h>
+#include <binder/Parcel.h>
+#include <transport/trace_context.h>
+
+namespace android {
+
+namespace os {
+
+namespace {
+
+// Writes the calling thread's trace context after the interface token.
+::android::status_t _aidl_WriteTraceContext(::android::Parcel* data) {
+const ::android::aidl::transport::TraceContext& trace = ::android::aidl::transport::TraceContext::Current();
+::android::status_t status = data->writeInt32(trace.WireFlags());
+if (status == ::android::OK && trace.IsValid()) {
+status = data->writeInt64(static_cast<int64_t>(trace.trace_id));
+if (status == ::android::OK) {
+status = data->writeInt64(static_cast<int64_t>(trace.span_id));
+}
+}
+return status;
+}
+
+}  // namespace
+
+BpTraced::BpTraced(const ::android::sp<::android::IBinder>& _aidl_impl)
+    : BpInterface<ITraced>(_aidl_impl){
+}
+
+::android::binder::Status BpTraced::Add(int32_t x, int32_t y, int32_t* _aidl_return) {
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = ::android::OK;
+::android::binder::Status _aidl_status;
+_aidl_ret_status = _aidl_data.writeInterfaceToken(getInterfaceDescriptor());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_WriteTraceContext(&_aidl_data);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeInt32(x);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeInt32(y);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = remote()->transact(ITraced::ADD, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = _aidl_reply.readInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const char kExpectedTraceContextServerSourceOutput[] =
+R"(#include <android/os/BnTraced.h>
+#include <binder/Parcel.h>
+#include <transport/trace_context.h>
+
+namespace android {
+
+namespace os {
+
+namespace {
+
+// Reads the trace context the caller wrote after the interface token.
+::android::status_t _aidl_ReadTraceContext(const ::android::Parcel& data, ::android::aidl::transport::TraceContext* caller) {
+int32_t flags;
+::android::status_t status = data.readInt32(&flags);
+if (status != ::android::OK || !(flags & ::android::aidl::transport::TraceContext::kPresent)) {
+return status;
+}
+int64_t trace_id;
+int64_t span_id;
+status = data.readInt64(&trace_id);
+if (status == ::android::OK) {
+status = data.readInt64(&span_id);
+}
+if (status == ::android::OK) {
+*caller = ::android::aidl::transport::TraceContext::FromWire(flags, static_cast<uint64_t>(trace_id), static_cast<uint64_t>(span_id));
+}
+return status;
+}
+
+}  // namespace
+
+::android::status_t BnTraced::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::ADD:
+{
+int32_t in_x;
+int32_t in_y;
+int32_t _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+::android::aidl::transport::TraceContext _aidl_trace;
+_aidl_ret_status = _aidl_ReadTraceContext(_aidl_data, &_aidl_trace);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::aidl::transport::ScopedTraceContext _aidl_trace_scope(_aidl_trace.NewChild());
+if (((_aidl_data.dataAvail()) < (8))) {
+_aidl_ret_status = ::android::NOT_ENOUGH_DATA;
+break;
+}
+in_x = _aidl_data.readInt32();
+in_y = _aidl_data.readInt32();
+::android::binder::Status _aidl_status(Add(in_x, in_y, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kNonNullInterfaceAIDL =
+R"(package android.os;
+import android.os.Reading;
+interface ISorter {
+  @nonnull Reading[] Sort(in @nonnull Reading[] readings, inout @nonnull Reading pivot);
+})";
+
+const char kExpectedNonNullClientSourceOutput[] =
+R"(#include <android/os/BpSorter.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+namespace {
+
+template <typename T>
+::android::status_t _aidl_WriteNonNullParcelable(::android::Parcel* parcel, const T& value) {
+return value.writeToParcel(parcel);
+}
+
+template <typename T>
+::android::status_t _aidl_ReadNonNullParcelable(const ::android::Parcel& parcel, T* value) {
+return value->readFromParcel(&parcel);
+}
+
+template <typename T>
+::android::status_t _aidl_WriteNonNullParcelableVector(::android::Parcel* parcel, const ::std::vector<T>& value) {
+if (value.size() > static_cast<size_t>(INT32_MAX)) {
+return ::android::BAD_VALUE;
+}
+::android::status_t status = parcel->writeInt32(static_cast<int32_t>(value.size()));
+for (size_t i = 0; status == ::android::OK && i < value.size(); ++i) {
+status = value[i].writeToParcel(parcel);
+}
+return status;
+}
+
+template <typename T>
+::android::status_t _aidl_ReadNonNullParcelableVector(const ::android::Parcel& parcel, ::std::vector<T>* value) {
+int32_t size;
+::android::status_t status = parcel.readInt32(&size);
+if (status != ::android::OK) {
+return status;
+}
+if (size == -1) {
+return ::android::UNEXPECTED_NULL;
+}
+if (size < 0) {
+return ::android::BAD_VALUE;
+}
+value->resize(size);
+for (int32_t i = 0; status == ::android::OK && i < size; ++i) {
+status = (*value)[i].readFromParcel(&parcel);
+}
+return status;
+}
+
+}  // namespace
+
+BpSorter::BpSorter(const ::android::sp<::android::IBinder>& _aidl_impl)
+    : BpInterface<ISorter>(_aidl_impl){
+}
+
+::android::binder::Status BpSorter::Sort(const ::std::vector<android::os::Reading>& readings, ::android::os::Reading* pivot, ::std::vector<android::os::Reading>* _aidl_return) {
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = ::android::OK;
+::android::binder::Status _aidl_status;
+_aidl_ret_status = _aidl_data.writeInterfaceToken(getInterfaceDescriptor());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_WriteNonNullParcelableVector(&_aidl_data, readings);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_WriteNonNullParcelable(&_aidl_data, *pivot);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = remote()->transact(ISorter::SORT, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = _aidl_ReadNonNullParcelableVector(_aidl_reply, _aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_ReadNonNullParcelable(_aidl_reply, pivot);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
+
+const string kSkippableInterfaceAIDL =
+R"(package android.os;
+interface IMeasurer {
+  int Measure(in String what, out @skippable double[] samples, out @skippable List<String> names);
+})";
 
-const char kExpectedComplexTypeInterfaceSourceOutput[] =
-R"(#include <android/os/IComplexTypeInterface.h>
-#include <android/os/BpComplexTypeInterface.h>
+const char kExpectedSkippableClientSourceOutput[] =
+R"(#include <android/os/BpMeasurer.h>
+#include <binder/Parcel.h>
 
 namespace android {
 
 namespace os {
 
-IMPLEMENT_META_INTERFACE(ComplexTypeInterface, "android.os.IComplexTypeInterface");
+BpMeasurer::BpMeasurer(const ::android::sp<::android::IBinder>& _aidl_impl)
+    : BpInterface<IMeasurer>(_aidl_impl){
+}
+
+::android::binder::Status BpMeasurer::Measure(const ::android::String16& what, ::std::vector<double>* samples, ::std::vector<::android::String16>* names, int32_t* _aidl_return) {
+::android::Parcel _aidl_data;
+::android::Parcel _aidl_reply;
+::android::status_t _aidl_ret_status = ::android::OK;
+::android::binder::Status _aidl_status;
+_aidl_ret_status = _aidl_data.writeInterfaceToken(getInterfaceDescriptor());
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeInt32(static_cast<int32_t>(((samples != nullptr) ? 0x2 : 0) | ((names != nullptr) ? 0x4 : 0)));
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_data.writeString16(what);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = remote()->transact(IMeasurer::MEASURE, _aidl_data, &_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+_aidl_ret_status = _aidl_status.readFromParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (!_aidl_status.isOk()) {
+return _aidl_status;
+}
+_aidl_ret_status = _aidl_reply.readInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+if (samples != nullptr) {
+_aidl_ret_status = _aidl_reply.readDoubleVector(samples);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+}
+if (names != nullptr) {
+_aidl_ret_status = _aidl_reply.readString16Vector(names);
+if (((_aidl_ret_status) != (::android::OK))) {
+goto _aidl_error;
+}
+}
+_aidl_error:
+_aidl_status.setFromStatusT(_aidl_ret_status);
+return _aidl_status;
+}
 
 }  // namespace os
 
 }  // namespace android
 )";
 
-}  // namespace
+const char kExpectedSkippableServerSourceOutput[] =
+R"(#include <android/os/BnMeasurer.h>
+#include <binder/Parcel.h>
+
+namespace android {
+
+namespace os {
+
+::android::status_t BnMeasurer::onTransact(uint32_t _aidl_code, const ::android::Parcel& _aidl_data, ::android::Parcel* _aidl_reply, uint32_t _aidl_flags) {
+::android::status_t _aidl_ret_status = ::android::OK;
+switch (_aidl_code) {
+case Call::MEASURE:
+{
+::android::String16 in_what;
+::std::vector<double> out_samples;
+::std::vector<::android::String16> out_names;
+int32_t _aidl_return;
+if (!(_aidl_data.checkInterface(this))) {
+_aidl_ret_status = ::android::BAD_TYPE;
+break;
+}
+int32_t _aidl_out_mask;
+_aidl_ret_status = _aidl_data.readInt32(&_aidl_out_mask);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+_aidl_ret_status = _aidl_data.readString16(&in_what);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+::android::binder::Status _aidl_status(Measure(in_what, ((_aidl_out_mask & 0x2) != 0) ? &out_samples : nullptr, ((_aidl_out_mask & 0x4) != 0) ? &out_names : nullptr, &_aidl_return));
+_aidl_ret_status = _aidl_status.writeToParcel(_aidl_reply);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if (!_aidl_status.isOk()) {
+break;
+}
+_aidl_ret_status = _aidl_reply->writeInt32(_aidl_return);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+if ((_aidl_out_mask & 0x2) != 0) {
+_aidl_ret_status = _aidl_reply->writeDoubleVector(out_samples);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+if ((_aidl_out_mask & 0x4) != 0) {
+_aidl_ret_status = _aidl_reply->writeString16Vector(out_names);
+if (((_aidl_ret_status) != (::android::OK))) {
+break;
+}
+}
+}
+break;
+default:
+{
+_aidl_ret_status = ::android::BBinder::onTransact(_aidl_code, _aidl_data, _aidl_reply, _aidl_flags);
+}
+break;
+}
+if (_aidl_ret_status == ::android::UNEXPECTED_NULL) {
+_aidl_ret_status = ::android::binder::Status::fromExceptionCode(::android::binder::Status::EX_NULL_POINTER).writeToParcel(_aidl_reply);
+}
+return _aidl_ret_status;
+}
+
+}  // namespace os
+
+}  // namespace android
+)";
 
 class ASTTest : public ::testing::Test {
  protected:
@@ -751,6 +3078,267 @@ TEST_F(ComplexTypeInterfaceASTTest, GeneratesInterfaceSource) {
   Compare(doc.get(), kExpectedComplexTypeInterfaceSourceOutput);
 }
 
+class TypedConstantInterfaceASTTest : public ASTTest {
+ public:
+  TypedConstantInterfaceASTTest()
+      : ASTTest("android/os/IConfig.aidl", kTypedConstantInterfaceAIDL) {}
+};
+
+TEST_F(TypedConstantInterfaceASTTest, GeneratesInterfaceHeader) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildInterfaceHeader(types_, *interface);
+  Compare(doc.get(), kExpectedTypedConstantInterfaceHeaderOutput);
+}
+
+TEST_F(TypedConstantInterfaceASTTest, GeneratesInterfaceSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildInterfaceSource(types_, *interface);
+  Compare(doc.get(), kExpectedTypedConstantInterfaceSourceOutput);
+}
+
+class EnumInterfaceASTTest : public ASTTest {
+ public:
+  EnumInterfaceASTTest()
+      : ASTTest("android/os/IPalette.aidl", kEnumInterfaceAIDL) {}
+};
+
+TEST_F(EnumInterfaceASTTest, GeneratesInterfaceHeader) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildInterfaceHeader(types_, *interface);
+  Compare(doc.get(), kExpectedEnumInterfaceHeaderOutput);
+}
+
+TEST_F(EnumInterfaceASTTest, GeneratesInterfaceSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildInterfaceSource(types_, *interface);
+  Compare(doc.get(), kExpectedEnumInterfaceSourceOutput);
+}
+
+TEST_F(EnumInterfaceASTTest, GeneratesClientSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildClientSource(types_, *interface);
+  Compare(doc.get(), kExpectedEnumClientSourceOutput);
+}
+
+TEST_F(EnumInterfaceASTTest, GeneratesServerSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerSource(types_, *interface);
+  Compare(doc.get(), kExpectedEnumServerSourceOutput);
+}
+
+class ShardedInterfaceASTTest : public ASTTest {
+ public:
+  ShardedInterfaceASTTest()
+      : ASTTest("android/os/IKeyValueStore.aidl", kShardedInterfaceAIDL) {}
+};
+
+TEST_F(ShardedInterfaceASTTest, GeneratesRouterHeader) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildRouterHeader(types_, *interface);
+  Compare(doc.get(), kExpectedRouterHeaderOutput);
+}
+
+TEST_F(ShardedInterfaceASTTest, GeneratesRouterSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildRouterSource(types_, *interface);
+  Compare(doc.get(), kExpectedRouterSourceOutput);
+}
+
+class DeltaInterfaceASTTest : public ASTTest {
+ public:
+  DeltaInterfaceASTTest()
+      : ASTTest("android/os/IDeltaBuffer.aidl", kDeltaInterfaceAIDL) {}
+};
+
+TEST_F(DeltaInterfaceASTTest, GeneratesClientSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildClientSource(types_, *interface);
+  Compare(doc.get(), kExpectedDeltaClientSourceOutput);
+}
+
+TEST_F(DeltaInterfaceASTTest, GeneratesServerSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerSource(types_, *interface);
+  Compare(doc.get(), kExpectedDeltaServerSourceOutput);
+}
+
+class FixedSizeInterfaceASTTest : public ASTTest {
+ public:
+  FixedSizeInterfaceASTTest()
+      : ASTTest("android/os/IMotion.aidl", kFixedSizeInterfaceAIDL) {}
+};
+
+TEST_F(FixedSizeInterfaceASTTest, GeneratesServerSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerSource(types_, *interface);
+  Compare(doc.get(), kExpectedFixedSizeServerSourceOutput);
+}
+
+TEST_F(FixedSizeInterfaceASTTest, GeneratesServerMetrics) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerHeader(
+      types_, *interface, true /* server_metrics */);
+  Compare(doc.get(), kExpectedMetricsServerHeaderOutput);
+  doc = internals::BuildServerSource(types_, *interface,
+                                     true /* server_metrics */);
+  Compare(doc.get(), kExpectedMetricsServerSourceOutput);
+}
+
+TEST_F(FixedSizeInterfaceASTTest, GeneratesServerWatchdog) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerHeader(
+      types_, *interface, false /* server_metrics */,
+      true /* server_watchdog */);
+  Compare(doc.get(), kExpectedWatchdogServerHeaderOutput);
+  doc = internals::BuildServerSource(types_, *interface,
+                                     false /* server_metrics */,
+                                     false /* trace_context */,
+                                     true /* server_watchdog */);
+  Compare(doc.get(), kExpectedWatchdogServerSourceOutput);
+}
+
+class ChainableInterfaceASTTest : public ASTTest {
+ public:
+  ChainableInterfaceASTTest()
+      : ASTTest("android/os/IDirectory.aidl", kChainableInterfaceAIDL) {}
+};
+
+TEST_F(ChainableInterfaceASTTest, GeneratesCallChainHeader) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc =
+      internals::BuildCallChainHeader(types_, *interface);
+  Compare(doc.get(), kExpectedCallChainHeaderOutput);
+}
+
+TEST_F(ChainableInterfaceASTTest, GeneratesCallChainSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc =
+      internals::BuildCallChainSource(types_, *interface);
+  Compare(doc.get(), kExpectedCallChainSourceOutput);
+}
+
+TEST_F(ChainableInterfaceASTTest, GeneratesServerSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerSource(types_, *interface);
+  Compare(doc.get(), kExpectedChainableServerSourceOutput);
+}
+
+class MirroredInterfaceASTTest : public ASTTest {
+ public:
+  MirroredInterfaceASTTest()
+      : ASTTest("android/os/ISensor.aidl", kMirroredInterfaceAIDL) {
+    io_delegate_.SetFileContents(
+        "android/os/Reading.aidl",
+        "package android.os; parcelable Reading cpp_header "
+        "\"android/os/Reading.h\";");
+  }
+};
+
+TEST_F(MirroredInterfaceASTTest, GeneratesClientHeader) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildClientHeader(types_, *interface);
+  Compare(doc.get(), kExpectedMirrorClientHeaderOutput);
+}
+
+TEST_F(MirroredInterfaceASTTest, GeneratesClientSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildClientSource(types_, *interface);
+  Compare(doc.get(), kExpectedMirrorClientSourceOutput);
+}
+
+TEST_F(MirroredInterfaceASTTest, GeneratesServerHeader) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerHeader(types_, *interface);
+  Compare(doc.get(), kExpectedMirrorServerHeaderOutput);
+}
+
+TEST_F(MirroredInterfaceASTTest, GeneratesServerSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerSource(types_, *interface);
+  Compare(doc.get(), kExpectedMirrorServerSourceOutput);
+}
+
+class TracedInterfaceASTTest : public ASTTest {
+ public:
+  TracedInterfaceASTTest()
+      : ASTTest("android/os/ITraced.aidl", kTracedInterfaceAIDL) {}
+};
+
+TEST_F(TracedInterfaceASTTest, GeneratesClientSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildClientSource(
+      types_, *interface, true /* trace_context */);
+  Compare(doc.get(), kExpectedTraceContextClientSourceOutput);
+}
+
+TEST_F(TracedInterfaceASTTest, GeneratesServerSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerSource(
+      types_, *interface, false /* server_metrics */,
+      true /* trace_context */);
+  Compare(doc.get(), kExpectedTraceContextServerSourceOutput);
+}
+
+class NonNullInterfaceASTTest : public ASTTest {
+ public:
+  NonNullInterfaceASTTest()
+      : ASTTest("android/os/ISorter.aidl", kNonNullInterfaceAIDL) {
+    io_delegate_.SetFileContents(
+        "android/os/Reading.aidl",
+        "package android.os; parcelable Reading cpp_header "
+        "\"android/os/Reading.h\";");
+  }
+};
+
+TEST_F(NonNullInterfaceASTTest, GeneratesClientSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildClientSource(types_, *interface);
+  Compare(doc.get(), kExpectedNonNullClientSourceOutput);
+}
+
+class SkippableInterfaceASTTest : public ASTTest {
+ public:
+  SkippableInterfaceASTTest()
+      : ASTTest("android/os/IMeasurer.aidl", kSkippableInterfaceAIDL) {}
+};
+
+TEST_F(SkippableInterfaceASTTest, GeneratesClientSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildClientSource(types_, *interface);
+  Compare(doc.get(), kExpectedSkippableClientSourceOutput);
+}
+
+TEST_F(SkippableInterfaceASTTest, GeneratesServerSource) {
+  unique_ptr<AidlInterface> interface = Parse();
+  ASSERT_NE(interface, nullptr);
+  unique_ptr<Document> doc = internals::BuildServerSource(types_, *interface);
+  Compare(doc.get(), kExpectedSkippableServerSourceOutput);
+}
+
 namespace test_io_handling {
 
 const char kInputPath[] = "a/IFoo.aidl";
@@ -22,6 +22,7 @@
 #include "aidl_language.h"
 #include "ast_java.h"
 #include "io_delegate.h"
+#include "options.h"
 
 namespace android {
 namespace aidl {
@@ -32,10 +33,11 @@ class JavaTypeNamespace;
 
 int generate_java(const std::string& filename, const std::string& originalSrc,
                   AidlInterface* iface, java::JavaTypeNamespace* types,
-                  const IoDelegate& io_delegate);
+                  const IoDelegate& io_delegate, const JavaOptions& options);
 
 android::aidl::java::Class* generate_binder_interface_class(
-    const AidlInterface* iface, java::JavaTypeNamespace* types);
+    const AidlInterface* iface, java::JavaTypeNamespace* types,
+    const JavaOptions& options);
 
 }  // namespace java
 
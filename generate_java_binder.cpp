@@ -21,11 +21,18 @@
 #include <string.h>
 #include <string.h>
 
+#include <set>
+#include <utility>
+#include <vector>
+
 #include <android-base/macros.h>
+#include <android-base/stringprintf.h>
 
 #include "type_java.h"
 
+using android::base::StringPrintf;
 using std::string;
+using std::vector;
 
 namespace android {
 namespace aidl {
@@ -35,9 +42,15 @@ namespace java {
 class StubClass : public Class {
  public:
   StubClass(const Type* type, const InterfaceType* interfaceType,
-            JavaTypeNamespace* types);
+            JavaTypeNamespace* types, bool sharedRuntime, bool cacheProxies,
+            bool traceContext);
   virtual ~StubClass() = default;
 
+  // True if the stub extends android.aidl.runtime.AidlStub.
+  const bool sharedRuntime;
+  // True if each call runs under the caller's TraceContext.
+  const bool traceContext;
+
   Variable* transact_code;
   Variable* transact_data;
   Variable* transact_reply;
@@ -46,19 +59,25 @@ class StubClass : public Class {
 
  private:
   void make_as_interface(const InterfaceType* interfaceType,
-                         JavaTypeNamespace* types);
+                         JavaTypeNamespace* types, bool cacheProxies);
 
   DISALLOW_COPY_AND_ASSIGN(StubClass);
 };
 
 StubClass::StubClass(const Type* type, const InterfaceType* interfaceType,
-                     JavaTypeNamespace* types)
-    : Class() {
+                     JavaTypeNamespace* types, bool sharedRuntime,
+                     bool cacheProxies, bool traceContext)
+    : Class(), sharedRuntime(sharedRuntime), traceContext(traceContext) {
   this->comment = "/** Local-side IPC implementation stub class. */";
   this->modifiers = PUBLIC | ABSTRACT | STATIC;
   this->what = Class::CLASS;
   this->type = type;
-  this->extends = types->BinderNativeType();
+  if (sharedRuntime) {
+    this->extends = new Type(types, "android.aidl.runtime", "AidlStub",
+                             ValidatableType::KIND_BUILT_IN, false, false);
+  } else {
+    this->extends = types->BinderNativeType();
+  }
   this->interfaces.push_back(interfaceType);
 
   // descriptor
@@ -76,33 +95,42 @@ StubClass::StubClass(const Type* type, const InterfaceType* interfaceType,
       "interface. */";
   ctor->name = "Stub";
   ctor->statements = new StatementBlock;
-  MethodCall* attach =
-      new MethodCall(THIS_VALUE, "attachInterface", 2, THIS_VALUE,
-                     new LiteralExpression("DESCRIPTOR"));
-  ctor->statements->Add(attach);
+  if (sharedRuntime) {
+    ctor->statements->Add(new MethodCall(
+        "super", 1, new LiteralExpression("DESCRIPTOR")));
+  } else {
+    MethodCall* attach =
+        new MethodCall(THIS_VALUE, "attachInterface", 2, THIS_VALUE,
+                       new LiteralExpression("DESCRIPTOR"));
+    ctor->statements->Add(attach);
+  }
   this->elements.push_back(ctor);
 
   // asInterface
-  make_as_interface(interfaceType, types);
-
-  // asBinder
-  Method* asBinder = new Method;
-  asBinder->modifiers = PUBLIC | OVERRIDE;
-  asBinder->returnType = types->IBinderType();
-  asBinder->name = "asBinder";
-  asBinder->statements = new StatementBlock;
-  asBinder->statements->Add(new ReturnStatement(THIS_VALUE));
-  this->elements.push_back(asBinder);
+  make_as_interface(interfaceType, types, cacheProxies);
+
+  // asBinder, which AidlStub already provides
+  if (!sharedRuntime) {
+    Method* asBinder = new Method;
+    asBinder->modifiers = PUBLIC | OVERRIDE;
+    asBinder->returnType = types->IBinderType();
+    asBinder->name = "asBinder";
+    asBinder->statements = new StatementBlock;
+    asBinder->statements->Add(new ReturnStatement(THIS_VALUE));
+    this->elements.push_back(asBinder);
+  }
 
   // onTransact
   this->transact_code = new Variable(types->IntType(), "code");
   this->transact_data = new Variable(types->ParcelType(), "data");
   this->transact_reply = new Variable(types->ParcelType(), "reply");
   this->transact_flags = new Variable(types->IntType(), "flags");
+  // AidlStub handles the descriptor transaction in onTransact() and only
+  // hands us the calls that may be to our own methods.
   Method* onTransact = new Method;
-  onTransact->modifiers = PUBLIC | OVERRIDE;
+  onTransact->modifiers = (sharedRuntime ? PROTECTED : PUBLIC) | OVERRIDE;
   onTransact->returnType = types->BoolType();
-  onTransact->name = "onTransact";
+  onTransact->name = sharedRuntime ? "dispatch" : "onTransact";
   onTransact->parameters.push_back(this->transact_code);
   onTransact->parameters.push_back(this->transact_data);
   onTransact->parameters.push_back(this->transact_reply);
@@ -113,21 +141,48 @@ StubClass::StubClass(const Type* type, const InterfaceType* interfaceType,
   this->transact_switch = new SwitchStatement(this->transact_code);
 
   onTransact->statements->Add(this->transact_switch);
-  MethodCall* superCall = new MethodCall(
-      SUPER_VALUE, "onTransact", 4, this->transact_code, this->transact_data,
-      this->transact_reply, this->transact_flags);
-  onTransact->statements->Add(new ReturnStatement(superCall));
+  if (sharedRuntime) {
+    onTransact->statements->Add(new ReturnStatement(FALSE_VALUE));
+  } else {
+    MethodCall* superCall = new MethodCall(
+        SUPER_VALUE, "onTransact", 4, this->transact_code,
+        this->transact_data, this->transact_reply, this->transact_flags);
+    onTransact->statements->Add(new ReturnStatement(superCall));
+  }
+}
+
+// Remote objects are keyed by identity, since neither Binder nor BinderProxy
+// overrides equals().  The cache only holds its proxies weakly: each proxy
+// refers to its binder, so a strongly held proxy would keep its own key
+// alive forever.
+static const char kProxyCacheMethod[] =
+    R"(private static final java.util.WeakHashMap<android.os.IBinder, java.lang.ref.WeakReference<Proxy>> sProxies = new java.util.WeakHashMap<android.os.IBinder, java.lang.ref.WeakReference<Proxy>>();
+private static Proxy getCachedProxy(android.os.IBinder obj)
+{
+synchronized (sProxies) {
+java.lang.ref.WeakReference<Proxy> ref = sProxies.get(obj);
+Proxy proxy = (ref != null) ? ref.get() : null;
+if (proxy == null) {
+proxy = new Proxy(obj);
+sProxies.put(obj, new java.lang.ref.WeakReference<Proxy>(proxy));
+}
+return proxy;
+}
 }
+)";
 
 void StubClass::make_as_interface(const InterfaceType* interfaceType,
-                                  JavaTypeNamespace* types) {
+                                  JavaTypeNamespace* types,
+                                  bool cacheProxies) {
   Variable* obj = new Variable(types->IBinderType(), "obj");
 
   Method* m = new Method;
   m->comment = "/**\n * Cast an IBinder object into an ";
   m->comment += interfaceType->JavaType();
   m->comment += " interface,\n";
-  m->comment += " * generating a proxy if needed.\n */";
+  m->comment += (cacheProxies)
+      ? " * reusing the proxy for that object if there is one.\n */"
+      : " * generating a proxy if needed.\n */";
   m->modifiers = PUBLIC | STATIC;
   m->returnType = interfaceType;
   m->name = "asInterface";
@@ -166,27 +221,91 @@ void StubClass::make_as_interface(const InterfaceType* interfaceType,
       new ReturnStatement(new Cast(interfaceType, iin)));
   m->statements->Add(instOfStatement);
 
-  NewExpression* ne = new NewExpression(interfaceType->GetProxy());
-  ne->arguments.push_back(obj);
-  m->statements->Add(new ReturnStatement(ne));
+  if (cacheProxies) {
+    // return getCachedProxy(obj);
+    m->statements->Add(
+        new ReturnStatement(new MethodCall("getCachedProxy", 1, obj)));
+  } else {
+    NewExpression* ne = new NewExpression(interfaceType->GetProxy());
+    ne->arguments.push_back(obj);
+    m->statements->Add(new ReturnStatement(ne));
+  }
 
   this->elements.push_back(m);
+  if (cacheProxies) {
+    this->elements.push_back(new LiteralClassElement(kProxyCacheMethod));
+  }
 }
 
 // =================================================
+// Each thread keeps one request and one reply parcel for its proxy calls.
+// A call made while another is in progress on the same thread, such as one
+// made by an incoming nested transaction, obtains its own parcels instead.
+// Parcels that grew large are handed back rather than kept.
+static const char kThreadParcelsClass[] =
+    R"(private static final int MAX_KEPT_PARCEL_CAPACITY = 64 * 1024;
+private static final class ThreadParcels
+{
+android.os.Parcel data = android.os.Parcel.obtain();
+android.os.Parcel reply = android.os.Parcel.obtain();
+int depth;
+}
+private static final java.lang.ThreadLocal<ThreadParcels> sThreadParcels = new java.lang.ThreadLocal<ThreadParcels>() {
+@Override protected ThreadParcels initialValue()
+{
+return new ThreadParcels();
+}
+};
+private static android.os.Parcel resetThreadParcel(android.os.Parcel parcel)
+{
+if (parcel.dataCapacity() > MAX_KEPT_PARCEL_CAPACITY) {
+parcel.recycle();
+return android.os.Parcel.obtain();
+}
+parcel.setDataSize(0);
+return parcel;
+}
+private static void releaseThreadParcels(ThreadParcels parcels, android.os.Parcel data, android.os.Parcel reply)
+{
+if (--parcels.depth != 0) {
+if (reply != null) {
+reply.recycle();
+}
+data.recycle();
+return;
+}
+parcels.data = resetThreadParcel(parcels.data);
+parcels.reply = resetThreadParcel(parcels.reply);
+}
+)";
+
 class ProxyClass : public Class {
  public:
   ProxyClass(const JavaTypeNamespace* types, const Type* type,
-             const InterfaceType* interfaceType);
+             const InterfaceType* interfaceType, bool sharedRuntime,
+             bool threadLocalParcels, bool traceContext);
   virtual ~ProxyClass();
 
+  // Null if the proxy extends android.aidl.runtime.AidlProxy, which keeps
+  // the remote binder to itself.
   Variable* mRemote;
   bool mOneWay;
+  const bool sharedRuntime;
+  // Proxy methods take their parcels from sThreadParcels rather than from
+  // the global pool behind Parcel.obtain().
+  const bool threadLocalParcels;
+  // Proxy methods send the calling thread's TraceContext.
+  const bool traceContext;
 };
 
 ProxyClass::ProxyClass(const JavaTypeNamespace* types, const Type* type,
-                       const InterfaceType* interfaceType)
-    : Class() {
+                       const InterfaceType* interfaceType, bool sharedRuntime,
+                       bool threadLocalParcels, bool traceContext)
+    : Class(),
+      mRemote(nullptr),
+      sharedRuntime(sharedRuntime),
+      threadLocalParcels(threadLocalParcels),
+      traceContext(traceContext) {
   this->modifiers = PRIVATE | STATIC;
   this->what = Class::CLASS;
   this->type = type;
@@ -194,19 +313,28 @@ ProxyClass::ProxyClass(const JavaTypeNamespace* types, const Type* type,
 
   mOneWay = interfaceType->OneWay();
 
-  // IBinder mRemote
-  mRemote = new Variable(types->IBinderType(), "mRemote");
-  this->elements.push_back(new Field(PRIVATE, mRemote));
-
-  // Proxy()
   Variable* remote = new Variable(types->IBinderType(), "remote");
   Method* ctor = new Method;
   ctor->name = "Proxy";
   ctor->statements = new StatementBlock;
   ctor->parameters.push_back(remote);
-  ctor->statements->Add(new Assignment(mRemote, remote));
   this->elements.push_back(ctor);
 
+  if (sharedRuntime) {
+    this->extends = new Type(types, "android.aidl.runtime", "AidlProxy",
+                             ValidatableType::KIND_BUILT_IN, false, false);
+    ctor->statements->Add(new MethodCall(
+        "super", 2, remote, new LiteralExpression("DESCRIPTOR")));
+    return;
+  }
+
+  // IBinder mRemote
+  mRemote = new Variable(types->IBinderType(), "mRemote");
+  this->elements.insert(this->elements.begin(), new Field(PRIVATE, mRemote));
+
+  // Proxy()
+  ctor->statements->Add(new Assignment(mRemote, remote));
+
   // IBinder asBinder()
   Method* asBinder = new Method;
   asBinder->modifiers = PUBLIC | OVERRIDE;
@@ -215,10 +343,211 @@ ProxyClass::ProxyClass(const JavaTypeNamespace* types, const Type* type,
   asBinder->statements = new StatementBlock;
   asBinder->statements->Add(new ReturnStatement(mRemote));
   this->elements.push_back(asBinder);
+
+  if (threadLocalParcels) {
+    this->elements.push_back(new LiteralClassElement(kThreadParcelsClass));
+  }
 }
 
 ProxyClass::~ProxyClass() {}
 
+// =================================================
+class RouterClass : public Class {
+ public:
+  RouterClass(const JavaTypeNamespace* types, const InterfaceType* interfaceType,
+              const AidlInterface& iface);
+  virtual ~RouterClass() = default;
+
+  Variable* mShards;
+  Variable* mCalls;
+  Variable* mErrors;
+
+ private:
+  void make_hash_methods(const JavaTypeNamespace* types,
+                         const AidlInterface& iface);
+
+  DISALLOW_COPY_AND_ASSIGN(RouterClass);
+};
+
+RouterClass::RouterClass(const JavaTypeNamespace* types,
+                         const InterfaceType* interfaceType,
+                         const AidlInterface& iface)
+    : Class() {
+  this->comment =
+      "/**\n"
+      " * Spreads calls across several instances of the interface.  Methods\n"
+      " * with a @shardKey argument go to the shard picked by hashing the\n"
+      " * key, all other methods are sent to every shard in turn.\n"
+      " */";
+  this->modifiers = PUBLIC | STATIC;
+  this->what = Class::CLASS;
+  this->type = new Type(types, interfaceType->JavaType() + ".Router",
+                        ValidatableType::KIND_GENERATED, false, false);
+  this->interfaces.push_back(interfaceType);
+
+  const Type* counterType =
+      new Type(types, "java.util.concurrent.atomic", "AtomicLongArray",
+               ValidatableType::KIND_BUILT_IN, false, false);
+
+  mShards = new Variable(interfaceType, "mShards", 1);
+  this->elements.push_back(new Field(PRIVATE | FINAL, mShards));
+  mCalls = new Variable(counterType, "mCalls");
+  this->elements.push_back(new Field(PRIVATE | FINAL, mCalls));
+  mErrors = new Variable(counterType, "mErrors");
+  this->elements.push_back(new Field(PRIVATE | FINAL, mErrors));
+
+  // Router(IFoo[] shards)
+  Variable* shards = new Variable(interfaceType, "shards", 1);
+  Expression* shardCount = new FieldVariable(shards, "length");
+  Method* ctor = new Method;
+  ctor->modifiers = PUBLIC;
+  ctor->name = "Router";
+  ctor->parameters.push_back(shards);
+  ctor->statements = new StatementBlock;
+  ctor->statements->Add(
+      new Assignment(mShards, new MethodCall(shards, "clone")));
+  NewExpression* newCalls = new NewExpression(counterType);
+  newCalls->arguments.push_back(shardCount);
+  ctor->statements->Add(new Assignment(mCalls, newCalls));
+  NewExpression* newErrors = new NewExpression(counterType);
+  newErrors->arguments.push_back(shardCount);
+  ctor->statements->Add(new Assignment(mErrors, newErrors));
+  this->elements.push_back(ctor);
+
+  // int getShardCount()
+  Method* getShardCount = new Method;
+  getShardCount->modifiers = PUBLIC;
+  getShardCount->returnType = types->IntType();
+  getShardCount->name = "getShardCount";
+  getShardCount->statements = new StatementBlock;
+  getShardCount->statements->Add(
+      new ReturnStatement(new FieldVariable(mShards, "length")));
+  this->elements.push_back(getShardCount);
+
+  // long getShardCallCount(int shard), long getShardErrorCount(int shard)
+  // Like the C++ router, these return 0 for shards that don't exist.
+  for (const auto& counter : {std::make_pair("getShardCallCount", mCalls),
+                              std::make_pair("getShardErrorCount", mErrors)}) {
+    Variable* shard = new Variable(types->IntType(), "shard");
+    Method* m = new Method;
+    m->modifiers = PUBLIC;
+    m->returnType = types->LongType();
+    m->name = counter.first;
+    m->parameters.push_back(shard);
+    m->statements = new StatementBlock;
+    IfStatement* rangeCheck = new IfStatement();
+    rangeCheck->expression = new Comparison(
+        new Comparison(shard, "<", new LiteralExpression("0")), "||",
+        new Comparison(shard, ">=", new FieldVariable(mShards, "length")));
+    rangeCheck->statements->Add(
+        new ReturnStatement(new LiteralExpression("0")));
+    m->statements->Add(rangeCheck);
+    m->statements->Add(
+        new ReturnStatement(new MethodCall(counter.second, "get", 1, shard)));
+    this->elements.push_back(m);
+  }
+
+  // A router is a purely local object, so there is no binder to hand out.
+  Method* asBinder = new Method;
+  asBinder->modifiers = PUBLIC | OVERRIDE;
+  asBinder->returnType = types->IBinderType();
+  asBinder->name = "asBinder";
+  asBinder->statements = new StatementBlock;
+  asBinder->statements->Add(new ReturnStatement(NULL_VALUE));
+  this->elements.push_back(asBinder);
+
+  make_hash_methods(types, iface);
+}
+
+void RouterClass::make_hash_methods(const JavaTypeNamespace* types,
+                                    const AidlInterface& iface) {
+  // private int shardIndex(long hash)
+  Variable* hash = new Variable(types->LongType(), "hash");
+  Method* shardIndex = new Method;
+  shardIndex->modifiers = PRIVATE;
+  shardIndex->returnType = types->IntType();
+  shardIndex->name = "shardIndex";
+  shardIndex->parameters.push_back(hash);
+  shardIndex->statements = new StatementBlock;
+  shardIndex->statements->Add(new ReturnStatement(new LiteralExpression(
+      "(int) ((hash & 0x7fffffffffffffffL) % mShards.length)")));
+  this->elements.push_back(shardIndex);
+
+  // Keys are hashed with 64 bit FNV-1a over their little endian bytes (UTF-16
+  // code units for strings), exactly like the C++ router does.
+  Variable* mixHash = new Variable(types->LongType(), "hash");
+  Variable* value = new Variable(types->LongType(), "value");
+  Variable* bytes = new Variable(types->IntType(), "bytes");
+  Method* mix = new Method;
+  mix->modifiers = PRIVATE | STATIC;
+  mix->returnType = types->LongType();
+  mix->name = "mixShardKey";
+  mix->parameters.push_back(mixHash);
+  mix->parameters.push_back(value);
+  mix->parameters.push_back(bytes);
+  mix->statements = new StatementBlock;
+  ForStatement* mixLoop =
+      new ForStatement(new Variable(types->IntType(), "i"),
+                       new LiteralExpression("0"), bytes);
+  mixLoop->statements->Add(
+      new LiteralExpression("hash ^= (value >>> (8 * i)) & 0xff"));
+  mixLoop->statements->Add(new LiteralExpression("hash *= 0x100000001b3L"));
+  mix->statements->Add(mixLoop);
+  mix->statements->Add(new ReturnStatement(mixHash));
+  this->elements.push_back(mix);
+
+  bool need_int = false;
+  bool need_long = false;
+  bool need_string = false;
+  for (const auto& method : iface.GetMethods()) {
+    const AidlArgument* key = method->GetShardKeyArgument();
+    if (key == nullptr) {
+      continue;
+    }
+    const string& name = key->GetType().GetName();
+    need_int |= (name == "int");
+    need_long |= (name == "long");
+    need_string |= (name != "int" && name != "long");
+  }
+
+  const char kOffsetBasis[] = "0xcbf29ce484222325L";
+  const Type* key_types[] = {types->IntType(), types->LongType(),
+                             types->StringType()};
+  const bool needed[] = {need_int, need_long, need_string};
+  for (size_t i = 0; i < 3; i++) {
+    if (!needed[i]) {
+      continue;
+    }
+    Variable* key = new Variable(key_types[i], "key");
+    Method* m = new Method;
+    m->modifiers = PRIVATE | STATIC;
+    m->returnType = types->LongType();
+    m->name = "hashShardKey";
+    m->parameters.push_back(key);
+    m->statements = new StatementBlock;
+    if (key_types[i] == types->IntType()) {
+      m->statements->Add(new ReturnStatement(new LiteralExpression(
+          string("mixShardKey(") + kOffsetBasis + ", key & 0xffffffffL, 4)")));
+    } else if (key_types[i] == types->LongType()) {
+      m->statements->Add(new ReturnStatement(new LiteralExpression(
+          string("mixShardKey(") + kOffsetBasis + ", key, 8)")));
+    } else {
+      Variable* keyHash = new Variable(types->LongType(), "hash");
+      m->statements->Add(new VariableDeclaration(
+          keyHash, new LiteralExpression(kOffsetBasis)));
+      ForStatement* loop =
+          new ForStatement(new Variable(types->IntType(), "i"),
+                           new LiteralExpression("0"),
+                           new MethodCall(key, "length"));
+      loop->statements->Add(new Assignment(
+          keyHash, new LiteralExpression("mixShardKey(hash, key.charAt(i), 2)")));
+      m->statements->Add(loop);
+      m->statements->Add(new ReturnStatement(keyHash));
+    }
+    this->elements.push_back(m);
+  }
+}
+
 // =================================================
 static void generate_new_array(const Type* t, StatementBlock* addTo,
                                Variable* v, Variable* parcel,
@@ -251,14 +580,721 @@ static void generate_read_from_parcel(const Type* t, StatementBlock* addTo,
   t->ReadFromParcel(addTo, v, parcel, cl);
 }
 
+// Reads an @reuse argument into the instance this thread kept from its last
+// call, or into a new one.  The instance is taken out of |cache| while the
+// call is in progress, so a nested call on the same thread gets its own.
+// @nonnull arguments are read the same way, without the null marker.
+static void generate_reused_from_parcel(const Type* t, StatementBlock* addTo,
+                                        Variable* v, Variable* parcel,
+                                        Variable* cache, bool nonnull) {
+  // if (0 != parcel.readInt()) {
+  //     v = cache.get();
+  //     if (v == null) {
+  //         v = new T();
+  //     } else {
+  //         cache.set(null);
+  //     }
+  //     v.readFromParcel(parcel);
+  // } else {
+  //     v = null;
+  // }
+  IfStatement* fresh = new IfStatement();
+  fresh->expression = new Comparison(v, "==", NULL_VALUE);
+  fresh->statements->Add(new Assignment(v, new NewExpression(t)));
+  fresh->elseif = new IfStatement();
+  fresh->elseif->statements->Add(new MethodCall(cache, "set", 1, NULL_VALUE));
+
+  if (nonnull) {
+    addTo->Add(new Assignment(v, new MethodCall(cache, "get")));
+    addTo->Add(fresh);
+    addTo->Add(new MethodCall(v, "readFromParcel", 1, parcel));
+    return;
+  }
+  IfStatement* ifpart = new IfStatement();
+  ifpart->expression = new Comparison(new LiteralExpression("0"), "!=",
+                                      new MethodCall(parcel, "readInt"));
+  ifpart->statements->Add(new Assignment(v, new MethodCall(cache, "get")));
+  ifpart->statements->Add(fresh);
+  ifpart->statements->Add(new MethodCall(v, "readFromParcel", 1, parcel));
+  ifpart->elseif = new IfStatement();
+  ifpart->elseif->statements->Add(new Assignment(v, NULL_VALUE));
+  addTo->Add(ifpart);
+}
+
+// The mask of @skippable out parameters the caller wants back: those it
+// passed an object or an array for.
+static Expression* out_mask_expression(const AidlMethod& method) {
+  string mask;
+  for (const AidlArgument* arg : method.GetOutArguments()) {
+    if (!arg->GetType().IsSkippable()) {
+      continue;
+    }
+    if (!mask.empty()) {
+      mask += "|";
+    }
+    mask += StringPrintf("((%s!=null)?0x%x:0)", arg->GetName().c_str(),
+                         method.GetOutMaskBit(*arg));
+  }
+  return new LiteralExpression(mask);
+}
+
+// True in the stub if the caller wants the @skippable out parameter |arg|.
+static Expression* out_wanted_expression(const AidlMethod& method,
+                                         const AidlArgument& arg,
+                                         Variable* mask) {
+  return new Comparison(
+      new LiteralExpression(StringPrintf("(%s&0x%x)", mask->name.c_str(),
+                                         method.GetOutMaskBit(arg))),
+      "!=", new LiteralExpression("0"));
+}
+
+// Reads an out parameter back into what the caller passed, or leaves it
+// alone if it is @skippable and the caller passed null.
+static void generate_read_out_from_parcel(const AidlArgument& arg,
+                                          StatementBlock* addTo, Variable* v,
+                                          Variable* parcel, Variable** cl) {
+  const Type* t = arg.GetType().GetLanguageType<Type>();
+  if (!arg.GetType().IsSkippable()) {
+    generate_read_from_parcel(t, addTo, v, parcel, cl);
+    return;
+  }
+  IfStatement* wanted = new IfStatement();
+  wanted->expression = new Comparison(v, "!=", NULL_VALUE);
+  generate_read_from_parcel(t, wanted->statements, v, parcel, cl);
+  addTo->Add(wanted);
+}
+
+// Makes the proxy throw before anything is marshalled when it is handed null
+// for a @nonnull argument, since the stub has no way to receive one.
+static void generate_non_null_checks(const AidlMethod& method,
+                                     StatementBlock* addTo) {
+  for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
+    if (!arg->GetType().IsNonNull()) {
+      continue;
+    }
+    IfStatement* check = new IfStatement();
+    check->expression = new Comparison(
+        new Variable(arg->GetType().GetLanguageType<Type>(), arg->GetName()),
+        "==", NULL_VALUE);
+    check->statements->Add(new LiteralExpression(
+        "throw new java.lang.NullPointerException(\"" + arg->GetName() +
+        " is @nonnull\")"));
+    addTo->Add(check);
+  }
+}
+
+// Describes what implementations may do with @reuse arguments in the
+// comment on the interface method.
+static string add_reuse_contract(const string& comments,
+                                 const vector<string>& reused) {
+  string contract;
+  for (const string& name : reused) {
+    contract += " * <p>The stub reuses the object it passes as {@code " + name +
+                "}\n"
+                " * for later calls on the same thread.  It is only valid until"
+                " this\n"
+                " * method returns and must not be kept or handed to other"
+                " threads.\n";
+  }
+  const size_t end = comments.rfind("*/");
+  if (end == string::npos) {
+    return comments + "/**\n" + contract + " */";
+  }
+  return comments.substr(0, end) + "\n" + contract + " " +
+         comments.substr(end);
+}
+
+// Runs the calls in a chain one after the other, feeding results of earlier
+// calls to later ones, and replies with what each call replied.  The format
+// is the same one the C++ generator uses.
+static const char kRunCallChainMethod[] =
+    R"(private void runCallChain(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+int stepCount = data.readInt();
+// Every step takes up at least 8 bytes of the request.
+if (stepCount < 0 || stepCount > data.dataAvail() / 8) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+android.os.Parcel[] results = new android.os.Parcel[stepCount];
+int[] resultStarts = new int[stepCount];
+int completed = 0;
+try {
+while (completed < stepCount) {
+int code = data.readInt();
+int argumentCount = data.readInt();
+if (!isChainableTransaction(code) || argumentCount < 0) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+android.os.Parcel stepData = android.os.Parcel.obtain();
+android.os.Parcel result = android.os.Parcel.obtain();
+results[completed] = result;
+try {
+stepData.writeInterfaceToken(DESCRIPTOR);
+for (int i = 0; i < argumentCount; i++) {
+int source = data.readInt();
+if (source >= 0) {
+if (source >= completed) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+stepData.appendFrom(results[source], resultStarts[source], results[source].dataSize() - resultStarts[source]);
+continue;
+}
+int size = data.readInt();
+int start = data.dataPosition();
+if (size < 0 || size > data.dataAvail()) {
+throw new java.lang.IllegalArgumentException("malformed call chain");
+}
+stepData.appendFrom(data, start, size);
+data.setDataPosition(start + size);
+}
+stepData.setDataPosition(0);
+try {
+if (!this.onTransact(code, stepData, result, 0)) {
+throw new java.lang.IllegalArgumentException("unknown call in call chain");
+}
+}
+catch (java.lang.RuntimeException e) {
+result.setDataSize(0);
+result.writeException(e);
+}
+}
+finally {
+stepData.recycle();
+}
+completed++;
+result.setDataPosition(0);
+int exceptionCode = result.readExceptionCode();
+resultStarts[completed - 1] = result.dataPosition();
+if (exceptionCode != 0) {
+break;
+}
+}
+reply.writeNoException();
+reply.writeInt(completed);
+for (int i = 0; i < completed; i++) {
+reply.writeInt(results[i].dataSize());
+reply.appendFrom(results[i], 0, results[i].dataSize());
+}
+}
+finally {
+for (android.os.Parcel result : results) {
+if (result != null) {
+result.recycle();
+}
+}
+}
+}
+)";
+
+static const char kCallChainArgumentTypes[] =
+    R"(/**
+ * An argument to a chained call: either a value, which is written out
+ * when the call is added to the chain, or the Result of an earlier call.
+ */
+public static class Arg<T>
+{
+T value;
+int step = -1;
+public static <T> Arg<T> of(T value)
+{
+Arg<T> arg = new Arg<T>();
+arg.value = value;
+return arg;
+}
+}
+/** The result of a chained call, available once the chain has run. */
+public static final class Result<T> extends Arg<T>
+{
+private boolean mDone = false;
+public T get()
+{
+if (!mDone) {
+throw new java.lang.IllegalStateException("call chain has not run yet");
+}
+return value;
+}
+@SuppressWarnings("unchecked")
+void set(java.lang.Object value)
+{
+this.value = (T) value;
+mDone = true;
+}
+}
+private android.os.Parcel mData = android.os.Parcel.obtain();
+private final java.util.ArrayList<java.lang.Integer> mCodes = new java.util.ArrayList<java.lang.Integer>();
+private final java.util.ArrayList<Result<?>> mResults = new java.util.ArrayList<Result<?>>();
+private <T> Result<T> beginStep(int code, int argumentCount)
+{
+if (mData == null) {
+throw new java.lang.IllegalStateException("call chain has already run");
+}
+Result<T> result = new Result<T>();
+result.step = mResults.size();
+mCodes.add(code);
+mResults.add(result);
+mData.writeInt(code);
+mData.writeInt(argumentCount);
+return result;
+}
+private int mSizePosition;
+// Returns true if the caller should write out the argument's value.
+private boolean beginArgument(Arg<?> arg)
+{
+if (arg.step >= 0) {
+if (arg.step + 1 >= mResults.size()) {
+throw new java.lang.IllegalArgumentException("result is not from an earlier call in this chain");
+}
+mData.writeInt(arg.step);
+return false;
+}
+mData.writeInt(-1);
+mSizePosition = mData.dataPosition();
+mData.writeInt(0);
+return true;
+}
+private void endArgument()
+{
+int end = mData.dataPosition();
+mData.setDataPosition(mSizePosition);
+mData.writeInt(end - mSizePosition - 4);
+mData.setDataPosition(end);
+}
+)";
+
+// Chained builders are generic over their arguments, so primitives have to
+// be boxed.
+static string boxed_java_type(const AidlType& type) {
+  const string java_type = type.GetLanguageType<Type>()->JavaType();
+  if (type.IsArray()) {
+    return java_type + "[]";
+  }
+  static const char* const kBoxed[][2] = {
+      {"boolean", "java.lang.Boolean"}, {"byte", "java.lang.Byte"},
+      {"char", "java.lang.Character"},  {"int", "java.lang.Integer"},
+      {"long", "java.lang.Long"},       {"float", "java.lang.Float"},
+      {"double", "java.lang.Double"},
+  };
+  for (const auto& boxed : kBoxed) {
+    if (java_type == boxed[0]) {
+      return boxed[1];
+    }
+  }
+  return java_type;
+}
+
+class CallChainClass : public Class {
+ public:
+  CallChainClass(JavaTypeNamespace* types, const InterfaceType* interfaceType);
+  virtual ~CallChainClass() = default;
+
+  void AddMethod(const AidlMethod& method, JavaTypeNamespace* types);
+
+  Variable* mData;
+  SwitchStatement* result_switch;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CallChainClass);
+};
+
+CallChainClass::CallChainClass(JavaTypeNamespace* types,
+                               const InterfaceType* interfaceType)
+    : Class() {
+  this->comment =
+      "/**\n"
+      " * Collects calls to make with a single transaction.  Calls may take\n"
+      " * the results of earlier calls in the chain as arguments, without\n"
+      " * those results making a round trip through the caller.\n"
+      " */";
+  this->modifiers = PUBLIC | STATIC;
+  this->what = Class::CLASS;
+  this->type = new Type(types, interfaceType->JavaType() + ".CallChain",
+                        ValidatableType::KIND_GENERATED, false, false);
+  this->elements.push_back(new LiteralClassElement(kCallChainArgumentTypes));
+
+  mData = new Variable(types->ParcelType(), "mData");
+
+  // void transact(IFoo service)
+  Variable* service = new Variable(interfaceType, "service");
+  Method* transact = new Method;
+  transact->comment =
+      "/**\n"
+      " * Makes the calls added so far.  The first call to fail stops the\n"
+      " * chain, and its exception is thrown here.\n"
+      " */";
+  transact->modifiers = PUBLIC;
+  transact->returnType = types->VoidType();
+  transact->name = "transact";
+  transact->parameters.push_back(service);
+  transact->exceptions.push_back(types->RemoteExceptionType());
+  transact->statements = new StatementBlock;
+  this->elements.push_back(transact);
+
+  StatementBlock* b = transact->statements;
+  IfStatement* used = new IfStatement();
+  used->expression = new Comparison(mData, "==", NULL_VALUE);
+  used->statements->Add(new LiteralExpression(
+      "throw new java.lang.IllegalStateException("
+      "\"call chain has already run\")"));
+  b->Add(used);
+  Variable* _data = new Variable(types->ParcelType(), "_data");
+  b->Add(new VariableDeclaration(
+      _data, new MethodCall(types->ParcelType(), "obtain")));
+  Variable* _reply = new Variable(types->ParcelType(), "_reply");
+  b->Add(new VariableDeclaration(
+      _reply, new MethodCall(types->ParcelType(), "obtain")));
+  TryStatement* tryStatement = new TryStatement();
+  b->Add(tryStatement);
+  FinallyStatement* finallyStatement = new FinallyStatement();
+  b->Add(finallyStatement);
+
+  StatementBlock* t = tryStatement->statements;
+  t->Add(new MethodCall(_data, "writeInterfaceToken", 1,
+                        new LiteralExpression("Stub.DESCRIPTOR")));
+  t->Add(new MethodCall(_data, "writeInt", 1,
+                        new LiteralExpression("mResults.size()")));
+  t->Add(new MethodCall(_data, "appendFrom", 3, mData,
+                        new LiteralExpression("0"),
+                        new MethodCall(mData, "dataSize")));
+  t->Add(new MethodCall(new MethodCall(service, "asBinder"), "transact", 4,
+                        new LiteralExpression("Stub.TRANSACTION_CALL_CHAIN"),
+                        _data, _reply, new LiteralExpression("0")));
+  t->Add(new MethodCall(_reply, "readException"));
+  Variable* completed = new Variable(types->IntType(), "_completed");
+  t->Add(new VariableDeclaration(completed,
+                                 new MethodCall(_reply, "readInt")));
+  IfStatement* countCheck = new IfStatement();
+  countCheck->expression =
+      new LiteralExpression("_completed < 0 || _completed > mResults.size()");
+  countCheck->statements->Add(new LiteralExpression(
+      "throw new android.os.RemoteException(\"malformed call chain reply\")"));
+  t->Add(countCheck);
+
+  // Each step's reply is exactly what the call would have replied on its own.
+  Variable* stepReply = new Variable(types->ParcelType(), "_stepReply");
+  t->Add(new VariableDeclaration(
+      stepReply, new MethodCall(types->ParcelType(), "obtain")));
+  TryStatement* stepTry = new TryStatement();
+  t->Add(stepTry);
+  FinallyStatement* stepFinally = new FinallyStatement();
+  t->Add(stepFinally);
+  stepFinally->statements->Add(new MethodCall(stepReply, "recycle"));
+  ForStatement* loop = new ForStatement(new Variable(types->IntType(), "i"),
+                                        new LiteralExpression("0"), completed);
+  stepTry->statements->Add(loop);
+  StatementBlock* body = loop->statements;
+  Variable* size = new Variable(types->IntType(), "_size");
+  body->Add(new VariableDeclaration(size, new MethodCall(_reply, "readInt")));
+  Variable* start = new Variable(types->IntType(), "_start");
+  body->Add(new VariableDeclaration(start,
+                                    new MethodCall(_reply, "dataPosition")));
+  IfStatement* sizeCheck = new IfStatement();
+  sizeCheck->expression =
+      new LiteralExpression("_size < 0 || _size > _reply.dataAvail()");
+  sizeCheck->statements->Add(new LiteralExpression(
+      "throw new android.os.RemoteException(\"malformed call chain reply\")"));
+  body->Add(sizeCheck);
+  body->Add(new MethodCall(stepReply, "setDataSize", 1,
+                           new LiteralExpression("0")));
+  body->Add(new MethodCall(stepReply, "appendFrom", 3, _reply, start, size));
+  body->Add(new MethodCall(_reply, "setDataPosition", 1,
+                           new LiteralExpression("_start + _size")));
+  body->Add(new MethodCall(stepReply, "setDataPosition", 1,
+                           new LiteralExpression("0")));
+  body->Add(new MethodCall(stepReply, "readException"));
+  body->Add(new MethodCall(THIS_VALUE, "readResult", 3,
+                           new LiteralExpression("mCodes.get(i)"), stepReply,
+                           new LiteralExpression("mResults.get(i)")));
+  // The service only stops early after a call that fails.
+  IfStatement* completionCheck = new IfStatement();
+  completionCheck->expression =
+      new LiteralExpression("_completed != mResults.size()");
+  completionCheck->statements->Add(new LiteralExpression(
+      "throw new android.os.RemoteException(\"malformed call chain reply\")"));
+  t->Add(completionCheck);
+
+  finallyStatement->statements->Add(new MethodCall(_reply, "recycle"));
+  finallyStatement->statements->Add(new MethodCall(_data, "recycle"));
+  finallyStatement->statements->Add(new MethodCall(mData, "recycle"));
+  finallyStatement->statements->Add(new Assignment(mData, NULL_VALUE));
+
+  // private void readResult(int code, Parcel reply, Result<?> result)
+  Variable* code = new Variable(types->IntType(), "code");
+  Variable* reply = new Variable(types->ParcelType(), "reply");
+  Variable* result = new Variable(
+      new Type(types, "Result<?>", ValidatableType::KIND_BUILT_IN, false,
+               false),
+      "result");
+  Method* readResult = new Method;
+  readResult->modifiers = PRIVATE;
+  readResult->returnType = types->VoidType();
+  readResult->name = "readResult";
+  readResult->parameters.push_back(code);
+  readResult->parameters.push_back(reply);
+  readResult->parameters.push_back(result);
+  readResult->statements = new StatementBlock;
+  result_switch = new SwitchStatement(code);
+  readResult->statements->Add(result_switch);
+  this->elements.push_back(readResult);
+}
+
+void CallChainClass::AddMethod(const AidlMethod& method,
+                               JavaTypeNamespace* types) {
+  const string transactCodeName = "Stub.TRANSACTION_" + method.GetName();
+  const bool hasResult = method.GetType().GetName() != "void";
+  const Type* resultType = types->VoidType();
+  if (hasResult) {
+    resultType = new Type(types,
+                          "Result<" + boxed_java_type(method.GetType()) + ">",
+                          ValidatableType::KIND_BUILT_IN, false, false);
+  }
+
+  Method* m = new Method;
+  m->comment = method.GetComments();
+  m->modifiers = PUBLIC;
+  m->returnType = resultType;
+  m->name = method.GetName();
+  m->statements = new StatementBlock;
+
+  Variable* _result = nullptr;
+  MethodCall* beginStep = new MethodCall(
+      THIS_VALUE, "beginStep", 2, new LiteralExpression(transactCodeName),
+      new LiteralExpression(std::to_string(method.GetInArguments().size())));
+  if (hasResult) {
+    _result = new Variable(resultType, "_result");
+    m->statements->Add(new VariableDeclaration(_result, beginStep));
+  } else {
+    m->statements->Add(beginStep);
+  }
+
+  for (const AidlArgument* arg : method.GetInArguments()) {
+    const Type* t = arg->GetType().GetLanguageType<Type>();
+    Variable* a = new Variable(
+        new Type(types, "Arg<" + boxed_java_type(arg->GetType()) + ">",
+                 ValidatableType::KIND_BUILT_IN, false, false),
+        arg->GetName());
+    m->parameters.push_back(a);
+
+    IfStatement* hasValue = new IfStatement();
+    hasValue->expression = new MethodCall(THIS_VALUE, "beginArgument", 1, a);
+    Variable* v = new Variable(t, "_" + arg->GetName(),
+                               arg->GetType().IsArray() ? 1 : 0);
+    hasValue->statements->Add(
+        new VariableDeclaration(v, new FieldVariable(a, "value")));
+    generate_write_to_parcel(t, hasValue->statements, v, mData, 0);
+    hasValue->statements->Add(new MethodCall(THIS_VALUE, "endArgument"));
+    m->statements->Add(hasValue);
+  }
+
+  if (_result != nullptr) {
+    m->statements->Add(new ReturnStatement(_result));
+  }
+  this->elements.push_back(m);
+
+  if (!hasResult) {
+    return;
+  }
+  Variable* cl = nullptr;
+  Case* c = new Case(transactCodeName);
+  Variable* value = new Variable(method.GetType().GetLanguageType<Type>(),
+                                 "_value", method.GetType().IsArray() ? 1 : 0);
+  c->statements->Add(new VariableDeclaration(value));
+  generate_create_from_parcel(value->type, c->statements, value,
+                              new Variable(types->ParcelType(), "reply"), &cl);
+  c->statements->Add(new MethodCall(new LiteralExpression("result"), "set", 1,
+                                    value));
+  c->statements->Add(new Break());
+  result_switch->cases.push_back(c);
+}
+
+static Type* trace_context_type(JavaTypeNamespace* types) {
+  return new Type(types, "android.aidl.runtime", "TraceContext",
+                  ValidatableType::KIND_BUILT_IN, false, false);
+}
+
 static void generate_constant(const AidlConstant& constant, Class* interface) {
   Constant* decl = new Constant;
   decl->name = constant.GetName();
-  decl->value = constant.GetValue();
+  decl->value = constant.GetValueText();
+  switch (constant.GetType()) {
+    case AidlConstant::INT:
+      break;
+    case AidlConstant::LONG:
+      decl->type = "long";
+      decl->value += "L";
+      break;
+    case AidlConstant::FLOAT:
+      decl->type = "float";
+      decl->value += "f";
+      break;
+    case AidlConstant::DOUBLE:
+      decl->type = "double";
+      break;
+    case AidlConstant::BOOLEAN:
+      decl->type = "boolean";
+      break;
+    case AidlConstant::STRING:
+      decl->type = "java.lang.String";
+      decl->value = "\"" + decl->value + "\"";
+      break;
+  }
 
   interface->elements.push_back(decl);
 }
 
+// Enums are a holder class of constants in the backing type.  Values read
+// from a parcel go through checked(), which for contiguous enumerators costs
+// one unsigned compare (Java has none, so both sides are offset by
+// Long.MIN_VALUE).
+static void generate_enum(const AidlEnum& e, Class* interface) {
+  const string& type = e.GetBackingType();
+  const string& name = e.GetName();
+  const char* suffix = (type == "long") ? "L" : "";
+
+  string holder = "public static final class " + name + "\n{\n";
+  for (const auto& enumerator : e.GetEnumerators()) {
+    holder += "public static final " + type + " " + enumerator.name + " = " +
+              std::to_string(enumerator.value) + suffix + ";\n";
+  }
+  holder += "private " + name + "() {}\n";
+
+  string check;
+  if (e.IsContiguous()) {
+    const string& min = e.GetMin().name;
+    const string& max = e.GetMax().name;
+    if (e.GetMin().value == 0) {
+      check = "value + Long.MIN_VALUE <= " + max + " + Long.MIN_VALUE";
+    } else {
+      check = "value - " + min + " + Long.MIN_VALUE <= " + max + " - " + min +
+              " + Long.MIN_VALUE";
+    }
+  } else {
+    std::set<int64_t> seen;
+    for (const auto& enumerator : e.GetEnumerators()) {
+      if (!seen.insert(enumerator.value).second) { continue; }
+      if (!check.empty()) { check += " || "; }
+      check += "value == " + enumerator.name;
+    }
+  }
+  holder += "public static boolean isValid(long value)\n{\n"
+            "return " + check + ";\n}\n";
+  holder += "public static " + type + " checked(" + type + " value)\n{\n"
+            "if (!isValid(value)) {\n"
+            "throw new IllegalArgumentException(\"Bad " + name +
+            " value \" + value);\n}\nreturn value;\n}\n";
+  holder += "public static " + type + "[] checked(" + type + "[] values)\n{\n"
+            "if (values != null) {\n"
+            "for (" + type + " value : values) {\nchecked(value);\n}\n}\n"
+            "return values;\n}\n";
+  holder += "}\n";
+
+  interface->elements.push_back(new LiteralClassElement(holder));
+}
+
+// Proxy methods on top of AidlProxy leave obtaining, sending and recycling
+// the request to the base class.
+static void generate_shared_runtime_proxy_method(const AidlMethod& method,
+                                                 Method* proxy,
+                                                 const string& transactCodeName,
+                                                 bool oneway,
+                                                 bool traceContext,
+                                                 JavaTypeNamespace* types) {
+  Variable* _data = new Variable(types->ParcelType(), "_data");
+  proxy->statements->Add(new VariableDeclaration(
+      _data, new MethodCall(THIS_VALUE, "obtainRequest")));
+
+  // call() and callOneway() only recycle the request once they have it, so
+  // recycle it here if writing an argument throws.
+  TryStatement* writeTry = new TryStatement();
+  StatementBlock* writes = writeTry->statements;
+  if (traceContext) {
+    writes->Add(
+        new MethodCall(trace_context_type(types), "writeCurrent", 1, _data));
+  }
+  if (method.HasSkippableArguments()) {
+    writes->Add(
+        new MethodCall(_data, "writeInt", 1, out_mask_expression(method)));
+  }
+
+  // the parameters
+  for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
+    const Type* t = arg->GetType().GetLanguageType<Type>();
+    Variable* v =
+        new Variable(t, arg->GetName(), arg->GetType().IsArray() ? 1 : 0);
+    AidlArgument::Direction dir = arg->GetDirection();
+    if (dir == AidlArgument::OUT_DIR && arg->GetType().IsArray()) {
+      IfStatement* checklen = new IfStatement();
+      checklen->expression = new Comparison(v, "==", NULL_VALUE);
+      checklen->statements->Add(
+          new MethodCall(_data, "writeInt", 1, new LiteralExpression("-1")));
+      checklen->elseif = new IfStatement();
+      checklen->elseif->statements->Add(
+          new MethodCall(_data, "writeInt", 1, new FieldVariable(v, "length")));
+      writes->Add(checklen);
+    } else if (dir & AidlArgument::IN_DIR) {
+      generate_write_to_parcel(t, writes, v, _data, 0);
+    }
+  }
+  if (!writes->statements.empty()) {
+    Variable* _written = new Variable(types->BoolType(), "_written");
+    proxy->statements->Add(new VariableDeclaration(_written, FALSE_VALUE));
+    writes->Add(new Assignment(_written, TRUE_VALUE));
+    proxy->statements->Add(writeTry);
+    FinallyStatement* recycle = new FinallyStatement();
+    IfStatement* failed = new IfStatement();
+    failed->expression = new LiteralExpression("!_written");
+    failed->statements->Add(new MethodCall(_data, "recycle"));
+    recycle->statements->Add(failed);
+    proxy->statements->Add(recycle);
+  }
+
+  Expression* code = new LiteralExpression("Stub." + transactCodeName);
+  if (oneway) {
+    proxy->statements->Add(
+        new MethodCall(THIS_VALUE, "callOneway", 2, code, _data));
+    return;
+  }
+
+  MethodCall* call = new MethodCall(THIS_VALUE, "call", 2, code, _data);
+  const bool hasResult = method.GetType().GetName() != "void";
+  if (!hasResult && method.GetOutArguments().empty()) {
+    proxy->statements->Add(new MethodCall(call, "recycle"));
+    return;
+  }
+
+  Variable* _reply = new Variable(types->ParcelType(), "_reply");
+  proxy->statements->Add(new VariableDeclaration(_reply, call));
+  TryStatement* tryStatement = new TryStatement();
+  proxy->statements->Add(tryStatement);
+  FinallyStatement* finallyStatement = new FinallyStatement();
+  proxy->statements->Add(finallyStatement);
+
+  Variable* cl = NULL;
+  Variable* _result = NULL;
+  if (hasResult) {
+    _result = new Variable(proxy->returnType, "_result",
+                           method.GetType().IsArray() ? 1 : 0);
+    tryStatement->statements->Add(new VariableDeclaration(_result));
+    generate_create_from_parcel(proxy->returnType, tryStatement->statements,
+                                _result, _reply, &cl);
+  }
+
+  // the out/inout parameters
+  for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
+    const Type* t = arg->GetType().GetLanguageType<Type>();
+    Variable* v =
+        new Variable(t, arg->GetName(), arg->GetType().IsArray() ? 1 : 0);
+    if (arg->GetDirection() & AidlArgument::OUT_DIR) {
+      generate_read_out_from_parcel(*arg, tryStatement->statements, v, _reply,
+                                    &cl);
+    }
+  }
+
+  if (_result != NULL) {
+    tryStatement->statements->Add(new ReturnStatement(_result));
+  }
+  finallyStatement->statements->Add(new MethodCall(_reply, "recycle"));
+}
+
 static void generate_method(const AidlMethod& method, Class* interface,
                             StubClass* stubClass, ProxyClass* proxyClass,
                             int index, JavaTypeNamespace* types) {
@@ -296,6 +1332,16 @@ static void generate_method(const AidlMethod& method, Class* interface,
 
   decl->exceptions.push_back(types->RemoteExceptionType());
 
+  vector<string> reused;
+  for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
+    if (arg->GetType().IsReuse()) {
+      reused.push_back(arg->GetName());
+    }
+  }
+  if (!reused.empty()) {
+    decl->comment = add_reuse_contract(decl->comment, reused);
+  }
+
   interface->elements.push_back(decl);
 
   // == the stub method ====================================================
@@ -309,9 +1355,30 @@ static void generate_method(const AidlMethod& method, Class* interface,
                                     "enforceInterface", 1,
                                     new LiteralExpression("DESCRIPTOR")));
 
+  // the call runs in a child span of the caller's, until the case returns
+  Variable* _trace = NULL;
+  size_t tracedFrom = 0;
+  if (stubClass->traceContext) {
+    _trace = new Variable(trace_context_type(types), "_aidl_trace");
+    c->statements->Add(new VariableDeclaration(
+        _trace, new MethodCall(_trace->type, "enterFrom", 1,
+                               stubClass->transact_data)));
+    tracedFrom = c->statements->statements.size();
+  }
+
+  // the @skippable out parameters the caller wants back
+  Variable* _outMask = NULL;
+  if (method.HasSkippableArguments()) {
+    _outMask = new Variable(types->IntType(), "_aidl_out_mask");
+    c->statements->Add(new VariableDeclaration(
+        _outMask, new MethodCall(stubClass->transact_data, "readInt")));
+  }
+
   // args
   Variable* cl = NULL;
   VariableFactory stubArgs("_arg");
+  // Per thread instances of the @reuse arguments, and where they go.
+  vector<std::pair<Variable*, Variable*>> reusedArgs;
   for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
     const Type* t = arg->GetType().GetLanguageType<Type>();
     Variable* v = stubArgs.Get(t);
@@ -319,11 +1386,29 @@ static void generate_method(const AidlMethod& method, Class* interface,
 
     c->statements->Add(new VariableDeclaration(v));
 
-    if (arg->GetDirection() & AidlArgument::IN_DIR) {
+    if (arg->GetType().IsReuse()) {
+      const string threadLocal = "java.lang.ThreadLocal<" + t->JavaType() + ">";
+      Variable* cache = new Variable(
+          new Type(types, threadLocal, ValidatableType::KIND_BUILT_IN, false,
+                   false),
+          "sReused_" + method.GetName() + "_" + arg->GetName());
+      Field* cacheField = new Field(PRIVATE | STATIC | FINAL, cache);
+      cacheField->value = "new " + threadLocal + "()";
+      stubClass->elements.push_back(cacheField);
+      generate_reused_from_parcel(t, c->statements, v,
+                                  stubClass->transact_data, cache,
+                                  arg->GetType().IsNonNull());
+      reusedArgs.emplace_back(cache, v);
+    } else if (arg->GetDirection() & AidlArgument::IN_DIR) {
       generate_create_from_parcel(t, c->statements, v, stubClass->transact_data,
                                   &cl);
     } else {
-      if (!arg->GetType().IsArray()) {
+      if (arg->GetType().IsSkippable() && !arg->GetType().IsArray()) {
+        // null tells the implementation it need not fill this one in
+        c->statements->Add(new Assignment(
+            v, new Ternary(out_wanted_expression(method, *arg, _outMask),
+                           new NewExpression(v->type), NULL_VALUE)));
+      } else if (!arg->GetType().IsArray()) {
         c->statements->Add(new Assignment(v, new NewExpression(v->type)));
       } else {
         generate_new_array(v->type, c->statements, v, stubClass->transact_data,
@@ -363,6 +1448,15 @@ static void generate_method(const AidlMethod& method, Class* interface,
                              Type::PARCELABLE_WRITE_RETURN_VALUE);
   }
 
+  // hand the @reuse arguments back for the next call on this thread
+  for (const auto& reusedArg : reusedArgs) {
+    IfStatement* keep = new IfStatement();
+    keep->expression = new Comparison(reusedArg.second, "!=", NULL_VALUE);
+    keep->statements->Add(
+        new MethodCall(reusedArg.first, "set", 1, reusedArg.second));
+    c->statements->Add(keep);
+  }
+
   // out parameters
   i = 0;
   for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
@@ -370,7 +1464,14 @@ static void generate_method(const AidlMethod& method, Class* interface,
     Variable* v = stubArgs.Get(i++);
 
     if (arg->GetDirection() & AidlArgument::OUT_DIR) {
-      generate_write_to_parcel(t, c->statements, v, stubClass->transact_reply,
+      StatementBlock* write = c->statements;
+      if (arg->GetType().IsSkippable()) {
+        IfStatement* wanted = new IfStatement();
+        wanted->expression = out_wanted_expression(method, *arg, _outMask);
+        c->statements->Add(wanted);
+        write = wanted->statements;
+      }
+      generate_write_to_parcel(t, write, v, stubClass->transact_reply,
                                Type::PARCELABLE_WRITE_RETURN_VALUE);
       hasOutParams = true;
     }
@@ -378,6 +1479,18 @@ static void generate_method(const AidlMethod& method, Class* interface,
 
   // return true
   c->statements->Add(new ReturnStatement(TRUE_VALUE));
+  if (_trace != NULL) {
+    vector<Statement*>& statements = c->statements->statements;
+    TryStatement* traced = new TryStatement();
+    traced->statements->statements.assign(statements.begin() + tracedFrom,
+                                          statements.end());
+    statements.erase(statements.begin() + tracedFrom, statements.end());
+    c->statements->Add(traced);
+    FinallyStatement* restore = new FinallyStatement();
+    restore->statements->Add(
+        new MethodCall(_trace->type, "restore", 1, _trace));
+    c->statements->Add(restore);
+  }
   stubClass->transact_switch->cases.push_back(c);
 
   // == the proxy method ===================================================
@@ -396,15 +1509,45 @@ static void generate_method(const AidlMethod& method, Class* interface,
   proxy->exceptions.push_back(types->RemoteExceptionType());
   proxyClass->elements.push_back(proxy);
 
+  generate_non_null_checks(method, proxy->statements);
+
+  if (proxyClass->sharedRuntime) {
+    generate_shared_runtime_proxy_method(method, proxy, transactCodeName,
+                                         oneway, proxyClass->traceContext,
+                                         types);
+    return;
+  }
+
   // the parcels
+  Variable* _parcels = NULL;
+  Variable* _nested = NULL;
+  if (proxyClass->threadLocalParcels) {
+    _parcels = new Variable(
+        new Type(types, "ThreadParcels", ValidatableType::KIND_BUILT_IN, false,
+                 false),
+        "_parcels");
+    proxy->statements->Add(new VariableDeclaration(
+        _parcels, new LiteralExpression("sThreadParcels.get()")));
+    _nested = new Variable(types->BoolType(), "_nested");
+    proxy->statements->Add(new VariableDeclaration(
+        _nested, new LiteralExpression("(_parcels.depth++ != 0)")));
+  }
   Variable* _data = new Variable(types->ParcelType(), "_data");
-  proxy->statements->Add(new VariableDeclaration(
-      _data, new MethodCall(types->ParcelType(), "obtain")));
+  Expression* obtainData = new MethodCall(types->ParcelType(), "obtain");
+  if (_parcels != NULL) {
+    obtainData = new Ternary(_nested, obtainData,
+                             new FieldVariable(_parcels, "data"));
+  }
+  proxy->statements->Add(new VariableDeclaration(_data, obtainData));
   Variable* _reply = NULL;
   if (!oneway) {
     _reply = new Variable(types->ParcelType(), "_reply");
-    proxy->statements->Add(new VariableDeclaration(
-        _reply, new MethodCall(types->ParcelType(), "obtain")));
+    Expression* obtainReply = new MethodCall(types->ParcelType(), "obtain");
+    if (_parcels != NULL) {
+      obtainReply = new Ternary(_nested, obtainReply,
+                                new FieldVariable(_parcels, "reply"));
+    }
+    proxy->statements->Add(new VariableDeclaration(_reply, obtainReply));
   }
 
   // the return value
@@ -425,6 +1568,14 @@ static void generate_method(const AidlMethod& method, Class* interface,
   // string
   tryStatement->statements->Add(new MethodCall(
       _data, "writeInterfaceToken", 1, new LiteralExpression("DESCRIPTOR")));
+  if (proxyClass->traceContext) {
+    tryStatement->statements->Add(
+        new MethodCall(trace_context_type(types), "writeCurrent", 1, _data));
+  }
+  if (method.HasSkippableArguments()) {
+    tryStatement->statements->Add(
+        new MethodCall(_data, "writeInt", 1, out_mask_expression(method)));
+  }
 
   // the parameters
   for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
@@ -473,21 +1624,162 @@ static void generate_method(const AidlMethod& method, Class* interface,
       Variable* v =
           new Variable(t, arg->GetName(), arg->GetType().IsArray() ? 1 : 0);
       if (arg->GetDirection() & AidlArgument::OUT_DIR) {
-        generate_read_from_parcel(t, tryStatement->statements, v, _reply, &cl);
+        generate_read_out_from_parcel(*arg, tryStatement->statements, v,
+                                      _reply, &cl);
       }
     }
-
-    finallyStatement->statements->Add(new MethodCall(_reply, "recycle"));
   }
-  finallyStatement->statements->Add(new MethodCall(_data, "recycle"));
+  if (_parcels != NULL) {
+    finallyStatement->statements->Add(new MethodCall(
+        "releaseThreadParcels", 3, _parcels, _data,
+        _reply ? _reply : NULL_VALUE));
+  } else {
+    if (_reply != NULL) {
+      finallyStatement->statements->Add(new MethodCall(_reply, "recycle"));
+    }
+    finallyStatement->statements->Add(new MethodCall(_data, "recycle"));
+  }
 
   if (_result != NULL) {
     proxy->statements->Add(new ReturnStatement(_result));
   }
 }
 
+static const char* default_java_value(const AidlType& type) {
+  if (type.IsArray()) {
+    return "null";
+  }
+  const string& name = type.GetName();
+  if (name == "boolean") {
+    return "false";
+  }
+  if (name == "byte" || name == "char" || name == "int" || name == "long" ||
+      name == "float" || name == "double") {
+    return "0";
+  }
+  return "null";
+}
+
+static void generate_router_method(const AidlMethod& method,
+                                   RouterClass* router,
+                                   JavaTypeNamespace* types) {
+  const Type* returnType = method.GetType().GetLanguageType<Type>();
+  const bool hasResult = method.GetType().GetName() != "void";
+  const int returnDimension = method.GetType().IsArray() ? 1 : 0;
+
+  Method* m = new Method;
+  m->modifiers = PUBLIC | OVERRIDE;
+  m->returnType = returnType;
+  m->returnTypeDimension = returnDimension;
+  m->name = method.GetName();
+  m->statements = new StatementBlock;
+  m->exceptions.push_back(types->RemoteExceptionType());
+
+  // Like the C++ router, one without shards fails every call.
+  IfStatement* noShards = new IfStatement();
+  noShards->expression =
+      new Comparison(new FieldVariable(router->mShards, "length"), "==",
+                     new LiteralExpression("0"));
+  noShards->statements->Add(new LiteralExpression(
+      "throw new java.lang.IllegalStateException(\"no shards\")"));
+  m->statements->Add(noShards);
+
+  Variable* shard = new Variable(types->IntType(), "_shard");
+  MethodCall* shardCall = new MethodCall(
+      new LiteralExpression(router->mShards->name + "[_shard]"),
+      method.GetName());
+  for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
+    Variable* v =
+        new Variable(arg->GetType().GetLanguageType<Type>(), arg->GetName(),
+                     arg->GetType().IsArray() ? 1 : 0);
+    m->parameters.push_back(v);
+    shardCall->arguments.push_back(v);
+  }
+
+  // Every call is counted against its shard, and failures also count as
+  // errors before they are passed on to the caller.
+  StatementBlock* body;
+  const AidlArgument* key = method.GetShardKeyArgument();
+  Variable* _result = nullptr;
+  if (key != nullptr) {
+    const string& keyType = key->GetType().GetName();
+    if (keyType != "int" && keyType != "long") {
+      // A C++ service would fail a null String with EX_NULL_POINTER.
+      IfStatement* nullKey = new IfStatement();
+      nullKey->expression = new Comparison(
+          new LiteralExpression(key->GetName()), "==", NULL_VALUE);
+      nullKey->statements->Add(new LiteralExpression(
+          "throw new java.lang.NullPointerException(\"" + key->GetName() +
+          " is null\")"));
+      m->statements->Add(nullKey);
+    }
+    m->statements->Add(new VariableDeclaration(
+        shard, new LiteralExpression("shardIndex(hashShardKey(" +
+                                     key->GetName() + "))")));
+    body = m->statements;
+  } else {
+    if (hasResult) {
+      _result = new Variable(returnType, "_result", returnDimension);
+      m->statements->Add(new VariableDeclaration(
+          _result,
+          new LiteralExpression(default_java_value(method.GetType()))));
+    }
+    // Calls without a key are broadcast to every shard in order.  Only the
+    // first shard's return value is kept.
+    ForStatement* loop = new ForStatement(
+        shard, new LiteralExpression("0"),
+        new FieldVariable(router->mShards, "length"));
+    m->statements->Add(loop);
+    body = loop->statements;
+  }
+
+  body->Add(new MethodCall(router->mCalls, "incrementAndGet", 1, shard));
+  TryStatement* tryStatement = new TryStatement();
+  if (key != nullptr) {
+    if (hasResult) {
+      tryStatement->statements->Add(new ReturnStatement(shardCall));
+    } else {
+      tryStatement->statements->Add(shardCall);
+    }
+  } else if (hasResult) {
+    Variable* shardResult =
+        new Variable(returnType, "_shardResult", returnDimension);
+    tryStatement->statements->Add(
+        new VariableDeclaration(shardResult, shardCall));
+    IfStatement* first = new IfStatement();
+    first->expression =
+        new Comparison(shard, "==", new LiteralExpression("0"));
+    first->statements->Add(new Assignment(_result, shardResult));
+    tryStatement->statements->Add(first);
+  } else {
+    tryStatement->statements->Add(shardCall);
+  }
+  body->Add(tryStatement);
+
+  for (const Type* exceptionType :
+       {types->RemoteExceptionType(), types->RuntimeExceptionType()}) {
+    CatchStatement* catchStatement =
+        new CatchStatement(new Variable(exceptionType, "e"));
+    catchStatement->statements->Add(
+        new MethodCall(router->mErrors, "incrementAndGet", 1, shard));
+    catchStatement->statements->Add(new LiteralExpression("throw e"));
+    body->Add(catchStatement);
+  }
+
+  if (_result != nullptr) {
+    m->statements->Add(new ReturnStatement(_result));
+  }
+
+  router->elements.push_back(m);
+}
+
 static void generate_interface_descriptors(StubClass* stub, ProxyClass* proxy,
                                            const JavaTypeNamespace* types) {
+  // AidlStub and AidlProxy take care of these.
+  if (stub->sharedRuntime) {
+    return;
+  }
+
   // the interface descriptor transaction handler
   Case* c = new Case("INTERFACE_TRANSACTION");
   c->statements->Add(new MethodCall(stub->transact_reply, "writeString", 1,
@@ -507,8 +1799,52 @@ static void generate_interface_descriptors(StubClass* stub, ProxyClass* proxy,
   proxy->elements.push_back(getDesc);
 }
 
+static void generate_call_chain_stub(const AidlInterface& iface,
+                                     StubClass* stub,
+                                     const JavaTypeNamespace* types) {
+  Field* transactCode =
+      new Field(STATIC | FINAL,
+                new Variable(types->IntType(), "TRANSACTION_CALL_CHAIN"));
+  transactCode->value = "android.os.IBinder.LAST_CALL_TRANSACTION";
+  stub->elements.push_back(transactCode);
+
+  Case* c = new Case("TRANSACTION_CALL_CHAIN");
+  c->statements->Add(new MethodCall(stub->transact_data, "enforceInterface",
+                                    1, new LiteralExpression("DESCRIPTOR")));
+  c->statements->Add(new MethodCall(THIS_VALUE, "runCallChain", 2,
+                                    stub->transact_data,
+                                    stub->transact_reply));
+  c->statements->Add(new ReturnStatement(TRUE_VALUE));
+  stub->transact_switch->cases.push_back(c);
+
+  stub->elements.push_back(new LiteralClassElement(kRunCallChainMethod));
+
+  // Only methods a chain could have been built from can be its steps, which
+  // keeps out the chain call itself and the meta transactions.
+  string isChainable =
+      "private static boolean isChainableTransaction(int code)\n"
+      "{\n"
+      "switch (code) {\n";
+  bool anyChainable = false;
+  for (const auto& method : iface.GetMethods()) {
+    if (method->CanBeChained()) {
+      isChainable += "case TRANSACTION_" + method->GetName() + ":\n";
+      anyChainable = true;
+    }
+  }
+  if (anyChainable) {
+    isChainable += "return true;\n";
+  }
+  isChainable +=
+      "}\n"
+      "return false;\n"
+      "}\n";
+  stub->elements.push_back(new LiteralClassElement(isChainable));
+}
+
 Class* generate_binder_interface_class(const AidlInterface* iface,
-                                       JavaTypeNamespace* types) {
+                                       JavaTypeNamespace* types,
+                                       const JavaOptions& options) {
   const InterfaceType* interfaceType = iface->GetLanguageType<InterfaceType>();
 
   // the interface class
@@ -521,12 +1857,17 @@ Class* generate_binder_interface_class(const AidlInterface* iface,
 
   // the stub inner class
   StubClass* stub =
-      new StubClass(interfaceType->GetStub(), interfaceType, types);
+      new StubClass(interfaceType->GetStub(), interfaceType, types,
+                    options.use_shared_runtime_, options.cache_proxies_,
+                    options.trace_context_);
   interface->elements.push_back(stub);
 
   // the proxy inner class
   ProxyClass* proxy =
-      new ProxyClass(types, interfaceType->GetProxy(), interfaceType);
+      new ProxyClass(types, interfaceType->GetProxy(), interfaceType,
+                     options.use_shared_runtime_,
+                     options.use_thread_local_parcels_,
+                     options.trace_context_);
   stub->elements.push_back(proxy);
 
   // stub and proxy support for getInterfaceDescriptor()
@@ -537,11 +1878,37 @@ Class* generate_binder_interface_class(const AidlInterface* iface,
     generate_constant(*item, interface);
   }
 
+  // the holder classes of the declared enums
+  for (const auto& item : iface->GetEnums()) {
+    generate_enum(*item, interface);
+  }
+
   // all the declared methods of the interface
   for (const auto& item : iface->GetMethods()) {
     generate_method(*item, interface, stub, proxy, item->GetId(), types);
   }
 
+  // the call chain inner class, for @chainable interfaces
+  if (iface->IsChainable()) {
+    generate_call_chain_stub(*iface, stub, types);
+    CallChainClass* chain = new CallChainClass(types, interfaceType);
+    interface->elements.push_back(chain);
+    for (const auto& item : iface->GetMethods()) {
+      if (item->CanBeChained()) {
+        chain->AddMethod(*item, types);
+      }
+    }
+  }
+
+  // the router inner class, for interfaces with @shardKey arguments
+  if (iface->IsSharded()) {
+    RouterClass* router = new RouterClass(types, interfaceType, *iface);
+    interface->elements.push_back(router);
+    for (const auto& item : iface->GetMethods()) {
+      generate_router_method(*item, router, types);
+    }
+  }
+
   return interface;
 }
 
@@ -46,6 +46,18 @@ ImportResolver::ImportResolver(const IoDelegate& io_delegate,
 
 
 string ImportResolver::FindImportFile(const string& canonical_name) const {
+  // Look for the file at each of our import roots.
+  for (const string& path : CandidatePaths(canonical_name)) {
+    if (io_delegate_.FileIsReadable(path)) {
+      return path;
+    }
+  }
+
+  return "";
+}
+
+vector<string> ImportResolver::CandidatePaths(
+    const string& canonical_name) const {
   // Convert the canonical name to a relative file path.
   string relative_path = canonical_name;
   for (char& c : relative_path) {
@@ -55,15 +67,11 @@ string ImportResolver::FindImportFile(const string& canonical_name) const {
   }
   relative_path += ".aidl";
 
-  // Look for that relative path at each of our import roots.
-  for (string path : import_paths_) {
-    path = path + relative_path;
-    if (io_delegate_.FileIsReadable(path)) {
-      return path;
-    }
+  vector<string> paths;
+  for (const string& import_path : import_paths_) {
+    paths.push_back(import_path + relative_path);
   }
-
-  return "";
+  return paths;
 }
 
 }  // namespace android
@@ -37,6 +37,11 @@ class ImportResolver {
   // in one of the import paths given to the ImportResolver.
   std::string FindImportFile(const std::string& canonical_name) const;
 
+  // Returns every path FindImportFile() may check for |canonical_name|, in
+  // the order it checks them.
+  std::vector<std::string> CandidatePaths(
+      const std::string& canonical_name) const;
+
  private:
   const IoDelegate& io_delegate_;
   std::vector<std::string> import_paths_;
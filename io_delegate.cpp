@@ -178,6 +178,8 @@ unique_ptr<CodeWriter> IoDelegate::GetCodeWriter(
   return GetFileWriter(file_path);
 }
 
+void IoDelegate::PrefetchFiles(const vector<string>& /* paths */) const {}
+
 void IoDelegate::RemovePath(const std::string& file_path) const {
 #ifdef _WIN32
   _unlink(file_path.c_str());
@@ -62,6 +62,10 @@ class IoDelegate {
 
   virtual void RemovePath(const std::string& file_path) const;
 
+  // Hints that |paths| are about to be checked and read.  Delegates that
+  // can read in the background start on them now.  Does nothing by default.
+  virtual void PrefetchFiles(const std::vector<std::string>& paths) const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(IoDelegate);
 };  // class IoDelegate
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jobserver.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+
+#include "logging.h"
+
+using android::base::Split;
+using android::base::StartsWith;
+using android::base::StringPrintf;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+
+namespace {
+
+const char kAuthFlag[] = "--jobserver-auth=";
+// make before 4.2 called it this.
+const char kFdsFlag[] = "--jobserver-fds=";
+const char kFifoPrefix[] = "fifo:";
+
+// Parses a descriptor named in MAKEFLAGS and checks it is a pipe, since
+// make may not have let us inherit it and its number may have been reused.
+bool ParseFd(const string& text, int* fd) {
+  if (text.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  const long value = strtol(text.c_str(), &end, 10);
+  if (*end != '\0' || value < 0) {
+    return false;
+  }
+  *fd = static_cast<int>(value);
+  struct stat info;
+  return fstat(*fd, &info) == 0 && S_ISFIFO(info.st_mode);
+}
+
+}  // namespace
+
+unique_ptr<JobserverClient> JobserverClient::FromMakeflags(
+    const string& makeflags) {
+  // The last occurrence wins, as it does for make.
+  string auth;
+  for (const string& word : Split(makeflags, " ")) {
+    if (StartsWith(word, kAuthFlag)) {
+      auth = word.substr(strlen(kAuthFlag));
+    } else if (StartsWith(word, kFdsFlag)) {
+      auth = word.substr(strlen(kFdsFlag));
+    }
+  }
+  if (auth.empty()) {
+    return nullptr;
+  }
+
+  if (StartsWith(auth, kFifoPrefix)) {
+    const string path = auth.substr(strlen(kFifoPrefix));
+    int read_fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (read_fd < 0) {
+      LOG(WARNING) << "Can't open jobserver " << path;
+      return nullptr;
+    }
+    int write_fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (write_fd < 0) {
+      LOG(WARNING) << "Can't open jobserver " << path;
+      close(read_fd);
+      return nullptr;
+    }
+    return unique_ptr<JobserverClient>(
+        new JobserverClient(read_fd, write_fd, true));
+  }
+
+  vector<string> fds = Split(auth, ",");
+  int inherited_read_fd = -1;
+  int write_fd = -1;
+  if (fds.size() != 2 || !ParseFd(fds[0], &inherited_read_fd) ||
+      !ParseFd(fds[1], &write_fd)) {
+    // make only passes its pipe to commands it knows to be recursive makes,
+    // or that are marked with '+'.
+    LOG(DEBUG) << "Ignoring unusable jobserver " << auth;
+    return nullptr;
+  }
+  // The pipe is shared with make and its other children, which expect
+  // blocking reads, so read from a description of our own that can be made
+  // non-blocking.
+  const string path = StringPrintf("/proc/self/fd/%d", inherited_read_fd);
+  int read_fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (read_fd < 0) {
+    LOG(DEBUG) << "Can't reopen jobserver pipe " << auth;
+    return nullptr;
+  }
+  return unique_ptr<JobserverClient>(
+      new JobserverClient(read_fd, write_fd, false));
+}
+
+unique_ptr<JobserverClient> JobserverClient::FromEnvironment() {
+  const char* makeflags = getenv("MAKEFLAGS");
+  if (makeflags == nullptr) {
+    return nullptr;
+  }
+  return FromMakeflags(makeflags);
+}
+
+JobserverClient::JobserverClient(int read_fd, int write_fd,
+                                 bool owns_write_fd)
+    : read_fd_(read_fd), write_fd_(write_fd), owns_write_fd_(owns_write_fd) {}
+
+JobserverClient::~JobserverClient() {
+  while (HeldTokens() > 0) {
+    Release();
+  }
+  close(read_fd_);
+  if (owns_write_fd_) {
+    close(write_fd_);
+  }
+}
+
+bool JobserverClient::TryAcquire() {
+  char token;
+  if (TEMP_FAILURE_RETRY(read(read_fd_, &token, 1)) != 1) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(lock_);
+  held_tokens_.push_back(token);
+  return true;
+}
+
+void JobserverClient::Release() {
+  char token;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (held_tokens_.empty()) {
+      LOG(ERROR) << "Releasing a jobserver token that was never acquired";
+      return;
+    }
+    token = held_tokens_.back();
+    held_tokens_.pop_back();
+  }
+  // A token that isn't given back is a job slot lost for the whole build.
+  if (TEMP_FAILURE_RETRY(write(write_fd_, &token, 1)) != 1) {
+    PLOG(ERROR) << "Failed to return a jobserver token";
+  }
+}
+
+void JobserverClient::WaitForToken(std::chrono::milliseconds timeout) {
+  struct pollfd readable = {read_fd_, POLLIN, 0};
+  TEMP_FAILURE_RETRY(poll(&readable, 1, static_cast<int>(timeout.count())));
+}
+
+size_t JobserverClient::HeldTokens() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return held_tokens_.size();
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_JOBSERVER_H_
+#define AIDL_JOBSERVER_H_
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace aidl {
+
+// A client of the GNU make jobserver, which lets the threads of a process
+// run by make -jN (or by ninja acting as a jobserver) share the build's N
+// job slots instead of adding to them.
+//
+// Every process make starts already holds one implicit token.  Each extra
+// thread that wants to run takes a token from the jobserver first and gives
+// it back as soon as it runs out of work.  Methods may be called from any
+// thread.
+class JobserverClient {
+ public:
+  // Returns nullptr unless |makeflags| names a jobserver this process can
+  // reach, either as --jobserver-auth=R,W (or the older --jobserver-fds=R,W)
+  // with both descriptors open, or as --jobserver-auth=fifo:PATH.
+  static std::unique_ptr<JobserverClient> FromMakeflags(
+      const std::string& makeflags);
+  // Reads $MAKEFLAGS.
+  static std::unique_ptr<JobserverClient> FromEnvironment();
+
+  // Returns any tokens still held.
+  ~JobserverClient();
+
+  // Takes a token if one is free, without waiting.
+  bool TryAcquire();
+  // Gives back a token taken by TryAcquire().
+  void Release();
+  // Waits up to |timeout| for a token to look free.  Another process may
+  // still take it first, so follow up with TryAcquire().
+  void WaitForToken(std::chrono::milliseconds timeout);
+
+  size_t HeldTokens() const;
+
+ private:
+  // Takes ownership of |read_fd|, and of |write_fd| if |owns_write_fd|.
+  // |read_fd| must be non-blocking.
+  JobserverClient(int read_fd, int write_fd, bool owns_write_fd);
+
+  const int read_fd_;
+  const int write_fd_;
+  const bool owns_write_fd_;
+
+  mutable std::mutex lock_;
+  // make expects back the bytes it handed out.
+  std::string held_tokens_;
+
+  DISALLOW_COPY_AND_ASSIGN(JobserverClient);
+};  // class JobserverClient
+
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_JOBSERVER_H_
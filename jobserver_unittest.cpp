@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include <android-base/stringprintf.h>
+#include <gtest/gtest.h>
+
+#include "jobserver.h"
+
+using android::base::StringPrintf;
+using std::string;
+using std::unique_ptr;
+
+namespace android {
+namespace aidl {
+
+class JobserverClientTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(0, pipe(fds_));
+    ASSERT_EQ(3, write(fds_[1], "+++", 3));
+  }
+  void TearDown() override {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  // Reads back the tokens left in the pipe.
+  string DrainTokens() {
+    string tokens;
+    const int flags = fcntl(fds_[0], F_GETFL);
+    fcntl(fds_[0], F_SETFL, flags | O_NONBLOCK);
+    char token;
+    while (read(fds_[0], &token, 1) == 1) {
+      tokens.push_back(token);
+    }
+    fcntl(fds_[0], F_SETFL, flags);
+    return tokens;
+  }
+
+  int fds_[2];
+};
+
+TEST_F(JobserverClientTest, IgnoresMakeflagsWithoutJobserver) {
+  EXPECT_EQ(nullptr, JobserverClient::FromMakeflags(""));
+  EXPECT_EQ(nullptr, JobserverClient::FromMakeflags("-j4"));
+  EXPECT_EQ(nullptr, JobserverClient::FromMakeflags("-- --jobserver-auth="));
+  EXPECT_EQ(nullptr,
+            JobserverClient::FromMakeflags(" --jobserver-auth=fifo:/none"));
+  // Descriptors that aren't open, or aren't pipes, weren't meant for us.
+  EXPECT_EQ(nullptr,
+            JobserverClient::FromMakeflags(" --jobserver-auth=998,999"));
+  const int not_a_pipe = open("/dev/null", O_RDONLY);
+  ASSERT_LE(0, not_a_pipe);
+  EXPECT_EQ(nullptr, JobserverClient::FromMakeflags(
+      StringPrintf(" --jobserver-auth=%d,%d", not_a_pipe, fds_[1])));
+  close(not_a_pipe);
+  EXPECT_EQ("+++", DrainTokens());
+}
+
+TEST_F(JobserverClientTest, SharesPipeTokens) {
+  unique_ptr<JobserverClient> client = JobserverClient::FromMakeflags(
+      StringPrintf("-j4 --jobserver-auth=%d,%d", fds_[0], fds_[1]));
+  ASSERT_NE(nullptr, client);
+  EXPECT_TRUE(client->TryAcquire());
+  EXPECT_TRUE(client->TryAcquire());
+  EXPECT_EQ(2u, client->HeldTokens());
+  client->Release();
+  EXPECT_EQ(1u, client->HeldTokens());
+  // The pipe is read without blocking, even though make's end of it blocks.
+  EXPECT_EQ("++", DrainTokens());
+  EXPECT_FALSE(client->TryAcquire());
+  EXPECT_EQ(0, fcntl(fds_[0], F_GETFL) & O_NONBLOCK);
+
+  // Tokens still held are returned on destruction.
+  client.reset();
+  EXPECT_EQ("+", DrainTokens());
+}
+
+TEST_F(JobserverClientTest, AcceptsOldMakeflags) {
+  unique_ptr<JobserverClient> client = JobserverClient::FromMakeflags(
+      StringPrintf(" --jobserver-fds=%d,%d -j", fds_[0], fds_[1]));
+  ASSERT_NE(nullptr, client);
+  EXPECT_TRUE(client->TryAcquire());
+}
+
+TEST_F(JobserverClientTest, SharesFifoTokens) {
+  char dir[] = "/tmp/aidl_jobserver_XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(dir));
+  const string path = string(dir) + "/fifo";
+  ASSERT_EQ(0, mkfifo(path.c_str(), 0600));
+  // Stands in for make, which keeps the fifo open.
+  const int fifo = open(path.c_str(), O_RDWR);
+  ASSERT_LE(0, fifo);
+  ASSERT_EQ(2, write(fifo, "ab", 2));
+  {
+    unique_ptr<JobserverClient> client =
+        JobserverClient::FromMakeflags(" -j3 --jobserver-auth=fifo:" + path);
+    ASSERT_NE(nullptr, client);
+    EXPECT_TRUE(client->TryAcquire());
+    EXPECT_TRUE(client->TryAcquire());
+    EXPECT_FALSE(client->TryAcquire());
+  }
+  // Each token came back as it was handed out.
+  char tokens[3] = {};
+  EXPECT_EQ(2, read(fifo, tokens, 2));
+  EXPECT_EQ(2u, string(tokens).size());
+  EXPECT_NE(string::npos, string(tokens).find('a'));
+  EXPECT_NE(string::npos, string(tokens).find('b'));
+  close(fifo);
+  unlink(path.c_str());
+  rmdir(dir);
+}
+
+}  // namespace aidl
+}  // namespace android
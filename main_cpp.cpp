@@ -20,8 +20,16 @@
 #include "io_delegate.h"
 #include "logging.h"
 #include "options.h"
+#include "recording_io_delegate.h"
+
+#ifndef _WIN32
+#include "async_io_delegate.h"
+#include "jobserver.h"
+#endif
 
 using android::aidl::CppOptions;
+using android::aidl::IoDelegate;
+using android::aidl::RunWithCapture;
 
 int main(int argc, char** argv) {
   android::base::InitLogging(argv);
@@ -32,6 +40,24 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  android::aidl::IoDelegate io_delegate;
-  return android::aidl::compile_aidl_to_cpp(*options, io_delegate);
+  auto compile = [&options](const IoDelegate& io_delegate) {
+    return android::aidl::compile_aidl_to_cpp(*options, io_delegate);
+  };
+  IoDelegate io_delegate;
+#ifndef _WIN32
+  if (options->IoThreads() > 0) {
+    std::unique_ptr<android::aidl::JobserverClient> jobserver =
+        android::aidl::JobserverClient::FromEnvironment();
+    android::aidl::AsyncIoDelegate async_io_delegate(
+        io_delegate, options->IoThreads(), jobserver.get());
+    auto compile_and_write = [&compile, &async_io_delegate](
+        const IoDelegate& wrapped_io_delegate) {
+      const int result = compile(wrapped_io_delegate);
+      return async_io_delegate.FinishWrites() ? result : 1;
+    };
+    return RunWithCapture("aidl-cpp", argc, argv, async_io_delegate,
+                          compile_and_write);
+  }
+#endif
+  return RunWithCapture("aidl-cpp", argc, argv, io_delegate, compile);
 }
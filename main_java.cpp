@@ -21,18 +21,20 @@
 #include "io_delegate.h"
 #include "logging.h"
 #include "options.h"
+#include "recording_io_delegate.h"
 
+#ifndef _WIN32
+#include "async_io_delegate.h"
+#include "jobserver.h"
+#endif
+
+using android::aidl::IoDelegate;
 using android::aidl::JavaOptions;
+using android::aidl::RunWithCapture;
 
-int main(int argc, char** argv) {
-  android::base::InitLogging(argv);
-  LOG(DEBUG) << "aidl starting";
-  std::unique_ptr<JavaOptions> options = JavaOptions::Parse(argc, argv);
-  if (!options) {
-    return 1;
-  }
+namespace {
 
-  android::aidl::IoDelegate io_delegate;
+int process(JavaOptions* options, const IoDelegate& io_delegate) {
   switch (options->task) {
     case JavaOptions::COMPILE_AIDL_TO_JAVA:
       return android::aidl::compile_aidl_to_java(*options, io_delegate);
@@ -40,7 +42,45 @@ int main(int argc, char** argv) {
       if (android::aidl::preprocess_aidl(*options, io_delegate))
         return 0;
       return 1;
+    case JavaOptions::BUNDLE_AIDL:
+      if (android::aidl::bundle_aidl(*options, io_delegate))
+        return 0;
+      return 1;
+    case JavaOptions::COMPILE_BUNDLE_TO_JAVA:
+      return android::aidl::compile_bundle_to_java(options, io_delegate);
   }
   std::cerr << "aidl: internal error" << std::endl;
   return 1;
 }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  android::base::InitLogging(argv);
+  LOG(DEBUG) << "aidl starting";
+  std::unique_ptr<JavaOptions> options = JavaOptions::Parse(argc, argv);
+  if (!options) {
+    return 1;
+  }
+
+  auto compile = [&options](const IoDelegate& io_delegate) {
+    return process(options.get(), io_delegate);
+  };
+  IoDelegate io_delegate;
+#ifndef _WIN32
+  if (options->io_threads_ > 0) {
+    std::unique_ptr<android::aidl::JobserverClient> jobserver =
+        android::aidl::JobserverClient::FromEnvironment();
+    android::aidl::AsyncIoDelegate async_io_delegate(
+        io_delegate, options->io_threads_, jobserver.get());
+    auto compile_and_write = [&compile, &async_io_delegate](
+        const IoDelegate& wrapped_io_delegate) {
+      const int result = compile(wrapped_io_delegate);
+      return async_io_delegate.FinishWrites() ? result : 1;
+    };
+    return RunWithCapture("aidl", argc, argv, async_io_delegate,
+                          compile_and_write);
+  }
+#endif
+  return RunWithCapture("aidl", argc, argv, io_delegate, compile);
+}
@@ -16,10 +16,12 @@
 
 #include "options.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <stdio.h>
 
+#include "bundle.h"
 #include "logging.h"
 #include "os.h"
 
@@ -33,10 +35,30 @@ namespace android {
 namespace aidl {
 namespace {
 
+const char kIoThreadsFlag[] = "--io-threads=";
+
+// Parses the count in --io-threads=<N>.  Returns false if |arg| is not that
+// flag or has a malformed count.
+bool ParseIoThreads(const char* arg, size_t* io_threads) {
+  const size_t flag_length = strlen(kIoThreadsFlag);
+  if (strncmp(arg, kIoThreadsFlag, flag_length) != 0 ||
+      arg[flag_length] == '\0') {
+    return false;
+  }
+  char* end = nullptr;
+  const unsigned long count = strtoul(arg + flag_length, &end, 10);
+  if (*end != '\0' || arg[flag_length] == '-') {
+    return false;
+  }
+  *io_threads = count;
+  return true;
+}
+
 unique_ptr<JavaOptions> java_usage() {
   fprintf(stderr,
           "usage: aidl OPTIONS INPUT [OUTPUT]\n"
           "       aidl --preprocess OUTPUT INPUT...\n"
+          "       aidl --bundle [-I<DIR>...] [-p<FILE>...] OUTPUT INPUT...\n"
           "\n"
           "OPTIONS:\n"
           "   -I<DIR>    search path for import statements.\n"
@@ -46,9 +68,22 @@ unique_ptr<JavaOptions> java_usage() {
           "   -p<FILE>   file created by --preprocess to import.\n"
           "   -o<FOLDER> base output folder for generated files.\n"
           "   -b         fail when trying to compile a parcelable.\n"
+          "   --shared-runtime  generate smaller stubs and proxies that\n"
+          "              extend the classes in android.aidl.runtime.\n"
+          "   --thread-local-parcels  reuse a Parcel pair per thread for proxy\n"
+          "              calls instead of Parcel.obtain().\n"
+          "   --cache-proxies  return the same proxy from asInterface() for\n"
+          "              as long as it is in use.\n"
+          "   --trace-context  send the caller's trace context with each\n"
+          "              call; needs android.aidl.runtime.\n"
+          "   --io-threads=<N>  read imports and write outputs on N threads.\n"
+          "              Under make -j, all but one take a job slot first.\n"
           "\n"
           "INPUT:\n"
-          "   An aidl interface file.\n"
+          "   An aidl interface file, or a bundle created by --bundle.\n"
+          "   Bundles end in .aidlbundle and carry their own import paths and\n"
+          "   preprocessed files, so -I, -p, -d and -a cannot be used with\n"
+          "   them, and either OUTPUT or -o is required.\n"
           "\n"
           "OUTPUT:\n"
           "   The generated interface files.\n"
@@ -78,6 +113,10 @@ unique_ptr<JavaOptions> JavaOptions::Parse(int argc, const char* const* argv) {
   }
 
   options->task = COMPILE_AIDL_TO_JAVA;
+  if (argc >= 2 && 0 == strcmp(argv[1], "--bundle")) {
+    options->task = BUNDLE_AIDL;
+    i++;
+  }
   // OPTIONS
   while (i < argc) {
     const char* s = argv[i];
@@ -122,6 +161,19 @@ unique_ptr<JavaOptions> JavaOptions::Parse(int argc, const char* const* argv) {
       }
     } else if (strcmp(s, "-b") == 0) {
       options->fail_on_parcelable_ = true;
+    } else if (strcmp(s, "--shared-runtime") == 0) {
+      options->use_shared_runtime_ = true;
+    } else if (strcmp(s, "--thread-local-parcels") == 0) {
+      options->use_thread_local_parcels_ = true;
+    } else if (strcmp(s, "--cache-proxies") == 0) {
+      options->cache_proxies_ = true;
+    } else if (strcmp(s, "--trace-context") == 0) {
+      options->trace_context_ = true;
+    } else if (strncmp(s, kIoThreadsFlag, strlen(kIoThreadsFlag)) == 0) {
+      if (!ParseIoThreads(s, &options->io_threads_)) {
+        fprintf(stderr, "%s requires a thread count.\n", kIoThreadsFlag);
+        return java_usage();
+      }
     } else {
       // s[1] is not known
       fprintf(stderr, "unknown option (%d): %s\n", i, s);
@@ -129,15 +181,46 @@ unique_ptr<JavaOptions> JavaOptions::Parse(int argc, const char* const* argv) {
     }
     i++;
   }
+
+  if (options->use_shared_runtime_ && options->use_thread_local_parcels_) {
+    // AidlProxy obtains the parcels for shared runtime proxies.
+    fprintf(stderr,
+            "--thread-local-parcels cannot be used with --shared-runtime\n");
+    return java_usage();
+  }
+
+  if (options->task == BUNDLE_AIDL) {
+    if (argc - i < 2) {
+      fprintf(stderr, "--bundle requires OUTPUT and at least one INPUT\n");
+      return java_usage();
+    }
+    options->output_file_name_ = argv[i++];
+    for (; i < argc; i++) {
+      options->files_to_bundle_.push_back(argv[i]);
+    }
+    return options;
+  }
+
   // INPUT
-  if (i < argc) {
+  if (i < argc && EndsWith(argv[i], Bundle::kSuffix)) {
+    options->bundle_file_name_ = argv[i];
+    options->task = COMPILE_BUNDLE_TO_JAVA;
+    i++;
+    if (!options->import_paths_.empty() ||
+        !options->preprocessed_files_.empty() ||
+        !options->DependencyFilePath().empty()) {
+      fprintf(stderr, "-I, -p, -d and -a cannot be used with a bundle\n");
+      return java_usage();
+    }
+  } else if (i < argc) {
     options->input_file_name_ = argv[i];
     i++;
   } else {
     fprintf(stderr, "INPUT required\n");
     return java_usage();
   }
-  if (!EndsWith(options->input_file_name_, ".aidl")) {
+  if (options->task == COMPILE_AIDL_TO_JAVA &&
+      !EndsWith(options->input_file_name_, ".aidl")) {
     cerr << "Expected .aidl file for input but got "
          << options->input_file_name_ << endl;
     return java_usage();
@@ -147,6 +230,10 @@ unique_ptr<JavaOptions> JavaOptions::Parse(int argc, const char* const* argv) {
   if (i < argc) {
     options->output_file_name_ = argv[i];
     i++;
+  } else if (options->task == COMPILE_BUNDLE_TO_JAVA &&
+             options->output_base_folder_.empty()) {
+    fprintf(stderr, "OUTPUT or -o is required with a bundle\n");
+    return java_usage();
   } else if (options->output_base_folder_.empty()) {
     // copy input into output and change the extension from .aidl to .java
     options->output_file_name_= options->input_file_name_;
@@ -186,6 +273,18 @@ unique_ptr<CppOptions> cpp_usage() {
        << "OPTIONS:" << endl
        << "   -I<DIR>   search path for import statements" << endl
        << "   -d<FILE>  generate dependency file" << endl
+       << "   --io-threads=<N>  read imports and write outputs on N threads"
+       << endl
+       << "                     (under make -j, all but one take a job slot)"
+       << endl
+       << "   --server-metrics  time each transaction BnFoo handles, for"
+       << endl
+       << "                     libaidl-socket-transport's autoscaler" << endl
+       << "   --server-watchdog  let a CallWatchdog report calls BnFoo takes"
+       << endl
+       << "                     too long to handle" << endl
+       << "   --trace-context   send the caller's TraceContext with each call"
+       << endl
        << endl
        << "INPUT_FILE:" << endl
        << "   an aidl interface file" << endl
@@ -218,6 +317,14 @@ unique_ptr<CppOptions> CppOptions::Parse(int argc, const char* const* argv) {
       options->import_paths_.push_back(the_rest);
     } else if (s[1] == 'd') {
       options->dep_file_name_ = the_rest;
+    } else if (ParseIoThreads(s, &options->io_threads_)) {
+      // Parsed.
+    } else if (strcmp(s, "--server-metrics") == 0) {
+      options->server_metrics_ = true;
+    } else if (strcmp(s, "--server-watchdog") == 0) {
+      options->server_watchdog_ = true;
+    } else if (strcmp(s, "--trace-context") == 0) {
+      options->trace_context_ = true;
     } else {
       cerr << "Invalid argument '" << s << "'." << endl;
       return cpp_usage();
@@ -32,6 +32,8 @@ class JavaOptions final {
   enum {
       COMPILE_AIDL_TO_JAVA,
       PREPROCESS_AIDL,
+      BUNDLE_AIDL,
+      COMPILE_BUNDLE_TO_JAVA,
   };
 
   ~JavaOptions() = default;
@@ -52,7 +54,20 @@ class JavaOptions final {
   std::string output_base_folder_;
   std::string dep_file_name_;
   bool auto_dep_file_{false};
+  // Generate stubs and proxies on top of android.aidl.runtime.
+  bool use_shared_runtime_{false};
+  // Give each thread its own pair of Parcels for proxy calls.
+  bool use_thread_local_parcels_{false};
+  // Reuse one proxy per remote object in asInterface().
+  bool cache_proxies_{false};
+  // Send the caller's android.aidl.runtime.TraceContext with each call.
+  bool trace_context_{false};
+  // Threads to do file I/O on, or 0 to do it on the main thread.
+  size_t io_threads_{0};
   std::vector<std::string> files_to_preprocess_;
+  std::vector<std::string> files_to_bundle_;
+  // Set instead of |input_file_name_| when the input is a bundle.
+  std::string bundle_file_name_;
 
  private:
   JavaOptions() = default;
@@ -62,6 +77,20 @@ class JavaOptions final {
   FRIEND_TEST(AidlTest, WritePreprocessedFile);
   FRIEND_TEST(AidlTest, WritesCorrectDependencyFile);
   FRIEND_TEST(AidlTest, WritesTrivialDependencyFileForParcelable);
+  FRIEND_TEST(AidlTest, GeneratesRouterInJava);
+  FRIEND_TEST(AidlTest, GeneratesJavaForSharedRuntime);
+  FRIEND_TEST(AidlTest, JavaRejectsDelta);
+  FRIEND_TEST(AidlTest, JavaGeneratesCallChain);
+  FRIEND_TEST(AidlTest, BundlesImportClosure);
+  FRIEND_TEST(AidlTest, CompilesFromBundle);
+  FRIEND_TEST(AidlTest, GeneratesThreadLocalParcels);
+  FRIEND_TEST(AidlTest, GeneratesReusedParcelables);
+  FRIEND_TEST(AidlTest, GeneratesProxyCache);
+  FRIEND_TEST(AidlTest, GeneratesTraceContext);
+  FRIEND_TEST(AidlTest, GeneratesTypedConstantsInJava);
+  FRIEND_TEST(AidlTest, GeneratesEnumsInJava);
+  FRIEND_TEST(AidlTest, GeneratesNonNullParcelablesInJava);
+  FRIEND_TEST(AidlTest, GeneratesSkippableArgumentsInJava);
 
   DISALLOW_COPY_AND_ASSIGN(JavaOptions);
 };
@@ -82,6 +111,14 @@ class CppOptions final {
 
   std::vector<std::string> ImportPaths() const { return import_paths_; }
   std::string DependencyFilePath() const { return dep_file_name_; }
+  // Threads to do file I/O on, or 0 to do it on the main thread.
+  size_t IoThreads() const { return io_threads_; }
+  // Whether BnFoo keeps per-method TransactionMetrics.
+  bool ServerMetrics() const { return server_metrics_; }
+  // Whether BnFoo publishes its calls in flight for a CallWatchdog.
+  bool ServerWatchdog() const { return server_watchdog_; }
+  // Whether calls carry the caller's transport::TraceContext.
+  bool TraceContext() const { return trace_context_; }
 
  private:
   CppOptions() = default;
@@ -91,6 +128,10 @@ class CppOptions final {
   std::string output_header_dir_;
   std::string output_file_name_;
   std::string dep_file_name_;
+  size_t io_threads_{0};
+  bool server_metrics_{false};
+  bool server_watchdog_{false};
+  bool trace_context_{false};
 
   FRIEND_TEST(CppOptionsTests, ParsesCompileCpp);
   DISALLOW_COPY_AND_ASSIGN(CppOptions);
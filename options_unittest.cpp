@@ -113,6 +113,126 @@ TEST(JavaOptionsTests, ParsesCompileJava) {
   EXPECT_EQ(string{kCompileCommandInput}, options->input_file_name_);
   EXPECT_EQ(string{kCompileCommandJavaOutput}, options->output_file_name_);
   EXPECT_EQ(false, options->auto_dep_file_);
+  EXPECT_EQ(false, options->use_shared_runtime_);
+}
+
+TEST(JavaOptionsTests, ParsesSharedRuntime) {
+  const char* command[] = {
+      "aidl",
+      "--shared-runtime",
+      kCompileCommandInput,
+      nullptr,
+  };
+  unique_ptr<JavaOptions> options = GetOptions<JavaOptions>(command);
+  EXPECT_EQ(JavaOptions::COMPILE_AIDL_TO_JAVA, options->task);
+  EXPECT_EQ(true, options->use_shared_runtime_);
+  EXPECT_EQ(string{kCompileCommandInput}, options->input_file_name_);
+}
+
+TEST(JavaOptionsTests, ParsesThreadLocalParcels) {
+  const char* command[] = {
+      "aidl",
+      "--thread-local-parcels",
+      kCompileCommandInput,
+      nullptr,
+  };
+  unique_ptr<JavaOptions> options = GetOptions<JavaOptions>(command);
+  EXPECT_EQ(true, options->use_thread_local_parcels_);
+
+  const char* with_shared_runtime[] = {
+      "aidl",
+      "--thread-local-parcels",
+      "--shared-runtime",
+      kCompileCommandInput,
+      nullptr,
+  };
+  EXPECT_EQ(nullptr, JavaOptions::Parse(4, with_shared_runtime));
+}
+
+TEST(JavaOptionsTests, ParsesIoThreads) {
+  const char* command[] = {
+      "aidl",
+      "--io-threads=8",
+      kCompileCommandInput,
+      nullptr,
+  };
+  unique_ptr<JavaOptions> options = GetOptions<JavaOptions>(command);
+  EXPECT_EQ(8u, options->io_threads_);
+
+  const char* missing_count[] = {
+      "aidl",
+      "--io-threads=",
+      kCompileCommandInput,
+      nullptr,
+  };
+  EXPECT_EQ(nullptr, JavaOptions::Parse(3, missing_count));
+}
+
+TEST(JavaOptionsTests, ParsesCacheProxies) {
+  const char* command[] = {
+      "aidl",
+      "--cache-proxies",
+      kCompileCommandInput,
+      nullptr,
+  };
+  unique_ptr<JavaOptions> options = GetOptions<JavaOptions>(command);
+  EXPECT_EQ(JavaOptions::COMPILE_AIDL_TO_JAVA, options->task);
+  EXPECT_EQ(true, options->cache_proxies_);
+  EXPECT_EQ(string{kCompileCommandInput}, options->input_file_name_);
+}
+
+TEST(JavaOptionsTests, ParsesTraceContext) {
+  const char* command[] = {
+      "aidl",
+      "--trace-context",
+      kCompileCommandInput,
+      nullptr,
+  };
+  unique_ptr<JavaOptions> options = GetOptions<JavaOptions>(command);
+  EXPECT_EQ(JavaOptions::COMPILE_AIDL_TO_JAVA, options->task);
+  EXPECT_EQ(true, options->trace_context_);
+  EXPECT_EQ(string{kCompileCommandInput}, options->input_file_name_);
+}
+
+TEST(JavaOptionsTests, ParsesBundle) {
+  const char* command[] = {
+      "aidl",
+      "--bundle",
+      kCompileCommandIncludePath,
+      "output.aidlbundle",
+      kCompileCommandInput,
+      nullptr,
+  };
+  unique_ptr<JavaOptions> options = GetOptions<JavaOptions>(command);
+  EXPECT_EQ(JavaOptions::BUNDLE_AIDL, options->task);
+  EXPECT_EQ(vector<string>{string{kCompileCommandIncludePath}.substr(2)},
+            options->import_paths_);
+  EXPECT_EQ(string{"output.aidlbundle"}, options->output_file_name_);
+  EXPECT_EQ(vector<string>{kCompileCommandInput}, options->files_to_bundle_);
+}
+
+TEST(JavaOptionsTests, ParsesBundleInput) {
+  const char* command[] = {
+      "aidl",
+      "-oout",
+      "input.aidlbundle",
+      nullptr,
+  };
+  unique_ptr<JavaOptions> options = GetOptions<JavaOptions>(command);
+  EXPECT_EQ(JavaOptions::COMPILE_BUNDLE_TO_JAVA, options->task);
+  EXPECT_EQ(string{"input.aidlbundle"}, options->bundle_file_name_);
+  EXPECT_EQ(string{}, options->input_file_name_);
+  EXPECT_EQ(string{"out"}, options->output_base_folder_);
+
+  // Bundles carry their own import paths.
+  const char* with_imports[] = {
+      "aidl",
+      kCompileCommandIncludePath,
+      "input.aidlbundle",
+      "IFoo.java",
+      nullptr,
+  };
+  EXPECT_EQ(nullptr, JavaOptions::Parse(4, with_imports));
 }
 
 TEST(CppOptionsTests, ParsesCompileCpp) {
@@ -126,6 +246,77 @@ TEST(CppOptionsTests, ParsesCompileCpp) {
   EXPECT_EQ(kCompileCommandCppOutput, options->OutputCppFilePath());
 }
 
+TEST(CppOptionsTests, ParsesIoThreads) {
+  const char* command[] = {
+      "aidl-cpp",
+      "--io-threads=4",
+      kCompileCommandInput,
+      kCompileCommandHeaderDir,
+      kCompileCommandCppOutput,
+      nullptr,
+  };
+  unique_ptr<CppOptions> options = GetOptions<CppOptions>(command);
+  EXPECT_EQ(4u, options->IoThreads());
+
+  const char* malformed[] = {
+      "aidl-cpp",
+      "--io-threads=four",
+      kCompileCommandInput,
+      kCompileCommandHeaderDir,
+      kCompileCommandCppOutput,
+      nullptr,
+  };
+  EXPECT_EQ(nullptr, CppOptions::Parse(5, malformed));
+}
+
+TEST(CppOptionsTests, ParsesServerMetrics) {
+  unique_ptr<CppOptions> options = GetOptions<CppOptions>(kCompileCppCommand);
+  EXPECT_FALSE(options->ServerMetrics());
+
+  const char* command[] = {
+      "aidl-cpp",
+      "--server-metrics",
+      kCompileCommandInput,
+      kCompileCommandHeaderDir,
+      kCompileCommandCppOutput,
+      nullptr,
+  };
+  options = GetOptions<CppOptions>(command);
+  EXPECT_TRUE(options->ServerMetrics());
+}
+
+TEST(CppOptionsTests, ParsesServerWatchdog) {
+  unique_ptr<CppOptions> options = GetOptions<CppOptions>(kCompileCppCommand);
+  EXPECT_FALSE(options->ServerWatchdog());
+
+  const char* command[] = {
+      "aidl-cpp",
+      "--server-watchdog",
+      kCompileCommandInput,
+      kCompileCommandHeaderDir,
+      kCompileCommandCppOutput,
+      nullptr,
+  };
+  options = GetOptions<CppOptions>(command);
+  EXPECT_TRUE(options->ServerWatchdog());
+}
+
+TEST(CppOptionsTests, ParsesTraceContext) {
+  unique_ptr<CppOptions> options = GetOptions<CppOptions>(kCompileCppCommand);
+  EXPECT_FALSE(options->TraceContext());
+
+  const char* command[] = {
+      "aidl-cpp",
+      "--trace-context",
+      kCompileCommandInput,
+      kCompileCommandHeaderDir,
+      kCompileCommandCppOutput,
+      nullptr,
+  };
+  options = GetOptions<CppOptions>(command);
+  EXPECT_TRUE(options->TraceContext());
+}
+
 TEST(OptionsTests, EndsWith) {
   EXPECT_TRUE(EndsWith("foo", ""));
   EXPECT_TRUE(EndsWith("foo", "o"));
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "recording_io_delegate.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <android-base/stringprintf.h>
+
+#include "logging.h"
+#include "os.h"
+
+using android::base::StringPrintf;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+
+const char kCaptureDirEnvironmentVariable[] = "AIDL_CAPTURE_DIR";
+
+namespace {
+
+// A capture is a header line followed by records, each a line holding a
+// kind and a length, then that many bytes and a newline.  A "file" record
+// holding a path is followed by a "contents" record.
+const char kCaptureHeader[] = "aidl-capture 1";
+
+void WriteRecord(std::ostream* out, const char* kind, const string& payload) {
+  *out << kind << ' ' << payload.size() << '\n';
+  out->write(payload.data(), payload.size());
+  *out << '\n';
+}
+
+bool ReadRecord(std::istream* in, string* kind, string* payload) {
+  size_t length;
+  if (!(*in >> *kind >> length) || in->get() != '\n') {
+    return false;
+  }
+  payload->resize(length);
+  if (length > 0 && !in->read(&(*payload)[0], length)) {
+    return false;
+  }
+  return in->get() == '\n';
+}
+
+int ProcessId() {
+#ifdef _WIN32
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+}  // namespace
+
+bool BuildCapture::Save(const string& path) const {
+  std::ofstream out(path, std::ios::out | std::ios::binary);
+  out << kCaptureHeader << '\n';
+  WriteRecord(&out, "tool", tool);
+  for (const string& arg : args) {
+    WriteRecord(&out, "arg", arg);
+  }
+  WriteRecord(&out, "status", std::to_string(status));
+  for (const auto& file : files) {
+    WriteRecord(&out, "file", file.first);
+    WriteRecord(&out, "contents", file.second);
+  }
+  out.close();
+  if (!out) {
+    LOG(ERROR) << "Failed to save capture to " << path;
+    return false;
+  }
+  return true;
+}
+
+bool BuildCapture::Load(const string& path) {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  string header;
+  if (!std::getline(in, header) || header != kCaptureHeader) {
+    LOG(ERROR) << path << " is not an aidl capture";
+    return false;
+  }
+  tool.clear();
+  args.clear();
+  status = 0;
+  files.clear();
+
+  string kind, payload, file;
+  while (ReadRecord(&in, &kind, &payload)) {
+    if (kind == "tool") {
+      tool = payload;
+    } else if (kind == "arg") {
+      args.push_back(payload);
+    } else if (kind == "status") {
+      status = atoi(payload.c_str());
+    } else if (kind == "file") {
+      file = payload;
+    } else if (kind == "contents") {
+      files[file] = payload;
+    } else {
+      LOG(ERROR) << path << " has an unknown record " << kind;
+      return false;
+    }
+  }
+  if (!in.eof()) {
+    LOG(ERROR) << path << " is truncated";
+    return false;
+  }
+  return !tool.empty();
+}
+
+RecordingIoDelegate::RecordingIoDelegate(const IoDelegate& io_delegate,
+                                         BuildCapture* capture)
+    : io_delegate_(io_delegate),
+      capture_(capture) {}
+
+unique_ptr<string> RecordingIoDelegate::GetFileContents(
+    const string& filename,
+    const string& content_suffix) const {
+  unique_ptr<string> contents =
+      io_delegate_.GetFileContents(filename, content_suffix);
+  if (contents && capture_->files.count(filename) == 0) {
+    capture_->files[filename] =
+        contents->substr(0, contents->size() - content_suffix.size());
+  }
+  return contents;
+}
+
+unique_ptr<LineReader> RecordingIoDelegate::GetLineReader(
+    const string& file_path) const {
+  unique_ptr<LineReader> reader = io_delegate_.GetLineReader(file_path);
+  if (reader && capture_->files.count(file_path) == 0) {
+    unrecorded_paths_.insert(file_path);
+  }
+  return reader;
+}
+
+bool RecordingIoDelegate::FileIsReadable(const string& path) const {
+  // Replays only find the files they have the contents of.
+  const bool readable = io_delegate_.FileIsReadable(path);
+  if (readable && capture_->files.count(path) == 0) {
+    unrecorded_paths_.insert(path);
+  }
+  return readable;
+}
+
+bool RecordingIoDelegate::CreatedNestedDirs(
+    const string& base_dir,
+    const vector<string>& nested_subdirs) const {
+  return io_delegate_.CreatedNestedDirs(base_dir, nested_subdirs);
+}
+
+unique_ptr<CodeWriter> RecordingIoDelegate::GetCodeWriter(
+    const string& file_path) const {
+  return io_delegate_.GetCodeWriter(file_path);
+}
+
+void RecordingIoDelegate::RemovePath(const string& file_path) const {
+  io_delegate_.RemovePath(file_path);
+}
+
+void RecordingIoDelegate::PrefetchFiles(const vector<string>& paths) const {
+  io_delegate_.PrefetchFiles(paths);
+}
+
+void RecordingIoDelegate::FinishRecording() const {
+  for (const string& path : unrecorded_paths_) {
+    if (capture_->files.count(path) > 0) {
+      continue;
+    }
+    unique_ptr<string> contents = io_delegate_.GetFileContents(path);
+    if (contents) {
+      capture_->files[path] = std::move(*contents);
+    }
+  }
+  unrecorded_paths_.clear();
+}
+
+int RunWithCapture(const char* tool, int argc, const char* const* argv,
+                   const IoDelegate& io_delegate,
+                   const std::function<int(const IoDelegate&)>& compile) {
+  const char* capture_dir = getenv(kCaptureDirEnvironmentVariable);
+  if (capture_dir == nullptr || capture_dir[0] == '\0') {
+    return compile(io_delegate);
+  }
+
+  BuildCapture capture;
+  capture.tool = tool;
+  for (int i = 1; i < argc; ++i) {
+    capture.args.push_back(argv[i]);
+  }
+  RecordingIoDelegate recording_io_delegate(io_delegate, &capture);
+  capture.status = compile(recording_io_delegate);
+  recording_io_delegate.FinishRecording();
+
+  // Builds run many of us at once, so every run gets a file of its own.
+  string path = capture_dir;
+  if (path.back() != OS_PATH_SEPARATOR) {
+    path += OS_PATH_SEPARATOR;
+  }
+  path += StringPrintf(
+      "%s-%lld-%d.capture", tool,
+      static_cast<long long>(
+          std::chrono::system_clock::now().time_since_epoch().count()),
+      ProcessId());
+  // Failing to capture shouldn't fail the build.
+  capture.Save(path);
+  return capture.status;
+}
+
+}  // namespace aidl
+}  // namespace android
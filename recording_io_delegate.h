@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_RECORDING_IO_DELEGATE_H_
+#define AIDL_RECORDING_IO_DELEGATE_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "io_delegate.h"
+
+namespace android {
+namespace aidl {
+
+// Everything one run of aidl or aidl-cpp depended on, so that it can be
+// rerun without the tree it came from.
+struct BuildCapture {
+  // "aidl" or "aidl-cpp".
+  std::string tool;
+  // The command line, without argv[0].
+  std::vector<std::string> args;
+  // What the run returned from main().
+  int status = 0;
+  // Every file the run read, or found readable, by the path it asked for.
+  std::map<std::string, std::string> files;
+
+  bool Save(const std::string& path) const;
+  // Returns false if |path| is missing or isn't a capture.
+  bool Load(const std::string& path);
+};
+
+// Passes everything through to another IoDelegate, and records the files
+// read through it into a BuildCapture.  Not safe to call from several
+// threads at once, so it wraps an AsyncIoDelegate rather than the other way
+// around.
+//
+// Files that are only found readable, or read line by line, are read into
+// the capture by FinishRecording(), so that reading them doesn't use up the
+// contents an AsyncIoDelegate prefetched for the compiler.
+class RecordingIoDelegate : public IoDelegate {
+ public:
+  RecordingIoDelegate(const IoDelegate& io_delegate, BuildCapture* capture);
+  virtual ~RecordingIoDelegate() = default;
+
+  // Overrides from IoDelegate
+  std::unique_ptr<std::string> GetFileContents(
+      const std::string& filename,
+      const std::string& content_suffix = "") const override;
+  std::unique_ptr<LineReader> GetLineReader(
+      const std::string& file_path) const override;
+  bool FileIsReadable(const std::string& path) const override;
+  bool CreatedNestedDirs(
+      const std::string& base_dir,
+      const std::vector<std::string>& nested_subdirs) const override;
+  std::unique_ptr<CodeWriter> GetCodeWriter(
+      const std::string& file_path) const override;
+  void RemovePath(const std::string& file_path) const override;
+  void PrefetchFiles(const std::vector<std::string>& paths) const override;
+
+  // Reads the files the compiler didn't read in full into the capture.
+  void FinishRecording() const;
+
+ private:
+  const IoDelegate& io_delegate_;
+  BuildCapture* const capture_;
+  // Files to read into the capture once the compiler is done with them.
+  mutable std::set<std::string> unrecorded_paths_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingIoDelegate);
+};  // class RecordingIoDelegate
+
+// Environment variable naming the directory that captures are saved to.
+extern const char kCaptureDirEnvironmentVariable[];
+
+// Returns |compile(io_delegate)|.  If the environment names a capture
+// directory, also saves what the run read to a new file in it, with the
+// command line |argv| of |tool|.  |compile| should wait for its outputs to
+// be written, so that the status it returns, which is saved as well, is
+// final.
+int RunWithCapture(const char* tool, int argc, const char* const* argv,
+                   const IoDelegate& io_delegate,
+                   const std::function<int(const IoDelegate&)>& compile);
+
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_RECORDING_IO_DELEGATE_H_
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "aidl.h"
+#include "options.h"
+#include "async_io_delegate.h"
+#include "recording_io_delegate.h"
+#include "tests/fake_io_delegate.h"
+#include "tests/slow_io_delegate.h"
+
+using android::aidl::test::FakeIoDelegate;
+using android::aidl::test::SlowIoDelegate;
+using std::string;
+using std::unique_ptr;
+
+namespace android {
+namespace aidl {
+
+namespace {
+
+const char* kJavaArgv[] = {"aidl", "-Iinclude0", "-Iinclude1",
+                           "src/p/IFoo.aidl", "out/IFoo.java"};
+
+}  // namespace
+
+class RecordingIoDelegateTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    io_delegate_.SetFileContents(
+        "src/p/IFoo.aidl",
+        "package p; import q.Bar; interface IFoo { void f(in Bar b); }");
+    io_delegate_.SetFileContents("include1/q/Bar.aidl",
+                                 "package q; parcelable Bar;");
+    io_delegate_.SetFileContents("include1/q/Unused.aidl",
+                                 "package q; parcelable Unused;");
+    options_ = JavaOptions::Parse(arraysize(kJavaArgv), kJavaArgv);
+    ASSERT_NE(nullptr, options_);
+  }
+
+  FakeIoDelegate io_delegate_;
+  unique_ptr<JavaOptions> options_;
+};
+
+TEST_F(RecordingIoDelegateTest, RecordsFilesThatWereRead) {
+  BuildCapture capture;
+  RecordingIoDelegate recording_io_delegate(io_delegate_, &capture);
+  ASSERT_EQ(0, compile_aidl_to_java(*options_, recording_io_delegate));
+
+  EXPECT_EQ(2u, capture.files.size());
+  EXPECT_EQ("package q; parcelable Bar;", capture.files["include1/q/Bar.aidl"]);
+  EXPECT_EQ(1u, capture.files.count("src/p/IFoo.aidl"));
+  // Outputs still go to the delegate underneath.
+  EXPECT_TRUE(io_delegate_.GetWrittenContents("out/IFoo.java", nullptr));
+}
+
+TEST_F(RecordingIoDelegateTest, LeavesPrefetchedFilesToTheCompiler) {
+  SlowIoDelegate slow_io_delegate;
+  slow_io_delegate.SetFileContents("a/Foo.aidl", "foo");
+  slow_io_delegate.SetFileContents("a/Bar.aidl", "bar");
+  AsyncIoDelegate async_io_delegate(slow_io_delegate, 1);
+  BuildCapture capture;
+  RecordingIoDelegate recording_io_delegate(async_io_delegate, &capture);
+  recording_io_delegate.PrefetchFiles({"a/Foo.aidl", "a/Bar.aidl"});
+
+  EXPECT_TRUE(recording_io_delegate.FileIsReadable("a/Foo.aidl"));
+  EXPECT_TRUE(recording_io_delegate.FileIsReadable("a/Bar.aidl"));
+  unique_ptr<string> contents =
+      recording_io_delegate.GetFileContents("a/Foo.aidl");
+  ASSERT_NE(nullptr, contents);
+  EXPECT_EQ("foo", *contents);
+  // a/Bar.aidl was only looked up, and is read once the compiler is done.
+  recording_io_delegate.FinishRecording();
+  EXPECT_EQ("foo", capture.files["a/Foo.aidl"]);
+  EXPECT_EQ("bar", capture.files["a/Bar.aidl"]);
+  // Everything was served from the prefetched contents.
+  EXPECT_EQ(2u,
+            slow_io_delegate.GetCallCount(SlowIoDelegate::GET_FILE_CONTENTS));
+}
+
+TEST_F(RecordingIoDelegateTest, ReplaysToTheSameOutput) {
+  BuildCapture capture;
+  RecordingIoDelegate recording_io_delegate(io_delegate_, &capture);
+  ASSERT_EQ(0, compile_aidl_to_java(*options_, recording_io_delegate));
+  string recorded_output;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IFoo.java",
+                                              &recorded_output));
+
+  FakeIoDelegate replay_io_delegate;
+  for (const auto& file : capture.files) {
+    replay_io_delegate.SetFileContents(file.first, file.second);
+  }
+  ASSERT_EQ(0, compile_aidl_to_java(*options_, replay_io_delegate));
+  string replayed_output;
+  ASSERT_TRUE(replay_io_delegate.GetWrittenContents("out/IFoo.java",
+                                                    &replayed_output));
+  EXPECT_EQ(recorded_output, replayed_output);
+}
+
+TEST_F(RecordingIoDelegateTest, SavesAndLoadsCaptures) {
+  BuildCapture capture;
+  capture.tool = "aidl";
+  capture.args = {"-Iinclude0", "", "arg\nwith a newline"};
+  capture.status = 1;
+  capture.files["a/IFoo.aidl"] = "interface IFoo {}\n";
+  capture.files["a/Empty.aidl"] = "";
+
+  const char* tmpdir = getenv("TMPDIR");
+  string path = string((tmpdir) ? tmpdir : "/tmp") + "/aidl_captureXXXXXX";
+  int fd = mkstemp(&path[0]);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  ASSERT_TRUE(capture.Save(path));
+
+  BuildCapture loaded;
+  EXPECT_TRUE(loaded.Load(path));
+  unlink(path.c_str());
+  EXPECT_EQ(capture.tool, loaded.tool);
+  EXPECT_EQ(capture.args, loaded.args);
+  EXPECT_EQ(capture.status, loaded.status);
+  EXPECT_EQ(capture.files, loaded.files);
+
+  EXPECT_FALSE(loaded.Load(path));
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.aidl.runtime;
+
+import android.os.IBinder;
+import android.os.IInterface;
+import android.os.Parcel;
+import android.os.RemoteException;
+
+/**
+ * Base class for proxies generated by aidl --shared-runtime.
+ *
+ * A generated method obtains a request with obtainRequest(), writes its
+ * arguments, and hands the request to call() or callOneway(), which always
+ * recycle it.  If writing an argument throws, the generated method recycles
+ * the request itself.  The reply returned by call() belongs to the caller.
+ */
+public abstract class AidlProxy implements IInterface {
+    private final IBinder mRemote;
+    private final String mDescriptor;
+
+    protected AidlProxy(IBinder remote, String descriptor) {
+        mRemote = remote;
+        mDescriptor = descriptor;
+    }
+
+    @Override
+    public IBinder asBinder() {
+        return mRemote;
+    }
+
+    public String getInterfaceDescriptor() {
+        return mDescriptor;
+    }
+
+    /** Returns a new request Parcel that already holds the interface token. */
+    protected final Parcel obtainRequest() {
+        Parcel data = Parcel.obtain();
+        data.writeInterfaceToken(mDescriptor);
+        return data;
+    }
+
+    /**
+     * Sends |data| and returns the reply, after rethrowing any exception the
+     * remote side reported.
+     */
+    protected final Parcel call(int code, Parcel data) throws RemoteException {
+        Parcel reply = Parcel.obtain();
+        boolean success = false;
+        try {
+            mRemote.transact(code, data, reply, 0);
+            reply.readException();
+            success = true;
+            return reply;
+        } finally {
+            data.recycle();
+            if (!success) {
+                reply.recycle();
+            }
+        }
+    }
+
+    /** Sends |data| without waiting for the remote side. */
+    protected final void callOneway(int code, Parcel data)
+            throws RemoteException {
+        try {
+            mRemote.transact(code, data, null, IBinder.FLAG_ONEWAY);
+        } finally {
+            data.recycle();
+        }
+    }
+}
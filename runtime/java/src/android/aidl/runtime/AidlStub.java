@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.aidl.runtime;
+
+import android.os.Binder;
+import android.os.IBinder;
+import android.os.IInterface;
+import android.os.Parcel;
+import android.os.RemoteException;
+
+/**
+ * Base class for stubs generated by aidl --shared-runtime.
+ *
+ * Handles everything that is the same for every interface, so that the
+ * generated Stub only has to decode and dispatch its own methods.
+ */
+public abstract class AidlStub extends Binder implements IInterface {
+    private final String mDescriptor;
+
+    protected AidlStub(String descriptor) {
+        mDescriptor = descriptor;
+        attachInterface(this, descriptor);
+    }
+
+    @Override
+    public IBinder asBinder() {
+        return this;
+    }
+
+    @Override
+    protected boolean onTransact(int code, Parcel data, Parcel reply, int flags)
+            throws RemoteException {
+        if (code == INTERFACE_TRANSACTION) {
+            reply.writeString(mDescriptor);
+            return true;
+        }
+        if (code >= FIRST_CALL_TRANSACTION && code <= LAST_CALL_TRANSACTION
+                && dispatch(code, data, reply, flags)) {
+            return true;
+        }
+        return super.onTransact(code, data, reply, flags);
+    }
+
+    /**
+     * Decodes and runs the method identified by |code|, after checking the
+     * interface token.  Returns false for unknown codes, without reading
+     * |data|, so that they fall through to Binder.onTransact().
+     */
+    protected abstract boolean dispatch(int code, Parcel data, Parcel reply,
+            int flags) throws RemoteException;
+}
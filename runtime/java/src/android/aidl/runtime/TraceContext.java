@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.aidl.runtime;
+
+import android.os.Parcel;
+
+import java.util.concurrent.ThreadLocalRandom;
+
+/**
+ * Identifies the span of work a thread is doing within a trace.
+ *
+ * Code generated with aidl --trace-context writes the calling thread's
+ * context after the interface token of each call, and runs the call in a
+ * child span of it on the other side.  The wire format matches
+ * ::android::aidl::transport::TraceContext, so traces cross between Java
+ * and C++ processes.
+ */
+public final class TraceContext {
+    /** The context of threads that aren't part of a trace. */
+    public static final TraceContext NONE = new TraceContext(0, 0, 0, false);
+
+    private static final int FLAG_PRESENT = 1 << 0;
+    private static final int FLAG_SAMPLED = 1 << 1;
+
+    private static final ThreadLocal<TraceContext> sCurrent =
+            new ThreadLocal<TraceContext>() {
+                @Override
+                protected TraceContext initialValue() {
+                    return NONE;
+                }
+            };
+
+    public final long traceId;
+    public final long spanId;
+    public final long parentSpanId;
+    /** Whether the trace is being recorded, as decided where it started. */
+    public final boolean sampled;
+
+    private TraceContext(long traceId, long spanId, long parentSpanId,
+            boolean sampled) {
+        this.traceId = traceId;
+        this.spanId = spanId;
+        this.parentSpanId = parentSpanId;
+        this.sampled = sampled;
+    }
+
+    public boolean isValid() {
+        return traceId != 0;
+    }
+
+    /** Starts a new trace with a single span. */
+    public static TraceContext newTrace(boolean sampled) {
+        return new TraceContext(newId(), newId(), 0, sampled);
+    }
+
+    /** Returns a new span under this one, or NONE if this is NONE. */
+    public TraceContext newChild() {
+        if (!isValid()) {
+            return NONE;
+        }
+        return new TraceContext(traceId, newId(), spanId, sampled);
+    }
+
+    /** Returns the context of the calling thread. */
+    public static TraceContext current() {
+        return sCurrent.get();
+    }
+
+    /**
+     * Makes |context| the calling thread's context and returns the one it
+     * replaced, which the caller should hand back to restore().
+     */
+    public static TraceContext enter(TraceContext context) {
+        TraceContext previous = sCurrent.get();
+        sCurrent.set(context);
+        return previous;
+    }
+
+    public static void restore(TraceContext previous) {
+        sCurrent.set(previous);
+    }
+
+    /** Writes the calling thread's context to a request. */
+    public static void writeCurrent(Parcel data) {
+        TraceContext context = sCurrent.get();
+        if (!context.isValid()) {
+            data.writeInt(0);
+            return;
+        }
+        data.writeInt(FLAG_PRESENT | (context.sampled ? FLAG_SAMPLED : 0));
+        data.writeLong(context.traceId);
+        data.writeLong(context.spanId);
+    }
+
+    /**
+     * Reads the caller's context from a request and enters a child span of
+     * it, returning the context to restore() afterwards.
+     */
+    public static TraceContext enterFrom(Parcel data) {
+        int flags = data.readInt();
+        TraceContext caller = NONE;
+        if ((flags & FLAG_PRESENT) != 0) {
+            long traceId = data.readLong();
+            long spanId = data.readLong();
+            if (traceId != 0) {
+                caller = new TraceContext(traceId, spanId, 0,
+                        (flags & FLAG_SAMPLED) != 0);
+            }
+        }
+        return enter(caller.newChild());
+    }
+
+    // Trace and span ids are random, and never 0.
+    private static long newId() {
+        long id;
+        do {
+            id = ThreadLocalRandom.current().nextLong();
+        } while (id == 0);
+        return id;
+    }
+}
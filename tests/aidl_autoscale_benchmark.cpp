@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Drives an ILoadBench generated with --server-metrics over the socket
+// transport with a burst of clients and then a lull, once with a fixed pool
+// of server threads and once with a WorkerPoolAutoscaler in charge of it.
+// Each phase reports its throughput and mean latency, and the thread count
+// the pool ended up with; the autoscaled run also logs every resize.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <binder/Status.h>
+#include <utils/StrongPointer.h>
+
+#include "android/aidl/tests/BnLoadBench.h"
+#include "android/aidl/tests/ILoadBench.h"
+#include "tests/test_util.h"
+#include "transport/socket_transport.h"
+#include "transport/transaction_metrics.h"
+#include "transport/worker_pool_autoscaler.h"
+
+using android::IBinder;
+using android::sp;
+using android::aidl::test::BenchmarkSocketPath;
+using android::aidl::tests::BnLoadBench;
+using android::aidl::tests::ILoadBench;
+using android::aidl::transport::SocketBinder;
+using android::aidl::transport::SocketServer;
+using android::aidl::transport::TransactionStats;
+using android::aidl::transport::WorkerPoolAutoscaler;
+using android::binder::Status;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+const int kBurstClients = 16;
+const int kLullClients = 1;
+const int kWorkMicros = 2000;
+const std::chrono::seconds kBurstDuration(2);
+const std::chrono::seconds kLullDuration(2);
+const size_t kMinThreads = 1;
+const size_t kMaxThreads = 16;
+
+class LoadBench : public BnLoadBench {
+ public:
+  Status Work(int32_t micros, int32_t* ret) override {
+    std::this_thread::sleep_for(std::chrono::microseconds(micros));
+    *ret = micros;
+    return Status::ok();
+  }
+
+  Status Ping() override {
+    return Status::ok();
+  }
+};
+
+// Calls Work() from |clients| threads, back to back, for |duration|.
+bool RunPhase(const string& label, const string& phase,
+              const sp<ILoadBench>& bench, SocketServer* server, int clients,
+              clock::duration duration) {
+  std::atomic<bool> success(true);
+  std::atomic<uint64_t> calls(0);
+  vector<std::thread> threads;
+
+  const clock::time_point start = clock::now();
+  const clock::time_point end = start + duration;
+  for (int i = 0; i < clients; ++i) {
+    threads.emplace_back([&bench, &success, &calls, end]() {
+      int32_t ret;
+      while (clock::now() < end) {
+        if (!bench->Work(kWorkMicros, &ret).isOk()) {
+          success = false;
+          return;
+        }
+        ++calls;
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const double seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+
+  cout << label << " phase=" << phase << " clients=" << clients
+       << " calls_per_second=" << (calls / seconds)
+       << " latency_us=" << (seconds * 1e6 * clients / calls)
+       << " server_threads=" << server->ThreadCount() << endl;
+  if (!success) {
+    cerr << label << ": call failed" << endl;
+  }
+  return success.load();
+}
+
+bool RunBenchmark(const string& label, const string& path,
+                  const sp<LoadBench>& service, bool autoscale) {
+  SocketServer server(service);
+  if (!server.Listen(path) || !server.Start(kMinThreads)) {
+    cerr << "Failed to start socket server on " << path << endl;
+    return false;
+  }
+  sp<ILoadBench> bench = ILoadBench::asInterface(SocketBinder::Connect(path));
+  if (bench == nullptr) {
+    cerr << "Failed to connect to " << path << endl;
+    return false;
+  }
+
+  WorkerPoolAutoscaler::Options options;
+  options.min_threads = kMinThreads;
+  options.max_threads = kMaxThreads;
+  WorkerPoolAutoscaler autoscaler(&server, options);
+  const clock::time_point start = clock::now();
+  autoscaler.SetResizeCallback([&label, start](size_t from, size_t to) {
+    cout << label << " resize_ms="
+         << std::chrono::duration_cast<std::chrono::milliseconds>(
+                clock::now() - start).count()
+         << " from=" << from << " to=" << to << endl;
+  });
+  if (autoscale && !autoscaler.Start()) {
+    cerr << "Failed to start the autoscaler" << endl;
+    return false;
+  }
+
+  bool success = RunPhase(label, "burst", bench, &server, kBurstClients,
+                          kBurstDuration);
+  success &= RunPhase(label, "lull", bench, &server, kLullClients,
+                      kLullDuration);
+
+  autoscaler.Stop();
+  server.Stop();
+  return success;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sp<LoadBench> service = new LoadBench();
+
+  const string path =
+      BenchmarkSocketPath(argc, argv, "aidl_autoscale_benchmark");
+
+  bool success = RunBenchmark("fixed", path, service, false);
+  success &= RunBenchmark("autoscaled", path, service, true);
+
+  // What the generated BnLoadBench measured over both runs.
+  const TransactionStats work = service->GetTransactionMetrics().Method(0);
+  if (work.calls > 0) {
+    cout << "Work calls=" << work.calls
+         << " service_us=" << (work.service_time_ns / work.calls / 1000)
+         << " queue_delay_us=" << (work.queue_delay_ns / work.calls / 1000)
+         << endl;
+  }
+  return success ? 0 : 1;
+}
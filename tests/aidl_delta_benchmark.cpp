@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares full and @delta replies for an inout array as the fraction of
+// elements the server modifies goes from none to all of them.  The proxy
+// talks to an in-process BnDeltaBuffer through a binder that counts reply
+// bytes, so both sides run the generated serialization.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <binder/Status.h>
+#include <utils/StrongPointer.h>
+
+#include "android/aidl/tests/BnDeltaBuffer.h"
+#include "android/aidl/tests/BpDeltaBuffer.h"
+
+using android::BBinder;
+using android::IBinder;
+using android::Parcel;
+using android::sp;
+using android::status_t;
+using android::aidl::tests::BnDeltaBuffer;
+using android::aidl::tests::BpDeltaBuffer;
+using android::aidl::tests::IDeltaBuffer;
+using android::binder::Status;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const size_t kBufferSize = 64 * 1024;
+const int kCalls = 200;
+
+class DeltaBuffer : public BnDeltaBuffer {
+ public:
+  Status Touch(vector<int32_t>* buffer, int32_t stride) override {
+    Increment(buffer, stride);
+    return Status::ok();
+  }
+
+  Status TouchDelta(vector<int32_t>* buffer, int32_t stride) override {
+    Increment(buffer, stride);
+    return Status::ok();
+  }
+
+ private:
+  static void Increment(vector<int32_t>* buffer, int32_t stride) {
+    if (stride <= 0) {
+      return;
+    }
+    for (size_t i = 0; i < buffer->size(); i += stride) {
+      ++(*buffer)[i];
+    }
+  }
+};
+
+// Forwards transactions to |service| and adds up the size of the replies.
+class CountingBinder : public BBinder {
+ public:
+  explicit CountingBinder(const sp<IBinder>& service) : service_(service) {}
+
+  status_t transact(uint32_t code, const Parcel& data, Parcel* reply,
+                    uint32_t flags) override {
+    status_t status = service_->transact(code, data, reply, flags);
+    if (reply != nullptr) {
+      reply_bytes_ += reply->dataSize();
+    }
+    return status;
+  }
+
+  size_t TakeReplyBytes() {
+    size_t bytes = reply_bytes_;
+    reply_bytes_ = 0;
+    return bytes;
+  }
+
+ private:
+  const sp<IBinder> service_;
+  size_t reply_bytes_ = 0;
+};
+
+bool RunBenchmark(const sp<IDeltaBuffer>& proxy, CountingBinder* counter,
+                  int32_t stride, bool delta) {
+  using clock = std::chrono::steady_clock;
+  vector<int32_t> buffer(kBufferSize);
+  vector<int32_t> expected(kBufferSize);
+
+  counter->TakeReplyBytes();
+  const clock::time_point start = clock::now();
+  for (int call = 0; call < kCalls; ++call) {
+    Status status = (delta) ? proxy->TouchDelta(&buffer, stride)
+                            : proxy->Touch(&buffer, stride);
+    if (!status.isOk()) {
+      cerr << "Call failed: " << status.toString8().string() << endl;
+      return false;
+    }
+  }
+  const double seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+
+  for (size_t i = 0; stride > 0 && i < expected.size(); i += stride) {
+    expected[i] = kCalls;
+  }
+  if (buffer != expected) {
+    cerr << "Buffer contents are wrong after " << kCalls << " calls" << endl;
+    return false;
+  }
+
+  const double ratio = (stride > 0) ? 1.0 / stride : 0.0;
+  cout << ((delta) ? "delta" : "full") << " modified_ratio=" << ratio
+       << " reply_bytes=" << (counter->TakeReplyBytes() / kCalls)
+       << " latency_us=" << (seconds * 1e6 / kCalls) << endl;
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  sp<IBinder> service = new DeltaBuffer();
+  sp<CountingBinder> counter = new CountingBinder(service);
+  // Wrap the binder in a proxy directly; asInterface() would notice that it
+  // is local and bypass serialization altogether.
+  sp<IDeltaBuffer> proxy = new BpDeltaBuffer(counter);
+
+  bool success = true;
+  for (int32_t stride : {0, 1000, 100, 10, 2, 1}) {
+    success &= RunBenchmark(proxy, counter.get(), stride, false);
+    success &= RunBenchmark(proxy, counter.get(), stride, true);
+  }
+  return success ? 0 : 1;
+}
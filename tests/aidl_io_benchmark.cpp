@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures how the compiler behaves on slow storage by running it against a
+// SlowIoDelegate.  Import resolution searches many include directories,
+// preprocessed loading reads one large preprocessed file instead, and output
+// writing generates C++ for an interface with many methods.  Each scenario
+// runs on storage without latency, on simulated network storage, and on the
+// real filesystem under a temporary directory, both with I/O on the main
+// thread and through an AsyncIoDelegate.  It reports the wall time and, for
+// simulated storage, how often each operation ran.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android-base/stringprintf.h>
+
+#include "aidl.h"
+#include "async_io_delegate.h"
+#include "io_delegate.h"
+#include "options.h"
+#include "tests/slow_io_delegate.h"
+
+using android::aidl::AsyncIoDelegate;
+using android::aidl::CppOptions;
+using android::aidl::IoDelegate;
+using android::aidl::JavaOptions;
+using android::aidl::compile_aidl_to_cpp;
+using android::aidl::compile_aidl_to_java;
+using android::aidl::test::SlowIoDelegate;
+using android::base::StringAppendF;
+using android::base::StringPrintf;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+const int kImports = 50;
+const int kImportDirs = 8;
+const int kMethods = 200;
+const char kInterfacePath[] = "src/a/IBench.aidl";
+const size_t kIoThreads = 8;
+
+// Adds a file for a scenario to read.
+using AddFile = std::function<void(const string& path,
+                                   const string& contents)>;
+using Scenario = std::function<int(const AddFile& add_file,
+                                   const IoDelegate& io_delegate)>;
+
+// Declares IBench, which takes each of |parcelable_count| parcelables in one
+// method and has |method_count| methods in all.
+string MakeInterface(int parcelable_count, int method_count) {
+  string contents = "package a;\n";
+  for (int i = 0; i < parcelable_count; ++i) {
+    StringAppendF(&contents, "import b.P%d;\n", i);
+  }
+  contents += "interface IBench {\n";
+  for (int i = 0; i < method_count; ++i) {
+    if (i < parcelable_count) {
+      StringAppendF(&contents, "  void M%d(in P%d p);\n", i, i);
+    } else {
+      StringAppendF(&contents, "  int M%d(int a, String b);\n", i);
+    }
+  }
+  contents += "}\n";
+  return contents;
+}
+
+// Parcelables live in the last of the include directories, so every lookup
+// misses in all the others first.
+void AddImportDirs(const AddFile& add_file, vector<string>* args) {
+  for (int dir = 0; dir < kImportDirs; ++dir) {
+    args->push_back(StringPrintf("-Iinclude%d", dir));
+  }
+  for (int i = 0; i < kImports; ++i) {
+    add_file(StringPrintf("include%d/b/P%d.aidl", kImportDirs - 1, i),
+             StringPrintf("package b;\nparcelable P%d;\n", i));
+  }
+}
+
+int ImportResolution(const AddFile& add_file, const IoDelegate& io_delegate) {
+  add_file(kInterfacePath, MakeInterface(kImports, kImports));
+  vector<string> args = {"aidl"};
+  AddImportDirs(add_file, &args);
+  args.push_back(kInterfacePath);
+  args.push_back("out/IBench.java");
+
+  vector<const char*> argv;
+  for (const string& arg : args) {
+    argv.push_back(arg.c_str());
+  }
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(argv.size(),
+                                                       argv.data());
+  return compile_aidl_to_java(*options, io_delegate);
+}
+
+int PreprocessedLoading(const AddFile& add_file,
+                        const IoDelegate& io_delegate) {
+  add_file(kInterfacePath, MakeInterface(kImports, kImports));
+  string preprocessed;
+  for (int i = 0; i < kImports; ++i) {
+    StringAppendF(&preprocessed, "parcelable b.P%d;\n", i);
+  }
+  add_file("preprocessed.aidl", preprocessed);
+  vector<string> args = {"aidl", "-ppreprocessed.aidl"};
+  AddImportDirs(add_file, &args);
+  args.push_back(kInterfacePath);
+  args.push_back("out/IBench.java");
+
+  vector<const char*> argv;
+  for (const string& arg : args) {
+    argv.push_back(arg.c_str());
+  }
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(argv.size(),
+                                                       argv.data());
+  return compile_aidl_to_java(*options, io_delegate);
+}
+
+int OutputWriting(const AddFile& add_file, const IoDelegate& io_delegate) {
+  add_file(kInterfacePath, MakeInterface(0, kMethods));
+  const char* argv[] = {"aidl-cpp", "-dout/IBench.d", kInterfacePath,
+                        "out/include", "out/IBench.cpp"};
+  unique_ptr<CppOptions> options = CppOptions::Parse(arraysize(argv), argv);
+  return compile_aidl_to_cpp(*options, io_delegate);
+}
+
+// Compiles with I/O on the main thread, or on |io_threads| threads.
+int Compile(const Scenario& scenario, const AddFile& add_file,
+            const IoDelegate& io_delegate, size_t io_threads) {
+  if (io_threads == 0) {
+    return scenario(add_file, io_delegate);
+  }
+  AsyncIoDelegate async_io_delegate(io_delegate, io_threads);
+  const int result = scenario(add_file, async_io_delegate);
+  return (async_io_delegate.FinishWrites()) ? result : 1;
+}
+
+double Time(const std::function<int()>& run, int* result) {
+  using clock = std::chrono::steady_clock;
+  const clock::time_point start = clock::now();
+  *result = run();
+  return std::chrono::duration<double>(clock::now() - start).count();
+}
+
+bool RunScenario(const string& label, const Scenario& scenario,
+                 bool network_filesystem, size_t io_threads) {
+  SlowIoDelegate io_delegate;
+  if (network_filesystem) {
+    io_delegate.SimulateNetworkFilesystem();
+  }
+  const AddFile add_file = [&io_delegate](const string& path,
+                                          const string& contents) {
+    io_delegate.SetFileContents(path, contents);
+  };
+
+  int result;
+  const double seconds = Time([&]() {
+    return Compile(scenario, add_file, io_delegate, io_threads);
+  }, &result);
+  if (result != 0) {
+    cerr << label << ": compilation failed" << endl;
+    return false;
+  }
+
+  cout << label << " storage=" << ((network_filesystem) ? "nfs" : "local")
+       << " io_threads=" << io_threads << " time_ms=" << (seconds * 1e3);
+  for (int i = 0; i < SlowIoDelegate::OPERATION_COUNT; ++i) {
+    const auto operation = static_cast<SlowIoDelegate::Operation>(i);
+    cout << " " << SlowIoDelegate::OperationName(operation) << "="
+         << io_delegate.GetCallCount(operation);
+  }
+  cout << endl;
+  return true;
+}
+
+// Runs |scenario| against files in a fresh temporary directory.
+bool RunScenarioOnDisk(const string& label, const Scenario& scenario,
+                       size_t io_threads) {
+  char dir[] = "/tmp/aidl_io_benchmark.XXXXXX";
+  if (mkdtemp(dir) == nullptr || chdir(dir) != 0) {
+    cerr << label << ": cannot create a temporary directory" << endl;
+    return false;
+  }
+  IoDelegate io_delegate;
+  bool files_written = true;
+  const AddFile add_file = [&](const string& path, const string& contents) {
+    std::ofstream out;
+    if (io_delegate.CreatePathForFile(path)) {
+      out.open(path, std::ios::out | std::ios::binary);
+    }
+    out << contents;
+    files_written = files_written && out.good();
+  };
+  io_delegate.CreatePathForFile("out/include/");
+
+  int result;
+  const double seconds = Time([&]() {
+    return Compile(scenario, add_file, io_delegate, io_threads);
+  }, &result);
+  const string cleanup = StringPrintf("rm -rf %s", dir);
+  if (chdir("/") != 0 || system(cleanup.c_str()) != 0) {
+    cerr << label << ": cannot remove " << dir << endl;
+  }
+  if (result != 0 || !files_written) {
+    cerr << label << ": compilation failed" << endl;
+    return false;
+  }
+
+  cout << label << " storage=disk io_threads=" << io_threads
+       << " time_ms=" << (seconds * 1e3) << endl;
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  const vector<std::pair<string, Scenario>> scenarios = {
+      {"import_resolution", ImportResolution},
+      {"preprocessed_loading", PreprocessedLoading},
+      {"output_writing", OutputWriting},
+  };
+  bool success = true;
+  for (size_t io_threads : {size_t{0}, kIoThreads}) {
+    for (bool network_filesystem : {false, true}) {
+      for (const auto& scenario : scenarios) {
+        success &= RunScenario(scenario.first, scenario.second,
+                               network_filesystem, io_threads);
+      }
+    }
+    for (const auto& scenario : scenarios) {
+      success &= RunScenarioOnDisk(scenario.first, scenario.second,
+                                   io_threads);
+    }
+  }
+  return success ? 0 : 1;
+}
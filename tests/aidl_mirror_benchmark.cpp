@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares a @mirrored method read from its state mirror with the same
+// call made over IPC, through the socket transport.  Each reports the mean
+// latency per call, first with a single reader and then with many readers
+// while a writer keeps publishing new snapshots.
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <binder/IBinder.h>
+#include <binder/Parcel.h>
+#include <binder/Status.h>
+#include <utils/StrongPointer.h>
+
+#include "android/aidl/tests/BnMirrorBench.h"
+#include "android/aidl/tests/IMirrorBench.h"
+#include "tests/simple_parcelable.h"
+#include "tests/test_util.h"
+#include "transport/socket_transport.h"
+
+using android::IBinder;
+using android::OK;
+using android::Parcel;
+using android::sp;
+using android::aidl::test::BenchmarkSocketPath;
+using android::aidl::tests::BnMirrorBench;
+using android::aidl::tests::IMirrorBench;
+using android::aidl::tests::SimpleParcelable;
+using android::aidl::transport::SocketBinder;
+using android::aidl::transport::SocketServer;
+using android::binder::Status;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+const int kIterations = 20000;
+const int kReaders = 8;
+const size_t kServerThreads = 4;
+
+class MirrorBench : public BnMirrorBench {
+ public:
+  MirrorBench() {
+    Bump();
+  }
+
+  Status GetState(SimpleParcelable* ret) override {
+    *ret = SimpleParcelable("mirror", version_);
+    return Status::ok();
+  }
+
+  Status Bump() override {
+    PublishState(SimpleParcelable("mirror", ++version_));
+    return Status::ok();
+  }
+
+ private:
+  std::atomic<int32_t> version_{0};
+};
+
+// Calls GetState() over IPC, skipping the mirror the generated proxy would
+// read from.
+bool GetStateOverIpc(const sp<IBinder>& binder, SimpleParcelable* state) {
+  Parcel data;
+  Parcel reply;
+  Status status;
+  return data.writeInterfaceToken(IMirrorBench::descriptor) == OK &&
+         binder->transact(IMirrorBench::GETSTATE, data, &reply) == OK &&
+         status.readFromParcel(reply) == OK && status.isOk() &&
+         reply.readParcelable(state) == OK;
+}
+
+// Calls |get_state| |kIterations| times from each of |readers| threads,
+// while another thread calls Bump() if |publish| is set.
+bool Run(const string& label, const sp<IMirrorBench>& bench, int readers,
+         bool publish, const std::function<bool(SimpleParcelable*)>& get_state) {
+  std::atomic<bool> success(true);
+  std::atomic<bool> done(false);
+  std::thread writer;
+  if (publish) {
+    writer = std::thread([&bench, &done, &success]() {
+      while (!done) {
+        if (!bench->Bump().isOk()) {
+          success = false;
+          return;
+        }
+      }
+    });
+  }
+
+  vector<std::thread> threads;
+  const clock::time_point start = clock::now();
+  for (int i = 0; i < readers; ++i) {
+    threads.emplace_back([&get_state, &success]() {
+      SimpleParcelable state;
+      for (int j = 0; j < kIterations; ++j) {
+        if (!get_state(&state)) {
+          success = false;
+          return;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const double seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+  done = true;
+  if (writer.joinable()) {
+    writer.join();
+  }
+
+  cout << label << " readers=" << readers << " publishing=" << publish
+       << " latency_us=" << (seconds * 1e6 / kIterations)
+       << " calls_per_second=" << (kIterations * readers / seconds) << endl;
+  if (!success) {
+    cerr << label << ": call failed" << endl;
+  }
+  return success.load();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const string path = BenchmarkSocketPath(argc, argv, "aidl_mirror_benchmark");
+
+  sp<MirrorBench> service = new MirrorBench();
+  SocketServer server(service);
+  if (!server.Listen(path) || !server.Start(kServerThreads)) {
+    cerr << "Failed to start socket server on " << path << endl;
+    return 1;
+  }
+  sp<IBinder> binder = SocketBinder::Connect(path);
+  sp<IMirrorBench> bench = IMirrorBench::asInterface(binder);
+  if (bench == nullptr) {
+    cerr << "Failed to connect to " << path << endl;
+    return 1;
+  }
+
+  auto from_mirror = [&bench](SimpleParcelable* state) {
+    return bench->GetState(state).isOk();
+  };
+  auto over_ipc = [&binder](SimpleParcelable* state) {
+    return GetStateOverIpc(binder, state);
+  };
+
+  bool success = true;
+  for (bool publish : {false, true}) {
+    for (int readers : {1, kReaders}) {
+      success &= Run("ipc", bench, readers, publish, over_ipc);
+      success &= Run("mirror", bench, readers, publish, from_mirror);
+    }
+  }
+
+  server.Stop();
+  return success ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the bison parser with the recursive descent one.  Each parses an
+// interface with many methods and a file of many parcelables, and we report
+// the time and the heap allocations per parse.  Both read the file through
+// a FakeIoDelegate, whose copy of the contents is counted too.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <android-base/stringprintf.h>
+
+#include "aidl_language.h"
+#include "tests/allocation_counter.h"
+#include "tests/fake_io_delegate.h"
+
+using android::aidl::test::FakeIoDelegate;
+using android::aidl::tests::ScopedAllocationCounter;
+using android::base::StringAppendF;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const int kMethods = 500;
+const int kParcelables = 2000;
+const int kIterations = 200;
+const char kFileName[] = "a/IBench.aidl";
+
+string MakeInterface() {
+  string contents = "package a;\nimport b.P;\n\n/** Benchmark. */\n";
+  contents += "interface IBench {\n  const int VERSION = 1;\n";
+  for (int i = 0; i < kMethods; ++i) {
+    StringAppendF(&contents, "  // Method %d.\n", i);
+    switch (i % 4) {
+      case 0:
+        StringAppendF(&contents, "  void M%d(in int[] a, out P b);\n", i);
+        break;
+      case 1:
+        StringAppendF(&contents,
+                      "  @nullable @utf8InCpp String M%d(\n"
+                      "      inout List<String> a, in Map<String, b.P> b);\n",
+                      i);
+        break;
+      case 2:
+        StringAppendF(&contents, "  oneway void M%d(long a, double b) = %d;\n",
+                      i, i + 1000);
+        break;
+      default:
+        StringAppendF(&contents, "  int M%d();\n", i);
+        break;
+    }
+  }
+  contents += "}\n";
+  return contents;
+}
+
+string MakeParcelables() {
+  string contents = "package b;\n";
+  for (int i = 0; i < kParcelables; ++i) {
+    StringAppendF(&contents, "parcelable P%d cpp_header \"b/P%d.h\";\n",
+                  i, i);
+  }
+  return contents;
+}
+
+bool Benchmark(const string& label, const string& contents,
+               Parser::Implementation implementation) {
+  FakeIoDelegate io_delegate;
+  io_delegate.SetFileContents(kFileName, contents);
+
+  size_t allocations = 0;
+  size_t bytes = 0;
+  using clock = std::chrono::steady_clock;
+  const clock::time_point start = clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    Parser parser(io_delegate, implementation);
+    ScopedAllocationCounter counter;
+    if (!parser.ParseFile(kFileName)) {
+      cerr << label << ": parse failed" << endl;
+      return false;
+    }
+    allocations += counter.allocations();
+    bytes += counter.bytes();
+  }
+  const double seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+
+  cout << label << " parser="
+       << ((implementation == Parser::BISON) ? "bison" : "recursive_descent")
+       << " us_per_parse=" << (seconds * 1e6 / kIterations)
+       << " mb_per_s=" << (contents.size() * kIterations / seconds / 1e6)
+       << " allocations_per_parse=" << (allocations / kIterations)
+       << " bytes_per_parse=" << (bytes / kIterations) << endl;
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  const vector<std::pair<string, string>> inputs = {
+      {"interface", MakeInterface()},
+      {"parcelables", MakeParcelables()},
+  };
+  bool success = true;
+  for (const auto& input : inputs) {
+    for (Parser::Implementation implementation :
+         {Parser::BISON, Parser::RECURSIVE_DESCENT}) {
+      success &= Benchmark(input.first, input.second, implementation);
+    }
+  }
+  return success ? 0 : 1;
+}
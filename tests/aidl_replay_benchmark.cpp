@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reruns aidl and aidl-cpp invocations captured from a real build with
+// AIDL_CAPTURE_DIR set, in process and with every file in memory, and
+// reports how long each took.  Takes capture files, or directories of them:
+//
+//   aidl_replay_benchmark [--iterations=N] <capture or dir>...
+
+#include <dirent.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aidl.h"
+#include "options.h"
+#include "recording_io_delegate.h"
+#include "tests/fake_io_delegate.h"
+
+using android::aidl::BuildCapture;
+using android::aidl::CppOptions;
+using android::aidl::IoDelegate;
+using android::aidl::JavaOptions;
+using android::aidl::test::FakeIoDelegate;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+const char kIterationsFlag[] = "--iterations=";
+const char kCaptureSuffix[] = ".capture";
+
+// Adds |path| to |captures|, or the captures in it if it is a directory.
+void FindCaptures(const string& path, vector<string>* captures) {
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    captures->push_back(path);
+    return;
+  }
+  vector<string> found;
+  while (dirent* entry = readdir(dir)) {
+    const string name = entry->d_name;
+    if (name.size() > strlen(kCaptureSuffix) &&
+        name.compare(name.size() - strlen(kCaptureSuffix), string::npos,
+                     kCaptureSuffix) == 0) {
+      found.push_back(path + "/" + name);
+    }
+  }
+  closedir(dir);
+  std::sort(found.begin(), found.end());
+  captures->insert(captures->end(), found.begin(), found.end());
+}
+
+// Runs the command line in |capture| the way main_java.cpp or main_cpp.cpp
+// would, and returns its status.
+int Run(const BuildCapture& capture, const IoDelegate& io_delegate) {
+  vector<const char*> argv{capture.tool.c_str()};
+  for (const string& arg : capture.args) {
+    argv.push_back(arg.c_str());
+  }
+  if (capture.tool == "aidl-cpp") {
+    unique_ptr<CppOptions> options =
+        CppOptions::Parse(argv.size(), argv.data());
+    if (!options) {
+      return 1;
+    }
+    return android::aidl::compile_aidl_to_cpp(*options, io_delegate);
+  }
+
+  unique_ptr<JavaOptions> options =
+      JavaOptions::Parse(argv.size(), argv.data());
+  if (!options) {
+    return 1;
+  }
+  switch (options->task) {
+    case JavaOptions::COMPILE_AIDL_TO_JAVA:
+      return android::aidl::compile_aidl_to_java(*options, io_delegate);
+    case JavaOptions::PREPROCESS_AIDL:
+      return android::aidl::preprocess_aidl(*options, io_delegate) ? 0 : 1;
+    case JavaOptions::BUNDLE_AIDL:
+      return android::aidl::bundle_aidl(*options, io_delegate) ? 0 : 1;
+    case JavaOptions::COMPILE_BUNDLE_TO_JAVA:
+      return android::aidl::compile_bundle_to_java(options.get(),
+                                                   io_delegate);
+  }
+  return 1;
+}
+
+// Replays |capture| |iterations| times and returns the mean time taken, or
+// a negative time if it didn't return what it returned when captured.
+double Replay(const string& path, const BuildCapture& capture,
+              int iterations) {
+  using clock = std::chrono::steady_clock;
+  clock::duration total{0};
+  for (int i = 0; i < iterations; ++i) {
+    // A fresh delegate each time, so outputs of one run don't leak into
+    // the next.  Filling it in isn't part of the time.
+    FakeIoDelegate io_delegate;
+    for (const auto& file : capture.files) {
+      // FakeIoDelegate looks files up without a leading "./".
+      string file_path = file.first;
+      while (file_path.compare(0, 2, "./") == 0) {
+        file_path.erase(0, 2);
+      }
+      io_delegate.SetFileContents(file_path, file.second);
+    }
+
+    const clock::time_point start = clock::now();
+    const int status = Run(capture, io_delegate);
+    total += clock::now() - start;
+    if (status != capture.status) {
+      cerr << path << ": returned " << status << " instead of "
+           << capture.status << endl;
+      return -1;
+    }
+  }
+  return std::chrono::duration<double>(total).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = 10;
+  vector<string> captures;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], kIterationsFlag, strlen(kIterationsFlag)) == 0) {
+      iterations = std::max(atoi(argv[i] + strlen(kIterationsFlag)), 1);
+    } else {
+      FindCaptures(argv[i], &captures);
+    }
+  }
+  if (captures.empty()) {
+    cerr << "usage: " << argv[0] << " [--iterations=N] <capture or dir>..."
+         << endl;
+    return 1;
+  }
+
+  bool success = true;
+  double total_seconds = 0;
+  size_t total_bytes = 0;
+  for (const string& path : captures) {
+    BuildCapture capture;
+    if (!capture.Load(path)) {
+      success = false;
+      continue;
+    }
+    size_t bytes = 0;
+    for (const auto& file : capture.files) {
+      bytes += file.second.size();
+    }
+    const double seconds = Replay(path, capture, iterations);
+    if (seconds < 0) {
+      success = false;
+      continue;
+    }
+    total_seconds += seconds;
+    total_bytes += bytes;
+    cout << path << " tool=" << capture.tool
+         << " files_read=" << capture.files.size()
+         << " bytes_read=" << bytes
+         << " us=" << (seconds * 1e6) << endl;
+  }
+  cout << "total invocations=" << captures.size()
+       << " bytes_read=" << total_bytes
+       << " us=" << (total_seconds * 1e6) << endl;
+  return success ? 0 : 1;
+}
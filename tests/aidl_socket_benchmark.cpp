@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares generated proxies talking over the socket transport against the
+// same proxies calling straight into an in-process BnFoo.  Both paths run the
+// generated serialization, so the difference is the cost of the transport.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <binder/Status.h>
+#include <utils/String16.h>
+#include <utils/StrongPointer.h>
+
+#include "android/aidl/tests/BnNamedCallback.h"
+#include "android/aidl/tests/BpNamedCallback.h"
+#include "android/aidl/tests/INamedCallback.h"
+#include "tests/test_util.h"
+#include "transport/socket_transport.h"
+
+using android::IBinder;
+using android::String16;
+using android::sp;
+using android::aidl::test::BenchmarkSocketPath;
+using android::aidl::tests::BnNamedCallback;
+using android::aidl::tests::BpNamedCallback;
+using android::aidl::tests::INamedCallback;
+using android::aidl::transport::SocketBinder;
+using android::aidl::transport::SocketServer;
+using android::binder::Status;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const int kCallsPerThread = 20000;
+const size_t kServerThreads = 4;
+
+class NamedCallback : public BnNamedCallback {
+ public:
+  explicit NamedCallback(const String16& name) : name_(name) {}
+
+  Status GetName(String16* ret) override {
+    *ret = name_;
+    return Status::ok();
+  }
+
+ private:
+  const String16 name_;
+};
+
+// Makes |calls| calls per thread on |thread_count| threads and reports the
+// mean latency and the aggregate throughput.
+bool RunBenchmark(const string& label, const sp<INamedCallback>& callback,
+                  int thread_count, int calls) {
+  using clock = std::chrono::steady_clock;
+  std::atomic<bool> success(true);
+  vector<std::thread> threads;
+
+  const clock::time_point start = clock::now();
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&callback, &success, calls]() {
+      String16 name;
+      for (int call = 0; call < calls; ++call) {
+        if (!callback->GetName(&name).isOk()) {
+          success = false;
+          return;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const double seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+
+  const double total_calls = static_cast<double>(thread_count) * calls;
+  cout << label << " threads=" << thread_count
+       << " latency_us=" << (seconds * 1e6 * thread_count / total_calls)
+       << " calls_per_second=" << (total_calls / seconds) << endl;
+  if (!success) {
+    cerr << label << ": call failed" << endl;
+  }
+  return success.load();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sp<IBinder> service = new NamedCallback(String16("benchmark"));
+
+  const string path = BenchmarkSocketPath(argc, argv, "aidl_socket_benchmark");
+  SocketServer server(service);
+  if (!server.Listen(path) || !server.Start(kServerThreads)) {
+    cerr << "Failed to start socket server on " << path << endl;
+    return 1;
+  }
+  sp<SocketBinder> remote = SocketBinder::Connect(path);
+  if (remote == nullptr) {
+    cerr << "Failed to connect to " << path << endl;
+    return 1;
+  }
+
+  // Wrap the local service in a proxy directly; asInterface() would notice
+  // that it is local and bypass serialization altogether.
+  sp<INamedCallback> in_process = new BpNamedCallback(service);
+  sp<INamedCallback> over_socket = INamedCallback::asInterface(remote);
+
+  bool success = true;
+  for (int threads : {1, 4}) {
+    success &= RunBenchmark("in_process", in_process, threads,
+                            kCallsPerThread);
+    success &= RunBenchmark("unix_socket", over_socket, threads,
+                            kCallsPerThread);
+  }
+
+  server.Stop();
+  return success ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures what loading generated interfaces costs a process at startup.
+// libaidl-startup-generated holds interfaces compiled by aidl-cpp, and
+// libaidl-startup-meta-interface the same interfaces with the descriptors
+// IMPLEMENT_META_INTERFACE defines.  Each is loaded once, and reported with
+// the number of dynamic initializers in its .init_array, the heap
+// allocations those made and how long dlopen() took.
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+
+#include "tests/allocation_counter.h"
+
+using android::aidl::tests::ScopedAllocationCounter;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// Loaded up front, so that their own initializers aren't counted against
+// whichever library is measured first.
+const char* const kDependencies[] = {"libutils.so", "libbinder.so"};
+
+struct InitArrayQuery {
+  const char* library;
+  size_t entries;
+  bool found;
+};
+
+int CountInitArray(struct dl_phdr_info* info, size_t /* size */,
+                   void* data) {
+  InitArrayQuery* query = static_cast<InitArrayQuery*>(data);
+  const char* slash = strrchr(info->dlpi_name, '/');
+  const char* name = (slash == nullptr) ? info->dlpi_name : slash + 1;
+  if (strcmp(name, query->library) != 0) {
+    return 0;
+  }
+  query->found = true;
+  for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+    if (phdr.p_type != PT_DYNAMIC) {
+      continue;
+    }
+    const ElfW(Dyn)* dyn =
+        reinterpret_cast<const ElfW(Dyn)*>(info->dlpi_addr + phdr.p_vaddr);
+    for (; dyn->d_tag != DT_NULL; ++dyn) {
+      if (dyn->d_tag == DT_INIT_ARRAYSZ) {
+        query->entries = dyn->d_un.d_val / sizeof(ElfW(Addr));
+      }
+    }
+  }
+  return 1;
+}
+
+bool Measure(const string& label, const char* library) {
+  void* handle;
+  clock::duration elapsed;
+  size_t allocations;
+  {
+    ScopedAllocationCounter counter;
+    const clock::time_point start = clock::now();
+    handle = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+    elapsed = clock::now() - start;
+    allocations = counter.allocations();
+  }
+  if (handle == nullptr) {
+    cerr << label << ": " << dlerror() << endl;
+    return false;
+  }
+
+  InitArrayQuery query = {library, 0, false};
+  dl_iterate_phdr(CountInitArray, &query);
+  if (!query.found) {
+    cerr << label << ": " << library << " is not loaded" << endl;
+    return false;
+  }
+  cout << label << " init_array_entries=" << query.entries
+       << " allocations=" << allocations << " dlopen_us="
+       << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+              .count()
+       << endl;
+  return true;
+}
+
+}  // namespace
+
+int main(int /* argc */, char** /* argv */) {
+  for (const char* dependency : kDependencies) {
+    if (dlopen(dependency, RTLD_NOW) == nullptr) {
+      cerr << dlerror() << endl;
+      return 1;
+    }
+  }
+
+  bool success = Measure("meta_interface", "libaidl-startup-meta-interface.so");
+  success &= Measure("generated", "libaidl-startup-generated.so");
+  return success ? 0 : 1;
+}
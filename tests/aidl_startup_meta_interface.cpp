@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The baseline for aidl_startup_benchmark: the interfaces that
+// libaidl-startup-generated compiles from .aidl files, with their
+// descriptors declared the way aidl-cpp used to, through
+// DECLARE_META_INTERFACE and IMPLEMENT_META_INTERFACE.  Their methods are
+// left out, as they don't run at load time.  Being in one file, their
+// descriptors share a single .init_array entry, where aidl-cpp gave each
+// IFoo.cpp one of its own.
+
+#include <binder/IBinder.h>
+#include <binder/IInterface.h>
+#include <utils/String16.h>
+#include <utils/StrongPointer.h>
+
+#define STARTUP_META_INTERFACE(NAME)                                  \
+  class I##NAME : public ::android::IInterface {                      \
+   public:                                                            \
+    DECLARE_META_INTERFACE(NAME);                                     \
+  };                                                                  \
+  class Bp##NAME : public ::android::BpInterface<I##NAME> {           \
+   public:                                                            \
+    explicit Bp##NAME(const ::android::sp<::android::IBinder>& impl)  \
+        : ::android::BpInterface<I##NAME>(impl) {}                    \
+  };                                                                  \
+  IMPLEMENT_META_INTERFACE(NAME, "android.aidl.tests.I" #NAME)
+
+namespace android {
+namespace aidl {
+namespace tests {
+namespace meta_interface {
+
+STARTUP_META_INTERFACE(NamedCallback);
+STARTUP_META_INTERFACE(DeltaBuffer);
+STARTUP_META_INTERFACE(LoadBench);
+STARTUP_META_INTERFACE(PooledParcelBench);
+
+}  // namespace meta_interface
+}  // namespace tests
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Counts the heap allocations made by generated code for one call of each
+// kind of ITestService method.  The proxy and the stub are measured
+// separately, both without the binder driver: BpTestService talks to a
+// binder that replays a recorded reply, and BnTestService::onTransact() is
+// handed a recorded request.  Counts are reported as test properties, named
+// "<method>.client" and "<method>.server", so that they can be tracked.
+
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <binder/Status.h>
+#include <gtest/gtest.h>
+#include <nativehelper/ScopedFd.h>
+#include <utils/String16.h>
+#include <utils/StrongPointer.h>
+
+#include "android/aidl/tests/BnTestService.h"
+#include "android/aidl/tests/BpTestService.h"
+#include "android/aidl/tests/ITestService.h"
+#include "tests/allocation_counter.h"
+
+using android::BBinder;
+using android::IBinder;
+using android::OK;
+using android::Parcel;
+using android::String16;
+using android::binder::Status;
+using android::sp;
+using android::status_t;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace tests {
+
+namespace {
+
+template <typename T>
+Status Reverse(const vector<T>& input, vector<T>* repeated,
+               vector<T>* _aidl_return) {
+  *repeated = input;
+  *_aidl_return = vector<T>(input.rbegin(), input.rend());
+  return Status::ok();
+}
+
+// Does as little as possible beyond what the interface asks for, so that
+// the counts are dominated by generated code.
+class TestService : public BnTestService {
+ public:
+  Status RepeatBoolean(bool token, bool* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatByte(int8_t token, int8_t* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatChar(char16_t token, char16_t* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatInt(int32_t token, int32_t* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatLong(int64_t token, int64_t* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatFloat(float token, float* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatDouble(double token, double* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatString(const String16& token, String16* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status SumPrimitives(bool a, int8_t b, char16_t c, int32_t d, int64_t e,
+                       float f, double g, double* _aidl_return) override {
+    *_aidl_return = a + b + c + d + e + f + g;
+    return Status::ok();
+  }
+  Status RepeatSimpleParcelable(const SimpleParcelable& input,
+                                SimpleParcelable* repeat,
+                                SimpleParcelable* _aidl_return) override {
+    *repeat = input;
+    *_aidl_return = input;
+    return Status::ok();
+  }
+  Status RepeatPersistableBundle(
+      const os::PersistableBundle& input,
+      os::PersistableBundle* _aidl_return) override {
+    *_aidl_return = input;
+    return Status::ok();
+  }
+  Status ReverseBoolean(const vector<bool>& input, vector<bool>* repeated,
+                        vector<bool>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseByte(const vector<uint8_t>& input, vector<uint8_t>* repeated,
+                     vector<uint8_t>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseChar(const vector<char16_t>& input, vector<char16_t>* repeated,
+                     vector<char16_t>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseInt(const vector<int32_t>& input, vector<int32_t>* repeated,
+                    vector<int32_t>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseLong(const vector<int64_t>& input, vector<int64_t>* repeated,
+                     vector<int64_t>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseFloat(const vector<float>& input, vector<float>* repeated,
+                      vector<float>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseDouble(const vector<double>& input, vector<double>* repeated,
+                       vector<double>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseString(const vector<String16>& input,
+                       vector<String16>* repeated,
+                       vector<String16>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseSimpleParcelables(
+      const vector<SimpleParcelable>& input,
+      vector<SimpleParcelable>* repeated,
+      vector<SimpleParcelable>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReversePersistableBundles(
+      const vector<os::PersistableBundle>& input,
+      vector<os::PersistableBundle>* repeated,
+      vector<os::PersistableBundle>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status GetOtherTestService(
+      const String16& /* name */,
+      sp<INamedCallback>* /* returned_service */) override {
+    return Status::fromExceptionCode(Status::EX_UNSUPPORTED_OPERATION);
+  }
+  Status VerifyName(const sp<INamedCallback>& /* service */,
+                    const String16& /* name */,
+                    bool* /* returned_value */) override {
+    return Status::fromExceptionCode(Status::EX_UNSUPPORTED_OPERATION);
+  }
+  Status ReverseStringList(const vector<String16>& input,
+                           vector<String16>* repeated,
+                           vector<String16>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseNamedCallbackList(const vector<sp<IBinder>>& input,
+                                  vector<sp<IBinder>>* repeated,
+                                  vector<sp<IBinder>>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status RepeatFileDescriptor(const ScopedFd& /* read */,
+                              ScopedFd* /* _aidl_return */) override {
+    return Status::fromExceptionCode(Status::EX_UNSUPPORTED_OPERATION);
+  }
+  Status ReverseFileDescriptorArray(
+      const vector<ScopedFd>& /* input */, vector<ScopedFd>* /* repeated */,
+      vector<ScopedFd>* /* _aidl_return */) override {
+    return Status::fromExceptionCode(Status::EX_UNSUPPORTED_OPERATION);
+  }
+  Status ThrowServiceException(int code) override {
+    return Status::fromServiceSpecificError(code);
+  }
+  Status RepeatNullableIntArray(
+      const unique_ptr<vector<int32_t>>& input,
+      unique_ptr<vector<int32_t>>* _aidl_return) override {
+    return RepeatNullable(input, _aidl_return);
+  }
+  Status RepeatNullableString(const unique_ptr<String16>& input,
+                              unique_ptr<String16>* _aidl_return) override {
+    return RepeatNullable(input, _aidl_return);
+  }
+  Status RepeatNullableStringList(
+      const unique_ptr<vector<unique_ptr<String16>>>& input,
+      unique_ptr<vector<unique_ptr<String16>>>* _aidl_return) override {
+    if (!input) {
+      _aidl_return->reset();
+      return Status::ok();
+    }
+    _aidl_return->reset(new vector<unique_ptr<String16>>);
+    for (const auto& item : *input) {
+      (*_aidl_return)->emplace_back(item ? new String16(*item) : nullptr);
+    }
+    return Status::ok();
+  }
+  Status RepeatNullableParcelable(
+      const unique_ptr<SimpleParcelable>& input,
+      unique_ptr<SimpleParcelable>* _aidl_return) override {
+    return RepeatNullable(input, _aidl_return);
+  }
+  Status RepeatUtf8CppString(const string& token,
+                             string* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status RepeatNullableUtf8CppString(
+      const unique_ptr<string>& token,
+      unique_ptr<string>* _aidl_return) override {
+    return RepeatNullable(token, _aidl_return);
+  }
+  Status ReverseUtf8CppString(const vector<string>& input,
+                              vector<string>* repeated,
+                              vector<string>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseUtf8CppStringList(
+      const unique_ptr<vector<unique_ptr<string>>>& /* input */,
+      unique_ptr<vector<unique_ptr<string>>>* /* repeated */,
+      unique_ptr<vector<unique_ptr<string>>>* /* _aidl_return */) override {
+    return Status::fromExceptionCode(Status::EX_UNSUPPORTED_OPERATION);
+  }
+  Status RepeatByteEnum(ByteEnum token, ByteEnum* _aidl_return) override {
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status ReverseByteEnum(const vector<ByteEnum>& input,
+                         vector<ByteEnum>* repeated,
+                         vector<ByteEnum>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseNonNullParcelables(
+      const vector<SimpleParcelable>& input,
+      vector<SimpleParcelable>* repeated,
+      vector<SimpleParcelable>* _aidl_return) override {
+    return Reverse(input, repeated, _aidl_return);
+  }
+  Status ReverseSkippableInt(const vector<int32_t>& input,
+                             vector<int32_t>* repeated,
+                             vector<int32_t>* _aidl_return) override {
+    if (repeated) {
+      *repeated = input;
+    }
+    *_aidl_return = vector<int32_t>(input.rbegin(), input.rend());
+    return Status::ok();
+  }
+
+ private:
+  template <typename T>
+  Status RepeatNullable(const unique_ptr<T>& input, unique_ptr<T>* out) {
+    out->reset(input ? new T(*input) : nullptr);
+    return Status::ok();
+  }
+};
+
+// Passes transactions on to |service| and keeps a copy of the last request
+// and reply.
+class RecordingBinder : public BBinder {
+ public:
+  explicit RecordingBinder(const sp<IBinder>& service) : service_(service) {}
+
+  status_t transact(uint32_t code, const Parcel& data, Parcel* reply,
+                    uint32_t flags) override {
+    code_ = code;
+    request_.freeData();
+    request_.appendFrom(&data, 0, data.dataSize());
+    status_t status = service_->transact(code, data, reply, flags);
+    reply_.freeData();
+    reply_.appendFrom(reply, 0, reply->dataSize());
+    return status;
+  }
+
+  uint32_t code() const { return code_; }
+  const Parcel& request() const { return request_; }
+  const Parcel& reply() const { return reply_; }
+
+ private:
+  const sp<IBinder> service_;
+  uint32_t code_ = 0;
+  Parcel request_;
+  Parcel reply_;
+};
+
+void ReleaseNothing(Parcel* /* parcel */, const uint8_t* /* data */,
+                    size_t /* data_size */,
+                    const binder_size_t* /* objects */,
+                    size_t /* object_count */, void* /* cookie */) {}
+
+// Hands out a recorded reply without copying it, the way the driver hands
+// replies to IPCThreadState.
+class ReplayingBinder : public BBinder {
+ public:
+  explicit ReplayingBinder(const Parcel& reply) : reply_(reply) {}
+
+  status_t transact(uint32_t /* code */, const Parcel& /* data */,
+                    Parcel* reply, uint32_t /* flags */) override {
+    reply->ipcSetDataReference(reply_.data(), reply_.dataSize(), nullptr, 0,
+                               ReleaseNothing, nullptr);
+    return OK;
+  }
+
+ private:
+  const Parcel& reply_;
+};
+
+}  // namespace
+
+class AllocationTest : public ::testing::Test {
+ protected:
+  // Makes |call| through a proxy, and then once more on each side with the
+  // recorded request and reply while counting allocations.
+  void Measure(const string& name,
+               const std::function<Status(ITestService*)>& call) {
+    sp<RecordingBinder> recorder = new RecordingBinder(service_);
+    sp<ITestService> recording_proxy = new BpTestService(recorder);
+    ASSERT_EQ(OK, call(recording_proxy.get()).transactionError());
+
+    sp<ITestService> replaying_proxy =
+        new BpTestService(new ReplayingBinder(recorder->reply()));
+    size_t client_allocations;
+    {
+      ScopedAllocationCounter counter;
+      call(replaying_proxy.get());
+      client_allocations = counter.allocations();
+    }
+
+    Parcel reply;
+    size_t server_allocations;
+    {
+      ScopedAllocationCounter counter;
+      service_->transact(recorder->code(), recorder->request(), &reply, 0);
+      server_allocations = counter.allocations();
+    }
+
+    RecordAllocationCount(name + ".client", client_allocations);
+    RecordAllocationCount(name + ".server", server_allocations);
+  }
+
+  const sp<IBinder> service_ = new TestService;
+};
+
+TEST(ScopedAllocationCounterTest, CountsAllocationsOnThisThread) {
+  // Go through volatile pointers so that the allocations are not elided.
+  void* (*volatile allocate)(size_t) = malloc;
+  void (*volatile release)(void*) = free;
+
+  ScopedAllocationCounter outer;
+  {
+    ScopedAllocationCounter inner;
+    release(allocate(16));
+    string heap_string(100, 'x');
+    EXPECT_EQ(2u, inner.allocations());
+    EXPECT_EQ(1u, inner.frees());
+    EXPECT_LE(116u, inner.bytes());
+  }
+  EXPECT_EQ(2u, outer.allocations());
+
+  // Starting the thread allocates here, but nothing it does itself counts.
+  ScopedAllocationCounter spawning;
+  std::thread thread([allocate, release]() {
+    for (int i = 0; i < 100; ++i) {
+      release(allocate(16));
+    }
+  });
+  thread.join();
+  EXPECT_GT(100u, spawning.allocations());
+}
+
+TEST(ScopedAllocationCounterTest, ExpectsNoAllocations) {
+  volatile int total = 0;
+  EXPECT_NO_ALLOCATIONS(for (int i = 0; i < 10; ++i) total += i);
+  EXPECT_EQ(45, total);
+}
+
+TEST_F(AllocationTest, RepeatInt) {
+  int32_t result;
+  Measure("RepeatInt", [&result](ITestService* s) {
+    return s->RepeatInt(42, &result);
+  });
+}
+
+TEST_F(AllocationTest, SumPrimitives) {
+  double result;
+  Measure("SumPrimitives", [&result](ITestService* s) {
+    return s->SumPrimitives(true, 1, u'2', 3, 4, 5.0f, 6.0, &result);
+  });
+}
+
+TEST_F(AllocationTest, RepeatString) {
+  const String16 token("a token of moderate length");
+  String16 result;
+  Measure("RepeatString", [&token, &result](ITestService* s) {
+    return s->RepeatString(token, &result);
+  });
+}
+
+TEST_F(AllocationTest, RepeatUtf8CppString) {
+  const string token("a token of moderate length");
+  string result;
+  Measure("RepeatUtf8CppString", [&token, &result](ITestService* s) {
+    return s->RepeatUtf8CppString(token, &result);
+  });
+}
+
+TEST_F(AllocationTest, RepeatNullableString) {
+  const unique_ptr<String16> token(new String16("nullable"));
+  unique_ptr<String16> result;
+  Measure("RepeatNullableString", [&token, &result](ITestService* s) {
+    return s->RepeatNullableString(token, &result);
+  });
+}
+
+TEST_F(AllocationTest, RepeatSimpleParcelable) {
+  const SimpleParcelable input("parcelable", 42);
+  SimpleParcelable repeat;
+  SimpleParcelable result;
+  Measure("RepeatSimpleParcelable",
+          [&input, &repeat, &result](ITestService* s) {
+    return s->RepeatSimpleParcelable(input, &repeat, &result);
+  });
+}
+
+TEST_F(AllocationTest, ReverseInt) {
+  const vector<int32_t> input(64, 7);
+  vector<int32_t> repeated;
+  vector<int32_t> result;
+  Measure("ReverseInt", [&input, &repeated, &result](ITestService* s) {
+    return s->ReverseInt(input, &repeated, &result);
+  });
+}
+
+TEST_F(AllocationTest, ReverseString) {
+  const vector<String16> input(8, String16("element"));
+  vector<String16> repeated;
+  vector<String16> result;
+  Measure("ReverseString", [&input, &repeated, &result](ITestService* s) {
+    return s->ReverseString(input, &repeated, &result);
+  });
+}
+
+TEST_F(AllocationTest, ReverseStringList) {
+  const vector<String16> input(8, String16("element"));
+  vector<String16> repeated;
+  vector<String16> result;
+  Measure("ReverseStringList", [&input, &repeated, &result](ITestService* s) {
+    return s->ReverseStringList(input, &repeated, &result);
+  });
+}
+
+TEST_F(AllocationTest, ThrowServiceException) {
+  Measure("ThrowServiceException", [](ITestService* s) {
+    return s->ThrowServiceException(-1);
+  });
+}
+
+}  // namespace tests
+}  // namespace aidl
+}  // namespace android
@@ -80,6 +80,10 @@ int main(int /* argc */, char * argv []) {
 
   if (!client_tests::ConfirmPrimitiveRepeat(service)) return 1;
 
+  if (!client_tests::ConfirmTruncatedRequests(service)) return 1;
+
+  if (!client_tests::ConfirmCallChain(service)) return 1;
+
   if (!client_tests::ConfirmReverseArrays(service)) return 1;
 
   if (!client_tests::ConfirmReverseLists(service)) return 1;
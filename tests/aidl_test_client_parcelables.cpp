@@ -72,6 +72,22 @@ bool ConfirmSimpleParcelables(const sp<ITestService>& s) {
     return false;
   }
 
+  cout << "Attempting to reverse an array of @nonnull SimpleParcelable objects."
+       << endl;
+  repeated.clear();
+  reversed.clear();
+  status = s->ReverseNonNullParcelables(original, &repeated, &reversed);
+  if (!status.isOk()) {
+    cout << "Binder call failed." << endl;
+    return false;
+  }
+  std::reverse(reversed.begin(), reversed.end());
+  if (repeated != original || reversed != original) {
+    cout << "Failed to reverse an array of @nonnull SimpleParcelable objects."
+         << endl;
+    return false;
+  }
+
   return true;
 }
 
@@ -19,10 +19,14 @@
 #include <iostream>
 #include <vector>
 
+#include <binder/IInterface.h>
+#include <binder/Parcel.h>
+#include <utils/Errors.h>
 #include <utils/String16.h>
 #include <utils/String8.h>
 
 #include "android/aidl/tests/INamedCallback.h"
+#include "android/aidl/tests/TestServiceCallChain.h"
 
 #include "test_helpers.h"
 
@@ -32,11 +36,14 @@ using android::String16;
 using android::String8;
 
 // libbinder:
+using android::IInterface;
+using android::Parcel;
 using android::binder::Status;
 
 // generated
 using android::aidl::tests::ITestService;
 using android::aidl::tests::INamedCallback;
+using android::aidl::tests::TestServiceCallChain;
 
 using std::cerr;
 using std::cout;
@@ -73,11 +80,32 @@ bool ConfirmPrimitiveRepeat(const sp<ITestService>& s) {
       !RepeatPrimitive(
           s, &ITestService::RepeatInt, ITestService::TEST_CONSTANT7) ||
       !RepeatPrimitive(
-          s, &ITestService::RepeatInt, ITestService::TEST_CONSTANT8)
+          s, &ITestService::RepeatInt, ITestService::TEST_CONSTANT8) ||
+      !RepeatPrimitive(
+          s, &ITestService::RepeatLong, ITestService::TEST_LONG_CONSTANT) ||
+      !RepeatPrimitive(
+          s, &ITestService::RepeatFloat, ITestService::TEST_FLOAT_CONSTANT) ||
+      !RepeatPrimitive(
+          s, &ITestService::RepeatDouble,
+          ITestService::TEST_DOUBLE_CONSTANT) ||
+      !RepeatPrimitive(
+          s, &ITestService::RepeatBoolean,
+          ITestService::TEST_BOOLEAN_CONSTANT) ||
+      !RepeatPrimitive(
+          s, &ITestService::RepeatByteEnum, ITestService::ByteEnum::BAZ)
       ) {
     return false;
   }
 
+  // The service must refuse a value that is not an enumerator.
+  ITestService::ByteEnum bad_enum_reply;
+  if (s->RepeatByteEnum(static_cast<ITestService::ByteEnum>(7),
+                        &bad_enum_reply).isOk()) {
+    cerr << "Service accepted a ByteEnum value that is not an enumerator."
+         << endl;
+    return false;
+  }
+
   vector<String16> inputs = {
       String16("Deliver us from evil."),
       String16(),
@@ -86,6 +114,7 @@ bool ConfirmPrimitiveRepeat(const sp<ITestService>& s) {
       //   U+10437: The 'small letter yee' character in the deseret alphabet
       //   U+20AC: A euro sign
       String16("\xD8\x01\xDC\x37\x20\xAC"),
+      String16(ITestService::TEST_STRING_CONSTANT),
   };
   for (const auto& input : inputs) {
     String16 reply;
@@ -100,6 +129,105 @@ bool ConfirmPrimitiveRepeat(const sp<ITestService>& s) {
   return true;
 }
 
+namespace {
+
+// Sends a request for |code| whose arguments are |word_count| zeroed 32 bit
+// words, bypassing the generated proxy.
+status_t TransactWords(const sp<ITestService>& s, uint32_t code,
+                       size_t word_count, Parcel* reply) {
+  Parcel data;
+  data.writeInterfaceToken(s->getInterfaceDescriptor());
+  for (size_t i = 0; i < word_count; ++i) {
+    data.writeInt32(0);
+  }
+  return IInterface::asBinder(s)->transact(code, data, reply);
+}
+
+}  // namespace
+
+bool ConfirmTruncatedRequests(const sp<ITestService>& s) {
+  cout << "Confirming truncated requests are rejected." << endl;
+
+  double sum = 0;
+  Status status = s->SumPrimitives(true, int8_t{-2}, char16_t{3}, 4,
+                                   int64_t{1ll << 40}, 0.5f, 0.25, &sum);
+  const double expected = 1 - 2 + 3 + 4 + static_cast<double>(1ll << 40) +
+                          0.5 + 0.25;
+  if (!status.isOk() || sum != expected) {
+    cerr << "Failed to sum primitives. Got status=" << status.toString8()
+         << " sum=" << sum << endl;
+    return false;
+  }
+
+  // SumPrimitives() checks its arguments against the parcel size up front,
+  // RepeatInt() checks them one at a time.  Both must reject short requests
+  // and ignore trailing data.
+  struct Request {
+    const char* name;
+    uint32_t code;
+    size_t word_count;  // Of the arguments when sent by the proxy.
+  };
+  const Request requests[] = {
+      {"SumPrimitives", ITestService::SUMPRIMITIVES, 9},
+      {"RepeatInt", ITestService::REPEATINT, 1},
+  };
+  for (const Request& request : requests) {
+    Parcel reply;
+    status_t result = TransactWords(s, request.code, request.word_count - 1,
+                                    &reply);
+    if (result != android::NOT_ENOUGH_DATA) {
+      cerr << "Expected truncated " << request.name
+           << " request to fail, got " << result << endl;
+      return false;
+    }
+    reply.freeData();
+    result = TransactWords(s, request.code, request.word_count + 1, &reply);
+    if (result != android::OK ||
+        status.readFromParcel(reply) != android::OK || !status.isOk()) {
+      cerr << "Expected oversized " << request.name
+           << " request to succeed, got " << result << " and status="
+           << status.toString8() << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ConfirmCallChain(const sp<ITestService>& s) {
+  cout << "Confirming chained calls work." << endl;
+
+  // Each call repeats the result of the one before it, without the values
+  // coming back to us in between.
+  TestServiceCallChain chain;
+  int32_t first = 0;
+  int32_t second = 0;
+  String16 repeated;
+  auto first_result = chain.RepeatInt(17, &first);
+  chain.RepeatInt(first_result, &second);
+  chain.RepeatString(String16("chained"), &repeated);
+  Status status = chain.Transact(s);
+  if (!status.isOk() || first != 17 || second != 17 ||
+      repeated != String16("chained")) {
+    cerr << "Call chain failed. Got status=" << status.toString8()
+         << " first=" << first << " second=" << second
+         << " repeated=" << String8(repeated).string() << endl;
+    return false;
+  }
+
+  // A failing call stops the chain and its status is reported.
+  TestServiceCallChain failing;
+  int32_t after = 0;
+  failing.ThrowServiceException(-3);
+  failing.RepeatInt(5, &after);
+  status = failing.Transact(s);
+  if (status.serviceSpecificErrorCode() != -3 || after != 0) {
+    cerr << "Expected failing call to stop the chain. Got status="
+         << status.toString8() << " after=" << after << endl;
+    return false;
+  }
+  return true;
+}
+
 bool ConfirmReverseArrays(const sp<ITestService>& s) {
   cout << "Confirming passing and returning arrays works." << endl;
 
@@ -113,12 +241,25 @@ bool ConfirmReverseArrays(const sp<ITestService>& s) {
                     {1, 2, 3}) ||
       !ReverseArray(s, &ITestService::ReverseLong,
                     {-1ll, 0ll, int64_t{1ll << 60}}) ||
+      !ReverseArray(s, &ITestService::ReverseByteEnum,
+                    {ITestService::ByteEnum::FOO, ITestService::ByteEnum::BAZ,
+                     ITestService::ByteEnum::BAR}) ||
       !ReverseArray(s, &ITestService::ReverseFloat,
                     {-0.3f, -0.7f, 8.0f}) ||
       !ReverseArray(s, &ITestService::ReverseDouble,
                     {1.0/3.0, 1.0/7.0, 42.0}) ||
       !ReverseArray(s, &ITestService::ReverseString,
-                    {String16{"f"}, String16{"a"}, String16{"b"}})) {
+                    {String16{"f"}, String16{"a"}, String16{"b"}}) ||
+      !ReverseArray(s, &ITestService::ReverseSkippableInt,
+                    {4, 5, 6})) {
+    return false;
+  }
+
+  const vector<int32_t> input{1, 2, 3};
+  vector<int32_t> reversed;
+  Status status = s->ReverseSkippableInt(input, nullptr, &reversed);
+  if (!status.isOk() || reversed != vector<int32_t>{3, 2, 1}) {
+    cout << "Failed to skip a @skippable out parameter." << endl;
     return false;
   }
 
@@ -28,6 +28,8 @@ namespace tests {
 namespace client {
 
 bool ConfirmPrimitiveRepeat(const sp<ITestService>& s);
+bool ConfirmTruncatedRequests(const android::sp<ITestService>& s);
+bool ConfirmCallChain(const android::sp<ITestService>& s);
 bool ConfirmReverseArrays(const android::sp<ITestService>& s);
 bool ConfirmReverseLists(const android::sp<ITestService>& s);
 bool ConfirmReverseBinderLists(const android::sp<ITestService>& s);
@@ -149,6 +149,11 @@ class NativeService : public BnTestService {
     *_aidl_return = token;
     return Status::ok();
   }
+  Status SumPrimitives(bool a, int8_t b, char16_t c, int32_t d, int64_t e,
+                       float f, double g, double* _aidl_return) override {
+    *_aidl_return = (a ? 1 : 0) + b + c + d + e + f + g;
+    return Status::ok();
+  }
   Status RepeatString(const String16& token, String16* _aidl_return) override {
     LogRepeatedStringToken(token);
     *_aidl_return = token;
@@ -392,6 +397,36 @@ class NativeService : public BnTestService {
     return Status::ok();
   }
 
+  Status RepeatByteEnum(ByteEnum token, ByteEnum* _aidl_return) override {
+    LogRepeatedToken(static_cast<int>(token));
+    *_aidl_return = token;
+    return Status::ok();
+  }
+  Status ReverseByteEnum(const vector<ByteEnum>& input,
+                         vector<ByteEnum>* repeated,
+                         vector<ByteEnum>* _aidl_return) override {
+    return ReverseArray(input, repeated, _aidl_return);
+  }
+
+  Status ReverseNonNullParcelables(
+      const vector<SimpleParcelable>& input,
+      vector<SimpleParcelable>* repeated,
+      vector<SimpleParcelable>* _aidl_return) override {
+    return ReverseArray(input, repeated, _aidl_return);
+  }
+
+  Status ReverseSkippableInt(const vector<int32_t>& input,
+                             vector<int32_t>* repeated,
+                             vector<int32_t>* _aidl_return) override {
+    ALOGI("Reversing array of length %zu, %s repeating it", input.size(),
+          (repeated) ? "and" : "without");
+    if (repeated) {
+      *repeated = input;
+    }
+    *_aidl_return = vector<int32_t>(input.rbegin(), input.rend());
+    return Status::ok();
+  }
+
  private:
   map<String16, sp<INamedCallback>> service_map_;
 };
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tests/allocation_counter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+
+using android::aidl::tests::ScopedAllocationCounter;
+
+namespace {
+
+// The real allocator, looked up the first time we need it.
+struct LibcAllocator {
+  void* (*malloc)(size_t);
+  void* (*calloc)(size_t, size_t);
+  void* (*realloc)(void*, size_t);
+  void (*free)(void*);
+};
+LibcAllocator libc;
+
+// dlsym() may allocate while we look the real allocator up, so requests
+// made in the meantime are served from a static buffer that is never freed.
+alignas(max_align_t) uint8_t bootstrap_buffer[4096];
+std::atomic<size_t> bootstrap_used(0);
+std::atomic<bool> resolving(false);
+
+bool IsBootstrapAllocation(const void* p) {
+  const uint8_t* address = static_cast<const uint8_t*>(p);
+  return address >= bootstrap_buffer &&
+         address < bootstrap_buffer + sizeof(bootstrap_buffer);
+}
+
+void* BootstrapAllocate(size_t size) {
+  const size_t alignment = alignof(max_align_t);
+  size = (size + alignment - 1) & ~(alignment - 1);
+  const size_t offset = bootstrap_used.fetch_add(size);
+  if (offset + size > sizeof(bootstrap_buffer)) {
+    abort();
+  }
+  return bootstrap_buffer + offset;
+}
+
+void ResolveLibc() {
+  if (libc.free != nullptr) {
+    return;
+  }
+  resolving = true;
+  libc.malloc =
+      reinterpret_cast<void* (*)(size_t)>(dlsym(RTLD_NEXT, "malloc"));
+  libc.calloc =
+      reinterpret_cast<void* (*)(size_t, size_t)>(dlsym(RTLD_NEXT, "calloc"));
+  libc.realloc =
+      reinterpret_cast<void* (*)(void*, size_t)>(dlsym(RTLD_NEXT, "realloc"));
+  libc.free = reinterpret_cast<void (*)(void*)>(dlsym(RTLD_NEXT, "free"));
+  resolving = false;
+  if (libc.malloc == nullptr || libc.calloc == nullptr ||
+      libc.realloc == nullptr || libc.free == nullptr) {
+    abort();
+  }
+}
+
+void* RealMalloc(size_t size) {
+  if (resolving) {
+    return BootstrapAllocate(size);
+  }
+  ResolveLibc();
+  return libc.malloc(size);
+}
+
+void RealFree(void* p) {
+  if (p == nullptr || IsBootstrapAllocation(p)) {
+    return;
+  }
+  ResolveLibc();
+  libc.free(p);
+}
+
+// Counters are found through a pthread key rather than a thread_local:
+// emulated TLS allocates on first use, which would recurse into malloc().
+pthread_key_t counter_key;
+pthread_once_t counter_key_once = PTHREAD_ONCE_INIT;
+std::atomic<bool> counter_key_created(false);
+
+void CreateCounterKey() {
+  if (pthread_key_create(&counter_key, nullptr) != 0) {
+    abort();
+  }
+  counter_key_created = true;
+}
+
+ScopedAllocationCounter* InnermostCounter() {
+  if (!counter_key_created) {
+    return nullptr;
+  }
+  return static_cast<ScopedAllocationCounter*>(
+      pthread_getspecific(counter_key));
+}
+
+}  // namespace
+
+namespace android {
+namespace aidl {
+namespace tests {
+
+ScopedAllocationCounter::ScopedAllocationCounter() {
+  pthread_once(&counter_key_once, CreateCounterKey);
+  outer_ = InnermostCounter();
+  pthread_setspecific(counter_key, this);
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter() {
+  pthread_setspecific(counter_key, outer_);
+}
+
+void ScopedAllocationCounter::RecordAllocation(size_t bytes) {
+  for (ScopedAllocationCounter* counter = InnermostCounter();
+       counter != nullptr; counter = counter->outer_) {
+    ++counter->allocations_;
+    counter->bytes_ += bytes;
+  }
+}
+
+void ScopedAllocationCounter::RecordFree() {
+  for (ScopedAllocationCounter* counter = InnermostCounter();
+       counter != nullptr; counter = counter->outer_) {
+    ++counter->frees_;
+  }
+}
+
+void RecordAllocationCount(const std::string& name, size_t count) {
+  ::testing::Test::RecordProperty(name, static_cast<int>(count));
+}
+
+}  // namespace tests
+}  // namespace aidl
+}  // namespace android
+
+extern "C" {
+
+void* malloc(size_t size) {
+  ScopedAllocationCounter::RecordAllocation(size);
+  return RealMalloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  size_t total;
+  if (__builtin_mul_overflow(count, size, &total)) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  ScopedAllocationCounter::RecordAllocation(total);
+  if (resolving) {
+    // The bootstrap buffer is static, so it starts out zeroed.
+    return BootstrapAllocate(total);
+  }
+  ResolveLibc();
+  return libc.calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+  if (p != nullptr && size == 0) {
+    ScopedAllocationCounter::RecordFree();
+  } else {
+    ScopedAllocationCounter::RecordAllocation(size);
+  }
+  if (p != nullptr && IsBootstrapAllocation(p)) {
+    void* moved = RealMalloc(size);
+    const size_t available =
+        bootstrap_buffer + sizeof(bootstrap_buffer) - static_cast<uint8_t*>(p);
+    if (moved != nullptr) {
+      memcpy(moved, p, size < available ? size : available);
+    }
+    return moved;
+  }
+  if (resolving) {
+    return BootstrapAllocate(size);
+  }
+  ResolveLibc();
+  return libc.realloc(p, size);
+}
+
+void free(void* p) {
+  if (p != nullptr) {
+    ScopedAllocationCounter::RecordFree();
+  }
+  RealFree(p);
+}
+
+}  // extern "C"
+
+// operator new would otherwise reach our malloc() through the C++ runtime,
+// so these forward to the C library directly to count each allocation once.
+void* operator new(size_t size) {
+  ScopedAllocationCounter::RecordAllocation(size);
+  void* p = RealMalloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    abort();
+  }
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  ScopedAllocationCounter::RecordAllocation(size);
+  return RealMalloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) noexcept {
+  return operator new(size, nothrow);
+}
+
+void operator delete(void* p) noexcept {
+  if (p != nullptr) {
+    ScopedAllocationCounter::RecordFree();
+  }
+  RealFree(p);
+}
+
+void operator delete[](void* p) noexcept {
+  operator delete(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  operator delete(p);
+}
+
+void operator delete(void* p, size_t /* size */) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void* p, size_t /* size */) noexcept {
+  operator delete(p);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TESTS_ALLOCATION_COUNTER_H_
+#define AIDL_TESTS_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+#include <string>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace aidl {
+namespace tests {
+
+// Counts the heap allocations made by the current thread while it is alive.
+//
+// Linking libaidl-allocation-counter (as a whole static library) replaces
+// malloc(), calloc(), realloc(), free() and the global operator new and
+// delete with versions that forward to the C library and update every
+// counter alive on the calling thread.  Counters nest, and allocations made
+// by other threads are ignored.
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter();
+  ~ScopedAllocationCounter();
+
+  // Calls to malloc(), calloc() and operator new, and calls to realloc()
+  // that may move the block.
+  size_t allocations() const { return allocations_; }
+  // Calls to free() and operator delete with a non-null pointer.
+  size_t frees() const { return frees_; }
+  // Bytes requested by the allocations above.
+  size_t bytes() const { return bytes_; }
+
+  // Called by the replaced allocation functions.
+  static void RecordAllocation(size_t bytes);
+  static void RecordFree();
+
+ private:
+  ScopedAllocationCounter* outer_ = nullptr;
+  size_t allocations_ = 0;
+  size_t frees_ = 0;
+  size_t bytes_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedAllocationCounter);
+};
+
+// Adds |count| to the properties of the running gtest, which puts it in the
+// XML report so that it can be tracked from one build to the next.
+void RecordAllocationCount(const std::string& name, size_t count);
+
+}  // namespace tests
+}  // namespace aidl
+}  // namespace android
+
+// Fails the current test if |statement| allocates on the calling thread.
+#define EXPECT_NO_ALLOCATIONS(statement)                              \
+  do {                                                                \
+    ::android::aidl::tests::ScopedAllocationCounter _aidl_counter;    \
+    statement;                                                        \
+    EXPECT_EQ(0u, _aidl_counter.allocations()) << #statement;         \
+  } while (0)
+
+#endif  // AIDL_TESTS_ALLOCATION_COUNTER_H_
@@ -81,12 +81,14 @@ std::unique_ptr<CodeWriter> FakeIoDelegate::GetCodeWriter(
   if (broken_files_.count(file_path) > 0) {
     return unique_ptr<CodeWriter>(new BrokenCodeWriter);
   }
+  std::lock_guard<std::mutex> guard(written_lock_);
   removed_files_.erase(file_path);
   written_file_contents_[file_path] = "";
   return GetStringWriter(&written_file_contents_[file_path]);
 }
 
 void FakeIoDelegate::RemovePath(const std::string& file_path) const {
+  std::lock_guard<std::mutex> guard(written_lock_);
   removed_files_.insert(file_path);
 }
 
@@ -136,6 +138,7 @@ void FakeIoDelegate::AddBrokenFilePath(const std::string& path) {
 }
 
 bool FakeIoDelegate::GetWrittenContents(const string& path, string* content) {
+  std::lock_guard<std::mutex> guard(written_lock_);
   const auto it = written_file_contents_.find(path);
   if (it == written_file_contents_.end()) {
     return false;
@@ -147,6 +150,7 @@ bool FakeIoDelegate::GetWrittenContents(const string& path, string* content) {
 }
 
 bool FakeIoDelegate::PathWasRemoved(const std::string& path) {
+  std::lock_guard<std::mutex> guard(written_lock_);
   if (removed_files_.count(path) > 0) {
     return true;
   }
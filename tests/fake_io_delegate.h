@@ -21,6 +21,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -70,6 +71,9 @@ class FakeIoDelegate : public IoDelegate {
   std::string CleanPath(const std::string& path) const;
 
   std::map<std::string, std::string> file_contents_;
+  // Guards the files written and removed, which AsyncIoDelegate may do from
+  // several threads at once.
+  mutable std::mutex written_lock_;
   // Normally, writing to files leaves the IoDelegate unchanged, so
   // GetCodeWriter is a const method.  However, for tests, we break this
   // intentionally by storing the written strings.
@@ -166,6 +166,38 @@ public class TestServiceClient extends Activity {
                     }
                 }
             }
+            {
+                long query = ITestService.TEST_LONG_CONSTANT;
+                long response = service.RepeatLong(query);
+                if (query != response) {
+                    mLog.logAndThrow("Repeat with " + query +
+                                     " responded " + response);
+                }
+            }
+            {
+                byte query = ITestService.ByteEnum.BAZ;
+                byte response = service.RepeatByteEnum(query);
+                if (query != response) {
+                    mLog.logAndThrow("Repeat with " + query +
+                                     " responded " + response);
+                }
+            }
+            {
+                double query = ITestService.TEST_DOUBLE_CONSTANT;
+                double response = service.RepeatDouble(query);
+                if (query != response) {
+                    mLog.logAndThrow("Repeat with " + query +
+                                     " responded " + response);
+                }
+            }
+            {
+                String query = ITestService.TEST_STRING_CONSTANT;
+                String response = service.RepeatString(query);
+                if (!query.equals(response)) {
+                    mLog.logAndThrow("Repeat with " + query +
+                                     " responded " + response);
+                }
+            }
             {
                 long query = 1 << 60;
                 long response = service.RepeatLong(query);
@@ -304,6 +336,19 @@ public class TestServiceClient extends Activity {
                     }
                 }
             }
+            {
+                int[] input = {1, 2, 3};
+                int[] echoed = new int[input.length];
+                int[] reversed = service.ReverseSkippableInt(input, echoed);
+                if (!Arrays.equals(input, echoed) ||
+                        !Arrays.equals(new int[] {3, 2, 1}, reversed)) {
+                    mLog.logAndThrow("Failed to reverse a @skippable array.");
+                }
+                reversed = service.ReverseSkippableInt(input, null);
+                if (!Arrays.equals(new int[] {3, 2, 1}, reversed)) {
+                    mLog.logAndThrow("Failed to skip a @skippable array.");
+                }
+            }
             {
                 long[] input = {-2, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8};
                 long echoed[] = new long[input.length];
@@ -323,6 +368,27 @@ public class TestServiceClient extends Activity {
                     }
                 }
             }
+            {
+                byte[] input = {ITestService.ByteEnum.FOO,
+                                ITestService.ByteEnum.BAZ,
+                                ITestService.ByteEnum.BAR};
+                byte echoed[] = new byte[input.length];
+                byte[] reversed = service.ReverseByteEnum(input, echoed);
+                if (!Arrays.equals(input, echoed)) {
+                    mLog.logAndThrow("Failed to echo input array back.");
+                }
+                if (input.length != reversed.length) {
+                    mLog.logAndThrow("Reversed array is the wrong size.");
+                }
+                for (int i = 0; i < input.length; ++i) {
+                    int j = reversed.length - (1 + i);
+                    if (input[i] != reversed[j]) {
+                        mLog.logAndThrow(
+                                "input[" + i + "] = " + input[i] +
+                                " but reversed value = " + reversed[j]);
+                    }
+                }
+            }
             {
                 float[] input = {0.0f, 1.0f, -0.3f};
                 float echoed[] = new float[input.length];
@@ -477,6 +543,29 @@ public class TestServiceClient extends Activity {
                     }
                 }
             }
+            {
+                SimpleParcelable[] input = new SimpleParcelable[2];
+                input[0] = new SimpleParcelable("a", 1);
+                input[1] = new SimpleParcelable("b", 2);
+                SimpleParcelable[] repeated = new SimpleParcelable[2];
+                SimpleParcelable[] reversed = service.ReverseNonNullParcelables(
+                        input, repeated);
+                if (!Arrays.equals(input, repeated) || reversed.length != 2 ||
+                        !input[0].equals(reversed[1]) ||
+                        !input[1].equals(reversed[0])) {
+                    mLog.logAndThrow(
+                            "Failed to reverse @nonnull SimpleParcelable objects.");
+                }
+                boolean threw = false;
+                try {
+                    service.ReverseNonNullParcelables(null, repeated);
+                } catch (NullPointerException e) {
+                    threw = true;
+                }
+                if (!threw) {
+                    mLog.logAndThrow("Proxy accepted null for a @nonnull argument.");
+                }
+            }
         } catch (Exception ex) {
             mLog.log(ex.toString());
             mLog.logAndThrow("Service failed to handle SimpleParcelable objects.");
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.aidl.tests;
+
+import android.os.Parcel;
+import android.os.Parcelable;
+
+/** A parcelable that reads itself without allocating. */
+public class BenchPoint implements Parcelable {
+    public int x;
+    public int y;
+
+    public BenchPoint() {}
+
+    public BenchPoint(int x, int y) {
+        this.x = x;
+        this.y = y;
+    }
+
+    public int describeContents() { return 0; }
+
+    public void writeToParcel(Parcel dest, int flags) {
+        dest.writeInt(x);
+        dest.writeInt(y);
+    }
+
+    public void readFromParcel(Parcel source) {
+        x = source.readInt();
+        y = source.readInt();
+    }
+
+    public static final Parcelable.Creator<BenchPoint> CREATOR =
+            new Parcelable.Creator<BenchPoint>() {
+        public BenchPoint createFromParcel(Parcel source) {
+            BenchPoint point = new BenchPoint();
+            point.readFromParcel(source);
+            return point;
+        }
+
+        public BenchPoint[] newArray(int size) {
+            return new BenchPoint[size];
+        }
+    };
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.aidl.tests;
+
+import android.os.Binder;
+import android.os.IBinder;
+import android.os.IInterface;
+import android.os.Parcel;
+import android.os.RemoteException;
+
+// Generated
+import android.aidl.tests.IPooledParcelBench;
+import android.aidl.tests.IThreadParcelBench;
+
+/**
+ * Compares proxies that take their parcels from Parcel.obtain() with proxies
+ * generated with --thread-local-parcels, as more and more threads call them.
+ *
+ * Run with:
+ *   adb shell CLASSPATH=/system/framework/aidl_parcel_benchmark.jar \
+ *       app_process /system/bin android.aidl.tests.ParcelReuseBenchmark
+ */
+public class ParcelReuseBenchmark {
+    private static final int CALLS_PER_THREAD = 200000;
+
+    private interface Call {
+        void run(int i) throws RemoteException;
+    }
+
+    /**
+     * Passes transactions to a local stub, but hides it from
+     * queryLocalInterface() so that asInterface() returns a proxy.
+     */
+    private static class ForwardingBinder extends Binder {
+        private final IBinder mTarget;
+
+        ForwardingBinder(IBinder target) {
+            mTarget = target;
+        }
+
+        @Override
+        public IInterface queryLocalInterface(String descriptor) {
+            return null;
+        }
+
+        @Override
+        protected boolean onTransact(int code, Parcel data, Parcel reply,
+                                     int flags) throws RemoteException {
+            return mTarget.transact(code, data, reply, flags);
+        }
+    }
+
+    private static double run(String label, int threadCount, final Call call)
+            throws InterruptedException {
+        final RemoteException[] failure = new RemoteException[1];
+        Thread[] threads = new Thread[threadCount];
+        for (int t = 0; t < threadCount; ++t) {
+            threads[t] = new Thread() {
+                @Override
+                public void run() {
+                    try {
+                        for (int i = 0; i < CALLS_PER_THREAD; ++i) {
+                            call.run(i);
+                        }
+                    } catch (RemoteException e) {
+                        failure[0] = e;
+                    }
+                }
+            };
+        }
+
+        long start = System.nanoTime();
+        for (Thread thread : threads) {
+            thread.start();
+        }
+        for (Thread thread : threads) {
+            thread.join();
+        }
+        double seconds = (System.nanoTime() - start) / 1e9;
+        if (failure[0] != null) {
+            throw new RuntimeException(label + ": call failed", failure[0]);
+        }
+
+        double callsPerSecond = threadCount * CALLS_PER_THREAD / seconds;
+        System.out.println(label + " threads=" + threadCount +
+                           " calls_per_second=" + callsPerSecond);
+        return callsPerSecond;
+    }
+
+    public static void main(String[] args) throws InterruptedException {
+        final IPooledParcelBench pooled = IPooledParcelBench.Stub.asInterface(
+                new ForwardingBinder(new IPooledParcelBench.Stub() {
+                    @Override
+                    public int Echo(int value) {
+                        return value;
+                    }
+
+                    @Override
+                    public String EchoString(String value) {
+                        return value;
+                    }
+                }));
+        final IThreadParcelBench threadLocal =
+                IThreadParcelBench.Stub.asInterface(
+                        new ForwardingBinder(new IThreadParcelBench.Stub() {
+                            @Override
+                            public int Echo(int value) {
+                                return value;
+                            }
+
+                            @Override
+                            public String EchoString(String value) {
+                                return value;
+                            }
+                        }));
+
+        final int cpus = Runtime.getRuntime().availableProcessors();
+        for (int threads : new int[] {1, 2, 4, cpus, 2 * cpus}) {
+            run("pooled_int", threads, new Call() {
+                public void run(int i) throws RemoteException {
+                    pooled.Echo(i);
+                }
+            });
+            run("thread_local_int", threads, new Call() {
+                public void run(int i) throws RemoteException {
+                    threadLocal.Echo(i);
+                }
+            });
+            run("pooled_string", threads, new Call() {
+                public void run(int i) throws RemoteException {
+                    pooled.EchoString("benchmark");
+                }
+            });
+            run("thread_local_string", threads, new Call() {
+                public void run(int i) throws RemoteException {
+                    threadLocal.EchoString("benchmark");
+                }
+            });
+        }
+    }
+}
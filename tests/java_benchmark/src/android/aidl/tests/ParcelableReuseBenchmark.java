@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.aidl.tests;
+
+import android.os.Debug;
+import android.os.Parcel;
+import android.os.RemoteException;
+
+// Generated
+import android.aidl.tests.IPointCallbackBench;
+
+/**
+ * Counts the objects a stub allocates to receive a parcelable, with and
+ * without @reuse on the argument.  Transactions go straight to the local
+ * stub, so only the stub's own unmarshalling is measured.
+ *
+ * Run with:
+ *   adb shell CLASSPATH=/system/framework/aidl_parcelable_reuse_benchmark.jar \
+ *       app_process /system/bin android.aidl.tests.ParcelableReuseBenchmark
+ */
+public class ParcelableReuseBenchmark {
+    private static final int CALLS = 100000;
+    private static final String DESCRIPTOR =
+            "android.aidl.tests.IPointCallbackBench";
+
+    private static double run(String label, IPointCallbackBench.Stub stub,
+                              int code) throws RemoteException {
+        Parcel data = Parcel.obtain();
+        Parcel reply = Parcel.obtain();
+        data.writeInterfaceToken(DESCRIPTOR);
+        data.writeInt(1);
+        new BenchPoint(3, 4).writeToParcel(data, 0);
+
+        // Let both paths settle before counting.
+        for (int i = 0; i < 1000; ++i) {
+            data.setDataPosition(0);
+            reply.setDataSize(0);
+            stub.transact(code, data, reply, 0);
+        }
+
+        Debug.startAllocCounting();
+        Debug.resetThreadAllocCount();
+        long start = System.nanoTime();
+        for (int i = 0; i < CALLS; ++i) {
+            data.setDataPosition(0);
+            reply.setDataSize(0);
+            stub.transact(code, data, reply, 0);
+        }
+        double seconds = (System.nanoTime() - start) / 1e9;
+        int allocations = Debug.getThreadAllocCount();
+        Debug.stopAllocCounting();
+        data.recycle();
+        reply.recycle();
+
+        double perCall = (double) allocations / CALLS;
+        System.out.println(label + " allocations_per_call=" + perCall +
+                           " calls_per_second=" + (CALLS / seconds));
+        return perCall;
+    }
+
+    public static void main(String[] args) throws RemoteException {
+        final int[] sum = new int[1];
+        IPointCallbackBench.Stub stub = new IPointCallbackBench.Stub() {
+            @Override
+            public void OnPoint(BenchPoint point) {
+                sum[0] += point.x + point.y;
+            }
+
+            @Override
+            public void OnReusedPoint(BenchPoint point) {
+                sum[0] += point.x + point.y;
+            }
+        };
+
+        double created = run("create_from_parcel", stub,
+                             IPointCallbackBench.Stub.TRANSACTION_OnPoint);
+        double reused = run("reuse", stub,
+                            IPointCallbackBench.Stub.TRANSACTION_OnReusedPoint);
+        if (sum[0] != 2 * 7 * (CALLS + 1000)) {
+            throw new RuntimeException("the stub saw the wrong points");
+        }
+        if (reused >= created) {
+            System.err.println("FAILED: @reuse did not save allocations");
+            System.exit(1);
+        }
+    }
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package android.aidl.tests;
+
+import android.os.Binder;
+import android.os.Debug;
+import android.os.IBinder;
+import android.os.IInterface;
+import android.os.Parcel;
+import android.os.RemoteException;
+
+// Generated
+import android.aidl.tests.ICachedProxyBench;
+import android.aidl.tests.IPooledParcelBench;
+
+/**
+ * Checks that asInterface() generated with --cache-proxies behaves like the
+ * default asInterface(), and measures how many objects each of them
+ * allocates when called over and over on the same binder.
+ *
+ * Run with:
+ *   adb shell CLASSPATH=/system/framework/aidl_proxy_cache_test.jar \
+ *       app_process /system/bin android.aidl.tests.ProxyCacheTest
+ */
+public class ProxyCacheTest {
+    private static final int CALLS = 100000;
+
+    private static boolean sFailed = false;
+
+    private interface Cast {
+        Object asInterface(IBinder binder);
+    }
+
+    /**
+     * Passes transactions to a local stub, but hides it from
+     * queryLocalInterface() so that asInterface() returns a proxy.
+     */
+    private static class ForwardingBinder extends Binder {
+        private final IBinder mTarget;
+
+        ForwardingBinder(IBinder target) {
+            mTarget = target;
+        }
+
+        @Override
+        public IInterface queryLocalInterface(String descriptor) {
+            return null;
+        }
+
+        @Override
+        protected boolean onTransact(int code, Parcel data, Parcel reply,
+                                     int flags) throws RemoteException {
+            return mTarget.transact(code, data, reply, flags);
+        }
+    }
+
+    private static void check(boolean condition, String message) {
+        if (!condition) {
+            System.err.println("FAILED: " + message);
+            sFailed = true;
+        }
+    }
+
+    private static double allocationsPerCall(Cast cast, IBinder binder) {
+        Debug.startAllocCounting();
+        Debug.resetThreadAllocCount();
+        for (int i = 0; i < CALLS; ++i) {
+            cast.asInterface(binder);
+        }
+        int allocations = Debug.getThreadAllocCount();
+        Debug.stopAllocCounting();
+        return (double) allocations / CALLS;
+    }
+
+    public static void main(String[] args) throws RemoteException {
+        ICachedProxyBench.Stub cachedStub = new ICachedProxyBench.Stub() {
+            @Override
+            public int Echo(int value) {
+                return value;
+            }
+
+            @Override
+            public String EchoString(String value) {
+                return value;
+            }
+        };
+        IPooledParcelBench.Stub uncachedStub = new IPooledParcelBench.Stub() {
+            @Override
+            public int Echo(int value) {
+                return value;
+            }
+
+            @Override
+            public String EchoString(String value) {
+                return value;
+            }
+        };
+
+        check(ICachedProxyBench.Stub.asInterface(null) == null,
+              "asInterface(null) should return null");
+        check(ICachedProxyBench.Stub.asInterface(cachedStub) == cachedStub,
+              "asInterface() should return local objects as they are");
+
+        IBinder remote = new ForwardingBinder(cachedStub);
+        ICachedProxyBench proxy = ICachedProxyBench.Stub.asInterface(remote);
+        check(proxy != cachedStub, "asInterface() should return a proxy");
+        check(proxy.asBinder() == remote,
+              "the proxy should wrap the binder it was made for");
+        check(proxy.Echo(7) == 7, "calls through the proxy should work");
+        check(ICachedProxyBench.Stub.asInterface(remote) == proxy,
+              "asInterface() should reuse the proxy for the same binder");
+        ICachedProxyBench other = ICachedProxyBench.Stub.asInterface(
+                new ForwardingBinder(cachedStub));
+        check(other != proxy,
+              "asInterface() should not share proxies between binders");
+        check(other.Echo(8) == 8, "calls through a second proxy should work");
+
+        final IBinder uncachedRemote = new ForwardingBinder(uncachedStub);
+        double uncached = allocationsPerCall(new Cast() {
+            public Object asInterface(IBinder binder) {
+                return IPooledParcelBench.Stub.asInterface(binder);
+            }
+        }, uncachedRemote);
+        double cached = allocationsPerCall(new Cast() {
+            public Object asInterface(IBinder binder) {
+                return ICachedProxyBench.Stub.asInterface(binder);
+            }
+        }, remote);
+        System.out.println("uncached allocations_per_call=" + uncached);
+        System.out.println("cached allocations_per_call=" + cached);
+        check(uncached >= 1.0, "the default asInterface() should allocate");
+        check(cached < 0.01,
+              "asInterface() with a live cached proxy should not allocate");
+
+        // Keep the proxy alive, and so cached, until we are done measuring.
+        check(proxy.Echo(9) == 9, "the cached proxy should still work");
+
+        if (sFailed) {
+            System.exit(1);
+        }
+        System.out.println("PASSED");
+    }
+}
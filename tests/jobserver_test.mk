@@ -0,0 +1,47 @@
+# Checks that the I/O threads of aidl-cpp share the job slots of the make
+# that runs it instead of adding to them.  Run it on its own:
+#
+#   time make -f tests/jobserver_test.mk -j4 AIDL_CPP=<path to aidl-cpp>
+#   time make -f tests/jobserver_test.mk -j4 AIDL_CPP=<...> JOBSERVER=false
+#
+# Every compile runs with --io-threads=$(IO_THREADS).  Recipes are marked
+# with '+' so that make passes them its jobserver; with JOBSERVER=false they
+# get an empty MAKEFLAGS and size their pools without regard to the build.
+# make reports an error if a compile exits without giving back its tokens,
+# and the build fails unless every compile produced its output.
+
+AIDL_CPP ?= aidl-cpp
+JOBSERVER ?= true
+COUNT ?= 64
+IO_THREADS ?= 8
+OUT ?= /tmp/aidl_jobserver_test
+
+ifeq ($(JOBSERVER),true)
+run_aidl = +$(AIDL_CPP)
+else
+run_aidl = MAKEFLAGS= $(AIDL_CPP)
+endif
+
+ids := $(shell seq 1 $(COUNT))
+sources := $(foreach i,$(ids),$(OUT)/src/p/IFoo$(i).aidl)
+outputs := $(foreach i,$(ids),$(OUT)/gen/IFoo$(i).cpp)
+
+.PHONY: all clean
+all: $(outputs)
+	@test $$(ls $(OUT)/gen/*.cpp | wc -l) -eq $(COUNT)
+	@echo "aidl-cpp wrote all $(COUNT) outputs (jobserver=$(JOBSERVER))"
+
+$(OUT)/src/p/Bar.aidl:
+	@mkdir -p $(dir $@)
+	@echo "package p; parcelable Bar cpp_header \"p/Bar.h\";" > $@
+
+$(OUT)/src/p/IFoo%.aidl: | $(OUT)/src/p/Bar.aidl
+	@echo "package p; import p.Bar; interface IFoo$* {" \
+	    "void f(in Bar b); int g(int a); }" > $@
+
+$(OUT)/gen/IFoo%.cpp: $(OUT)/src/p/IFoo%.aidl
+	@mkdir -p $(dir $@) $(OUT)/headers
+	$(run_aidl) --io-threads=$(IO_THREADS) -I$(OUT)/src $< $(OUT)/headers $@
+
+clean:
+	rm -rf $(OUT)
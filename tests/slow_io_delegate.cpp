@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tests/slow_io_delegate.h"
+
+#include <cstdarg>
+#include <thread>
+
+#include <android-base/stringprintf.h>
+
+using android::base::StringAppendV;
+using std::chrono::microseconds;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace test {
+
+namespace {
+
+// Charges the owning SlowIoDelegate when it is closed.
+class SlowCodeWriter : public CodeWriter {
+ public:
+  SlowCodeWriter(const SlowIoDelegate* io_delegate,
+                 unique_ptr<CodeWriter> writer)
+      : io_delegate_(io_delegate), writer_(std::move(writer)) {}
+  virtual ~SlowCodeWriter() = default;
+
+  bool Write(const char* format, ...) override {
+    string line;
+    va_list ap;
+    va_start(ap, format);
+    StringAppendV(&line, format, ap);
+    va_end(ap);
+    return writer_->Write("%s", line.c_str());
+  }
+
+  bool Close() override {
+    io_delegate_->Charge(SlowIoDelegate::CLOSE_CODE_WRITER);
+    return writer_->Close();
+  }
+
+ private:
+  const SlowIoDelegate* io_delegate_;
+  unique_ptr<CodeWriter> writer_;
+
+  DISALLOW_COPY_AND_ASSIGN(SlowCodeWriter);
+};  // class SlowCodeWriter
+
+}  // namespace
+
+unique_ptr<string> SlowIoDelegate::GetFileContents(
+    const string& filename,
+    const string& append_content_suffix) const {
+  Charge(GET_FILE_CONTENTS);
+  return FakeIoDelegate::GetFileContents(filename, append_content_suffix);
+}
+
+unique_ptr<LineReader> SlowIoDelegate::GetLineReader(
+    const string& file_path) const {
+  Charge(GET_LINE_READER);
+  return FakeIoDelegate::GetLineReader(file_path);
+}
+
+bool SlowIoDelegate::FileIsReadable(const string& path) const {
+  Charge(FILE_IS_READABLE);
+  return FakeIoDelegate::FileIsReadable(path);
+}
+
+bool SlowIoDelegate::CreatedNestedDirs(
+    const string& base_dir,
+    const vector<string>& nested_subdirs) const {
+  Charge(CREATED_NESTED_DIRS);
+  return FakeIoDelegate::CreatedNestedDirs(base_dir, nested_subdirs);
+}
+
+unique_ptr<CodeWriter> SlowIoDelegate::GetCodeWriter(
+    const string& file_path) const {
+  Charge(GET_CODE_WRITER);
+  return unique_ptr<CodeWriter>(
+      new SlowCodeWriter(this, FakeIoDelegate::GetCodeWriter(file_path)));
+}
+
+void SlowIoDelegate::RemovePath(const string& file_path) const {
+  Charge(REMOVE_PATH);
+  FakeIoDelegate::RemovePath(file_path);
+}
+
+void SlowIoDelegate::SetLatency(Operation operation, microseconds latency) {
+  latency_[operation] = latency;
+}
+
+void SlowIoDelegate::SimulateNetworkFilesystem() {
+  const microseconds round_trip(500);
+  SetLatency(FILE_IS_READABLE, round_trip);
+  SetLatency(CREATED_NESTED_DIRS, round_trip);
+  SetLatency(REMOVE_PATH, round_trip);
+  SetLatency(GET_FILE_CONTENTS, 3 * round_trip);
+  SetLatency(GET_LINE_READER, 3 * round_trip);
+  SetLatency(GET_CODE_WRITER, 2 * round_trip);
+  SetLatency(CLOSE_CODE_WRITER, 2 * round_trip);
+}
+
+size_t SlowIoDelegate::GetCallCount(Operation operation) const {
+  return call_count_[operation];
+}
+
+void SlowIoDelegate::ResetCallCounts() {
+  for (std::atomic<size_t>& count : call_count_) {
+    count = 0;
+  }
+}
+
+void SlowIoDelegate::Charge(Operation operation) const {
+  ++call_count_[operation];
+  if (latency_[operation].count() > 0) {
+    std::this_thread::sleep_for(latency_[operation]);
+  }
+}
+
+const char* SlowIoDelegate::OperationName(Operation operation) {
+  switch (operation) {
+    case GET_FILE_CONTENTS: return "get_file_contents";
+    case GET_LINE_READER: return "get_line_reader";
+    case FILE_IS_READABLE: return "file_is_readable";
+    case CREATED_NESTED_DIRS: return "created_nested_dirs";
+    case GET_CODE_WRITER: return "get_code_writer";
+    case CLOSE_CODE_WRITER: return "close_code_writer";
+    case REMOVE_PATH: return "remove_path";
+    case OPERATION_COUNT: break;
+  }
+  return "unknown";
+}
+
+}  // namespace test
+}  // namespace android
+}  // namespace aidl
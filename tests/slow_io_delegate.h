@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TESTS_SLOW_IO_DELEGATE_H_
+#define AIDL_TESTS_SLOW_IO_DELEGATE_H_
+
+#include <android-base/macros.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tests/fake_io_delegate.h"
+
+namespace android {
+namespace aidl {
+namespace test {
+
+// A FakeIoDelegate that stands in for slow storage: each operation sleeps
+// for a configurable time before doing its work, and is counted.
+class SlowIoDelegate : public FakeIoDelegate {
+ public:
+  enum Operation {
+    GET_FILE_CONTENTS,
+    GET_LINE_READER,
+    FILE_IS_READABLE,
+    CREATED_NESTED_DIRS,
+    GET_CODE_WRITER,
+    // Closing a CodeWriter returned by GetCodeWriter(), i.e. flushing it.
+    CLOSE_CODE_WRITER,
+    REMOVE_PATH,
+    OPERATION_COUNT,
+  };
+
+  SlowIoDelegate() { ResetCallCounts(); }
+  virtual ~SlowIoDelegate() = default;
+
+  // Overrides from FakeIoDelegate
+  std::unique_ptr<std::string> GetFileContents(
+      const std::string& filename,
+      const std::string& append_content_suffix = "") const override;
+  std::unique_ptr<LineReader> GetLineReader(
+      const std::string& file_path) const override;
+  bool FileIsReadable(const std::string& path) const override;
+  bool CreatedNestedDirs(
+      const std::string& base_dir,
+      const std::vector<std::string>& nested_subdirs) const override;
+  std::unique_ptr<CodeWriter> GetCodeWriter(
+      const std::string& file_path) const override;
+  void RemovePath(const std::string& file_path) const override;
+
+  void SetLatency(Operation operation, std::chrono::microseconds latency);
+  // Sets latencies that resemble a network filesystem, where metadata
+  // lookups cost a round trip and opening a file costs a few.
+  void SimulateNetworkFilesystem();
+
+  size_t GetCallCount(Operation operation) const;
+  void ResetCallCounts();
+
+  // Sleeps for the latency of |operation| and counts it.
+  void Charge(Operation operation) const;
+
+  static const char* OperationName(Operation operation);
+
+ private:
+  std::chrono::microseconds latency_[OPERATION_COUNT] = {};
+  // AsyncIoDelegate calls from several threads at once.
+  mutable std::atomic<size_t> call_count_[OPERATION_COUNT];
+
+  DISALLOW_COPY_AND_ASSIGN(SlowIoDelegate);
+};  // class SlowIoDelegate
+
+}  // namespace test
+}  // namespace android
+}  // namespace aidl
+
+#endif // AIDL_TESTS_SLOW_IO_DELEGATE_H_
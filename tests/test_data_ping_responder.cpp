@@ -82,7 +82,27 @@ namespace android {
 
 namespace os {
 
-IMPLEMENT_META_INTERFACE(PingResponder, "android.os.IPingResponder");
+constexpr IPingResponder::DescriptorLiteral IPingResponder::descriptor;
+
+IPingResponder::DescriptorLiteral::operator const ::android::String16&() const {
+static const ::android::String16* const _aidl_descriptor = new ::android::String16(u"android.os.IPingResponder");
+return *_aidl_descriptor;
+}
+
+const ::android::String16& IPingResponder::getInterfaceDescriptor() const {
+return descriptor;
+}
+
+::android::sp<IPingResponder> IPingResponder::asInterface(const ::android::sp<::android::IBinder>& obj) {
+::android::sp<IPingResponder> _aidl_intr;
+if (obj != nullptr) {
+_aidl_intr = static_cast<IPingResponder*>(obj->queryLocalInterface(descriptor).get());
+if (_aidl_intr == nullptr) {
+_aidl_intr = new BpPingResponder(obj);
+}
+}
+return _aidl_intr;
+}
 
 }  // namespace os
 
@@ -382,7 +402,15 @@ namespace os {
 
 class IPingResponder : public ::android::IInterface {
 public:
-DECLARE_META_INTERFACE(PingResponder);
+class DescriptorLiteral {
+public:
+operator const ::android::String16&() const;
+};  // class DescriptorLiteral
+static constexpr DescriptorLiteral descriptor{};
+static ::android::sp<IPingResponder> asInterface(const ::android::sp<::android::IBinder>& obj);
+virtual const ::android::String16& getInterfaceDescriptor() const;
+IPingResponder() = default;
+virtual ~IPingResponder() = default;
 virtual ::android::binder::Status Ping(const ::android::String16& input, ::android::String16* _aidl_return) = 0;
 virtual ::android::binder::Status NullablePing(const ::std::unique_ptr<::android::String16>& input, ::std::unique_ptr<::android::String16>* _aidl_return) = 0;
 virtual ::android::binder::Status Utf8Ping(const ::std::string& input, ::std::string* _aidl_return) = 0;
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
 #include <algorithm>
 #include <iostream>
 #include <iterator>
@@ -163,6 +165,11 @@ void PrintDiff(const string& a, const string& b) {
   }
 }
 
+string BenchmarkSocketPath(int argc, char** argv, const char* benchmark) {
+  const string dir = (argc > 1) ? argv[1] : "/data/local/tmp";
+  return dir + "/" + benchmark + "." + std::to_string(getpid());
+}
+
 }  // namespace test
 }  // namespace android
 }  // namespace aidl
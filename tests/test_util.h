@@ -33,6 +33,11 @@ void SplitPackageClass(const std::string& package_class,
 
 void PrintDiff(const std::string& a, const std::string& b);
 
+// Returns a path for a socket named after |benchmark| in the directory given
+// as argv[1], or in /data/local/tmp without one.  Takes the directory for the
+// socket, so that it also runs on hosts.
+std::string BenchmarkSocketPath(int argc, char** argv, const char* benchmark);
+
 }  // namespace test
 }  // namespace android
 }  // namespace aidl
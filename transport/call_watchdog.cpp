@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/call_watchdog.h"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "logging.h"
+
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_lock;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+// Where a thread publishes the call it is in.  Slots are never freed: a
+// thread hands its slot back when it exits, for the next thread to reuse,
+// so the watchdog can walk them without locking.
+struct ThreadSlot {
+  std::atomic<bool> in_use{true};
+  std::atomic<int64_t> thread_id{0};
+  // Goes up by one before and after each Publish(), so it is odd while the
+  // fields below are being written.  They are only meaningful while this
+  // holds the same even value before and after reading them.
+  std::atomic<uint64_t> generation{0};
+  // 0 while no call is in flight.
+  std::atomic<uint64_t> start_ns{0};
+  std::atomic<const CallWatchTable*> table{nullptr};
+  std::atomic<size_t> method{0};
+  // The generation that first published the call.  A call published again
+  // after a nested one keeps its id, so that it is reported once, while a
+  // call that happens to start on the same tick as an earlier one doesn't.
+  std::atomic<uint64_t> call_id{0};
+  // Written by the watchdog, so that each call is reported once.
+  std::atomic<uint64_t> reported_call_id{0};
+  ThreadSlot* next = nullptr;
+};
+
+std::atomic<ThreadSlot*> thread_slots(nullptr);
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t CurrentThreadId() {
+#if defined(__linux__)
+  return syscall(SYS_gettid);
+#else
+  return static_cast<int64_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+ThreadSlot* AcquireSlot() {
+  ThreadSlot* slot = thread_slots.load(std::memory_order_acquire);
+  for (; slot != nullptr; slot = slot->next) {
+    bool in_use = false;
+    if (slot->in_use.compare_exchange_strong(in_use, true,
+                                             std::memory_order_acquire)) {
+      break;
+    }
+  }
+  if (slot == nullptr) {
+    slot = new ThreadSlot;
+    slot->next = thread_slots.load(std::memory_order_relaxed);
+    while (!thread_slots.compare_exchange_weak(slot->next, slot,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {}
+  }
+  slot->thread_id.store(CurrentThreadId(), std::memory_order_relaxed);
+  return slot;
+}
+
+// Publishes a call the way a seqlock writer would.  A |call_id| of 0 makes
+// this a new call.  Only the thread that owns |slot| writes to it.
+void Publish(ThreadSlot* slot, const CallWatchTable* table, size_t method,
+             uint64_t start_ns, uint64_t call_id) {
+  const uint64_t generation =
+      slot->generation.load(std::memory_order_relaxed) + 2;
+  slot->generation.store(generation - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  if (call_id == 0) {
+    call_id = generation;
+  }
+  slot->start_ns.store(start_ns, std::memory_order_relaxed);
+  slot->table.store(table, std::memory_order_relaxed);
+  slot->method.store(method, std::memory_order_relaxed);
+  slot->call_id.store(call_id, std::memory_order_relaxed);
+  slot->generation.store(generation, std::memory_order_release);
+}
+
+class SlotOwner {
+ public:
+  SlotOwner() : slot_(AcquireSlot()) {}
+  ~SlotOwner() {
+    Publish(slot_, nullptr, 0, 0, 0);
+    slot_->in_use.store(false, std::memory_order_release);
+  }
+
+  ThreadSlot* slot() const { return slot_; }
+
+ private:
+  ThreadSlot* const slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(SlotOwner);
+};
+
+ThreadSlot* CurrentSlot() {
+  thread_local SlotOwner owner;
+  return owner.slot();
+}
+
+}  // namespace
+
+constexpr std::chrono::milliseconds CallWatchTable::kDefaultThreshold;
+
+CallWatchTable::CallWatchTable(const char* interface,
+                               std::initializer_list<const char*> methods)
+    : interface_(interface),
+      methods_(methods.begin(), methods.end()),
+      thresholds_ns_(new std::atomic<int64_t>[methods.size()]) {
+  SetAllThresholds(kDefaultThreshold);
+}
+
+const string& CallWatchTable::MethodName(size_t method) const {
+  static const string* const kUnknownMethod = new string();
+  if (method >= methods_.size()) {
+    return *kUnknownMethod;
+  }
+  return methods_[method];
+}
+
+std::chrono::nanoseconds CallWatchTable::Threshold(size_t method) const {
+  if (method >= methods_.size()) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::nanoseconds(
+      thresholds_ns_[method].load(std::memory_order_relaxed));
+}
+
+void CallWatchTable::SetThreshold(size_t method,
+                                  std::chrono::nanoseconds threshold) {
+  if (method < methods_.size()) {
+    thresholds_ns_[method].store(threshold.count(), std::memory_order_relaxed);
+  }
+}
+
+void CallWatchTable::SetAllThresholds(std::chrono::nanoseconds threshold) {
+  for (size_t method = 0; method < methods_.size(); ++method) {
+    SetThreshold(method, threshold);
+  }
+}
+
+CallWatchScope::CallWatchScope(const CallWatchTable* table, size_t method) {
+  ThreadSlot* slot = CurrentSlot();
+  outer_.table = slot->table.load(std::memory_order_relaxed);
+  outer_.method = slot->method.load(std::memory_order_relaxed);
+  outer_.start_ns = slot->start_ns.load(std::memory_order_relaxed);
+  outer_.call_id = slot->call_id.load(std::memory_order_relaxed);
+  Publish(slot, table, method, NowNs(), 0);
+}
+
+CallWatchScope::~CallWatchScope() {
+  // Calls a service makes on itself run inside the outer one, which is
+  // watched again, from when it started, once they return.
+  Publish(CurrentSlot(), outer_.table, outer_.method, outer_.start_ns,
+          outer_.call_id);
+}
+
+CallWatchdog::CallWatchdog(const Options& options, Sink sink)
+    : options_(options),
+      sink_(sink) {}
+
+CallWatchdog::~CallWatchdog() {
+  Stop();
+}
+
+bool CallWatchdog::Start() {
+  if (thread_.joinable()) {
+    return false;
+  }
+  {
+    lock_guard<mutex> guard(lock_);
+    stopping_ = false;
+  }
+  thread_ = std::thread(&CallWatchdog::Run, this);
+  return true;
+}
+
+void CallWatchdog::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    lock_guard<mutex> guard(lock_);
+    stopping_ = true;
+  }
+  stop_condition_.notify_all();
+  thread_.join();
+}
+
+size_t CallWatchdog::Scan() {
+  const uint64_t now_ns = NowNs();
+  size_t stuck_calls = 0;
+  ThreadSlot* slot = thread_slots.load(std::memory_order_acquire);
+  for (; slot != nullptr; slot = slot->next) {
+    const uint64_t generation =
+        slot->generation.load(std::memory_order_acquire);
+    if (generation % 2 != 0) {
+      continue;  // A call is starting or ending.
+    }
+    const uint64_t start_ns = slot->start_ns.load(std::memory_order_relaxed);
+    const CallWatchTable* table = slot->table.load(std::memory_order_relaxed);
+    const size_t method = slot->method.load(std::memory_order_relaxed);
+    const uint64_t call_id = slot->call_id.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->generation.load(std::memory_order_relaxed) != generation) {
+      continue;  // The call changed while we looked at it.
+    }
+    if (start_ns == 0 || start_ns > now_ns || table == nullptr ||
+        slot->reported_call_id.load(std::memory_order_relaxed) == call_id) {
+      continue;
+    }
+    const std::chrono::nanoseconds threshold = table->Threshold(method);
+    const std::chrono::nanoseconds elapsed(now_ns - start_ns);
+    if (threshold.count() <= 0 || elapsed < threshold) {
+      continue;
+    }
+
+    slot->reported_call_id.store(call_id, std::memory_order_relaxed);
+    ++stuck_calls;
+    StuckCall call{table->Interface(), table->MethodName(method),
+                   slot->thread_id.load(std::memory_order_relaxed), elapsed};
+    if (sink_) {
+      sink_(call);
+    } else {
+      LOG(WARNING) << call.interface << "." << call.method << " has run for "
+                   << std::chrono::duration_cast<std::chrono::milliseconds>(
+                          call.elapsed).count()
+                   << "ms on thread " << call.thread_id;
+    }
+  }
+  return stuck_calls;
+}
+
+void CallWatchdog::Run() {
+  unique_lock<mutex> lock(lock_);
+  while (!stop_condition_.wait_for(lock, options_.interval,
+                                   [this]() { return stopping_; })) {
+    lock.unlock();
+    Scan();
+    lock.lock();
+  }
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_CALL_WATCHDOG_H_
+#define AIDL_TRANSPORT_CALL_WATCHDOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// The methods of one interface, and how long each may run before a
+// CallWatchdog reports it.  A BnFoo generated with aidl-cpp
+// --server-watchdog has one for all its instances.
+class CallWatchTable {
+ public:
+  static constexpr std::chrono::milliseconds kDefaultThreshold{1000};
+
+  CallWatchTable(const char* interface,
+                 std::initializer_list<const char*> methods);
+  ~CallWatchTable() = default;
+
+  const std::string& Interface() const { return interface_; }
+  size_t MethodCount() const { return methods_.size(); }
+  // The name of |method|, in the order the methods are declared, or an empty
+  // string for a method the table doesn't have.
+  const std::string& MethodName(size_t method) const;
+
+  // A threshold of zero stops calls to |method| from being reported.
+  std::chrono::nanoseconds Threshold(size_t method) const;
+  void SetThreshold(size_t method, std::chrono::nanoseconds threshold);
+  void SetAllThresholds(std::chrono::nanoseconds threshold);
+
+ private:
+  const std::string interface_;
+  const std::vector<std::string> methods_;
+  std::unique_ptr<std::atomic<int64_t>[]> thresholds_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(CallWatchTable);
+};
+
+// Marks a call to |method| as in flight on this thread from construction to
+// destruction.  Generated onTransact() implementations put one in each
+// case.  Costs a clock read and a few stores to memory only this thread
+// writes.
+class CallWatchScope {
+ public:
+  CallWatchScope(const CallWatchTable* table, size_t method);
+  ~CallWatchScope();
+
+ private:
+  struct Saved {
+    const CallWatchTable* table;
+    size_t method;
+    uint64_t start_ns;
+    uint64_t call_id;
+  };
+  // What an enclosing call on this thread had published.
+  Saved outer_;
+
+  DISALLOW_COPY_AND_ASSIGN(CallWatchScope);
+};
+
+// A call that has run past its method's threshold.
+struct StuckCall {
+  std::string interface;
+  std::string method;
+  // The kernel's id for the thread, where there is one.
+  int64_t thread_id;
+  std::chrono::nanoseconds elapsed;
+};
+
+// Looks over the calls in flight in this process and hands each one that
+// outlives its threshold to a sink, once.  Only the innermost call on each
+// thread is visible.
+class CallWatchdog {
+ public:
+  using Sink = std::function<void(const StuckCall&)>;
+
+  struct Options {
+    // How often to look at the calls in flight.
+    std::chrono::milliseconds interval{100};
+  };
+
+  // With a null |sink|, stuck calls are logged.
+  CallWatchdog(const Options& options, Sink sink);
+  // Stops the watchdog if it is running.
+  ~CallWatchdog();
+
+  // Checks the calls in flight every |options.interval| on a thread of its
+  // own.
+  bool Start();
+  void Stop();
+
+  // Reports calls that have become stuck since the last look and returns
+  // how many there were.  Start() calls this.
+  size_t Scan();
+
+ private:
+  void Run();
+
+  const Options options_;
+  const Sink sink_;
+  std::thread thread_;
+  std::mutex lock_;
+  std::condition_variable stop_condition_;
+  bool stopping_ = false;  // GUARDED_BY(lock_)
+
+  DISALLOW_COPY_AND_ASSIGN(CallWatchdog);
+};
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_CALL_WATCHDOG_H_
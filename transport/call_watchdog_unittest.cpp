@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "transport/call_watchdog.h"
+
+using std::chrono::milliseconds;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+class CallWatchdogTest : public ::testing::Test {
+ protected:
+  CallWatchdogTest()
+      : table_("a.IFoo", {"Quick", "Slow"}),
+        watchdog_(CallWatchdog::Options(), [this](const StuckCall& call) {
+          std::lock_guard<std::mutex> guard(lock_);
+          stuck_calls_.push_back(call);
+          reported_.notify_all();
+        }) {
+    table_.SetThreshold(kSlow, milliseconds(1));
+  }
+
+  vector<StuckCall> StuckCalls() {
+    std::lock_guard<std::mutex> guard(lock_);
+    return stuck_calls_;
+  }
+
+  static const size_t kQuick = 0;
+  static const size_t kSlow = 1;
+
+  CallWatchTable table_;
+  CallWatchdog watchdog_;
+  std::mutex lock_;
+  std::condition_variable reported_;
+  vector<StuckCall> stuck_calls_;  // GUARDED_BY(lock_)
+};
+
+TEST_F(CallWatchdogTest, StartsWithDefaultThresholds) {
+  EXPECT_EQ(2u, table_.MethodCount());
+  EXPECT_EQ("Slow", table_.MethodName(kSlow));
+  EXPECT_EQ("", table_.MethodName(2));
+  EXPECT_EQ(CallWatchTable::kDefaultThreshold, table_.Threshold(kQuick));
+  EXPECT_EQ(milliseconds(0), table_.Threshold(2));
+}
+
+TEST_F(CallWatchdogTest, ReportsEachStuckCallOnce) {
+  {
+    CallWatchScope scope(&table_, kSlow);
+    std::this_thread::sleep_for(milliseconds(5));
+    EXPECT_EQ(1u, watchdog_.Scan());
+    EXPECT_EQ(0u, watchdog_.Scan());
+  }
+  const vector<StuckCall> stuck_calls = StuckCalls();
+  ASSERT_EQ(1u, stuck_calls.size());
+  EXPECT_EQ("a.IFoo", stuck_calls[0].interface);
+  EXPECT_EQ("Slow", stuck_calls[0].method);
+  EXPECT_GE(stuck_calls[0].elapsed, milliseconds(5));
+
+  // Finished calls are forgotten.
+  std::this_thread::sleep_for(milliseconds(5));
+  EXPECT_EQ(0u, watchdog_.Scan());
+}
+
+TEST_F(CallWatchdogTest, IgnoresCallsWithinTheirThreshold) {
+  table_.SetThreshold(kSlow, milliseconds(0));
+  CallWatchScope slow(&table_, kSlow);
+  CallWatchScope quick(&table_, kQuick);
+  std::this_thread::sleep_for(milliseconds(5));
+  EXPECT_EQ(0u, watchdog_.Scan());
+}
+
+TEST_F(CallWatchdogTest, WatchesTheOuterCallAgainAfterANestedOne) {
+  CallWatchScope outer(&table_, kSlow);
+  {
+    CallWatchScope inner(&table_, kQuick);
+    std::this_thread::sleep_for(milliseconds(5));
+    EXPECT_EQ(0u, watchdog_.Scan());
+  }
+  EXPECT_EQ(1u, watchdog_.Scan());
+  const vector<StuckCall> stuck_calls = StuckCalls();
+  ASSERT_EQ(1u, stuck_calls.size());
+  EXPECT_EQ("Slow", stuck_calls[0].method);
+  EXPECT_GE(stuck_calls[0].elapsed, milliseconds(5));
+}
+
+TEST_F(CallWatchdogTest, ReportsAnOuterCallOnceAcrossNestedCalls) {
+  table_.SetThreshold(kQuick, milliseconds(0));
+  std::atomic<bool> done(false);
+  std::thread caller([this, &done]() {
+    CallWatchScope outer(&table_, kSlow);
+    while (!done.load()) {
+      {
+        CallWatchScope inner(&table_, kQuick);
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+  // Only the innermost call is visible, so the outer one shows between
+  // nested ones.
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (StuckCalls().empty() && std::chrono::steady_clock::now() < deadline) {
+    watchdog_.Scan();
+  }
+  for (int i = 0; i < 1000; ++i) {
+    watchdog_.Scan();
+  }
+  done.store(true);
+  caller.join();
+
+  // Every look caught either the outer call or a nested one, never a mix.
+  const vector<StuckCall> stuck_calls = StuckCalls();
+  ASSERT_EQ(1u, stuck_calls.size());
+  EXPECT_EQ("Slow", stuck_calls[0].method);
+}
+
+TEST_F(CallWatchdogTest, ReportsCallsThatFollowAStuckOne) {
+  for (int i = 0; i < 2; ++i) {
+    CallWatchScope scope(&table_, kSlow);
+    std::this_thread::sleep_for(milliseconds(5));
+    EXPECT_EQ(1u, watchdog_.Scan());
+  }
+  EXPECT_EQ(2u, StuckCalls().size());
+}
+
+TEST_F(CallWatchdogTest, ReportsCallsStuckOnOtherThreads) {
+  ASSERT_TRUE(watchdog_.Start());
+  EXPECT_FALSE(watchdog_.Start());
+
+  bool reported = false;
+  std::thread([this, &reported]() {
+    CallWatchScope scope(&table_, kSlow);
+    std::unique_lock<std::mutex> lock(lock_);
+    reported = reported_.wait_for(lock, std::chrono::seconds(10), [this]() {
+      return !stuck_calls_.empty();
+    });
+  }).join();
+  watchdog_.Stop();
+
+  EXPECT_TRUE(reported);
+  const vector<StuckCall> stuck_calls = StuckCalls();
+  ASSERT_EQ(1u, stuck_calls.size());
+  EXPECT_EQ("Slow", stuck_calls[0].method);
+  EXPECT_NE(0, stuck_calls[0].thread_id);
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/socket_framing.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "logging.h"
+
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+// A peer going away should show up as an error, not kill the process.
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+#ifdef MSG_CMSG_CLOEXEC
+const int kReceiveFlags = MSG_CMSG_CLOEXEC;
+#else
+const int kReceiveFlags = 0;
+#endif
+
+uint64_t SteadyTimeNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Drops the first |n| bytes from the array of |*count| iovecs at |*iov|.
+void AdvanceIovecs(struct iovec** iov, size_t* count, size_t n) {
+  while (*count > 0 && n >= (*iov)->iov_len) {
+    n -= (*iov)->iov_len;
+    ++*iov;
+    --*count;
+  }
+  if (*count > 0) {
+    (*iov)->iov_base = static_cast<uint8_t*>((*iov)->iov_base) + n;
+    (*iov)->iov_len -= n;
+  }
+}
+
+bool ReadFully(int socket, void* buffer, size_t size) {
+  uint8_t* cursor = static_cast<uint8_t*>(buffer);
+  while (size > 0) {
+    ssize_t n = TEMP_FAILURE_RETRY(read(socket, cursor, size));
+    if (n < 0) {
+      PLOG(ERROR) << "Failed to read frame";
+      return false;
+    }
+    if (n == 0) {
+      LOG(ERROR) << "Unexpected end of stream in the middle of a frame";
+      return false;
+    }
+    cursor += n;
+    size -= n;
+  }
+  return true;
+}
+
+}  // namespace
+
+Frame::~Frame() {
+  CloseFds();
+}
+
+void Frame::CloseFds() {
+  for (int fd : fds) {
+    close(fd);
+  }
+  fds.clear();
+}
+
+bool WriteFrame(int socket, uint32_t code, uint32_t flags,
+                const void* data, size_t data_size,
+                const uint64_t* objects, size_t object_count,
+                const vector<int>& fds) {
+  if (data_size > kMaxFrameDataSize || fds.size() > kMaxFrameFds ||
+      object_count > data_size / sizeof(uint64_t)) {
+    LOG(ERROR) << "Refusing to write a frame with " << data_size
+               << " bytes of data, " << object_count << " objects and "
+               << fds.size() << " file descriptors";
+    return false;
+  }
+
+  FrameHeader header;
+  header.code = code;
+  header.flags = flags;
+  header.data_size = data_size;
+  header.object_count = object_count;
+  header.fd_count = fds.size();
+  header.reserved = 0;
+  header.send_time_ns = SteadyTimeNs();
+
+  struct iovec iovs[3];
+  iovs[0].iov_base = &header;
+  iovs[0].iov_len = sizeof(header);
+  iovs[1].iov_base = const_cast<void*>(data);
+  iovs[1].iov_len = data_size;
+  iovs[2].iov_base = const_cast<uint64_t*>(objects);
+  iovs[2].iov_len = object_count * sizeof(uint64_t);
+  struct iovec* iov = iovs;
+  size_t iov_count = 3;
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  vector<uint8_t> control;
+  if (!fds.empty()) {
+    control.resize(CMSG_SPACE(sizeof(int) * fds.size()));
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+  }
+
+  while (iov_count > 0) {
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_count;
+    ssize_t n = TEMP_FAILURE_RETRY(sendmsg(socket, &msg, kSendFlags));
+    if (n < 0) {
+      PLOG(ERROR) << "Failed to write frame";
+      return false;
+    }
+    // Descriptors are attached to the first byte we manage to send.
+    msg.msg_control = nullptr;
+    msg.msg_controllen = 0;
+    AdvanceIovecs(&iov, &iov_count, n);
+  }
+  return true;
+}
+
+bool ReadFrame(int socket, Frame* frame) {
+  frame->CloseFds();
+
+  FrameHeader header;
+  struct iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+  uint8_t control[CMSG_SPACE(sizeof(int) * kMaxFrameFds)];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t n = TEMP_FAILURE_RETRY(recvmsg(socket, &msg, kReceiveFlags));
+  if (n < 0) {
+    PLOG(ERROR) << "Failed to read frame";
+    return false;
+  }
+  if (n == 0) {
+    // The peer closed the connection between frames.
+    return false;
+  }
+
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    const int* received = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+    frame->fds.insert(frame->fds.end(), received, received + count);
+  }
+  if (msg.msg_flags & MSG_CTRUNC) {
+    LOG(ERROR) << "File descriptors attached to frame were truncated";
+    return false;
+  }
+
+  if (static_cast<size_t>(n) < sizeof(header) &&
+      !ReadFully(socket, reinterpret_cast<uint8_t*>(&header) + n,
+                 sizeof(header) - n)) {
+    return false;
+  }
+
+  if (header.data_size > kMaxFrameDataSize ||
+      header.object_count > header.data_size / sizeof(uint64_t) ||
+      header.fd_count != frame->fds.size()) {
+    LOG(ERROR) << "Received malformed frame header with " << header.data_size
+               << " bytes of data, " << header.object_count << " objects and "
+               << header.fd_count << " file descriptors ("
+               << frame->fds.size() << " received)";
+    return false;
+  }
+
+  frame->code = header.code;
+  frame->flags = header.flags;
+  frame->send_time_ns = header.send_time_ns;
+  frame->data.resize(header.data_size);
+  frame->objects.resize(header.object_count);
+  return ReadFully(socket, frame->data.data(), frame->data.size()) &&
+         ReadFully(socket, frame->objects.data(),
+                   frame->objects.size() * sizeof(uint64_t));
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_SOCKET_FRAMING_H_
+#define AIDL_TRANSPORT_SOCKET_FRAMING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// Every message on a transport socket is a frame: a fixed size header, then
+// the Parcel data, then the 64 bit offsets of the objects embedded in that
+// data.  File descriptors travel as SCM_RIGHTS ancillary data attached to the
+// header, in the order their objects appear in the data.
+struct FrameHeader {
+  uint32_t code;
+  uint32_t flags;
+  uint32_t data_size;
+  uint32_t object_count;
+  uint32_t fd_count;
+  // Zero.  Keeps |send_time_ns| aligned without padding on the wire.
+  uint32_t reserved;
+  // When the sender wrote the frame, on its steady clock.  Both ends of an
+  // AF_UNIX socket are on the same host and so share that clock.
+  uint64_t send_time_ns;
+};
+
+// Frames larger than this are treated as a protocol error, so that a
+// misbehaving peer cannot make us allocate arbitrary amounts of memory.
+const size_t kMaxFrameDataSize = 1024 * 1024;
+// The kernel refuses to pass more descriptors than this in one message.
+const size_t kMaxFrameFds = 253;
+
+class Frame {
+ public:
+  Frame() = default;
+  // Closes any descriptors still owned by the frame.
+  ~Frame();
+
+  // Closes and forgets the descriptors owned by the frame.
+  void CloseFds();
+
+  uint32_t code = 0;
+  uint32_t flags = 0;
+  uint64_t send_time_ns = 0;
+  std::vector<uint8_t> data;
+  std::vector<uint64_t> objects;
+  // Descriptors received with the frame.  They are owned by the frame.
+  std::vector<int> fds;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Frame);
+};
+
+// Writes a single frame to |socket|.  |fds| are not closed.
+// Returns false on any error, after which the socket should be closed.
+bool WriteFrame(int socket, uint32_t code, uint32_t flags,
+                const void* data, size_t data_size,
+                const uint64_t* objects, size_t object_count,
+                const std::vector<int>& fds);
+
+// Blocks until a whole frame has been read from |socket| into |frame|.
+// Returns false on end of stream or any error, after which the socket
+// should be closed.
+bool ReadFrame(int socket, Frame* frame);
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_SOCKET_FRAMING_H_
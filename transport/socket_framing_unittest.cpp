@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "transport/socket_framing.h"
+
+using std::string;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+class SocketFramingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets_));
+  }
+
+  void TearDown() override {
+    for (int fd : sockets_) {
+      if (fd >= 0) close(fd);
+    }
+  }
+
+  int sockets_[2] = {-1, -1};
+};
+
+TEST_F(SocketFramingTest, RoundTripsDataAndObjects) {
+  const vector<uint8_t> data{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                             15, 16};
+  const vector<uint64_t> objects{0, 8};
+  ASSERT_TRUE(WriteFrame(sockets_[0], 42, 7, data.data(), data.size(),
+                         objects.data(), objects.size(), {}));
+
+  Frame frame;
+  ASSERT_TRUE(ReadFrame(sockets_[1], &frame));
+  EXPECT_EQ(42u, frame.code);
+  EXPECT_EQ(7u, frame.flags);
+  EXPECT_EQ(data, frame.data);
+  EXPECT_EQ(objects, frame.objects);
+  EXPECT_TRUE(frame.fds.empty());
+}
+
+TEST_F(SocketFramingTest, RoundTripsEmptyFrames) {
+  ASSERT_TRUE(WriteFrame(sockets_[0], 1, 0, nullptr, 0, nullptr, 0, {}));
+  ASSERT_TRUE(WriteFrame(sockets_[0], 2, 0, nullptr, 0, nullptr, 0, {}));
+
+  Frame frame;
+  ASSERT_TRUE(ReadFrame(sockets_[1], &frame));
+  EXPECT_EQ(1u, frame.code);
+  EXPECT_TRUE(frame.data.empty());
+  ASSERT_TRUE(ReadFrame(sockets_[1], &frame));
+  EXPECT_EQ(2u, frame.code);
+}
+
+TEST_F(SocketFramingTest, StampsSendTime) {
+  using clock = std::chrono::steady_clock;
+  const uint64_t before = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now().time_since_epoch()).count();
+  ASSERT_TRUE(WriteFrame(sockets_[0], 1, 0, nullptr, 0, nullptr, 0, {}));
+  const uint64_t after = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now().time_since_epoch()).count();
+
+  Frame frame;
+  ASSERT_TRUE(ReadFrame(sockets_[1], &frame));
+  EXPECT_LE(before, frame.send_time_ns);
+  EXPECT_GE(after, frame.send_time_ns);
+}
+
+TEST_F(SocketFramingTest, PassesFileDescriptors) {
+  int pipe_fds[2];
+  ASSERT_EQ(0, pipe(pipe_fds));
+  const uint8_t data[8] = {};
+  const uint64_t object = 0;
+  ASSERT_TRUE(WriteFrame(sockets_[0], 1, 0, data, sizeof(data), &object, 1,
+                         {pipe_fds[1]}));
+  close(pipe_fds[1]);
+
+  Frame frame;
+  ASSERT_TRUE(ReadFrame(sockets_[1], &frame));
+  ASSERT_EQ(1u, frame.fds.size());
+
+  // The received descriptor refers to the write end of our pipe.
+  const string message = "hello";
+  ASSERT_EQ(static_cast<ssize_t>(message.size()),
+            write(frame.fds[0], message.data(), message.size()));
+  frame.CloseFds();
+  char buffer[16];
+  ASSERT_EQ(static_cast<ssize_t>(message.size()),
+            read(pipe_fds[0], buffer, sizeof(buffer)));
+  EXPECT_EQ(message, string(buffer, message.size()));
+  close(pipe_fds[0]);
+}
+
+TEST_F(SocketFramingTest, RejectsOversizedFrames) {
+  const vector<uint8_t> data(kMaxFrameDataSize + 1);
+  EXPECT_FALSE(WriteFrame(sockets_[0], 1, 0, data.data(), data.size(),
+                          nullptr, 0, {}));
+
+  FrameHeader header = {1, 0, kMaxFrameDataSize + 1, 0, 0, 0, 0};
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(header)),
+            write(sockets_[0], &header, sizeof(header)));
+  Frame frame;
+  EXPECT_FALSE(ReadFrame(sockets_[1], &frame));
+}
+
+TEST_F(SocketFramingTest, RejectsHugeObjectCounts) {
+  // Object counts whose size in bytes wraps around to fit in the data.
+  uint8_t data[8] = {};
+  EXPECT_FALSE(WriteFrame(sockets_[0], 1, 0, data, sizeof(data), nullptr,
+                          SIZE_MAX / sizeof(uint64_t) + 2, {}));
+
+  FrameHeader header = {1, 0, sizeof(data), 0x20000001, 0, 0, 0};
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(header)),
+            write(sockets_[0], &header, sizeof(header)));
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(data)),
+            write(sockets_[0], data, sizeof(data)));
+  Frame frame;
+  EXPECT_FALSE(ReadFrame(sockets_[1], &frame));
+  EXPECT_TRUE(frame.objects.empty());
+}
+
+TEST_F(SocketFramingTest, RejectsMissingFileDescriptors) {
+  uint8_t data[8] = {};
+  FrameHeader header = {1, 0, sizeof(data), 1, 1, 0, 0};
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(header)),
+            write(sockets_[0], &header, sizeof(header)));
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(data)),
+            write(sockets_[0], data, sizeof(data)));
+  Frame frame;
+  EXPECT_FALSE(ReadFrame(sockets_[1], &frame));
+}
+
+TEST_F(SocketFramingTest, FailsOnTruncatedFrame) {
+  FrameHeader header = {1, 0, 16, 0, 0, 0, 0};
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(header)),
+            write(sockets_[0], &header, sizeof(header)));
+  close(sockets_[0]);
+  sockets_[0] = -1;
+  Frame frame;
+  EXPECT_FALSE(ReadFrame(sockets_[1], &frame));
+  // A clean end of stream between frames is reported the same way.
+  EXPECT_FALSE(ReadFrame(sockets_[1], &frame));
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,490 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/socket_transport.h"
+
+#include <cstring>
+
+#include <errno.h>
+#include <linux/binder.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <android-base/logging.h>
+#include <utils/Errors.h>
+
+#include "transport/transaction_metrics.h"
+
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// Reply frames carry the status_t returned by the server's transact() in
+// place of the transaction code, and no flags.
+
+namespace {
+
+static_assert(sizeof(binder_size_t) == sizeof(uint64_t),
+              "Object offsets are sent as 64 bit values");
+
+// Frames are at most a megabyte on a local socket, so a peer that takes
+// longer than this to send or take one has stalled.
+const std::chrono::milliseconds kDefaultIoTimeout(5000);
+
+void ReleaseFrame(Parcel* /* parcel */, const uint8_t* /* data */,
+                  size_t /* data_size */, const binder_size_t* /* objects */,
+                  size_t /* object_count */, void* cookie) {
+  delete static_cast<Frame*>(cookie);
+}
+
+bool MakeAddress(const string& path, struct sockaddr_un* addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr->sun_path)) {
+    LOG(ERROR) << "Socket path is too long: " << path;
+    return false;
+  }
+  memcpy(addr->sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+int ConnectTo(const string& path) {
+  struct sockaddr_un addr;
+  if (!MakeAddress(path, &addr)) {
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    PLOG(ERROR) << "Failed to create socket";
+    return -1;
+  }
+  if (TEMP_FAILURE_RETRY(connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                                 sizeof(addr))) != 0) {
+    PLOG(ERROR) << "Failed to connect to " << path;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+status_t FrameToParcel(unique_ptr<Frame> frame, Parcel* parcel) {
+  size_t next_fd = 0;
+  for (uint64_t offset : frame->objects) {
+    if (offset > frame->data.size() ||
+        frame->data.size() - offset < sizeof(flat_binder_object)) {
+      LOG(ERROR) << "Object offset " << offset << " is out of bounds";
+      return BAD_VALUE;
+    }
+    // Offsets are only 4 byte aligned, so don't access the object in place.
+    flat_binder_object object;
+    memcpy(&object, frame->data.data() + offset, sizeof(object));
+    if (object.type != BINDER_TYPE_FD || next_fd >= frame->fds.size()) {
+      LOG(ERROR) << "Unexpected object in frame";
+      return BAD_TYPE;
+    }
+    object.handle = frame->fds[next_fd++];
+    memcpy(frame->data.data() + offset, &object, sizeof(object));
+  }
+  if (next_fd != frame->fds.size()) {
+    LOG(ERROR) << "Frame carries unreferenced file descriptors";
+    return BAD_VALUE;
+  }
+
+  Frame* owned = frame.release();
+  parcel->ipcSetDataReference(owned->data.data(), owned->data.size(),
+                              owned->objects.data(), owned->objects.size(),
+                              ReleaseFrame, owned);
+  return OK;
+}
+
+status_t WriteParcel(int socket, uint32_t code, uint32_t flags,
+                     const Parcel& parcel) {
+  const uint8_t* data = parcel.ipcData();
+  const binder_size_t* objects = parcel.ipcObjects();
+  vector<int> fds;
+  for (size_t i = 0; i < parcel.ipcObjectsCount(); ++i) {
+    flat_binder_object object;
+    memcpy(&object, data + objects[i], sizeof(object));
+    if (object.type != BINDER_TYPE_FD) {
+      LOG(ERROR) << "Binder objects cannot be sent over a socket";
+      return BAD_TYPE;
+    }
+    fds.push_back(object.handle);
+  }
+  if (!WriteFrame(socket, code, flags, data, parcel.ipcDataSize(), objects,
+                  parcel.ipcObjectsCount(), fds)) {
+    return DEAD_OBJECT;
+  }
+  return OK;
+}
+
+sp<SocketBinder> SocketBinder::Connect(const string& path) {
+  int fd = ConnectTo(path);
+  if (fd < 0) {
+    return nullptr;
+  }
+  sp<SocketBinder> binder = new SocketBinder(path);
+  binder->ReleaseConnection(fd);
+  return binder;
+}
+
+SocketBinder::SocketBinder(const string& path) : path_(path) {}
+
+SocketBinder::~SocketBinder() {
+  for (int fd : idle_connections_) {
+    close(fd);
+  }
+}
+
+status_t SocketBinder::transact(uint32_t code, const Parcel& data,
+                                Parcel* reply, uint32_t flags) {
+  int fd = AcquireConnection();
+  if (fd < 0) {
+    return DEAD_OBJECT;
+  }
+
+  status_t status = WriteParcel(fd, code, flags, data);
+  if (status == OK && (flags & FLAG_ONEWAY) == 0) {
+    unique_ptr<Frame> frame(new Frame);
+    if (!ReadFrame(fd, frame.get())) {
+      status = DEAD_OBJECT;
+    } else {
+      status = static_cast<status_t>(frame->code);
+      if (status == OK && reply != nullptr) {
+        status = FrameToParcel(std::move(frame), reply);
+      }
+    }
+  }
+
+  if (status == DEAD_OBJECT) {
+    // The stream is in an unknown state, don't reuse it.
+    close(fd);
+  } else {
+    ReleaseConnection(fd);
+  }
+  return status;
+}
+
+int SocketBinder::AcquireConnection() {
+  {
+    lock_guard<mutex> guard(lock_);
+    if (!idle_connections_.empty()) {
+      int fd = idle_connections_.back();
+      idle_connections_.pop_back();
+      return fd;
+    }
+  }
+  return ConnectTo(path_);
+}
+
+void SocketBinder::ReleaseConnection(int fd) {
+  lock_guard<mutex> guard(lock_);
+  idle_connections_.push_back(fd);
+}
+
+SocketServer::SocketServer(const sp<IBinder>& service)
+    : service_(service), io_timeout_(kDefaultIoTimeout) {}
+
+SocketServer::~SocketServer() {
+  Stop();
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    unlink(path_.c_str());
+  }
+}
+
+bool SocketServer::Listen(const string& path) {
+  struct sockaddr_un addr;
+  if (listen_fd_ >= 0 || !MakeAddress(path, &addr)) {
+    return false;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    PLOG(ERROR) << "Failed to create socket";
+    return false;
+  }
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    PLOG(ERROR) << "Failed to listen on " << path;
+    close(fd);
+    return false;
+  }
+  listen_fd_ = fd;
+  path_ = path;
+  return true;
+}
+
+void SocketServer::SetIoTimeout(std::chrono::milliseconds timeout) {
+  io_timeout_ = timeout;
+}
+
+bool SocketServer::Start(size_t thread_count) {
+  {
+    lock_guard<mutex> guard(workers_lock_);
+    if (listen_fd_ < 0 || epoll_fd_ >= 0 || thread_count == 0) {
+      return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    retire_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+    bool success = epoll_fd_ >= 0 && stop_fd_ >= 0 && retire_fd_ >= 0;
+    if (!success) {
+      PLOG(ERROR) << "Failed to set up epoll";
+    }
+    // All are level triggered: every worker sees the stop event, and any
+    // idle worker may pick up new connections or retire.
+    for (int fd : {listen_fd_, stop_fd_, retire_fd_}) {
+      if (!success) {
+        break;
+      }
+      struct epoll_event event;
+      event.events = EPOLLIN;
+      event.data.fd = fd;
+      if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        PLOG(ERROR) << "Failed to add descriptor to epoll set";
+        success = false;
+      }
+    }
+    if (success) {
+      for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&SocketServer::WorkerLoop, this);
+      }
+      thread_count_ = thread_count;
+      return true;
+    }
+  }
+  Stop();
+  return false;
+}
+
+void SocketServer::Stop() {
+  {
+    lock_guard<mutex> guard(workers_lock_);
+    if (stop_fd_ >= 0) {
+      uint64_t one = 1;
+      if (TEMP_FAILURE_RETRY(write(stop_fd_, &one, sizeof(one))) < 0) {
+        PLOG(ERROR) << "Failed to signal workers";
+      }
+    }
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+    thread_count_ = 0;
+    {
+      lock_guard<mutex> retired_guard(retired_lock_);
+      retired_.clear();
+    }
+
+    for (int* fd : {&epoll_fd_, &stop_fd_, &retire_fd_}) {
+      if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+      }
+    }
+  }
+
+  lock_guard<mutex> guard(lock_);
+  for (int fd : connections_) {
+    close(fd);
+  }
+  connections_.clear();
+}
+
+size_t SocketServer::ThreadCount() {
+  lock_guard<mutex> guard(workers_lock_);
+  return thread_count_;
+}
+
+bool SocketServer::SetThreadCount(size_t thread_count) {
+  lock_guard<mutex> guard(workers_lock_);
+  if (epoll_fd_ < 0 || thread_count == 0) {
+    return false;
+  }
+  JoinRetiredWorkers();
+  if (thread_count < thread_count_) {
+    uint64_t count = thread_count_ - thread_count;
+    if (TEMP_FAILURE_RETRY(write(retire_fd_, &count, sizeof(count))) < 0) {
+      PLOG(ERROR) << "Failed to retire workers";
+      return false;
+    }
+  }
+  for (size_t i = thread_count_; i < thread_count; ++i) {
+    workers_.emplace_back(&SocketServer::WorkerLoop, this);
+  }
+  thread_count_ = thread_count;
+  return true;
+}
+
+void SocketServer::JoinRetiredWorkers() {
+  vector<std::thread::id> retired;
+  {
+    lock_guard<mutex> guard(retired_lock_);
+    retired.swap(retired_);
+  }
+  for (std::thread::id id : retired) {
+    for (auto worker = workers_.begin(); worker != workers_.end(); ++worker) {
+      if (worker->get_id() == id) {
+        worker->join();
+        workers_.erase(worker);
+        break;
+      }
+    }
+  }
+}
+
+bool SocketServer::RetireWorker() {
+  // The semaphore only lets as many workers through as were asked to exit.
+  uint64_t value;
+  if (TEMP_FAILURE_RETRY(read(retire_fd_, &value, sizeof(value))) !=
+      sizeof(value)) {
+    return false;
+  }
+  lock_guard<mutex> guard(retired_lock_);
+  retired_.push_back(std::this_thread::get_id());
+  return true;
+}
+
+void SocketServer::WorkerLoop() {
+  while (true) {
+    struct epoll_event event;
+    int count = TEMP_FAILURE_RETRY(epoll_wait(epoll_fd_, &event, 1, -1));
+    if (count < 0) {
+      PLOG(ERROR) << "epoll_wait failed";
+      return;
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    const int fd = event.data.fd;
+    if (fd == stop_fd_) {
+      return;
+    }
+    if (fd == retire_fd_) {
+      if (RetireWorker()) {
+        return;
+      }
+      continue;
+    }
+    if (fd == listen_fd_) {
+      AcceptConnections();
+      continue;
+    }
+
+    // Connections are registered one shot, so no other worker can see this
+    // one until we re-arm it.
+    if (!HandleTransaction(fd)) {
+      CloseConnection(fd);
+      continue;
+    }
+    event.events = EPOLLIN | EPOLLONESHOT;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0) {
+      PLOG(ERROR) << "Failed to re-arm connection";
+      CloseConnection(fd);
+    }
+  }
+}
+
+void SocketServer::AcceptConnections() {
+  while (true) {
+    int fd = TEMP_FAILURE_RETRY(accept4(listen_fd_, nullptr, nullptr,
+                                        SOCK_CLOEXEC));
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        PLOG(ERROR) << "Failed to accept connection";
+      }
+      return;
+    }
+    {
+      lock_guard<mutex> guard(lock_);
+      connections_.insert(fd);
+    }
+    // Workers block on a connection until its frame has been read and its
+    // reply written, so a peer that stops part way must not keep them.
+    struct timeval timeout;
+    timeout.tv_sec = io_timeout_.count() / 1000;
+    timeout.tv_usec = (io_timeout_.count() % 1000) * 1000;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                   sizeof(timeout)) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                   sizeof(timeout)) != 0) {
+      PLOG(ERROR) << "Failed to set connection timeouts";
+      CloseConnection(fd);
+      continue;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      PLOG(ERROR) << "Failed to add connection to epoll set";
+      CloseConnection(fd);
+    }
+  }
+}
+
+bool SocketServer::HandleTransaction(int fd) {
+  unique_ptr<Frame> frame(new Frame);
+  if (!ReadFrame(fd, frame.get())) {
+    return false;
+  }
+  const uint32_t code = frame->code;
+  const uint32_t flags = frame->flags;
+
+  Parcel data;
+  Parcel reply;
+  const uint64_t send_time_ns = frame->send_time_ns;
+  status_t status = FrameToParcel(std::move(frame), &data);
+  if (status == OK) {
+    // Lets services generated with --server-metrics see how long the
+    // transaction waited for a worker.
+    TransactionMetrics::SetDispatchTime(send_time_ns);
+    status = service_->transact(code, data, &reply, flags);
+    TransactionMetrics::SetDispatchTime(0);
+  }
+  if (flags & IBinder::FLAG_ONEWAY) {
+    return true;
+  }
+  if (status != OK) {
+    return WriteParcel(fd, status, 0, Parcel()) == OK;
+  }
+  return WriteParcel(fd, OK, 0, reply) == OK;
+}
+
+void SocketServer::CloseConnection(int fd) {
+  lock_guard<mutex> guard(lock_);
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  connections_.erase(fd);
+  close(fd);
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
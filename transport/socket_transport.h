@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_SOCKET_TRANSPORT_H_
+#define AIDL_TRANSPORT_SOCKET_TRANSPORT_H_
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/macros.h>
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <utils/StrongPointer.h>
+
+#include "transport/socket_framing.h"
+#include "transport/worker_pool_autoscaler.h"
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// Carries transactions for generated interfaces over an AF_UNIX socket
+// instead of the binder driver.  Wrap it with IFoo::asInterface() to get a
+// BpFoo that talks to a SocketServer:
+//
+//   sp<IFoo> foo = IFoo::asInterface(SocketBinder::Connect("/run/foo"));
+//
+// File descriptors may be passed, but binder objects cannot cross a socket
+// and transactions containing them fail with BAD_TYPE.
+class SocketBinder : public BBinder {
+ public:
+  // Returns nullptr if |path| cannot be connected to.
+  static sp<SocketBinder> Connect(const std::string& path);
+  virtual ~SocketBinder();
+
+  status_t transact(uint32_t code, const Parcel& data, Parcel* reply,
+                    uint32_t flags = 0) override;
+
+ private:
+  explicit SocketBinder(const std::string& path);
+
+  // Connections are used by one transaction at a time.  Concurrent callers
+  // open extra connections, which are kept around for later calls.
+  int AcquireConnection();
+  void ReleaseConnection(int fd);
+
+  const std::string path_;
+  std::mutex lock_;
+  std::vector<int> idle_connections_;
+
+  DISALLOW_COPY_AND_ASSIGN(SocketBinder);
+};
+
+// Serves transactions arriving on an AF_UNIX socket by passing them to
+// |service|->transact(), typically a BnFoo.  Each connection handles one
+// transaction at a time; requests on different connections are processed
+// in parallel by a pool of worker threads sharing one epoll set.  The pool
+// may be resized while it runs, for instance by a WorkerPoolAutoscaler.
+class SocketServer : public ResizableWorkerPool {
+ public:
+  explicit SocketServer(const sp<IBinder>& service);
+  // Stops the server if it is running.
+  ~SocketServer();
+
+  // Binds to |path|, replacing any stale socket left there.
+  bool Listen(const std::string& path);
+  // Connections that stall for longer than |timeout| in the middle of a
+  // frame, or while a reply is written to them, are closed so that they
+  // can't hold on to a worker.  Must be called before Start().
+  void SetIoTimeout(std::chrono::milliseconds timeout);
+  // Starts |thread_count| workers.  Listen() must have succeeded.
+  bool Start(size_t thread_count);
+  // Stops all workers and closes every connection.
+  void Stop();
+
+  // The number of workers once any that were asked to exit have done so.
+  size_t ThreadCount() override;
+  // Starts more workers, or asks idle ones to exit.  Workers busy with a
+  // transaction finish it first.
+  bool SetThreadCount(size_t thread_count) override;
+
+ private:
+  void WorkerLoop();
+  // Returns true if this worker should exit to shrink the pool.
+  bool RetireWorker();
+  void JoinRetiredWorkers();  // REQUIRES(workers_lock_)
+  void AcceptConnections();
+  // Returns false if the connection should be closed.
+  bool HandleTransaction(int fd);
+  void CloseConnection(int fd);
+
+  const sp<IBinder> service_;
+  std::string path_;
+  int listen_fd_ = -1;
+  std::chrono::milliseconds io_timeout_;
+  int epoll_fd_ = -1;
+  int stop_fd_ = -1;
+  // A semaphore counting the workers that should exit.
+  int retire_fd_ = -1;
+  std::mutex workers_lock_;
+  std::vector<std::thread> workers_;  // GUARDED_BY(workers_lock_)
+  size_t thread_count_ = 0;  // GUARDED_BY(workers_lock_)
+  // Workers that have exited, to be joined.  Exiting workers can't take
+  // |workers_lock_|, which is held while joining them.
+  std::mutex retired_lock_;
+  std::vector<std::thread::id> retired_;  // GUARDED_BY(retired_lock_)
+  std::mutex lock_;
+  std::set<int> connections_;  // GUARDED_BY(lock_)
+
+  DISALLOW_COPY_AND_ASSIGN(SocketServer);
+};
+
+// Hands |frame| over to |parcel| without copying.  The frame's descriptors
+// are patched into the matching objects and closed when |parcel| lets go of
+// the data.
+status_t FrameToParcel(std::unique_ptr<Frame> frame, Parcel* parcel);
+
+// Writes |parcel| to |socket| as a single frame.
+status_t WriteParcel(int socket, uint32_t code, uint32_t flags,
+                     const Parcel& parcel);
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_SOCKET_TRANSPORT_H_
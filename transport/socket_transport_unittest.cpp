@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+#include <utils/StrongPointer.h>
+
+#include "transport/socket_framing.h"
+#include "transport/socket_transport.h"
+
+using std::string;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+// Replies with the integer it was sent, plus one.
+class Increment : public BBinder {
+ public:
+  status_t onTransact(uint32_t code, const Parcel& data, Parcel* reply,
+                      uint32_t flags) override {
+    int32_t value;
+    status_t status = data.readInt32(&value);
+    if (status != OK) {
+      return status;
+    }
+    return reply->writeInt32(value + 1);
+  }
+};
+
+}  // namespace
+
+class SocketTransportTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = "/data/local/tmp/socket_transport_unittest." +
+            std::to_string(getpid());
+    server_.reset(new SocketServer(new Increment));
+    ASSERT_TRUE(server_->Listen(path_));
+  }
+
+  // Connects without a SocketBinder, to write whatever we like.
+  int ConnectRaw() {
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                           sizeof(addr)) != 0) {
+      close(fd);
+      fd = -1;
+    }
+    return fd;
+  }
+
+  string path_;
+  std::unique_ptr<SocketServer> server_;
+};
+
+TEST_F(SocketTransportTest, RoundTripsTransactions) {
+  ASSERT_TRUE(server_->Start(1));
+  sp<SocketBinder> binder = SocketBinder::Connect(path_);
+  ASSERT_NE(nullptr, binder.get());
+  Parcel data, reply;
+  data.writeInt32(41);
+  ASSERT_EQ(OK, binder->transact(IBinder::FIRST_CALL_TRANSACTION, data,
+                                 &reply));
+  EXPECT_EQ(42, reply.readInt32());
+}
+
+TEST_F(SocketTransportTest, StalledClientDoesNotBlockOthers) {
+  server_->SetIoTimeout(std::chrono::milliseconds(500));
+  // A single worker, which the stalled client would otherwise keep.
+  ASSERT_TRUE(server_->Start(1));
+
+  const int stalled = ConnectRaw();
+  ASSERT_LE(0, stalled);
+  FrameHeader header = {IBinder::FIRST_CALL_TRANSACTION, 0, 4, 0, 0, 0, 0};
+  const size_t partial = sizeof(header) / 2;
+  ASSERT_EQ(static_cast<ssize_t>(partial), write(stalled, &header, partial));
+  // Lets the worker start on the stalled connection first.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  sp<SocketBinder> binder = SocketBinder::Connect(path_);
+  ASSERT_NE(nullptr, binder.get());
+  Parcel data, reply;
+  data.writeInt32(1);
+  EXPECT_EQ(OK, binder->transact(IBinder::FIRST_CALL_TRANSACTION, data,
+                                 &reply));
+  EXPECT_EQ(2, reply.readInt32());
+
+  // The server gave up on the stalled connection.
+  char byte;
+  EXPECT_EQ(0, read(stalled, &byte, 1));
+  close(stalled);
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
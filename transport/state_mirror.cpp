@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/state_mirror.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+
+using std::lock_guard;
+using std::mutex;
+using std::unique_ptr;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+// Regions start with room for this much and double past the largest
+// snapshot when they have to grow.
+const size_t kMinCapacity = 4096;
+
+}  // namespace
+
+status_t StateMirrorPublisher::Publish(const Parcel& snapshot) {
+  if (snapshot.objectsCount() != 0) {
+    return BAD_TYPE;
+  }
+  const size_t size = snapshot.dataSize();
+  lock_guard<mutex> guard(lock_);
+  // Destroying the old region retires it, which sends clients to fetch the
+  // new one.  Publish first so that they find a snapshot there.
+  unique_ptr<StateMirrorWriter> outgrown;
+  if (writer_ == nullptr || size > writer_->Capacity()) {
+    unique_ptr<StateMirrorWriter> writer =
+        StateMirrorWriter::Create(std::max(kMinCapacity, 2 * size));
+    if (writer == nullptr) {
+      return NO_MEMORY;
+    }
+    outgrown = std::move(writer_);
+    writer_ = std::move(writer);
+  }
+  return writer_->Publish(snapshot.data(), size) ? OK : BAD_VALUE;
+}
+
+status_t StateMirrorPublisher::WriteRegion(Parcel* reply) {
+  lock_guard<mutex> guard(lock_);
+  // Clients asking before the first snapshot get an empty region, and keep
+  // calling over IPC until something is published into it.
+  if (writer_ == nullptr) {
+    writer_ = StateMirrorWriter::Create(kMinCapacity);
+    if (writer_ == nullptr) {
+      return NO_MEMORY;
+    }
+  }
+  return reply->writeDupFileDescriptor(writer_->ReadOnlyFd());
+}
+
+bool StateMirrorSubscriber::Read(IBinder* remote, const String16& descriptor,
+                                 uint32_t mirror_code, uint32_t method,
+                                 Parcel* snapshot) {
+  if (unavailable_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  StateMirrorReader* reader = reader_.load(std::memory_order_acquire);
+  if (reader == nullptr || reader->IsRetired()) {
+    reader = Fetch(remote, descriptor, mirror_code, method);
+    if (reader == nullptr) {
+      return false;
+    }
+  }
+  return reader->Read([snapshot](const uint8_t* data, size_t size) {
+    return snapshot->setData(data, size) == OK;
+  });
+}
+
+StateMirrorReader* StateMirrorSubscriber::Fetch(IBinder* remote,
+                                                const String16& descriptor,
+                                                uint32_t mirror_code,
+                                                uint32_t method) {
+  lock_guard<mutex> guard(lock_);
+  StateMirrorReader* current = reader_.load(std::memory_order_relaxed);
+  if (current != nullptr && !current->IsRetired()) {
+    return current;  // Another thread fetched it first.
+  }
+
+  Parcel data;
+  Parcel reply;
+  status_t status = data.writeInterfaceToken(descriptor);
+  if (status == OK) {
+    status = data.writeInt32(method);
+  }
+  if (status == OK) {
+    status = remote->transact(mirror_code, data, &reply);
+  }
+  // The reply owns the descriptor it carries.
+  const int fd = (status == OK) ? reply.readFileDescriptor() : -1;
+  unique_ptr<StateMirrorReader> reader =
+      StateMirrorReader::Map((fd >= 0) ? fcntl(fd, F_DUPFD_CLOEXEC, 0) : -1);
+  if (reader == nullptr) {
+    // Services built without the mirror, or transports that can't pass
+    // descriptors, won't do any better next time.
+    unavailable_.store(true, std::memory_order_relaxed);
+    return nullptr;
+  }
+  readers_.push_back(std::move(reader));
+  reader_.store(readers_.back().get(), std::memory_order_release);
+  return readers_.back().get();
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
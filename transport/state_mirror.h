@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_STATE_MIRROR_H_
+#define AIDL_TRANSPORT_STATE_MIRROR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <android-base/macros.h>
+#include <binder/IBinder.h>
+#include <binder/Parcel.h>
+#include <utils/Errors.h>
+#include <utils/String16.h>
+
+#include "transport/state_mirror_region.h"
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// The service side of a @mirrored method.  A generated BnFoo keeps one for
+// each, which its PublishFoo() writes snapshots into.
+class StateMirrorPublisher {
+ public:
+  StateMirrorPublisher() = default;
+  ~StateMirrorPublisher() = default;
+
+  // Makes |snapshot| what clients read from now on.  Snapshots cannot carry
+  // binders or file descriptors.
+  status_t Publish(const Parcel& snapshot);
+  // Answers a client asking for the mirror with a read only descriptor.
+  status_t WriteRegion(Parcel* reply);
+
+ private:
+  std::mutex lock_;
+  std::unique_ptr<StateMirrorWriter> writer_;  // GUARDED_BY(lock_)
+
+  DISALLOW_COPY_AND_ASSIGN(StateMirrorPublisher);
+};
+
+// The client side of a @mirrored method, kept by a generated BpFoo.
+class StateMirrorSubscriber {
+ public:
+  StateMirrorSubscriber() = default;
+  ~StateMirrorSubscriber() = default;
+
+  // Copies the latest snapshot published for the method with transaction
+  // code |method| into |snapshot|.  On first use, and after the service
+  // moves the mirror, asks |remote| for it with a |mirror_code|
+  // transaction.  Returns false if the caller should make the call over IPC
+  // instead: the service has no mirror or hasn't published to it yet, or
+  // publishes too often to read a snapshot.
+  bool Read(IBinder* remote, const String16& descriptor, uint32_t mirror_code,
+            uint32_t method, Parcel* snapshot);
+
+ private:
+  StateMirrorReader* Fetch(IBinder* remote, const String16& descriptor,
+                           uint32_t mirror_code, uint32_t method);
+
+  std::atomic<StateMirrorReader*> reader_{nullptr};
+  std::atomic<bool> unavailable_{false};
+  std::mutex lock_;
+  // Retired readers too, as other threads may still be reading through them.
+  std::vector<std::unique_ptr<StateMirrorReader>> readers_;  // GUARDED_BY(lock_)
+
+  DISALLOW_COPY_AND_ASSIGN(StateMirrorSubscriber);
+};
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_STATE_MIRROR_H_
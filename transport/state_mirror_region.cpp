@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/state_mirror_region.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__ANDROID__)
+#include <cutils/ashmem.h>
+#elif defined(__linux__) && defined(__NR_memfd_create)
+#include <linux/memfd.h>
+#define AIDL_STATE_MIRROR_USE_MEMFD
+#endif
+
+#include "logging.h"
+
+using std::string;
+using std::unique_ptr;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// Sits at the start of the region, followed by the snapshot at kDataOffset.
+struct StateMirrorHeader {
+  uint32_t magic;
+  uint32_t capacity;
+  // Odd while a snapshot is being written, and 0 before the first one.
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint32_t> size;
+  std::atomic<uint32_t> retired;
+};
+
+namespace {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+              "Seqlocks in shared memory need address free atomics");
+
+const uint32_t kMagic = 0x6d697272;  // "mirr"
+const size_t kDataOffset = 64;
+static_assert(sizeof(StateMirrorHeader) <= kDataOffset,
+              "Header overlaps the snapshot");
+// A reader racing a writer this many times in a row falls back to IPC.
+const int kMaxReadAttempts = 64;
+
+// Creates |size| bytes of shared memory and maps them writable at |*mapping|.
+// |*read_only_fd| is set to a descriptor that can only be mapped for reading.
+#if defined(__ANDROID__)
+bool CreateSharedMemory(size_t size, void** mapping, int* read_only_fd) {
+  int fd = ashmem_create_region("aidl-state-mirror", size);
+  if (fd < 0) {
+    PLOG(ERROR) << "Failed to create state mirror";
+    return false;
+  }
+  *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (*mapping == MAP_FAILED) {
+    PLOG(ERROR) << "Failed to map state mirror";
+    close(fd);
+    return false;
+  }
+  // Later mappings, including every reader's, are read only.
+  if (ashmem_set_prot_region(fd, PROT_READ) != 0) {
+    PLOG(ERROR) << "Failed to protect state mirror";
+    munmap(*mapping, size);
+    close(fd);
+    return false;
+  }
+  *read_only_fd = fd;
+  return true;
+}
+#else
+// Hands out a file that is already unlinked, through a descriptor opened
+// for reading.
+bool CreateTemporaryFile(size_t size, void** mapping, int* read_only_fd) {
+  const char* tmpdir = getenv("TMPDIR");
+  string path = string((tmpdir != nullptr) ? tmpdir : "/tmp") +
+                "/aidl-state-mirror-XXXXXX";
+  int fd = mkstemp(&path[0]);
+  if (fd < 0) {
+    PLOG(ERROR) << "Failed to create state mirror";
+    return false;
+  }
+  *read_only_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  unlink(path.c_str());
+  if (*read_only_fd < 0 || ftruncate(fd, size) != 0) {
+    PLOG(ERROR) << "Failed to set up state mirror";
+    if (*read_only_fd >= 0) close(*read_only_fd);
+    close(fd);
+    return false;
+  }
+  *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (*mapping == MAP_FAILED) {
+    PLOG(ERROR) << "Failed to map state mirror";
+    close(*read_only_fd);
+    return false;
+  }
+  return true;
+}
+
+bool CreateSharedMemory(size_t size, void** mapping, int* read_only_fd) {
+#if defined(AIDL_STATE_MIRROR_USE_MEMFD)
+  int fd = syscall(__NR_memfd_create, "aidl-state-mirror",
+                   MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    // Kernels before 3.17 have no memfd.
+    return CreateTemporaryFile(size, mapping, read_only_fd);
+  }
+  const string self_path = "/proc/self/fd/" + std::to_string(fd);
+  *read_only_fd = -1;
+  *mapping = MAP_FAILED;
+  if (ftruncate(fd, size) == 0) {
+    *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (*mapping != MAP_FAILED) {
+    *read_only_fd = open(self_path.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+#if defined(F_ADD_SEALS)
+  // Readers must not be able to resize the region under us.
+  int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+#if defined(F_SEAL_FUTURE_WRITE)
+  // Nor, where the kernel allows it, write to it.
+  seals |= F_SEAL_FUTURE_WRITE;
+#endif
+  if (*read_only_fd >= 0 && fcntl(fd, F_ADD_SEALS, seals) != 0) {
+    PLOG(WARNING) << "Failed to seal state mirror";
+  }
+#endif
+  close(fd);
+  if (*read_only_fd < 0) {
+    PLOG(ERROR) << "Failed to set up state mirror";
+    if (*mapping != MAP_FAILED) munmap(*mapping, size);
+    return false;
+  }
+  return true;
+#else
+  return CreateTemporaryFile(size, mapping, read_only_fd);
+#endif
+}
+#endif
+
+size_t RegionSize(int fd) {
+#if defined(__ANDROID__)
+  int size = ashmem_get_size_region(fd);
+  return (size > 0) ? size : 0;
+#else
+  struct stat info;
+  return (fstat(fd, &info) == 0 && info.st_size > 0) ? info.st_size : 0;
+#endif
+}
+
+}  // namespace
+
+unique_ptr<StateMirrorWriter> StateMirrorWriter::Create(size_t capacity) {
+  if (capacity > UINT32_MAX - kDataOffset) {
+    return nullptr;
+  }
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t mapping_size =
+      (kDataOffset + capacity + page_size - 1) / page_size * page_size;
+  void* mapping;
+  int read_only_fd;
+  if (!CreateSharedMemory(mapping_size, &mapping, &read_only_fd)) {
+    return nullptr;
+  }
+  return unique_ptr<StateMirrorWriter>(
+      new StateMirrorWriter(mapping, mapping_size, read_only_fd));
+}
+
+StateMirrorWriter::StateMirrorWriter(void* mapping, size_t mapping_size,
+                                     int read_only_fd)
+    : mapping_(mapping),
+      mapping_size_(mapping_size),
+      read_only_fd_(read_only_fd),
+      header_(new (mapping) StateMirrorHeader),
+      data_(static_cast<uint8_t*>(mapping) + kDataOffset),
+      capacity_(mapping_size - kDataOffset) {
+  header_->capacity = capacity_;
+  header_->sequence.store(0, std::memory_order_relaxed);
+  header_->size.store(0, std::memory_order_relaxed);
+  header_->retired.store(0, std::memory_order_relaxed);
+  // Readers only get the descriptor after this, through IPC.
+  header_->magic = kMagic;
+}
+
+StateMirrorWriter::~StateMirrorWriter() {
+  Retire();
+  munmap(mapping_, mapping_size_);
+  close(read_only_fd_);
+}
+
+bool StateMirrorWriter::Publish(const uint8_t* data, size_t size) {
+  if (size > capacity_) {
+    return false;
+  }
+  const uint32_t sequence =
+      header_->sequence.load(std::memory_order_relaxed);
+  header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->size.store(size, std::memory_order_relaxed);
+  memcpy(data_, data, size);
+  // Skip 0, which means nothing was published, when the count wraps.
+  const uint32_t next = (sequence + 2 == 0) ? 2 : sequence + 2;
+  header_->sequence.store(next, std::memory_order_release);
+  return true;
+}
+
+void StateMirrorWriter::Retire() {
+  header_->retired.store(1, std::memory_order_release);
+}
+
+unique_ptr<StateMirrorReader> StateMirrorReader::Map(int fd) {
+  if (fd < 0) {
+    return nullptr;
+  }
+  const size_t mapping_size = RegionSize(fd);
+  void* mapping = MAP_FAILED;
+  if (mapping_size > kDataOffset) {
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map state mirror";
+    return nullptr;
+  }
+  const StateMirrorHeader* header =
+      static_cast<const StateMirrorHeader*>(mapping);
+  if (header->magic != kMagic ||
+      header->capacity > mapping_size - kDataOffset) {
+    LOG(ERROR) << "Descriptor is not a state mirror";
+    munmap(mapping, mapping_size);
+    return nullptr;
+  }
+  return unique_ptr<StateMirrorReader>(
+      new StateMirrorReader(mapping, mapping_size));
+}
+
+StateMirrorReader::StateMirrorReader(const void* mapping, size_t mapping_size)
+    : mapping_(mapping),
+      mapping_size_(mapping_size),
+      header_(static_cast<const StateMirrorHeader*>(mapping)),
+      data_(static_cast<const uint8_t*>(mapping) + kDataOffset),
+      capacity_(header_->capacity) {}
+
+StateMirrorReader::~StateMirrorReader() {
+  munmap(const_cast<void*>(mapping_), mapping_size_);
+}
+
+bool StateMirrorReader::Read(
+    const std::function<bool(const uint8_t* data, size_t size)>& copy) const {
+  for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+    if (IsRetired()) {
+      return false;
+    }
+    const uint32_t begin = header_->sequence.load(std::memory_order_acquire);
+    if (begin == 0) {
+      return false;
+    }
+    if (begin & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    // A size beyond the capacity can only come from a torn read.
+    const uint32_t size = header_->size.load(std::memory_order_relaxed);
+    const bool copied = size <= capacity_ && copy(data_, size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header_->sequence.load(std::memory_order_relaxed) == begin) {
+      return copied;
+    }
+  }
+  return false;
+}
+
+bool StateMirrorReader::IsRetired() const {
+  return header_->retired.load(std::memory_order_acquire) != 0;
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
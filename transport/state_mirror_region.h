@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_STATE_MIRROR_REGION_H_
+#define AIDL_TRANSPORT_STATE_MIRROR_REGION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+struct StateMirrorHeader;
+
+// Shared memory holding the latest snapshot of some state, written by one
+// process and read by others without any IPC.  Readers copy the snapshot out
+// under a seqlock and retry if a write overlapped their copy, so the writer
+// never waits for them.
+class StateMirrorWriter {
+ public:
+  // Returns nullptr if a region for snapshots of up to |capacity| bytes
+  // cannot be created.
+  static std::unique_ptr<StateMirrorWriter> Create(size_t capacity);
+  // Retires the region.
+  ~StateMirrorWriter();
+
+  size_t Capacity() const { return capacity_; }
+  // A descriptor for the region that can be mapped for reading only.
+  int ReadOnlyFd() const { return read_only_fd_; }
+
+  // Replaces the snapshot.  Fails if |size| exceeds the capacity.  Writes
+  // must not overlap each other.
+  bool Publish(const uint8_t* data, size_t size);
+  // Tells readers that the region is no longer written, for instance
+  // because snapshots outgrew it.
+  void Retire();
+
+ private:
+  StateMirrorWriter(void* mapping, size_t mapping_size, int read_only_fd);
+
+  void* const mapping_;
+  const size_t mapping_size_;
+  const int read_only_fd_;
+  StateMirrorHeader* const header_;
+  uint8_t* const data_;
+  const size_t capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(StateMirrorWriter);
+};
+
+class StateMirrorReader {
+ public:
+  // Maps the region behind |fd|, which it takes ownership of.  Returns
+  // nullptr if |fd| isn't a StateMirrorWriter's region.
+  static std::unique_ptr<StateMirrorReader> Map(int fd);
+  ~StateMirrorReader();
+
+  // Calls |copy| with the latest snapshot until it gets one that no write
+  // overlapped.  |copy| may see torn data in calls whose result is thrown
+  // away, so it should do nothing but copy.  Returns false if nothing was
+  // published, the region was retired, or writes kept overlapping the copy.
+  bool Read(const std::function<bool(const uint8_t* data, size_t size)>& copy)
+      const;
+  bool IsRetired() const;
+
+ private:
+  StateMirrorReader(const void* mapping, size_t mapping_size);
+
+  const void* const mapping_;
+  const size_t mapping_size_;
+  const StateMirrorHeader* const header_;
+  const uint8_t* const data_;
+  const size_t capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(StateMirrorReader);
+};
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_STATE_MIRROR_REGION_H_
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "transport/state_mirror_region.h"
+
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+unique_ptr<StateMirrorReader> MapReader(const StateMirrorWriter& writer) {
+  return StateMirrorReader::Map(fcntl(writer.ReadOnlyFd(), F_DUPFD_CLOEXEC, 0));
+}
+
+bool ReadSnapshot(const StateMirrorReader& reader, vector<uint8_t>* snapshot) {
+  return reader.Read([snapshot](const uint8_t* data, size_t size) {
+    snapshot->assign(data, data + size);
+    return true;
+  });
+}
+
+}  // namespace
+
+TEST(StateMirrorRegionTest, ReadsLatestSnapshot) {
+  unique_ptr<StateMirrorWriter> writer = StateMirrorWriter::Create(16);
+  ASSERT_NE(nullptr, writer);
+  EXPECT_GE(writer->Capacity(), 16u);
+  unique_ptr<StateMirrorReader> reader = MapReader(*writer);
+  ASSERT_NE(nullptr, reader);
+
+  vector<uint8_t> snapshot;
+  EXPECT_FALSE(ReadSnapshot(*reader, &snapshot));  // Nothing published yet.
+
+  const vector<uint8_t> first{1, 2, 3};
+  const vector<uint8_t> second{4, 5, 6, 7, 8};
+  ASSERT_TRUE(writer->Publish(first.data(), first.size()));
+  ASSERT_TRUE(ReadSnapshot(*reader, &snapshot));
+  EXPECT_EQ(first, snapshot);
+  ASSERT_TRUE(writer->Publish(second.data(), second.size()));
+  ASSERT_TRUE(ReadSnapshot(*reader, &snapshot));
+  EXPECT_EQ(second, snapshot);
+}
+
+TEST(StateMirrorRegionTest, RejectsOversizedSnapshots) {
+  unique_ptr<StateMirrorWriter> writer = StateMirrorWriter::Create(16);
+  ASSERT_NE(nullptr, writer);
+  const vector<uint8_t> too_big(writer->Capacity() + 1);
+  EXPECT_FALSE(writer->Publish(too_big.data(), too_big.size()));
+}
+
+TEST(StateMirrorRegionTest, ReadersSeeRetirement) {
+  unique_ptr<StateMirrorWriter> writer = StateMirrorWriter::Create(16);
+  ASSERT_NE(nullptr, writer);
+  unique_ptr<StateMirrorReader> reader = MapReader(*writer);
+  ASSERT_NE(nullptr, reader);
+  const uint8_t data[] = {1};
+  ASSERT_TRUE(writer->Publish(data, sizeof(data)));
+  EXPECT_FALSE(reader->IsRetired());
+
+  // Readers keep their mapping after the writer goes away.
+  writer.reset();
+  EXPECT_TRUE(reader->IsRetired());
+  vector<uint8_t> snapshot;
+  EXPECT_FALSE(ReadSnapshot(*reader, &snapshot));
+}
+
+TEST(StateMirrorRegionTest, ReadersCannotWrite) {
+  unique_ptr<StateMirrorWriter> writer = StateMirrorWriter::Create(16);
+  ASSERT_NE(nullptr, writer);
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  void* mapping = mmap(nullptr, page_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       writer->ReadOnlyFd(), 0);
+  EXPECT_EQ(MAP_FAILED, mapping);
+  if (mapping != MAP_FAILED) munmap(mapping, page_size);
+}
+
+TEST(StateMirrorRegionTest, RejectsOtherDescriptors) {
+  EXPECT_EQ(nullptr, StateMirrorReader::Map(-1));
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  close(fds[1]);
+  EXPECT_EQ(nullptr, StateMirrorReader::Map(fds[0]));
+}
+
+TEST(StateMirrorRegionTest, NeverReadsTornSnapshots) {
+  const size_t kSize = 1024;
+  unique_ptr<StateMirrorWriter> writer = StateMirrorWriter::Create(kSize);
+  ASSERT_NE(nullptr, writer);
+  unique_ptr<StateMirrorReader> reader = MapReader(*writer);
+  ASSERT_NE(nullptr, reader);
+
+  // Every snapshot repeats one byte, so a torn one has two different bytes.
+  std::atomic<bool> done(false);
+  std::thread publisher([&writer, &done]() {
+    vector<uint8_t> data(kSize);
+    for (int i = 0; i < 20000; ++i) {
+      memset(data.data(), i & 0xff, data.size());
+      writer->Publish(data.data(), data.size());
+    }
+    done = true;
+  });
+  int reads = 0;
+  int torn_reads = 0;
+  vector<uint8_t> snapshot;
+  while (!done || reads == 0) {
+    if (!ReadSnapshot(*reader, &snapshot)) continue;
+    ++reads;
+    if (snapshot.size() != kSize ||
+        static_cast<size_t>(std::count(snapshot.begin(), snapshot.end(),
+                                       snapshot[0])) != kSize) {
+      ++torn_reads;
+    }
+  }
+  publisher.join();
+  EXPECT_GT(reads, 0);
+  EXPECT_EQ(0, torn_reads);
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/trace_context.h"
+
+#include <random>
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+thread_local TraceContext current_context;
+
+// Trace and span ids are random, and never 0.
+uint64_t NewId() {
+  thread_local std::mt19937_64 generator{std::random_device{}()};
+  uint64_t id;
+  do {
+    id = generator();
+  } while (id == 0);
+  return id;
+}
+
+}  // namespace
+
+TraceContext TraceContext::NewTrace(bool sampled) {
+  TraceContext context;
+  context.trace_id = NewId();
+  context.span_id = NewId();
+  context.sampled = sampled;
+  return context;
+}
+
+TraceContext TraceContext::NewChild() const {
+  TraceContext child;
+  if (IsValid()) {
+    child.trace_id = trace_id;
+    child.span_id = NewId();
+    child.parent_span_id = span_id;
+    child.sampled = sampled;
+  }
+  return child;
+}
+
+const TraceContext& TraceContext::Current() {
+  return current_context;
+}
+
+int32_t TraceContext::WireFlags() const {
+  if (!IsValid()) {
+    return 0;
+  }
+  return kPresent | (sampled ? kSampled : 0);
+}
+
+TraceContext TraceContext::FromWire(int32_t flags, uint64_t trace_id,
+                                    uint64_t span_id) {
+  TraceContext context;
+  if ((flags & kPresent) && trace_id != 0) {
+    context.trace_id = trace_id;
+    context.span_id = span_id;
+    context.sampled = (flags & kSampled) != 0;
+  }
+  return context;
+}
+
+ScopedTraceContext::ScopedTraceContext(const TraceContext& context)
+    : previous_(current_context) {
+  current_context = context;
+}
+
+ScopedTraceContext::~ScopedTraceContext() {
+  current_context = previous_;
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
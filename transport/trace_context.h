@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_TRACE_CONTEXT_H_
+#define AIDL_TRANSPORT_TRACE_CONTEXT_H_
+
+#include <cstdint>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// Identifies the span of work a thread is doing within a trace.  Code
+// generated with aidl-cpp --trace-context sends the caller's context with
+// each call, and services run the call in a child span of it, so that the
+// spans of one request can be joined up across processes.
+struct TraceContext {
+  // Bits of the flags word that leads the context on the wire.  The ids
+  // follow as two int64s only when kPresent is set.
+  enum : int32_t {
+    kPresent = 1 << 0,
+    kSampled = 1 << 1,
+  };
+
+  // All zero when the thread isn't part of a trace.
+  uint64_t trace_id = 0;
+  uint64_t span_id = 0;
+  uint64_t parent_span_id = 0;
+  // Whether the trace is being recorded, as decided where it started.
+  bool sampled = false;
+
+  bool IsValid() const { return trace_id != 0; }
+
+  // Starts a new trace with a single span.
+  static TraceContext NewTrace(bool sampled);
+  // A new span under this one, in the same trace.  Invalid contexts have
+  // invalid children.
+  TraceContext NewChild() const;
+
+  // The context of the calling thread.
+  static const TraceContext& Current();
+
+  int32_t WireFlags() const;
+  // The caller's context, as read from a transaction.
+  static TraceContext FromWire(int32_t flags, uint64_t trace_id,
+                               uint64_t span_id);
+};
+
+// Makes |context| the calling thread's context until it goes out of scope.
+class ScopedTraceContext {
+ public:
+  explicit ScopedTraceContext(const TraceContext& context);
+  ~ScopedTraceContext();
+
+ private:
+  const TraceContext previous_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTraceContext);
+};
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_TRACE_CONTEXT_H_
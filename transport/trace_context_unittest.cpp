@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "transport/trace_context.h"
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+TEST(TraceContextTest, ThreadsStartOutsideAnyTrace) {
+  EXPECT_FALSE(TraceContext::Current().IsValid());
+  EXPECT_EQ(0, TraceContext::Current().WireFlags());
+  EXPECT_FALSE(TraceContext::Current().NewChild().IsValid());
+}
+
+TEST(TraceContextTest, ChildrenShareTheTrace) {
+  const TraceContext root = TraceContext::NewTrace(true /* sampled */);
+  ASSERT_TRUE(root.IsValid());
+  EXPECT_NE(0u, root.span_id);
+  EXPECT_EQ(0u, root.parent_span_id);
+
+  const TraceContext child = root.NewChild();
+  EXPECT_EQ(root.trace_id, child.trace_id);
+  EXPECT_EQ(root.span_id, child.parent_span_id);
+  EXPECT_NE(root.span_id, child.span_id);
+  EXPECT_TRUE(child.sampled);
+}
+
+TEST(TraceContextTest, ScopesNestAndRestore) {
+  const TraceContext outer = TraceContext::NewTrace(false /* sampled */);
+  {
+    ScopedTraceContext outer_scope(outer);
+    EXPECT_EQ(outer.span_id, TraceContext::Current().span_id);
+    {
+      ScopedTraceContext inner_scope(outer.NewChild());
+      EXPECT_EQ(outer.span_id, TraceContext::Current().parent_span_id);
+    }
+    EXPECT_EQ(outer.span_id, TraceContext::Current().span_id);
+
+    // Other threads keep their own context.
+    bool other_thread_valid = true;
+    std::thread([&other_thread_valid]() {
+      other_thread_valid = TraceContext::Current().IsValid();
+    }).join();
+    EXPECT_FALSE(other_thread_valid);
+  }
+  EXPECT_FALSE(TraceContext::Current().IsValid());
+}
+
+TEST(TraceContextTest, RoundTripsThroughTheWireFormat) {
+  const TraceContext sent = TraceContext::NewTrace(true /* sampled */);
+  const int32_t flags = sent.WireFlags();
+  EXPECT_EQ(TraceContext::kPresent | TraceContext::kSampled, flags);
+
+  const TraceContext received =
+      TraceContext::FromWire(flags, sent.trace_id, sent.span_id);
+  EXPECT_EQ(sent.trace_id, received.trace_id);
+  EXPECT_EQ(sent.span_id, received.span_id);
+  EXPECT_TRUE(received.sampled);
+
+  EXPECT_FALSE(TraceContext::FromWire(0, sent.trace_id, 1).IsValid());
+  EXPECT_FALSE(TraceContext::FromWire(TraceContext::kPresent, 0, 1).IsValid());
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/transaction_metrics.h"
+
+#include <chrono>
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+std::atomic<uint64_t> process_calls(0);
+std::atomic<uint64_t> process_service_time_ns(0);
+std::atomic<uint64_t> process_queue_delay_ns(0);
+
+// When the transaction about to be dispatched on this thread was received,
+// or 0 if the transport didn't say.
+thread_local uint64_t dispatch_time_ns = 0;
+// Timers alive on this thread.  Transactions that a service makes on itself
+// run inside the outer one and must not count as extra load.
+thread_local int timer_depth = 0;
+
+}  // namespace
+
+TransactionStats TransactionStats::operator-(
+    const TransactionStats& earlier) const {
+  TransactionStats difference;
+  difference.calls = calls - earlier.calls;
+  difference.service_time_ns = service_time_ns - earlier.service_time_ns;
+  difference.queue_delay_ns = queue_delay_ns - earlier.queue_delay_ns;
+  return difference;
+}
+
+TransactionMetrics::TransactionMetrics(size_t method_count)
+    : method_count_(method_count),
+      methods_(new Counters[method_count]) {}
+
+TransactionStats TransactionMetrics::Method(size_t method) const {
+  TransactionStats stats;
+  if (method < method_count_) {
+    const Counters& counters = methods_[method];
+    stats.calls = counters.calls.load(std::memory_order_relaxed);
+    stats.service_time_ns =
+        counters.service_time_ns.load(std::memory_order_relaxed);
+    stats.queue_delay_ns =
+        counters.queue_delay_ns.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void TransactionMetrics::Record(size_t method, uint64_t service_time_ns,
+                                uint64_t queue_delay_ns) {
+  if (method >= method_count_) {
+    return;
+  }
+  Counters& counters = methods_[method];
+  counters.calls.fetch_add(1, std::memory_order_relaxed);
+  counters.service_time_ns.fetch_add(service_time_ns,
+                                     std::memory_order_relaxed);
+  counters.queue_delay_ns.fetch_add(queue_delay_ns,
+                                    std::memory_order_relaxed);
+}
+
+TransactionStats TransactionMetrics::Process() {
+  TransactionStats stats;
+  stats.calls = process_calls.load(std::memory_order_relaxed);
+  stats.service_time_ns =
+      process_service_time_ns.load(std::memory_order_relaxed);
+  stats.queue_delay_ns = process_queue_delay_ns.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void TransactionMetrics::SetDispatchTime(uint64_t received_ns) {
+  dispatch_time_ns = received_ns;
+}
+
+uint64_t TransactionMetrics::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TransactionTimer::TransactionTimer(TransactionMetrics* metrics, size_t method)
+    : metrics_(metrics),
+      method_(method),
+      start_ns_(TransactionMetrics::NowNs()),
+      outermost_(timer_depth++ == 0) {
+  if (outermost_ && dispatch_time_ns != 0) {
+    if (start_ns_ > dispatch_time_ns) {
+      queue_delay_ns_ = start_ns_ - dispatch_time_ns;
+    }
+    // Only the first transaction after the transport's call waited.
+    dispatch_time_ns = 0;
+  }
+}
+
+TransactionTimer::~TransactionTimer() {
+  --timer_depth;
+  const uint64_t service_time_ns = TransactionMetrics::NowNs() - start_ns_;
+  metrics_->Record(method_, service_time_ns, queue_delay_ns_);
+  if (outermost_) {
+    process_calls.fetch_add(1, std::memory_order_relaxed);
+    process_service_time_ns.fetch_add(service_time_ns,
+                                      std::memory_order_relaxed);
+    process_queue_delay_ns.fetch_add(queue_delay_ns_,
+                                     std::memory_order_relaxed);
+  }
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_TRANSACTION_METRICS_H_
+#define AIDL_TRANSPORT_TRANSACTION_METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// Totals over some span of time.  Durations are in nanoseconds.
+struct TransactionStats {
+  uint64_t calls = 0;
+  // Time spent in onTransact(), including unparceling and replying.
+  uint64_t service_time_ns = 0;
+  // Time between the transport receiving a transaction and onTransact()
+  // starting on it.  Only transports that call SetDispatchTime() report it.
+  uint64_t queue_delay_ns = 0;
+
+  TransactionStats operator-(const TransactionStats& earlier) const;
+};
+
+// Per-method counters kept by a BnFoo generated with aidl-cpp
+// --server-metrics.  They may be read while other threads update them.
+class TransactionMetrics {
+ public:
+  explicit TransactionMetrics(size_t method_count);
+  ~TransactionMetrics() = default;
+
+  size_t MethodCount() const { return method_count_; }
+  // Totals for |method|, in the order the methods are declared.
+  TransactionStats Method(size_t method) const;
+
+  void Record(size_t method, uint64_t service_time_ns,
+              uint64_t queue_delay_ns);
+
+  // Totals over every transaction timed in this process, by any interface.
+  // Nested transactions on the same thread only count once.
+  static TransactionStats Process();
+
+  // Called by transports on the thread that is about to pass a transaction
+  // received at |received_ns| on the steady clock to transact().
+  static void SetDispatchTime(uint64_t received_ns);
+
+  static uint64_t NowNs();
+
+ private:
+  struct Counters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> service_time_ns{0};
+    std::atomic<uint64_t> queue_delay_ns{0};
+  };
+
+  friend class TransactionTimer;
+
+  const size_t method_count_;
+  std::unique_ptr<Counters[]> methods_;
+
+  DISALLOW_COPY_AND_ASSIGN(TransactionMetrics);
+};
+
+// Times one transaction for |method| from construction to destruction.
+// Generated onTransact() implementations put one in each case.
+class TransactionTimer {
+ public:
+  TransactionTimer(TransactionMetrics* metrics, size_t method);
+  ~TransactionTimer();
+
+ private:
+  TransactionMetrics* const metrics_;
+  const size_t method_;
+  const uint64_t start_ns_;
+  uint64_t queue_delay_ns_ = 0;
+  bool outermost_;
+
+  DISALLOW_COPY_AND_ASSIGN(TransactionTimer);
+};
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_TRANSACTION_METRICS_H_
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "transport/transaction_metrics.h"
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+TEST(TransactionMetricsTest, RecordsEachMethod) {
+  TransactionMetrics metrics(2);
+  const TransactionStats before = TransactionMetrics::Process();
+  {
+    TransactionTimer timer(&metrics, 1);
+  }
+  EXPECT_EQ(2u, metrics.MethodCount());
+  EXPECT_EQ(0u, metrics.Method(0).calls);
+  EXPECT_EQ(1u, metrics.Method(1).calls);
+  EXPECT_EQ(0u, metrics.Method(1).queue_delay_ns);
+  EXPECT_EQ(1u, (TransactionMetrics::Process() - before).calls);
+}
+
+TEST(TransactionMetricsTest, IgnoresUnknownMethods) {
+  TransactionMetrics metrics(1);
+  metrics.Record(1, 100, 100);
+  EXPECT_EQ(0u, metrics.Method(0).calls);
+  EXPECT_EQ(0u, metrics.Method(1).calls);
+}
+
+TEST(TransactionMetricsTest, MeasuresQueueDelayFromDispatchTime) {
+  TransactionMetrics metrics(1);
+  const uint64_t kDelayNs = 5000000;
+  TransactionMetrics::SetDispatchTime(TransactionMetrics::NowNs() - kDelayNs);
+  {
+    TransactionTimer timer(&metrics, 0);
+  }
+  EXPECT_GE(metrics.Method(0).queue_delay_ns, kDelayNs);
+
+  // The dispatch time is used up by the first transaction.
+  const uint64_t queue_delay_ns = metrics.Method(0).queue_delay_ns;
+  {
+    TransactionTimer timer(&metrics, 0);
+  }
+  EXPECT_EQ(2u, metrics.Method(0).calls);
+  EXPECT_EQ(queue_delay_ns, metrics.Method(0).queue_delay_ns);
+}
+
+TEST(TransactionMetricsTest, CountsNestedTransactionsOnceForTheProcess) {
+  TransactionMetrics metrics(2);
+  const TransactionStats before = TransactionMetrics::Process();
+  {
+    TransactionTimer outer(&metrics, 0);
+    TransactionTimer inner(&metrics, 1);
+  }
+  EXPECT_EQ(1u, metrics.Method(0).calls);
+  EXPECT_EQ(1u, metrics.Method(1).calls);
+  const TransactionStats process = TransactionMetrics::Process() - before;
+  EXPECT_EQ(1u, process.calls);
+  EXPECT_EQ(metrics.Method(0).service_time_ns, process.service_time_ns);
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
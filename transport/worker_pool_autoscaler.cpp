@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transport/worker_pool_autoscaler.h"
+
+#include <algorithm>
+
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+WorkerPoolAutoscaler::WorkerPoolAutoscaler(ResizableWorkerPool* pool,
+                                           const Options& options)
+    : pool_(pool),
+      options_(options) {}
+
+WorkerPoolAutoscaler::~WorkerPoolAutoscaler() {
+  Stop();
+}
+
+bool WorkerPoolAutoscaler::Start() {
+  if (thread_.joinable() || options_.min_threads == 0 ||
+      options_.min_threads > options_.max_threads) {
+    return false;
+  }
+  {
+    lock_guard<mutex> guard(lock_);
+    stopping_ = false;
+  }
+  thread_ = std::thread(&WorkerPoolAutoscaler::Run, this);
+  return true;
+}
+
+void WorkerPoolAutoscaler::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    lock_guard<mutex> guard(lock_);
+    stopping_ = true;
+  }
+  stop_condition_.notify_all();
+  thread_.join();
+}
+
+size_t WorkerPoolAutoscaler::Evaluate(const TransactionStats& load,
+                                      std::chrono::nanoseconds elapsed) {
+  const size_t threads = pool_->ThreadCount();
+  // The average number of threads that were busy.
+  const double busy_threads =
+      static_cast<double>(load.service_time_ns) /
+      std::max<int64_t>(elapsed.count(), 1);
+  const std::chrono::nanoseconds mean_queue_delay(
+      (load.calls == 0) ? 0 : load.queue_delay_ns / load.calls);
+
+  size_t target = threads;
+  if (mean_queue_delay > options_.grow_queue_delay) {
+    // Grow by half at a time so that a burst is absorbed in a few steps.
+    target = threads + std::max<size_t>(threads / 2, 1);
+  } else if (threads > 0 &&
+             busy_threads < options_.shrink_utilization * threads) {
+    // Shrink one at a time, so a lull between bursts costs little.
+    target = threads - 1;
+  }
+  target = std::min(std::max(target, options_.min_threads),
+                    options_.max_threads);
+
+  if (target != threads && pool_->SetThreadCount(target) &&
+      resize_callback_) {
+    resize_callback_(threads, target);
+  }
+  return pool_->ThreadCount();
+}
+
+void WorkerPoolAutoscaler::Run() {
+  TransactionStats last = TransactionMetrics::Process();
+  uint64_t last_ns = TransactionMetrics::NowNs();
+  unique_lock<mutex> lock(lock_);
+  while (!stop_condition_.wait_for(lock, options_.interval,
+                                   [this]() { return stopping_; })) {
+    lock.unlock();
+    const TransactionStats now = TransactionMetrics::Process();
+    const uint64_t now_ns = TransactionMetrics::NowNs();
+    Evaluate(now - last, std::chrono::nanoseconds(now_ns - last_ns));
+    last = now;
+    last_ns = now_ns;
+    lock.lock();
+  }
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRANSPORT_WORKER_POOL_AUTOSCALER_H_
+#define AIDL_TRANSPORT_WORKER_POOL_AUTOSCALER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <android-base/macros.h>
+
+#include "transport/transaction_metrics.h"
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+// A pool of threads serving transactions whose size can change while it
+// runs, such as a SocketServer.
+class ResizableWorkerPool {
+ public:
+  virtual ~ResizableWorkerPool() = default;
+
+  virtual size_t ThreadCount() = 0;
+  // Returns false if the pool isn't running.
+  virtual bool SetThreadCount(size_t thread_count) = 0;
+};
+
+// Grows |pool| when transactions queue up and shrinks it when its threads
+// sit idle, based on the load reported by TransactionMetrics::Process().
+// Only services generated with aidl-cpp --server-metrics report load.
+class WorkerPoolAutoscaler {
+ public:
+  struct Options {
+    size_t min_threads = 1;
+    size_t max_threads = 16;
+    // How often to look at the load.
+    std::chrono::milliseconds interval{100};
+    // Grow when transactions wait longer than this on average.
+    std::chrono::microseconds grow_queue_delay{500};
+    // Shrink when the threads are busy less than this fraction of the time.
+    double shrink_utilization = 0.3;
+  };
+
+  WorkerPoolAutoscaler(ResizableWorkerPool* pool, const Options& options);
+  // Stops the autoscaler if it is running.
+  ~WorkerPoolAutoscaler();
+
+  // Checks the load every |options.interval| on a thread of its own.
+  bool Start();
+  void Stop();
+
+  // Resizes the pool for |load|, the transactions that ran over the last
+  // |elapsed|, and returns the new thread count.  Start() calls this.
+  size_t Evaluate(const TransactionStats& load,
+                  std::chrono::nanoseconds elapsed);
+
+  // Called after each resize, for logging.
+  void SetResizeCallback(std::function<void(size_t from, size_t to)> callback) {
+    resize_callback_ = callback;
+  }
+
+ private:
+  void Run();
+
+  ResizableWorkerPool* const pool_;
+  const Options options_;
+  std::function<void(size_t, size_t)> resize_callback_;
+  std::thread thread_;
+  std::mutex lock_;
+  std::condition_variable stop_condition_;
+  bool stopping_ = false;  // GUARDED_BY(lock_)
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerPoolAutoscaler);
+};
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRANSPORT_WORKER_POOL_AUTOSCALER_H_
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "transport/worker_pool_autoscaler.h"
+
+using std::chrono::milliseconds;
+using std::pair;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace transport {
+
+namespace {
+
+class FakeWorkerPool : public ResizableWorkerPool {
+ public:
+  explicit FakeWorkerPool(size_t thread_count) : thread_count_(thread_count) {}
+
+  size_t ThreadCount() override { return thread_count_; }
+  bool SetThreadCount(size_t thread_count) override {
+    thread_count_ = thread_count;
+    ++resizes_;
+    return true;
+  }
+
+  std::atomic<size_t> thread_count_;
+  std::atomic<int> resizes_{0};
+};
+
+// |calls| transactions over 100ms, each waiting |queue_delay| and keeping a
+// thread busy for |service_time|.
+TransactionStats Load(uint64_t calls, milliseconds queue_delay,
+                      milliseconds service_time) {
+  TransactionStats load;
+  load.calls = calls;
+  load.queue_delay_ns =
+      calls * std::chrono::nanoseconds(queue_delay).count();
+  load.service_time_ns =
+      calls * std::chrono::nanoseconds(service_time).count();
+  return load;
+}
+
+const milliseconds kElapsed(100);
+
+}  // namespace
+
+TEST(WorkerPoolAutoscalerTest, GrowsWhenTransactionsQueue) {
+  FakeWorkerPool pool(4);
+  WorkerPoolAutoscaler autoscaler(&pool, WorkerPoolAutoscaler::Options());
+  EXPECT_EQ(6u, autoscaler.Evaluate(Load(400, milliseconds(2),
+                                         milliseconds(1)), kElapsed));
+  pool.thread_count_ = 1;
+  EXPECT_EQ(2u, autoscaler.Evaluate(Load(100, milliseconds(2),
+                                         milliseconds(1)), kElapsed));
+}
+
+TEST(WorkerPoolAutoscalerTest, ShrinksWhenIdle) {
+  FakeWorkerPool pool(4);
+  WorkerPoolAutoscaler autoscaler(&pool, WorkerPoolAutoscaler::Options());
+  EXPECT_EQ(3u, autoscaler.Evaluate(TransactionStats(), kElapsed));
+}
+
+TEST(WorkerPoolAutoscalerTest, HoldsSteadyWhenBusyWithoutQueueing) {
+  FakeWorkerPool pool(4);
+  WorkerPoolAutoscaler autoscaler(&pool, WorkerPoolAutoscaler::Options());
+  // 300 calls of 1ms keep 3 of the 4 threads busy.
+  EXPECT_EQ(4u, autoscaler.Evaluate(Load(300, milliseconds(0),
+                                         milliseconds(1)), kElapsed));
+  EXPECT_EQ(0, pool.resizes_);
+}
+
+TEST(WorkerPoolAutoscalerTest, StaysWithinBounds) {
+  WorkerPoolAutoscaler::Options options;
+  options.min_threads = 4;
+  options.max_threads = 5;
+
+  FakeWorkerPool pool(4);
+  WorkerPoolAutoscaler autoscaler(&pool, options);
+  EXPECT_EQ(4u, autoscaler.Evaluate(TransactionStats(), kElapsed));
+  EXPECT_EQ(0, pool.resizes_);
+  EXPECT_EQ(5u, autoscaler.Evaluate(Load(400, milliseconds(2),
+                                         milliseconds(1)), kElapsed));
+  EXPECT_EQ(5u, autoscaler.Evaluate(Load(400, milliseconds(2),
+                                         milliseconds(1)), kElapsed));
+  EXPECT_EQ(1, pool.resizes_);
+}
+
+TEST(WorkerPoolAutoscalerTest, ReportsResizes) {
+  FakeWorkerPool pool(4);
+  WorkerPoolAutoscaler autoscaler(&pool, WorkerPoolAutoscaler::Options());
+  vector<pair<size_t, size_t>> resizes;
+  autoscaler.SetResizeCallback([&resizes](size_t from, size_t to) {
+    resizes.emplace_back(from, to);
+  });
+  autoscaler.Evaluate(TransactionStats(), kElapsed);
+  ASSERT_EQ(1u, resizes.size());
+  EXPECT_EQ(4u, resizes[0].first);
+  EXPECT_EQ(3u, resizes[0].second);
+}
+
+TEST(WorkerPoolAutoscalerTest, RejectsBadBounds) {
+  FakeWorkerPool pool(4);
+  WorkerPoolAutoscaler::Options options;
+  options.min_threads = 0;
+  EXPECT_FALSE(WorkerPoolAutoscaler(&pool, options).Start());
+  options.min_threads = 8;
+  options.max_threads = 4;
+  EXPECT_FALSE(WorkerPoolAutoscaler(&pool, options).Start());
+}
+
+TEST(WorkerPoolAutoscalerTest, ShrinksIdlePoolInTheBackground) {
+  WorkerPoolAutoscaler::Options options;
+  options.min_threads = 2;
+  options.interval = milliseconds(1);
+
+  FakeWorkerPool pool(4);
+  WorkerPoolAutoscaler autoscaler(&pool, options);
+  ASSERT_TRUE(autoscaler.Start());
+  EXPECT_FALSE(autoscaler.Start());
+  for (int i = 0; i < 1000 && pool.thread_count_ != 2; ++i) {
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  autoscaler.Stop();
+  EXPECT_EQ(2u, pool.thread_count_);
+}
+
+}  // namespace transport
+}  // namespace aidl
+}  // namespace android
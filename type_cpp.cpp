@@ -209,6 +209,69 @@ class BinderType : public Type {
   std::string write_cast_;
 };
 
+// Enums are declared as an enum class nested in the interface.  The
+// interface also declares the helpers that move them across a Parcel,
+// rejecting values that are not enumerators.
+class EnumArrayType : public ArrayType {
+ public:
+  EnumArrayType(const AidlEnum& an_enum, const AidlInterface& interface,
+                const std::string& src_file_name)
+      : ArrayType(ValidatableType::KIND_GENERATED,
+                  interface.GetCanonicalName(), an_enum.GetName() + "[]",
+                  {"cstdint", "vector"},
+                  "::std::vector<" + GetCppName(an_enum, interface) + ">",
+                  GetHelperName(an_enum, interface, "Read", "Vector"),
+                  GetHelperName(an_enum, interface, "Write", "Vector"),
+                  kNoArrayType, kNoNullableType, src_file_name,
+                  an_enum.GetLine()) {}
+  virtual ~EnumArrayType() = default;
+
+  bool HasParcelHelpers() const override { return true; }
+
+  static string GetCppName(const AidlEnum& an_enum,
+                           const AidlInterface& interface) {
+    string ret;
+    for (const auto& term : interface.GetSplitPackage()) {
+      ret += "::" + term;
+    }
+    return ret + "::" + interface.GetName() + "::" + an_enum.GetName();
+  }
+
+  static string GetHelperName(const AidlEnum& an_enum,
+                              const AidlInterface& interface,
+                              const string& verb, const string& suffix) {
+    string ret;
+    for (const auto& term : interface.GetSplitPackage()) {
+      ret += "::" + term;
+    }
+    return ret + "::" + interface.GetName() + "::_aidl_" + verb +
+        an_enum.GetName() + suffix;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(EnumArrayType);
+};  // class EnumArrayType
+
+class EnumType : public Type {
+ public:
+  EnumType(const AidlEnum& an_enum, const AidlInterface& interface,
+           const std::string& src_file_name)
+      : Type(ValidatableType::KIND_GENERATED,
+             interface.GetCanonicalName(), an_enum.GetName(), {"cstdint"},
+             EnumArrayType::GetCppName(an_enum, interface),
+             EnumArrayType::GetHelperName(an_enum, interface, "Read", ""),
+             EnumArrayType::GetHelperName(an_enum, interface, "Write", ""),
+             new EnumArrayType(an_enum, interface, src_file_name),
+             kNoNullableType, src_file_name, an_enum.GetLine()) {}
+  virtual ~EnumType() = default;
+
+  bool IsCppPrimitive() const override { return true; }
+  bool HasParcelHelpers() const override { return true; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(EnumType);
+};  // class EnumType
+
 class NullableParcelableArrayType : public ArrayType {
  public:
   NullableParcelableArrayType(const AidlParcelable& parcelable,
@@ -229,6 +292,28 @@ class NullableParcelableArrayType : public ArrayType {
   }
 };
 
+// Reads and writes @nonnull parcelable arrays through helpers the generated
+// sources define, which leave out the null marker in front of each element.
+class NonNullParcelableArrayType : public ArrayType {
+ public:
+  NonNullParcelableArrayType(const AidlParcelable& parcelable,
+                             const std::string& src_file_name)
+      : ArrayType(ValidatableType::KIND_PARCELABLE,
+                  parcelable.GetPackage(), parcelable.GetName(),
+                  {parcelable.GetCppHeader(), "vector"},
+                  GetCppName(parcelable), "_aidl_ReadNonNullParcelableVector",
+                  "_aidl_WriteNonNullParcelableVector", kNoArrayType,
+                  kNoNullableType, src_file_name, parcelable.GetLine()) {}
+  virtual ~NonNullParcelableArrayType() = default;
+
+  bool HasParcelHelpers() const override { return true; }
+
+  static string GetCppName(const AidlParcelable& parcelable) {
+    return "::std::vector<" + Join(parcelable.GetSplitPackage(), "::") +
+        "::" + parcelable.GetName() + ">";
+  }
+};
+
 class ParcelableArrayType : public ArrayType {
  public:
   ParcelableArrayType(const AidlParcelable& parcelable,
@@ -236,17 +321,19 @@ class ParcelableArrayType : public ArrayType {
       : ArrayType(ValidatableType::KIND_PARCELABLE,
                   parcelable.GetPackage(), parcelable.GetName(),
                   {parcelable.GetCppHeader(), "vector"},
-                  GetCppName(parcelable), "readParcelableVector",
-                  "writeParcelableVector", kNoArrayType,
+                  NonNullParcelableArrayType::GetCppName(parcelable),
+                  "readParcelableVector", "writeParcelableVector",
+                  kNoArrayType,
                   new NullableParcelableArrayType(parcelable, src_file_name),
-                  src_file_name, parcelable.GetLine()) {}
+                  src_file_name, parcelable.GetLine()),
+        non_null_type_(
+            new NonNullParcelableArrayType(parcelable, src_file_name)) {}
   virtual ~ParcelableArrayType() = default;
 
+  const Type* NonNullType() const override { return non_null_type_.get(); }
+
  private:
-  static string GetCppName(const AidlParcelable& parcelable) {
-    return "::std::vector<" + Join(parcelable.GetSplitPackage(), "::") +
-        "::" + parcelable.GetName() + ">";
-  }
+  const std::unique_ptr<Type> non_null_type_;
 };
 
 class NullableParcelableType : public Type {
@@ -269,25 +356,47 @@ class NullableParcelableType : public Type {
   }
 };
 
+// Reads and writes @nonnull parcelables through helpers the generated
+// sources define, which leave out the null marker.
+class NonNullParcelableType : public Type {
+ public:
+  NonNullParcelableType(const AidlParcelable& parcelable,
+                        const std::string& src_file_name)
+      : Type(ValidatableType::KIND_PARCELABLE,
+             parcelable.GetPackage(), parcelable.GetName(),
+             {parcelable.GetCppHeader()}, GetCppName(parcelable),
+             "_aidl_ReadNonNullParcelable", "_aidl_WriteNonNullParcelable",
+             kNoArrayType, kNoNullableType,
+             src_file_name, parcelable.GetLine()) {}
+  virtual ~NonNullParcelableType() = default;
+  bool CanBeOutParameter() const override { return true; }
+  bool HasParcelHelpers() const override { return true; }
+
+  static string GetCppName(const AidlParcelable& parcelable) {
+    return "::" + Join(parcelable.GetSplitPackage(), "::") +
+        "::" + parcelable.GetName();
+  }
+};
+
 class ParcelableType : public Type {
  public:
   ParcelableType(const AidlParcelable& parcelable,
                  const std::string& src_file_name)
       : Type(ValidatableType::KIND_PARCELABLE,
              parcelable.GetPackage(), parcelable.GetName(),
-             {parcelable.GetCppHeader()}, GetCppName(parcelable),
+             {parcelable.GetCppHeader()},
+             NonNullParcelableType::GetCppName(parcelable),
              "readParcelable", "writeParcelable",
              new ParcelableArrayType(parcelable, src_file_name),
              new NullableParcelableType(parcelable, src_file_name),
-             src_file_name, parcelable.GetLine()) {}
+             src_file_name, parcelable.GetLine()),
+        non_null_type_(new NonNullParcelableType(parcelable, src_file_name)) {}
   virtual ~ParcelableType() = default;
   bool CanBeOutParameter() const override { return true; }
+  const Type* NonNullType() const override { return non_null_type_.get(); }
 
  private:
-  static string GetCppName(const AidlParcelable& parcelable) {
-    return "::" + Join(parcelable.GetSplitPackage(), "::") +
-        "::" + parcelable.GetName();
-  }
+  const std::unique_ptr<Type> non_null_type_;
 };
 
 class NullableStringListType : public Type {
@@ -529,6 +638,11 @@ bool TypeNamespace::AddBinderType(const AidlInterface& b,
   return true;
 }
 
+bool TypeNamespace::AddEnumType(const AidlEnum& e, const AidlInterface& b,
+                                const string& file_name) {
+  return Add(new EnumType(e, b, file_name));
+}
+
 bool TypeNamespace::AddListType(const std::string& type_name) {
   const Type* contained_type = FindTypeByCanonicalName(type_name);
   if (!contained_type) {
@@ -70,6 +70,10 @@ class Type : public ValidatableType {
   virtual std::string WriteCast(const std::string& value) const {
     return value;
   }
+  // True when ReadFromParcelMethod() and WriteToParcelMethod() name free
+  // functions taking the parcel as their first argument, rather than
+  // methods on the parcel itself.
+  virtual bool HasParcelHelpers() const { return false; }
 
  private:
   // |headers| are the headers we must include to use this type
@@ -118,6 +122,8 @@ class TypeNamespace : public ::android::aidl::LanguageTypeNamespace<Type> {
                          const std::string& filename) override;
   bool AddBinderType(const AidlInterface& b,
                      const std::string& filename) override;
+  bool AddEnumType(const AidlEnum& e, const AidlInterface& b,
+                   const std::string& filename) override;
   bool AddListType(const std::string& type_name) override;
   bool AddMapType(const std::string& key_type_name,
                   const std::string& value_type_name) override;
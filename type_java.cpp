@@ -146,6 +146,71 @@ void BasicArrayType::ReadFromParcel(StatementBlock* addTo, Variable* v,
 
 // ================================================================
 
+namespace {
+
+// Maps an enum backing type onto the suffix of the Parcel methods that
+// carry it, e.g. "byte" onto writeByte() and createByteArray().
+string EnumParcelSuffix(const string& backing_type) {
+  if (backing_type == "byte") return "Byte";
+  if (backing_type == "int") return "Int";
+  return "Long";
+}
+
+}  // namespace
+
+EnumType::EnumType(const JavaTypeNamespace* types, const AidlEnum& e,
+                   const AidlInterface& b, const string& declFile)
+    : Type(types, b.GetCanonicalName(), e.GetName(),
+           ValidatableType::KIND_GENERATED, true, false, declFile,
+           e.GetLine()),
+      m_backingType(e.GetBackingType()),
+      m_parcelSuffix(EnumParcelSuffix(e.GetBackingType())) {
+  m_array_type.reset(new EnumArrayType(types, e, b, declFile));
+}
+
+void EnumType::WriteToParcel(StatementBlock* addTo, Variable* v,
+                             Variable* parcel, int flags) const {
+  addTo->Add(new MethodCall(parcel, "write" + m_parcelSuffix, 1, v));
+}
+
+void EnumType::CreateFromParcel(StatementBlock* addTo, Variable* v,
+                                Variable* parcel, Variable**) const {
+  addTo->Add(new Assignment(v, new MethodCall(
+      new LiteralExpression(CanonicalName()), "checked", 1,
+      new MethodCall(parcel, "read" + m_parcelSuffix))));
+}
+
+EnumArrayType::EnumArrayType(const JavaTypeNamespace* types,
+                             const AidlEnum& e, const AidlInterface& b,
+                             const string& declFile)
+    : Type(types, b.GetCanonicalName(), e.GetName(),
+           ValidatableType::KIND_GENERATED, true, true, declFile,
+           e.GetLine()),
+      m_backingType(e.GetBackingType()),
+      m_parcelSuffix(EnumParcelSuffix(e.GetBackingType())) {}
+
+void EnumArrayType::WriteToParcel(StatementBlock* addTo, Variable* v,
+                                  Variable* parcel, int flags) const {
+  addTo->Add(new MethodCall(parcel, "write" + m_parcelSuffix + "Array", 1,
+                            v));
+}
+
+void EnumArrayType::CreateFromParcel(StatementBlock* addTo, Variable* v,
+                                     Variable* parcel, Variable**) const {
+  addTo->Add(new Assignment(v, new MethodCall(
+      new LiteralExpression(CanonicalName()), "checked", 1,
+      new MethodCall(parcel, "create" + m_parcelSuffix + "Array"))));
+}
+
+void EnumArrayType::ReadFromParcel(StatementBlock* addTo, Variable* v,
+                                   Variable* parcel, Variable**) const {
+  addTo->Add(new MethodCall(parcel, "read" + m_parcelSuffix + "Array", 1, v));
+  addTo->Add(new MethodCall(new LiteralExpression(CanonicalName()),
+                            "checked", 1, v));
+}
+
+// ================================================================
+
 FileDescriptorType::FileDescriptorType(const JavaTypeNamespace* types)
     : Type(types, "java.io", "FileDescriptor", ValidatableType::KIND_BUILT_IN,
            true, false) {
@@ -582,6 +647,9 @@ UserDataType::UserDataType(const JavaTypeNamespace* types,
   m_array_type.reset(new UserDataArrayType(types, package, name, builtIn,
                                            canWriteToParcel, declFile,
                                            declLine));
+  m_non_null_type.reset(new NonNullUserDataType(types, package, name,
+                                                canWriteToParcel, declFile,
+                                                declLine));
 }
 
 string UserDataType::CreatorName() const {
@@ -651,7 +719,11 @@ UserDataArrayType::UserDataArrayType(const JavaTypeNamespace* types,
     : Type(types, package, name,
            builtIn ? ValidatableType::KIND_BUILT_IN
                    : ValidatableType::KIND_PARCELABLE,
-           canWriteToParcel, true, declFile, declLine) {}
+           canWriteToParcel, true, declFile, declLine) {
+  m_non_null_type.reset(new NonNullUserDataArrayType(types, package, name,
+                                                     canWriteToParcel,
+                                                     declFile, declLine));
+}
 
 string UserDataArrayType::CreatorName() const {
   return JavaType() + ".CREATOR";
@@ -679,6 +751,125 @@ void UserDataArrayType::ReadFromParcel(StatementBlock* addTo, Variable* v,
 
 // ================================================================
 
+NonNullUserDataType::NonNullUserDataType(const JavaTypeNamespace* types,
+                                         const string& package,
+                                         const string& name,
+                                         bool canWriteToParcel,
+                                         const string& declFile, int declLine)
+    : Type(types, package, name, ValidatableType::KIND_PARCELABLE,
+           canWriteToParcel, true, declFile, declLine) {}
+
+string NonNullUserDataType::CreatorName() const {
+  return JavaType() + ".CREATOR";
+}
+
+void NonNullUserDataType::WriteToParcel(StatementBlock* addTo, Variable* v,
+                                        Variable* parcel, int flags) const {
+  // v.writeToParcel(parcel, flags);
+  addTo->Add(new MethodCall(v, "writeToParcel", 2, parcel,
+                            BuildWriteToParcelFlags(flags)));
+}
+
+void NonNullUserDataType::CreateFromParcel(StatementBlock* addTo, Variable* v,
+                                           Variable* parcel,
+                                           Variable**) const {
+  // v = CLASS.CREATOR.createFromParcel(parcel);
+  addTo->Add(new Assignment(
+      v, new MethodCall(v->type, "CREATOR.createFromParcel", 1, parcel)));
+}
+
+void NonNullUserDataType::ReadFromParcel(StatementBlock* addTo, Variable* v,
+                                         Variable* parcel, Variable**) const {
+  // v.readFromParcel(parcel);
+  addTo->Add(new MethodCall(v, "readFromParcel", 1, parcel));
+}
+
+NonNullUserDataArrayType::NonNullUserDataArrayType(
+    const JavaTypeNamespace* types, const string& package, const string& name,
+    bool canWriteToParcel, const string& declFile, int declLine)
+    : Type(types, package, name, ValidatableType::KIND_PARCELABLE,
+           canWriteToParcel, true, declFile, declLine) {}
+
+string NonNullUserDataArrayType::CreatorName() const {
+  return JavaType() + ".CREATOR";
+}
+
+void NonNullUserDataArrayType::WriteToParcel(StatementBlock* addTo,
+                                             Variable* v, Variable* parcel,
+                                             int flags) const {
+  // parcel.writeInt(v.length);
+  // for (int _i = 0; _i < v.length; _i++) {
+  //     v[_i].writeToParcel(parcel, flags);
+  // }
+  addTo->Add(new MethodCall(parcel, "writeInt", 1,
+                            new FieldVariable(v, "length")));
+  ForStatement* loop =
+      new ForStatement(new Variable(m_types->IntType(), "_i"),
+                       new LiteralExpression("0"),
+                       new FieldVariable(v, "length"));
+  loop->statements->Add(new MethodCall(
+      new LiteralExpression(v->name + "[_i]"), "writeToParcel", 2, parcel,
+      BuildWriteToParcelFlags(flags)));
+  addTo->Add(loop);
+}
+
+void NonNullUserDataArrayType::CreateFromParcel(StatementBlock* addTo,
+                                                Variable* v, Variable* parcel,
+                                                Variable**) const {
+  // int v_length = parcel.readInt();
+  // if (v_length < 0) {
+  //     throw new android.os.BadParcelableException("bad array length");
+  // }
+  // v = new CLASS[v_length];
+  // for (int _i = 0; _i < v.length; _i++) {
+  //     v[_i] = CLASS.CREATOR.createFromParcel(parcel);
+  // }
+  Variable* length = new Variable(m_types->IntType(), v->name + "_length");
+  addTo->Add(new VariableDeclaration(length, new MethodCall(parcel, "readInt")));
+  IfStatement* lencheck = new IfStatement();
+  lencheck->expression =
+      new Comparison(length, "<", new LiteralExpression("0"));
+  lencheck->statements->Add(new LiteralExpression(
+      "throw new android.os.BadParcelableException(\"bad array length\")"));
+  addTo->Add(lencheck);
+  addTo->Add(new Assignment(v, new NewArrayExpression(v->type, length)));
+  ForStatement* loop =
+      new ForStatement(new Variable(m_types->IntType(), "_i"),
+                       new LiteralExpression("0"),
+                       new FieldVariable(v, "length"));
+  loop->statements->Add(new Assignment(
+      new Variable(v->type, v->name + "[_i]"),
+      new MethodCall(v->type, "CREATOR.createFromParcel", 1, parcel)));
+  addTo->Add(loop);
+}
+
+void NonNullUserDataArrayType::ReadFromParcel(StatementBlock* addTo,
+                                              Variable* v, Variable* parcel,
+                                              Variable**) const {
+  // if (parcel.readInt() != v.length) {
+  //     throw new java.lang.RuntimeException("bad array lengths");
+  // }
+  // for (int _i = 0; _i < v.length; _i++) {
+  //     v[_i] = CLASS.CREATOR.createFromParcel(parcel);
+  // }
+  IfStatement* lencheck = new IfStatement();
+  lencheck->expression = new Comparison(new MethodCall(parcel, "readInt"), "!=",
+                                        new FieldVariable(v, "length"));
+  lencheck->statements->Add(new LiteralExpression(
+      "throw new java.lang.RuntimeException(\"bad array lengths\")"));
+  addTo->Add(lencheck);
+  ForStatement* loop =
+      new ForStatement(new Variable(m_types->IntType(), "_i"),
+                       new LiteralExpression("0"),
+                       new FieldVariable(v, "length"));
+  loop->statements->Add(new Assignment(
+      new Variable(v->type, v->name + "[_i]"),
+      new MethodCall(v->type, "CREATOR.createFromParcel", 1, parcel)));
+  addTo->Add(loop);
+}
+
+// ================================================================
+
 InterfaceType::InterfaceType(const JavaTypeNamespace* types,
                              const string& package, const string& name,
                              bool builtIn, bool oneway, const string& declFile,
@@ -776,7 +967,8 @@ ClassLoaderType::ClassLoaderType(const JavaTypeNamespace* types)
 // ================================================================
 
 void JavaTypeNamespace::Init() {
-  Add(new BasicType(this, "void", "XXX", "XXX", "XXX", "XXX", "XXX"));
+  m_void_type = new BasicType(this, "void", "XXX", "XXX", "XXX", "XXX", "XXX");
+  Add(m_void_type);
 
   m_bool_type = new BooleanType(this);
   Add(m_bool_type);
@@ -790,8 +982,10 @@ void JavaTypeNamespace::Init() {
                              "writeIntArray", "createIntArray", "readIntArray");
   Add(m_int_type);
 
-  Add(new BasicType(this, "long", "writeLong", "readLong", "writeLongArray",
-                    "createLongArray", "readLongArray"));
+  m_long_type = new BasicType(this, "long", "writeLong", "readLong",
+                              "writeLongArray", "createLongArray",
+                              "readLongArray");
+  Add(m_long_type);
 
   Add(new BasicType(this, "float", "writeFloat", "readFloat", "writeFloatArray",
                     "createFloatArray", "readFloatArray"));
@@ -888,6 +1082,11 @@ bool JavaTypeNamespace::AddBinderType(const AidlInterface& b,
   return success;
 }
 
+bool JavaTypeNamespace::AddEnumType(const AidlEnum& e, const AidlInterface& b,
+                                    const std::string& filename) {
+  return Add(new EnumType(this, e, b, filename));
+}
+
 bool JavaTypeNamespace::AddListType(const std::string& contained_type_name) {
   const Type* contained_type = FindTypeByCanonicalName(contained_type_name);
   if (!contained_type) {
@@ -115,6 +115,45 @@ class BasicType : public Type {
   std::string m_unmarshallParcel;
 };
 
+// Enums travel as their backing type.  The nested holder class generated
+// for each enum validates values as they come off the wire.
+class EnumArrayType : public Type {
+ public:
+  EnumArrayType(const JavaTypeNamespace* types, const AidlEnum& e,
+                const AidlInterface& b, const std::string& declFile);
+
+  std::string JavaType() const override { return m_backingType; }
+
+  void WriteToParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                     int flags) const override;
+  void CreateFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                        Variable** cl) const override;
+  void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                      Variable** cl) const override;
+  const ValidatableType* NullableType() const override { return this; }
+
+ private:
+  std::string m_backingType;
+  std::string m_parcelSuffix;
+};
+
+class EnumType : public Type {
+ public:
+  EnumType(const JavaTypeNamespace* types, const AidlEnum& e,
+           const AidlInterface& b, const std::string& declFile);
+
+  std::string JavaType() const override { return m_backingType; }
+
+  void WriteToParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                     int flags) const override;
+  void CreateFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                        Variable** cl) const override;
+
+ private:
+  std::string m_backingType;
+  std::string m_parcelSuffix;
+};
+
 class FileDescriptorArrayType : public Type {
  public:
   FileDescriptorArrayType(const JavaTypeNamespace* types);
@@ -348,6 +387,25 @@ class ListType : public Type {
   const ValidatableType* NullableType() const override { return this; }
 };
 
+// A @nonnull parcelable array, written as its length followed by each
+// element without a null marker in front.
+class NonNullUserDataArrayType : public Type {
+ public:
+  NonNullUserDataArrayType(const JavaTypeNamespace* types,
+                           const std::string& package, const std::string& name,
+                           bool canWriteToParcel, const std::string& declFile,
+                           int declLine);
+
+  std::string CreatorName() const override;
+
+  void WriteToParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                     int flags) const override;
+  void CreateFromParcel(StatementBlock* addTo, Variable* v,
+                        Variable* parcel, Variable** cl) const override;
+  void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                      Variable** cl) const override;
+};
+
 class UserDataArrayType : public Type {
  public:
   UserDataArrayType(const JavaTypeNamespace* types, const std::string& package,
@@ -364,6 +422,30 @@ class UserDataArrayType : public Type {
   void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                       Variable** cl) const override;
   const ValidatableType* NullableType() const override { return this; }
+  const ValidatableType* NonNullType() const override {
+    return m_non_null_type.get();
+  }
+
+ private:
+  std::unique_ptr<Type> m_non_null_type;
+};
+
+// A @nonnull parcelable, written without a null marker in front.
+class NonNullUserDataType : public Type {
+ public:
+  NonNullUserDataType(const JavaTypeNamespace* types,
+                      const std::string& package, const std::string& name,
+                      bool canWriteToParcel, const std::string& declFile,
+                      int declLine);
+
+  std::string CreatorName() const override;
+
+  void WriteToParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                     int flags) const override;
+  void CreateFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                        Variable** cl) const override;
+  void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                      Variable** cl) const override;
 };
 
 class UserDataType : public Type {
@@ -381,6 +463,12 @@ class UserDataType : public Type {
   void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                       Variable** cl) const override;
   const ValidatableType* NullableType() const override { return this; }
+  const ValidatableType* NonNullType() const override {
+    return m_non_null_type.get();
+  }
+
+ private:
+  std::unique_ptr<Type> m_non_null_type;
 };
 
 class InterfaceType : public Type {
@@ -443,12 +531,16 @@ class JavaTypeNamespace : public LanguageTypeNamespace<Type> {
                          const std::string& filename) override;
   bool AddBinderType(const AidlInterface& b,
                      const std::string& filename) override;
+  bool AddEnumType(const AidlEnum& e, const AidlInterface& b,
+                   const std::string& filename) override;
   bool AddListType(const std::string& contained_type_name) override;
   bool AddMapType(const std::string& key_type_name,
                   const std::string& value_type_name) override;
 
+  const Type* VoidType() const { return m_void_type; }
   const Type* BoolType() const { return m_bool_type; }
   const Type* IntType() const { return m_int_type; }
+  const Type* LongType() const { return m_long_type; }
   const Type* StringType() const { return m_string_type; }
   const Type* TextUtilsType() const { return m_text_utils_type; }
   const Type* RemoteExceptionType() const { return m_remote_exception_type; }
@@ -465,8 +557,10 @@ class JavaTypeNamespace : public LanguageTypeNamespace<Type> {
   const Type* ClassLoaderType() const { return m_classloader_type; }
 
  private:
+  const Type* m_void_type{nullptr};
   const Type* m_bool_type{nullptr};
   const Type* m_int_type{nullptr};
+  const Type* m_long_type{nullptr};
   const Type* m_string_type{nullptr};
   const Type* m_text_utils_type{nullptr};
   const Type* m_remote_exception_type{nullptr};
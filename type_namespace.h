@@ -67,6 +67,9 @@ class ValidatableType {
 
   virtual const ValidatableType* ArrayType() const = 0;
   virtual const ValidatableType* NullableType() const = 0;
+  // The variant of this type written without a null marker, for types
+  // annotated with @nonnull, or nullptr if there is none.
+  virtual const ValidatableType* NonNullType() const { return nullptr; }
 
   // ShortName() is the class name without a package.
   std::string ShortName() const { return type_name_; }
@@ -99,6 +102,10 @@ class TypeNamespace {
                                  const std::string& filename) = 0;
   virtual bool AddBinderType(const AidlInterface& b,
                              const std::string& filename) = 0;
+  // Enums are scoped to the interface that declares them, so |e| is
+  // registered as <interface package>.<interface name>.<enum name>.
+  virtual bool AddEnumType(const AidlEnum& e, const AidlInterface& b,
+                           const std::string& filename) = 0;
   // Add a container type to this namespace.  Returns false only
   // on error. Silently discards requests to add non-container types.
   virtual bool MaybeAddContainerType(const AidlType& aidl_type) = 0;
@@ -394,8 +401,8 @@ const ValidatableType* LanguageTypeNamespace<T>::GetValidatableType(
       *error_msg = "void type cannot be an array";
       return nullptr;
     }
-    if (aidl_type.IsNullable() || aidl_type.IsUtf8() ||
-        aidl_type.IsUtf8InCpp()) {
+    if (aidl_type.IsNullable() || aidl_type.IsNonNull() ||
+        aidl_type.IsUtf8() || aidl_type.IsUtf8InCpp()) {
       *error_msg = "void type cannot be annotated";
       return nullptr;
     }
@@ -410,6 +417,11 @@ const ValidatableType* LanguageTypeNamespace<T>::GetValidatableType(
     return nullptr;
   }
 
+  if (aidl_type.IsNullable() && aidl_type.IsNonNull()) {
+    *error_msg = "Type cannot be marked as both @nullable and @nonnull.";
+    return nullptr;
+  }
+
   // Strings inside containers get remapped to appropriate utf8 versions when
   // we convert the container name to its canonical form and the look up the
   // type.  However, for non-compound types (i.e. those not in a container) we
@@ -464,6 +476,16 @@ const ValidatableType* LanguageTypeNamespace<T>::GetValidatableType(
     }
   }
 
+  if (aidl_type.IsNonNull()) {
+    type = type->NonNullType();
+    if (!type) {
+      *error_msg = StringPrintf("type '%s%s' cannot be marked as never null",
+                                aidl_type.GetName().c_str(),
+                                (aidl_type.IsArray()) ? "[]" : "");
+      return nullptr;
+    }
+  }
+
   return type;
 }
 